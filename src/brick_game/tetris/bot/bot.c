@@ -0,0 +1,269 @@
+#include "bot.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// weights of the placement score, per line, per row of height, per hole and
+// per row of difference between neighbouring columns
+#define TETRIS_BOT_LINE_WEIGHT 76
+#define TETRIS_BOT_HEIGHT_WEIGHT (-51)
+#define TETRIS_BOT_HOLE_WEIGHT (-36)
+#define TETRIS_BOT_BUMPINESS_WEIGHT (-18)
+
+// the number of rows a brick may fall before it is turned
+#define TETRIS_BOT_TURN_ROWS 2
+
+typedef int BotField[TETRIS_FIELD_HEIGHT][TETRIS_FIELD_WIDTH];
+
+/**
+ * @brief Checks whether a brick state fits into the field at a position.
+ *
+ * The brick cells are mapped onto the field the way the engine places them.
+ *
+ * @param field The field, the falling brick left out.
+ * @param brick The brick.
+ * @param state The rotation state of the brick.
+ * @param x The x-coordinate of the brick.
+ * @param y The y-coordinate of the brick.
+ * @return true if a cell of the brick is out of the field or on a busy cell.
+ */
+static bool is_collide(BotField field, const Brick *brick, int state, int x,
+                       int y) {
+  for (int row = 0; row < BRICK_HEIGHT; row++) {
+    for (int col = 0; col < BRICK_WIDTH; col++) {
+      if (!brick->states[state][row][col]) continue;
+      int field_x = x + (-BRICK_WIDTH / 2) + col;
+      int field_y = y + ((-BRICK_HEIGHT / 2) + 1) + row;
+      if (field_x < 0 || field_x >= TETRIS_FIELD_WIDTH || field_y < 0 ||
+          field_y >= TETRIS_FIELD_HEIGHT || field[field_y][field_x]) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Returns how many rows a brick state falls straight down before it
+ * lands.
+ *
+ * Only the lowest cell of every column of the brick can land on something,
+ * so the column under it is scanned instead of testing the whole brick at
+ * every row.
+ *
+ * @param field The field, the falling brick left out.
+ * @param brick The brick, it must fit at its position.
+ * @param state The rotation state of the brick.
+ * @param x The x-coordinate of the brick.
+ * @param y The y-coordinate of the brick.
+ * @return The number of rows.
+ */
+static int measure_drop(BotField field, const Brick *brick, int state, int x,
+                        int y) {
+  int drop = TETRIS_FIELD_HEIGHT;
+  for (int col = 0; col < BRICK_WIDTH; col++) {
+    int lowest = -1;
+    for (int row = 0; row < BRICK_HEIGHT; row++) {
+      if (brick->states[state][row][col]) lowest = row;
+    }
+    if (lowest < 0) continue;
+
+    int field_x = x + (-BRICK_WIDTH / 2) + col;
+    int field_y = y + ((-BRICK_HEIGHT / 2) + 1) + lowest;
+    int below = field_y + 1;
+    while (below < TETRIS_FIELD_HEIGHT && !field[below][field_x]) below++;
+    if (below - 1 - field_y < drop) drop = below - 1 - field_y;
+  }
+  return drop;
+}
+
+/**
+ * @brief Writes the cells of a brick state into the field.
+ *
+ * @param field The field.
+ * @param brick The brick.
+ * @param state The rotation state of the brick.
+ * @param x The x-coordinate of the brick.
+ * @param y The y-coordinate of the brick.
+ * @param value The value of the written cells, 0 to erase them.
+ */
+static void put_brick(BotField field, const Brick *brick, int state, int x,
+                      int y, int value) {
+  for (int row = 0; row < BRICK_HEIGHT; row++) {
+    for (int col = 0; col < BRICK_WIDTH; col++) {
+      if (brick->states[state][row][col]) {
+        field[y + ((-BRICK_HEIGHT / 2) + 1) + row]
+             [x + (-BRICK_WIDTH / 2) + col] = value;
+      }
+    }
+  }
+}
+
+/**
+ * @brief Scores the field a dropped brick leaves.
+ *
+ * @param field The field with the dropped brick.
+ * @return The score, higher is better.
+ */
+static int score_field(BotField field) {
+  bool is_full[TETRIS_FIELD_HEIGHT];
+  int lines = 0;
+  for (int row = 0; row < TETRIS_FIELD_HEIGHT; row++) {
+    int cells = 0;
+    for (int col = 0; col < TETRIS_FIELD_WIDTH; col++) {
+      cells += field[row][col] != 0;
+    }
+    is_full[row] = cells == TETRIS_FIELD_WIDTH;
+    lines += is_full[row];
+  }
+
+  // full rows are about to go, they count neither as height nor as a roof
+  int height = 0, holes = 0, bumpiness = 0, previous = -1;
+  for (int col = 0; col < TETRIS_FIELD_WIDTH; col++) {
+    int column = 0;
+    for (int row = TETRIS_FIELD_HEIGHT - 1, depth = 0; row >= 0; row--) {
+      if (is_full[row]) continue;
+      depth++;
+      if (field[row][col]) {
+        holes += depth - 1 - column;
+        column = depth;
+      }
+    }
+    height += column;
+    if (previous >= 0) bumpiness += abs(column - previous);
+    previous = column;
+  }
+
+  return TETRIS_BOT_LINE_WEIGHT * lines + TETRIS_BOT_HEIGHT_WEIGHT * height +
+         TETRIS_BOT_HOLE_WEIGHT * holes +
+         TETRIS_BOT_BUMPINESS_WEIGHT * bumpiness;
+}
+
+/**
+ * @brief Chooses the rotation state and the column of the falling brick.
+ *
+ * Every state is tried in every column, from the first of the next
+ * `TETRIS_BOT_TURN_ROWS` rows it fits in: a brick turned at the spawn row
+ * may reach out of the top of the field and only turns a row or two lower.
+ * The brick is then dropped straight down. Without a fitting placement the
+ * brick is dropped as it is.
+ *
+ * @param self A pointer to the TetrisBot instance.
+ * @param brick The falling brick.
+ */
+static void plan(TetrisBot *self, const Brick *brick) {
+  BotField field;
+  for (int row = 0; row < TETRIS_FIELD_HEIGHT; row++) {
+    for (int col = 0; col < TETRIS_FIELD_WIDTH; col++) {
+      field[row][col] = self->tetris->data.info.field[row][col];
+    }
+  }
+  put_brick(field, brick, brick->state, brick->pos.x, brick->pos.y, 0);
+
+  self->_target_state = brick->state;
+  self->_target_x = brick->pos.x;
+  bool is_planned = false;
+  int best = 0;
+  for (int state = 0; state < brick->total_states; state++) {
+    for (int x = -BRICK_WIDTH; x < TETRIS_FIELD_WIDTH + BRICK_WIDTH; x++) {
+      int y = brick->pos.y;
+      while (y < brick->pos.y + TETRIS_BOT_TURN_ROWS &&
+             is_collide(field, brick, state, x, y)) {
+        y++;
+      }
+      if (is_collide(field, brick, state, x, y)) continue;
+      y += measure_drop(field, brick, state, x, y);
+
+      put_brick(field, brick, state, x, y, brick->color);
+      int score = score_field(field);
+      put_brick(field, brick, state, x, y, 0);
+
+      if (!is_planned || score > best) {
+        is_planned = true;
+        best = score;
+        self->_target_state = state;
+        self->_target_x = x;
+      }
+    }
+  }
+  self->stats.plans++;
+}
+
+/**
+ * @brief Sends the next user action of the plan to the engine.
+ *
+ * A new plan is made whenever a new brick spawned. The brick is turned first,
+ * then moved and finally dropped. A refused turn moves the brick a row down to
+ * try again, up to `TETRIS_BOT_TURN_ROWS` rows, a refused move drops it right
+ * away.
+ *
+ * @param self A pointer to the TetrisBot instance.
+ * @return true if an action was sent, false if no brick is falling.
+ */
+static bool _play(TetrisBot *self) {
+  if (!self) return false;
+
+  Tetris *tetris = self->tetris;
+  Brick *brick = tetris->data.current_brick;
+  if (tetris->state != TETRIS_MOVING_STATE || !brick) return false;
+
+  if (self->_generation != tetris->generation.next) {
+    self->_generation = tetris->generation.next;
+    self->_spawn_y = brick->pos.y;
+    plan(self, brick);
+  }
+
+  int state = brick->state;
+  int x = brick->pos.x;
+  bool is_moved = true;
+  if (state != self->_target_state) {
+    tetris_user_input(tetris, Action, false);
+    if (brick->state == state) {
+      is_moved = brick->pos.y < self->_spawn_y + TETRIS_BOT_TURN_ROWS;
+      if (is_moved) tetris_user_input(tetris, Down, false);
+    }
+  } else if (x != self->_target_x) {
+    tetris_user_input(tetris, x < self->_target_x ? Right : Left, false);
+    is_moved = brick->pos.x != x;
+  } else {
+    tetris_user_input(tetris, Down, true);
+  }
+  self->stats.moves++;
+
+  if (!is_moved) {
+    self->stats.blocked++;
+    tetris_user_input(tetris, Down, true);
+    self->stats.moves++;
+  }
+  return true;
+}
+
+/**
+ * @brief Frees the bot.
+ *
+ * @param self A pointer to the TetrisBot instance.
+ */
+static void _destroy(TetrisBot *self) {
+  if (!self) return;
+  free(self);
+}
+
+/**
+ * @brief Creates a bot for an engine.
+ *
+ * @param tetris The engine, it must only be used on the thread of the bot.
+ * @return A pointer to the newly created bot.
+ */
+TetrisBot *new_tetris_bot(Tetris *tetris) {
+  TetrisBot *self = (TetrisBot *)calloc(1, sizeof(TetrisBot));
+  if (!self) {
+    fprintf(stderr, "Cannot allocate mem for TetrisBot\n");
+    exit(-1);
+  }
+
+  self->tetris = tetris;
+
+  self->play = _play;
+  self->destroy = _destroy;
+  return self;
+}
@@ -0,0 +1,65 @@
+#ifndef BRICKGAME_TETRIS_BOT_BOT_H
+#define BRICKGAME_TETRIS_BOT_BOT_H
+
+#include <stdbool.h>
+
+#include "../tetris.h"
+
+/**
+ * @brief Counters of a bot.
+ *
+ * @struct TetrisBotStats
+ * @var moves Number of user actions sent to the engine.
+ * @var plans Number of placements chosen, one for every spawned brick.
+ * @var blocked Number of plans cut short because a move was blocked.
+ */
+typedef struct {
+  unsigned long moves;
+  unsigned long plans;
+  unsigned long blocked;
+} TetrisBotStats;
+
+/**
+ * @brief A bot playing an engine through user actions.
+ *
+ * For every spawned brick the bot tries every rotation in every column, drops
+ * it and scores the field it leaves: cleared lines count for it, the total
+ * height of the columns, the holes under them and the height differences of
+ * neighbouring columns against it. It then rotates the brick, moves it to the
+ * best column and drops it, one user action per `play`. A refused turn is
+ * tried again a row lower, a blocked move drops the brick where it is. The
+ * bot never pauses and never starts a game, so the caller decides what a game
+ * over leads to.
+ *
+ * @struct __tetris_bot
+ * @var tetris The engine, owned by the caller.
+ * @var stats Counters of the bot.
+ * @var _generation The generation of the next brick the plan was made for.
+ * @var _spawn_y The y-coordinate the brick spawned at.
+ * @var _target_state The rotation state the brick is turned to.
+ * @var _target_x The column the brick is moved to.
+ * @var play Function pointer sending the next user action of the plan.
+ * @var destroy Function pointer freeing the bot, the engine is left alone.
+ */
+typedef struct __tetris_bot {
+  Tetris *tetris;
+  TetrisBotStats stats;
+
+  unsigned long _generation;
+  int _spawn_y;
+  int _target_state;
+  int _target_x;
+
+  bool (*play)(struct __tetris_bot *self);
+  void (*destroy)(struct __tetris_bot *self);
+} TetrisBot;
+
+/**
+ * @brief Creates a bot for an engine.
+ *
+ * @param tetris The engine, it must only be used on the thread of the bot.
+ * @return A pointer to the newly created bot.
+ */
+TetrisBot *new_tetris_bot(Tetris *tetris);
+
+#endif  // !BRICKGAME_TETRIS_BOT_BOT_H
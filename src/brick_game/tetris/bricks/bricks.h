@@ -8,6 +8,9 @@
 #define BRICK_HEIGHT 4
 #define BRICK_WIDTH 4
 
+#define BRICK_DEFAULTS_COUNT 7
+#define BRICK_CUSTOM_COUNT 2
+
 /**
  * @brief Enumeration representing the colors of Tetris bricks.
  *
@@ -87,6 +90,14 @@ typedef struct __brick {
  * @var get_random A function pointer for retrieving a random brick.
  * @var create A function pointer for creating a new brick and adding it to the
  * repository.
+ * @var rng_state The state of the repository random generator. Every
+ * repository owns its generator, so two repositories seeded with the same value
+ * yield the same sequence of bricks.
+ * @var _last_index The index of the last brick returned by `get_random`.
+ * @var seed A function pointer for reseeding the random generator and
+ * resetting the rotation of the bricks.
+ * @var populate_defaults A function pointer for populating the repository with
+ * the seven default bricks.
  * @var populate_custom A function pointer for populating the repository with
  * custom bricks.
  * @var destroy A function pointer for destroying the repository and freeing its
@@ -96,10 +107,15 @@ typedef struct __brick_repository {
   Brick *items;
   size_t items_count;
 
+  unsigned int rng_state;
+  int _last_index;
+
   Brick *(*get)(struct __brick_repository *self, int index);
   Brick *(*get_random)(struct __brick_repository *self);
   void (*create)(struct __brick_repository *self, Brick brick);
+  void (*seed)(struct __brick_repository *self, unsigned int seed);
 
+  void (*populate_defaults)(struct __brick_repository *self);
   void (*populate_custom)(struct __brick_repository *self);
 
   void (*destroy)(struct __brick_repository *self);
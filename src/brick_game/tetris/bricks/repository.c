@@ -59,34 +59,59 @@ static Brick *_get(TetrisBrickRepository *self, int index) {
   return item;
 }
 
+/**
+ * @brief Advances the xorshift32 generator of the repository.
+ *
+ * @param self A pointer to the TetrisBrickRepository structure.
+ * @return The next pseudo random value.
+ */
+static unsigned int next_random(TetrisBrickRepository *self) {
+  unsigned int x = self->rng_state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  self->rng_state = x;
+  return x;
+}
+
+/**
+ * @brief Reseeds the random generator of the repository.
+ *
+ * The generator state must never be zero, so a zero seed is replaced by a fixed
+ * constant. The "no repeat" guard and the rotation of every brick are reset as
+ * well, which makes the brick sequence depend on the seed only.
+ *
+ * @param self A pointer to the TetrisBrickRepository structure.
+ * @param seed The new seed.
+ */
+static void _seed(TetrisBrickRepository *self, unsigned int seed) {
+  if (!self) return;
+  self->rng_state = seed ? seed : 0x9E3779B9u;
+  self->_last_index = 0;
+  for (size_t i = 0; i < self->items_count; i++) {
+    self->items[i].state = 0;
+  }
+}
+
 /**
  * @brief Retrieves a random brick from the Tetris brick repository.
  *
  * This function selects a random brick from the Tetris brick repository,
- * ensuring that the same brick is not selected consecutively. It uses a static
- * variable to keep track of the last selected index and a guard mechanism to
- * prevent the same brick from being selected too frequently in succession. This
- * mechanism resets the guard block after a certain number of selections to
- * maintain randomness.
+ * ensuring that the same brick is not selected consecutively. The generator and
+ * the index of the last selected brick live in the repository itself, so
+ * independent repositories can be used from different threads.
  *
  * @param self A pointer to the TetrisBrickRepository structure.
  * @return A pointer to the randomly selected Brick structure.
  */
 static Brick *_get_random(TetrisBrickRepository *self) {
-  if (!self) return NULL;
+  if (!self || !self->items_count) return NULL;
   int index = 0;
 
-  // static int guard_block = 0;
-  // guard_block = (index == 0) ? 0 : guard_block + 1;
-  // if (guard_block >= 7) {
-  //   index = guard_block = 0;
-  // }
-
-  static int last_index = 0;
   do {
-    index = rand() % self->items_count;
-  } while ((index == last_index) && (self->items_count > 1));
-  last_index = index;
+    index = next_random(self) % self->items_count;
+  } while ((index == self->_last_index) && (self->items_count > 1));
+  self->_last_index = index;
 
   return self->get(self, index);
 }
@@ -131,6 +156,11 @@ static void _destroy(TetrisBrickRepository *self) {
   free(self);
 }
 
+/**
+ * @brief Populates the repository with the seven default bricks.
+ *
+ * @param repo A pointer to the TetrisBrickRepository structure.
+ */
 static void populate_repo_defaults(TetrisBrickRepository *repo) {
   if (!repo) return;
 
@@ -283,10 +313,13 @@ TetrisBrickRepository *new_brick_repository() {
 
   self->items = NULL;
   self->items_count = 0;
+  _seed(self, (unsigned int)time(NULL));
 
   self->get = _get;
   self->get_random = _get_random;
   self->create = _create;
+  self->seed = _seed;
+  self->populate_defaults = populate_repo_defaults;
   self->populate_custom = _populate_custom;
   self->destroy = _destroy;
 
@@ -0,0 +1,237 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "fleet.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief Returns the monotonic time.
+ *
+ * @return The time in nanoseconds.
+ */
+static long long fleet_now_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ * @brief Advances a game by one tick: the virtual clock moves on, the bot
+ * makes the moves it is due, the engine ticks and a finished game starts
+ * again.
+ *
+ * @param self A pointer to the TetrisFleet instance.
+ * @param game The game.
+ * @param period_ns The time of a tick.
+ */
+static void tick_game(TetrisFleet *self, TetrisFleetGame *game,
+                      long long period_ns) {
+  Tetris *tetris = game->tetris;
+  game->_clock_ns += period_ns * self->speed;
+  tetris->timer.set_time(
+      &tetris->timer,
+      (struct timespec){.tv_sec = game->_clock_ns / 1000000000LL,
+                        .tv_nsec = game->_clock_ns % 1000000000LL});
+
+  game->_moves += TETRIS_FLEET_MOVES_PER_SECOND * self->speed;
+  for (; game->_moves >= self->rate; game->_moves -= self->rate) {
+    if (!game->bot->play(game->bot)) {
+      game->_moves = 0;
+      break;
+    }
+  }
+  tetris_update_state(tetris);
+
+  if (tetris->state == TETRIS_GAMEOVER_STATE) {
+    game->games++;
+    tetris_user_input(tetris, Start, false);
+  }
+
+  if (tetris_snapshots_is_stale(&game->_snapshots, tetris, NULL)) {
+    tetris_snapshots_publish(&game->_snapshots, tetris, NULL, 0);
+  }
+}
+
+/**
+ * @brief An engine thread: ticks every `threads_count`-th game at the fixed
+ * rate, starting with the game of its index.
+ *
+ * Ticks missed altogether are skipped, the games then run slower than their
+ * speed instead of catching up in a burst.
+ *
+ * @param arg A pointer to the TetrisFleetWorker instance.
+ * @return NULL.
+ */
+static void *run_games(void *arg) {
+  TetrisFleetWorker *worker = (TetrisFleetWorker *)arg;
+  TetrisFleet *self = worker->fleet;
+  long long period_ns = 1000000000LL / self->rate;
+  long long deadline_ns = fleet_now_ns();
+
+  while (!atomic_load_explicit(&self->_is_stopping, memory_order_relaxed)) {
+    long long started_ns = fleet_now_ns();
+    for (int i = worker->index; i < self->count; i += self->threads_count) {
+      tick_game(self, &self->games[i], period_ns);
+      worker->stats.ticks++;
+    }
+    long long finished_ns = fleet_now_ns();
+    worker->stats.busy_ns += finished_ns - started_ns;
+
+    deadline_ns += period_ns;
+    if (deadline_ns <= finished_ns) deadline_ns = finished_ns + period_ns;
+    struct timespec deadline = {.tv_sec = deadline_ns / 1000000000LL,
+                                .tv_nsec = deadline_ns % 1000000000LL};
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+  }
+  return NULL;
+}
+
+/**
+ * @brief Returns the latest published snapshot of a game.
+ *
+ * The snapshot stays valid and unchanged until the next call for the same
+ * game.
+ *
+ * @param self A pointer to the TetrisFleet instance.
+ * @param index The index of the game.
+ * @return The snapshot or NULL if there is no such game.
+ */
+static const TetrisSnapshot *_latest(TetrisFleet *self, int index) {
+  if (!self || index < 0 || index >= self->count) return NULL;
+  return tetris_snapshots_latest(&self->games[index]._snapshots);
+}
+
+/**
+ * @brief Stops and joins the engine threads and sums up their counters.
+ *
+ * @param self A pointer to the TetrisFleet instance.
+ */
+static void _stop(TetrisFleet *self) {
+  if (!self || !self->_is_running) return;
+
+  atomic_store_explicit(&self->_is_stopping, true, memory_order_relaxed);
+  self->stats = (TetrisFleetStats){0};
+  for (int i = 0; i < self->threads_count; i++) {
+    TetrisFleetWorker *worker = &self->_workers[i];
+    pthread_join(worker->thread, NULL);
+    self->stats.ticks += worker->stats.ticks;
+    self->stats.busy_ns += worker->stats.busy_ns;
+  }
+  for (int i = 0; i < self->count; i++) {
+    self->stats.games += self->games[i].games;
+  }
+  self->_is_running = false;
+}
+
+/**
+ * @brief Starts every game, publishes their first snapshots and starts the
+ * engine threads.
+ *
+ * @param self A pointer to the TetrisFleet instance.
+ * @return 0 on success, -1 if a thread cannot be created.
+ */
+static int _start(TetrisFleet *self) {
+  if (!self || self->_is_running) return -1;
+
+  for (int i = 0; i < self->count; i++) {
+    TetrisFleetGame *game = &self->games[i];
+    if (game->tetris->state == TETRIS_READY_STATE) {
+      tetris_user_input(game->tetris, Start, false);
+    }
+    tetris_snapshots_fill(&game->_snapshots, game->tetris, NULL, 0);
+  }
+
+  atomic_store_explicit(&self->_is_stopping, false, memory_order_relaxed);
+  int started = 0;
+  for (; started < self->threads_count; started++) {
+    TetrisFleetWorker *worker = &self->_workers[started];
+    if (pthread_create(&worker->thread, NULL, run_games, worker)) break;
+  }
+
+  self->_is_running = true;
+  if (started < self->threads_count) {
+    self->threads_count = started;
+    _stop(self);
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Stops the engine threads and frees the fleet with its games.
+ *
+ * @param self A pointer to the TetrisFleet instance.
+ */
+static void _destroy(TetrisFleet *self) {
+  if (!self) return;
+  _stop(self);
+  for (int i = 0; i < self->count; i++) {
+    self->games[i].bot->destroy(self->games[i].bot);
+    self->games[i].tetris->destroy(self->games[i].tetris);
+  }
+  free(self->games);
+  free(self->_workers);
+  free(self);
+}
+
+/**
+ * @brief Creates a fleet of bot games.
+ *
+ * There is an engine thread for every online processor, up to
+ * `TETRIS_FLEET_MAX_THREADS` and never more than the games.
+ *
+ * @param count The number of games.
+ * @param seed The seed of the first game, the next games count up from it.
+ * @param speed The speed of the games relative to the real time, from 1 to
+ * `TETRIS_FLEET_MAX_SPEED`.
+ * @return A pointer to the newly created fleet or NULL if `count` is not
+ * positive.
+ */
+TetrisFleet *new_tetris_fleet(int count, unsigned int seed, int speed) {
+  if (count <= 0) return NULL;
+
+  TetrisFleet *self = (TetrisFleet *)calloc(1, sizeof(TetrisFleet));
+  long processors = sysconf(_SC_NPROCESSORS_ONLN);
+  int threads_count = processors > 0 ? (int)processors : 1;
+  if (threads_count > TETRIS_FLEET_MAX_THREADS) {
+    threads_count = TETRIS_FLEET_MAX_THREADS;
+  }
+  if (threads_count > count) threads_count = count;
+  if (self) {
+    self->games = (TetrisFleetGame *)calloc(count, sizeof(TetrisFleetGame));
+    self->_workers =
+        (TetrisFleetWorker *)calloc(threads_count, sizeof(TetrisFleetWorker));
+  }
+  if (!self || !self->games || !self->_workers) {
+    fprintf(stderr, "Cannot allocate mem for TetrisFleet\n");
+    exit(-1);
+  }
+
+  self->count = count;
+  self->speed = speed < 1                        ? 1
+                : speed > TETRIS_FLEET_MAX_SPEED ? TETRIS_FLEET_MAX_SPEED
+                                                 : speed;
+  self->rate = TETRIS_FLEET_RATE;
+  self->threads_count = threads_count;
+
+  for (int i = 0; i < count; i++) {
+    TetrisFleetGame *game = &self->games[i];
+    game->tetris = new_simulation_tetris(seed + i, BRICK_DEFAULTS_COUNT);
+    game->bot = new_tetris_bot(game->tetris);
+    tetris_snapshots_init(&game->_snapshots);
+  }
+  for (int i = 0; i < threads_count; i++) {
+    self->_workers[i].fleet = self;
+    self->_workers[i].index = i;
+  }
+  atomic_init(&self->_is_stopping, false);
+
+  self->start = _start;
+  self->latest = _latest;
+  self->stop = _stop;
+  self->destroy = _destroy;
+  return self;
+}
@@ -0,0 +1,127 @@
+#ifndef BRICKGAME_TETRIS_FLEET_FLEET_H
+#define BRICKGAME_TETRIS_FLEET_FLEET_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include "../bot/bot.h"
+#include "../runner/snapshot.h"
+#include "../tetris.h"
+
+#define TETRIS_FLEET_RATE 60
+#define TETRIS_FLEET_MAX_THREADS 8
+#define TETRIS_FLEET_MAX_SPEED 64
+#define TETRIS_FLEET_MOVES_PER_SECOND 10
+
+/**
+ * @brief A bot game of a fleet.
+ *
+ * @struct TetrisFleetGame
+ * @var tetris The simulation engine of the game.
+ * @var bot The bot playing the engine.
+ * @var games Number of finished games, read it after `stop`.
+ * @var _snapshots The snapshots of the engine, read through `latest`.
+ * @var _clock_ns The virtual clock of the engine.
+ * @var _moves The moves the bot may make, in moves per tick: a move costs
+ * `rate` of them.
+ */
+typedef struct {
+  Tetris *tetris;
+  TetrisBot *bot;
+  unsigned long games;
+
+  TetrisSnapshots _snapshots;
+  long long _clock_ns;
+  int _moves;
+} TetrisFleetGame;
+
+/**
+ * @brief Counters of a fleet.
+ *
+ * @struct TetrisFleetStats
+ * @var ticks Number of engine ticks of all games.
+ * @var games Number of finished games of all games.
+ * @var busy_ns Total time the engine threads spent ticking.
+ */
+typedef struct {
+  unsigned long ticks;
+  unsigned long games;
+  long long busy_ns;
+} TetrisFleetStats;
+
+/**
+ * @brief An engine thread of a fleet and the counters it keeps.
+ *
+ * @struct TetrisFleetWorker
+ * @var fleet The fleet.
+ * @var index The index of the first game of the thread.
+ * @var thread The thread.
+ * @var stats The counters of the games of the thread.
+ */
+typedef struct {
+  struct __tetris_fleet *fleet;
+  int index;
+  pthread_t thread;
+  TetrisFleetStats stats;
+} TetrisFleetWorker;
+
+/**
+ * @brief Runs many bot games at once on a few engine threads.
+ *
+ * Every game is a simulation engine played by a bot. The games are spread
+ * over the engine threads, every thread ticks its games at the fixed rate
+ * and publishes the snapshots of the games that changed, so a single reading
+ * thread can show all of them without ever waiting. The virtual clocks of
+ * the engines run `speed` times faster than the monotonic clock and the bots
+ * move `TETRIS_FLEET_MOVES_PER_SECOND` times per second of it, about as fast
+ * as a human player, so the games last as long as the gravity lets them. A
+ * finished game is started again right away.
+ *
+ * @struct __tetris_fleet
+ * @var count The number of games.
+ * @var speed The speed of the games relative to the real time.
+ * @var rate The number of ticks per second.
+ * @var threads_count The number of engine threads.
+ * @var games The games.
+ * @var stats Counters of all games, read them after `stop`.
+ * @var _workers The engine threads.
+ * @var _is_stopping Whether the engine threads are asked to end.
+ * @var _is_running Whether the engine threads are started.
+ * @var start Function pointer starting the games and the engine threads.
+ * @var latest Function pointer returning the latest published snapshot of a
+ * game.
+ * @var stop Function pointer stopping and joining the engine threads.
+ * @var destroy Function pointer freeing the fleet and its games.
+ */
+typedef struct __tetris_fleet {
+  int count;
+  int speed;
+  int rate;
+  int threads_count;
+  TetrisFleetGame *games;
+  TetrisFleetStats stats;
+
+  TetrisFleetWorker *_workers;
+  atomic_bool _is_stopping;
+  bool _is_running;
+
+  int (*start)(struct __tetris_fleet *self);
+  const TetrisSnapshot *(*latest)(struct __tetris_fleet *self, int index);
+  void (*stop)(struct __tetris_fleet *self);
+  void (*destroy)(struct __tetris_fleet *self);
+} TetrisFleet;
+
+/**
+ * @brief Creates a fleet of bot games.
+ *
+ * @param count The number of games.
+ * @param seed The seed of the first game, the next games count up from it.
+ * @param speed The speed of the games relative to the real time, from 1 to
+ * `TETRIS_FLEET_MAX_SPEED`.
+ * @return A pointer to the newly created fleet or NULL if `count` is not
+ * positive.
+ */
+TetrisFleet *new_tetris_fleet(int count, unsigned int seed, int speed);
+
+#endif  // !BRICKGAME_TETRIS_FLEET_FLEET_H
@@ -1,5 +1,99 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <time.h>
+
 #include "tetris.h"
 
+/**
+ * @brief A handler of a transition of the engine FSM.
+ *
+ * @param tetris A pointer to the Tetris game engine instance.
+ * @param hold Whether the action is held.
+ */
+typedef void (*TetrisFsmHandler)(Tetris *tetris, bool hold);
+
+/**
+ * @brief A cell of the dispatch table.
+ *
+ * @struct TetrisFsmTransition
+ * @var handler The handler, NULL if the action is ignored in the state.
+ * @var next The state the transition leads to, `TETRIS_FSM_ANY` if the handler
+ * decides.
+ */
+typedef struct {
+  TetrisFsmHandler handler;
+  int next;
+} TetrisFsmTransition;
+
+// the engine functions the handler column of the transitions names
+static void fsm_start(Tetris *tetris, bool hold) {
+  (void)hold;
+  tetris->start(tetris);
+}
+
+static void fsm_pause(Tetris *tetris, bool hold) {
+  (void)hold;
+  tetris->pause(tetris);
+}
+
+static void fsm_terminate(Tetris *tetris, bool hold) {
+  (void)hold;
+  tetris->terminate(tetris);
+}
+
+static void fsm_left(Tetris *tetris, bool hold) { tetris->left(tetris, hold); }
+
+static void fsm_right(Tetris *tetris, bool hold) {
+  tetris->right(tetris, hold);
+}
+
+static void fsm_up(Tetris *tetris, bool hold) { tetris->up(tetris, hold); }
+
+static void fsm_down(Tetris *tetris, bool hold) { tetris->down(tetris, hold); }
+
+static void fsm_action(Tetris *tetris, bool hold) {
+  tetris->action(tetris, hold);
+}
+
+#define TETRIS_FSM_CELL(state, action, handler, next) \
+  [state][action] = {fsm_##handler, next},
+
+// the dispatch table, state by action, generated from the transitions
+static const TetrisFsmTransition
+    transitions[TETRIS_FSM_STATES][TETRIS_FSM_ACTIONS] = {
+        TETRIS_FSM_TRANSITIONS(TETRIS_FSM_CELL)};
+
+#undef TETRIS_FSM_CELL
+
+#ifdef TETRIS_FSM_INSTRUMENT
+/**
+ * @brief Returns the monotonic time the handlers are timed with.
+ *
+ * @return The time in nanoseconds.
+ */
+static long long fsm_now_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ * @brief Counts a run of a handler.
+ *
+ * @param counter The counter of the transition or of the ticks.
+ * @param started_ns The time the handler started at.
+ * @param is_diverted Whether it ended in another state than declared.
+ */
+static void count_run(TetrisFsmCounter *counter, long long started_ns,
+                      bool is_diverted) {
+  long long ns = fsm_now_ns() - started_ns;
+  counter->count++;
+  counter->diverted += is_diverted;
+  counter->ns += ns;
+  if (ns > counter->max_ns) counter->max_ns = ns;
+}
+#endif
+
 /**
  * @brief Dispatches user actions to the Tetris game engine based on the current
  * game state.
@@ -11,106 +105,118 @@
  * and the `hold` parameter indicates whether the action should be held (e.g.,
  * moving a piece down continuously).
  *
- * The function handles various game states, including ready, spawn, moving,
- * pause, and game over states, and performs actions such as starting, pausing,
- * terminating, and moving the active piece.
+ * The handler is looked up in a table indexed by the state and the action,
+ * generated from `TETRIS_FSM_TRANSITIONS`, instead of going through a switch
+ * per state. The table also holds the next state, which is set once the
+ * handler returned; only the transitions declared `TETRIS_FSM_ANY` leave it to
+ * their handler. An instrumented build counts each transition, the time of its
+ * handler and the runs whose handler changed the state a declared transition
+ * sets.
  *
+ * @param tetris A pointer to the Tetris game engine instance.
  * @param action The action to be performed, as defined by the UserAction_t
  * enumeration.
  * @param hold A boolean value indicating whether the action should be held.
  */
-void dispatch(UserAction_t action, bool hold) {
-  (void)hold;
+void tetris_dispatch(Tetris *tetris, UserAction_t action, bool hold) {
+  if (!tetris || (unsigned)tetris->state >= TETRIS_FSM_STATES ||
+      (unsigned)action >= TETRIS_FSM_ACTIONS) {
+    return;
+  }
+
+  const TetrisFsmTransition *transition = &transitions[tetris->state][action];
+#ifdef TETRIS_FSM_INSTRUMENT
+  if (!transition->handler) {
+    tetris->fsm_stats.ignored++;
+    return;
+  }
+  TetriState state = tetris->state;
+  long long started_ns = fsm_now_ns();
+  transition->handler(tetris, hold);
+  count_run(&tetris->fsm_stats.transitions[state][action], started_ns,
+            transition->next != TETRIS_FSM_ANY && tetris->state != state);
+#else
+  if (!transition->handler) return;
+  transition->handler(tetris, hold);
+#endif
+  if (transition->next != TETRIS_FSM_ANY) {
+    tetris->state = (TetriState)transition->next;
+  }
+}
+
+/**
+ * @brief Ticks a given Tetris engine instance through the FSM.
+ *
+ * An instrumented build counts the tick and its time in the state it started
+ * in.
+ *
+ * @param tetris A pointer to the Tetris game engine instance.
+ */
+void tetris_fsm_tick(Tetris *tetris) {
+  if (!tetris) return;
+#ifdef TETRIS_FSM_INSTRUMENT
+  TetriState state = tetris->state;
+  long long started_ns = fsm_now_ns();
+  tetris->_tick(tetris);
+  if ((unsigned)state < TETRIS_FSM_STATES) {
+    count_run(&tetris->fsm_stats.ticks[state], started_ns, false);
+  }
+#else
+  tetris->_tick(tetris);
+#endif
+}
+
+#ifdef TETRIS_FSM_INSTRUMENT
+/**
+ * @brief Prints a counter, if it ever ran.
+ *
+ * @param file The file printed to.
+ * @param state The name of the state.
+ * @param event The name of the action or of the tick.
+ * @param counter The counter.
+ */
+static void print_counter(FILE *file, const char *state, const char *event,
+                          const TetrisFsmCounter *counter) {
+  if (!counter->count) return;
+  fprintf(file,
+          "fsm: %s %s: %lu runs, %lu diverted, %.3f/%.3fus handler "
+          "avg/max, %.3fms total\n",
+          state, event, counter->count, counter->diverted,
+          counter->ns / 1e3 / counter->count, counter->max_ns / 1e3,
+          counter->ns / 1e6);
+}
+
+/**
+ * @brief Prints the transitions and ticks that ran, with their counts and
+ * handler time, one line each.
+ *
+ * @param stats The counters.
+ * @param file The file printed to.
+ */
+void tetris_fsm_print_stats(const TetrisFsmStats *stats, FILE *file) {
+  static const char *states[TETRIS_FSM_STATES] = {
+      "ready", "spawn", "moving", "attach", "gameover", "pause", "terminated"};
+  static const char *actions[TETRIS_FSM_ACTIONS] = {
+      "start", "pause", "terminate", "left", "right", "up", "down", "action"};
 
-  Tetris *tetris = provide_tetris();
-  switch (tetris->state) {
-    case TETRIS_READY_STATE:
-      switch (action) {
-        case Start:
-          tetris->start(tetris);
-          break;
-        case Terminate:
-          tetris->terminate(tetris);
-          break;
-
-        default:
-          break;
-      }
-      break;
-
-    case TETRIS_SPAWN_STATE:
-      switch (action) {
-        case Pause:
-          tetris->pause(tetris);
-          break;
-        case Terminate:
-          tetris->terminate(tetris);
-          break;
-
-        default:
-          break;
-      }
-      break;
-
-    case TETRIS_MOVING_STATE:
-      switch (action) {
-        case Left:
-          tetris->left(tetris, hold);
-          break;
-        case Right:
-          tetris->right(tetris, hold);
-          break;
-        case Up:
-          tetris->up(tetris, hold);
-          break;
-        case Down:
-          tetris->down(tetris, hold);
-          break;
-        case Action:
-          tetris->action(tetris, hold);
-          break;
-        case Pause:
-          tetris->pause(tetris);
-          break;
-        case Terminate:
-          tetris->terminate(tetris);
-          break;
-
-        default:
-          break;
-      }
-      break;
-
-    case TETRIS_PAUSE_STATE:
-      switch (action) {
-        case Start:
-        case Pause:
-          tetris->pause(tetris);
-          break;
-        case Terminate:
-          tetris->terminate(tetris);
-          break;
-
-        default:
-          break;
-      }
-      break;
-
-    case TETRIS_GAMEOVER_STATE:
-      switch (action) {
-        case Start:
-          tetris->start(tetris);
-          break;
-        case Terminate:
-          tetris->terminate(tetris);
-          break;
-
-        default:
-          break;
-      }
-      break;
-
-    default:
-      break;
+  for (int state = 0; state < TETRIS_FSM_STATES; state++) {
+    print_counter(file, states[state], "tick", &stats->ticks[state]);
+    for (int action = 0; action < TETRIS_FSM_ACTIONS; action++) {
+      print_counter(file, states[state], actions[action],
+                    &stats->transitions[state][action]);
+    }
   }
-}
\ No newline at end of file
+  fprintf(file, "fsm: %lu actions ignored\n", stats->ignored);
+}
+#endif
+
+/**
+ * @brief Dispatches user actions to the singleton Tetris game engine.
+ *
+ * @param action The action to be performed, as defined by the UserAction_t
+ * enumeration.
+ * @param hold A boolean value indicating whether the action should be held.
+ */
+void dispatch(UserAction_t action, bool hold) {
+  tetris_dispatch(provide_tetris(), action, hold);
+}
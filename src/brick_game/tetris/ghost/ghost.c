@@ -0,0 +1,147 @@
+#include "ghost.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @brief Plays a single replay event on the ghost engine.
+ *
+ * The virtual clock of the engine is moved to the time of the event first, so
+ * the engine sees exactly the timing of the recorded game.
+ *
+ * @param self A pointer to the Ghost instance.
+ * @param event The event to play.
+ */
+static void play_event(Ghost *self, ReplayEvent event) {
+  self->_event_ns += (long long)event.dt_ns;
+  self->tetris->timer.set_time(
+      &self->tetris->timer,
+      (struct timespec){.tv_sec = self->_event_ns / 1000000000LL,
+                        .tv_nsec = self->_event_ns % 1000000000LL});
+
+  if (event.code == REPLAY_CODE_TICK) {
+    tetris_fsm_tick(self->tetris);
+  } else {
+    int action = (event.code & ~REPLAY_CODE_HOLD) - REPLAY_CODE_ACTION;
+    if (action >= Start && action <= Action) {
+      tetris_dispatch(self->tetris, (UserAction_t)action,
+                      event.code & REPLAY_CODE_HOLD);
+    }
+  }
+}
+
+/**
+ * @brief Restarts the replay from its first event.
+ *
+ * The engine is reset in place with the seed of the replay header and the
+ * game is started again at virtual time zero, exactly like a fresh simulation
+ * engine would start it.
+ *
+ * @param self A pointer to the Ghost instance.
+ */
+static void _restart(Ghost *self) {
+  if (!self) return;
+
+  replay_reader_init(&self->reader, self->data, self->size);
+  self->now_ns = 0;
+  self->_event_ns = 0;
+  self->_has_pending = false;
+  self->is_finished = false;
+
+  self->tetris->reset(self->tetris, self->reader.header.seed);
+  self->tetris->start(self->tetris);
+}
+
+/**
+ * @brief Moves the ghost clock forward and plays every event due by then.
+ *
+ * At most one decoded event is kept ahead of the clock, the rest of the replay
+ * stays encoded until it is due.
+ *
+ * @param self A pointer to the Ghost instance.
+ * @param dt_ns The time elapsed since the previous call.
+ */
+static void _advance(Ghost *self, long long dt_ns) {
+  if (!self || self->is_finished) return;
+
+  self->now_ns += dt_ns;
+  while (!self->is_finished) {
+    if (!self->_has_pending) {
+      self->_has_pending = replay_reader_next(&self->reader, &self->_pending);
+      self->is_finished = !self->_has_pending;
+    } else if (self->_event_ns + (long long)self->_pending.dt_ns <=
+               self->now_ns) {
+      play_event(self, self->_pending);
+      self->_has_pending = false;
+    } else {
+      break;
+    }
+  }
+}
+
+/**
+ * @brief Frees the ghost, its engine and its replay.
+ *
+ * @param self A pointer to the Ghost instance.
+ */
+static void _destroy(Ghost *self) {
+  if (!self) return;
+
+  if (self->tetris) self->tetris->destroy(self->tetris);
+  free(self->data);
+  free(self);
+}
+
+/**
+ * @brief Creates a ghost from an encoded replay.
+ *
+ * If memory allocation fails, the function prints an error message to stderr
+ * and exits the program with a failure status.
+ *
+ * @param data The encoded replay, the ghost takes ownership of it.
+ * @param size The size of the encoded replay.
+ * @return A pointer to the newly created Ghost instance or NULL if the replay
+ * header is invalid, in which case `data` is freed.
+ */
+Ghost *new_ghost(uint8_t *data, size_t size) {
+  ReplayReader reader;
+  Tetris *tetris = NULL;
+  if (replay_reader_init(&reader, data, size)) {
+    tetris =
+        new_simulation_tetris(reader.header.seed, reader.header.bricks_count);
+  }
+  if (!tetris) {
+    free(data);
+    return NULL;
+  }
+
+  Ghost *self = (Ghost *)calloc(1, sizeof(Ghost));
+  if (!self) {
+    fprintf(stderr, "Cannot allocate mem for Ghost\n");
+    exit(-1);
+  }
+
+  self->data = data;
+  self->size = size;
+  self->tetris = tetris;
+
+  self->restart = _restart;
+  self->advance = _advance;
+  self->destroy = _destroy;
+
+  self->restart(self);
+  return self;
+}
+
+/**
+ * @brief Creates a ghost from a replay file.
+ *
+ * @param filename The replay file.
+ * @return A pointer to the newly created Ghost instance or NULL if the file
+ * cannot be read or is not a replay.
+ */
+Ghost *load_ghost(const char *filename) {
+  size_t size = 0;
+  uint8_t *data = read_replay_file(filename, &size);
+  return data ? new_ghost(data, size) : NULL;
+}
@@ -0,0 +1,68 @@
+#ifndef BRICKGAME_TETRIS_GHOST_GHOST_H
+#define BRICKGAME_TETRIS_GHOST_GHOST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../tetris.h"
+
+/**
+ * @brief A recorded game played back next to a live game.
+ *
+ * The ghost owns an encoded replay and a simulation engine. The replay is
+ * decoded one event at a time while the ghost clock advances, so a ghost never
+ * allocates once it is created and any number of frames can be played.
+ *
+ * @struct __ghost
+ * @var data The encoded replay, owned by the ghost.
+ * @var size The size of the encoded replay.
+ * @var reader The reader decoding the replay.
+ * @var tetris The simulation engine playing the replay.
+ * @var now_ns The ghost clock, the time elapsed since the replay start.
+ * @var is_finished Whether all events of the replay were played.
+ * @var _event_ns The replay time of the last played event.
+ * @var _pending The decoded event waiting for the ghost clock.
+ * @var _has_pending Whether `_pending` holds an event.
+ * @var restart Function pointer restarting the replay from its first event.
+ * @var advance Function pointer moving the ghost clock forward and playing
+ * every event due by then.
+ * @var destroy Function pointer freeing the ghost.
+ */
+typedef struct __ghost {
+  uint8_t *data;
+  size_t size;
+  ReplayReader reader;
+  Tetris *tetris;
+
+  long long now_ns;
+  bool is_finished;
+  long long _event_ns;
+  ReplayEvent _pending;
+  bool _has_pending;
+
+  void (*restart)(struct __ghost *self);
+  void (*advance)(struct __ghost *self, long long dt_ns);
+  void (*destroy)(struct __ghost *self);
+} Ghost;
+
+/**
+ * @brief Creates a ghost from an encoded replay.
+ *
+ * @param data The encoded replay, the ghost takes ownership of it.
+ * @param size The size of the encoded replay.
+ * @return A pointer to the newly created ghost or NULL if the replay header is
+ * invalid, in which case `data` is freed.
+ */
+Ghost *new_ghost(uint8_t *data, size_t size);
+
+/**
+ * @brief Creates a ghost from a replay file.
+ *
+ * @param filename The replay file.
+ * @return A pointer to the newly created ghost or NULL if the file cannot be
+ * read or is not a replay.
+ */
+Ghost *load_ghost(const char *filename);
+
+#endif  // !BRICKGAME_TETRIS_GHOST_GHOST_H
@@ -0,0 +1,352 @@
+#include "replay.h"
+
+#include "../timer/timer.h"
+
+#define REPLAY_HEADER_SIZE (4 + 1 + 1 + 4 + 4 + 4 + REPLAY_PLAYER_SIZE)
+#define REPLAY_VARINT_MAX_SIZE 10
+
+/**
+ * @brief Writes a little endian 32 bit value.
+ *
+ * @param out Destination buffer, at least 4 bytes.
+ * @param value The value to write.
+ */
+static void put_u32(uint8_t *out, uint32_t value) {
+  for (int i = 0; i < 4; i++) out[i] = (uint8_t)(value >> (8 * i));
+}
+
+/**
+ * @brief Reads a little endian 32 bit value.
+ *
+ * @param in Source buffer, at least 4 bytes.
+ * @return The decoded value.
+ */
+static uint32_t get_u32(const uint8_t *in) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; i++) value |= (uint32_t)in[i] << (8 * i);
+  return value;
+}
+
+/**
+ * @brief Writes an unsigned LEB128 varint.
+ *
+ * @param out Destination buffer, at least REPLAY_VARINT_MAX_SIZE bytes.
+ * @param value The value to write.
+ * @return The number of bytes written.
+ */
+static size_t put_varint(uint8_t *out, uint64_t value) {
+  size_t size = 0;
+  do {
+    uint8_t byte = value & 0x7F;
+    value >>= 7;
+    out[size++] = byte | (value ? 0x80 : 0);
+  } while (value);
+  return size;
+}
+
+/**
+ * @brief Reads an unsigned LEB128 varint.
+ *
+ * @param in Source buffer.
+ * @param size Bytes available in the source buffer.
+ * @param value Where to store the decoded value.
+ * @return The number of bytes consumed or 0 on malformed input.
+ */
+static size_t get_varint(const uint8_t *in, size_t size, uint64_t *value) {
+  uint64_t result = 0;
+  size_t used = 0;
+  bool is_done = false;
+  while (!is_done && used < size && used < REPLAY_VARINT_MAX_SIZE) {
+    result |= (uint64_t)(in[used] & 0x7F) << (7 * used);
+    is_done = !(in[used] & 0x80);
+    used++;
+  }
+  if (is_done) *value = result;
+  return is_done ? used : 0;
+}
+
+/**
+ * @brief Initializes a reader over an encoded replay and decodes its header.
+ *
+ * @param reader The reader to initialize.
+ * @param data The encoded replay.
+ * @param size The size of the encoded replay in bytes.
+ * @return true if the header is valid, false otherwise.
+ */
+bool replay_reader_init(ReplayReader *reader, const uint8_t *data,
+                        size_t size) {
+  if (!reader || !data || size < REPLAY_HEADER_SIZE) return false;
+  if (memcmp(data, REPLAY_MAGIC, 4) || data[4] != REPLAY_VERSION) return false;
+
+  *reader = (ReplayReader){.data = data, .size = size};
+  reader->header.bricks_count = data[5];
+  reader->header.seed = get_u32(data + 6);
+  reader->header.score = (int32_t)get_u32(data + 10);
+  reader->header.events_count = get_u32(data + 14);
+  memcpy(reader->header.player, data + 18, REPLAY_PLAYER_SIZE);
+  reader->header.player[REPLAY_PLAYER_SIZE - 1] = '\0';
+  reader->offset = REPLAY_HEADER_SIZE;
+  return true;
+}
+
+/**
+ * @brief Decodes the next event of a replay.
+ *
+ * Events are stored as a varint time delta followed by a one byte code.
+ *
+ * @param reader The reader.
+ * @param event Where to store the decoded event.
+ * @return true if an event was decoded, false at the end of the replay or on
+ * malformed input.
+ */
+bool replay_reader_next(ReplayReader *reader, ReplayEvent *event) {
+  if (!reader || !event) return false;
+  if (reader->events_read >= reader->header.events_count) return false;
+
+  size_t used = get_varint(reader->data + reader->offset,
+                           reader->size - reader->offset, &event->dt_ns);
+  if (!used || reader->offset + used >= reader->size) return false;
+
+  event->code = reader->data[reader->offset + used];
+  reader->offset += used + 1;
+  reader->events_read++;
+  return true;
+}
+
+/**
+ * @brief Starts a new recording, dropping the events recorded before.
+ *
+ * @param self A pointer to the Replay instance.
+ * @param seed The state of the brick generator at the game start.
+ * @param bricks_count The number of bricks in the repository.
+ * @param now The time of the game start.
+ */
+static void _begin(Replay *self, uint32_t seed, size_t bricks_count,
+                   struct timespec now) {
+  if (!self) return;
+  self->header.seed = seed;
+  self->header.bricks_count = (uint8_t)bricks_count;
+  self->header.score = 0;
+  self->header.events_count = 0;
+  self->_last_event = now;
+  self->is_recording = true;
+}
+
+/**
+ * @brief Appends an event to the recording.
+ *
+ * The events array grows geometrically, so recording is amortized O(1).
+ *
+ * @param self A pointer to the Replay instance.
+ * @param code The event code.
+ * @param now The time of the event.
+ */
+static void _record(Replay *self, uint8_t code, struct timespec now) {
+  if (!self || !self->is_recording) return;
+
+  if (self->header.events_count >= self->events_capacity) {
+    size_t capacity = self->events_capacity ? self->events_capacity * 2 : 1024;
+    ReplayEvent *events = realloc(self->events, sizeof(ReplayEvent) * capacity);
+    if (!events) return;
+    self->events = events;
+    self->events_capacity = capacity;
+  }
+
+  long long dt_ns = timespec_diff_ns(now, self->_last_event);
+  self->events[self->header.events_count++] =
+      (ReplayEvent){.dt_ns = dt_ns > 0 ? (uint64_t)dt_ns : 0, .code = code};
+  self->_last_event = now;
+}
+
+/**
+ * @brief Serializes the replay into a newly allocated buffer.
+ *
+ * @param self A pointer to the Replay instance.
+ * @param size Where to store the size of the buffer.
+ * @return A malloc'ed buffer or NULL on failure.
+ */
+static uint8_t *_encode(const Replay *self, size_t *size) {
+  if (!self || !size) return NULL;
+
+  size_t capacity = REPLAY_HEADER_SIZE +
+                    self->header.events_count * (REPLAY_VARINT_MAX_SIZE + 1);
+  uint8_t *buffer = malloc(capacity);
+  if (!buffer) return NULL;
+
+  memcpy(buffer, REPLAY_MAGIC, 4);
+  buffer[4] = REPLAY_VERSION;
+  buffer[5] = self->header.bricks_count;
+  put_u32(buffer + 6, self->header.seed);
+  put_u32(buffer + 10, (uint32_t)self->header.score);
+  put_u32(buffer + 14, self->header.events_count);
+  size_t player_length = 0;
+  while (player_length < REPLAY_PLAYER_SIZE - 1 &&
+         self->header.player[player_length]) {
+    player_length++;
+  }
+  memset(buffer + 18, 0, REPLAY_PLAYER_SIZE);
+  memcpy(buffer + 18, self->header.player, player_length);
+
+  size_t offset = REPLAY_HEADER_SIZE;
+  for (size_t i = 0; i < self->header.events_count; i++) {
+    offset += put_varint(buffer + offset, self->events[i].dt_ns);
+    buffer[offset++] = self->events[i].code;
+  }
+
+  *size = offset;
+  return buffer;
+}
+
+/**
+ * @brief Writes the replay to a file.
+ *
+ * @param self A pointer to the Replay instance.
+ * @param filename The file to write.
+ * @return true on success, false otherwise.
+ */
+static bool _save(const Replay *self, const char *filename) {
+  size_t size = 0;
+  uint8_t *buffer = self ? self->encode(self, &size) : NULL;
+  if (!buffer) return false;
+
+  bool is_success = false;
+  FILE *file = fopen(filename, "wb");
+  if (file) {
+    is_success = fwrite(buffer, 1, size, file) == size;
+    fclose(file);
+  }
+  free(buffer);
+  return is_success;
+}
+
+/**
+ * @brief Frees a Replay instance and its events.
+ *
+ * @param self A pointer to the Replay instance.
+ */
+static void _destroy(Replay *self) {
+  if (!self) return;
+  free(self->events);
+  self->events = NULL;
+  free(self);
+}
+
+/**
+ * @brief Allocates and initializes an empty Replay instance.
+ *
+ * If memory allocation fails, the function prints an error message to stderr
+ * and exits the program with a failure status.
+ *
+ * @return A pointer to the newly created Replay instance.
+ */
+Replay *new_replay() {
+  Replay *self = (Replay *)malloc(sizeof(Replay));
+  if (!self) {
+    fprintf(stderr, "Cannot allocate mem for Replay\n");
+    exit(-1);
+  }
+
+  *self = (Replay){.header = {.bricks_count = 0},
+                   .events = NULL,
+                   .events_capacity = 0,
+                   .is_recording = false};
+  self->begin = _begin;
+  self->record = _record;
+  self->encode = _encode;
+  self->save = _save;
+  self->destroy = _destroy;
+  return self;
+}
+
+/**
+ * @brief Decodes a replay from a buffer into a new Replay instance.
+ *
+ * An event takes two bytes at least, so a header counting more events than
+ * the buffer can hold is rejected before the events are allocated.
+ *
+ * @param data The encoded replay.
+ * @param size The size of the encoded replay in bytes.
+ * @return A new Replay instance or NULL if the buffer is malformed.
+ */
+Replay *decode_replay(const uint8_t *data, size_t size) {
+  ReplayReader reader;
+  if (!replay_reader_init(&reader, data, size)) return NULL;
+  if (reader.header.events_count > (size - REPLAY_HEADER_SIZE) / 2) {
+    return NULL;
+  }
+
+  Replay *self = new_replay();
+  self->header = reader.header;
+  self->header.events_count = 0;
+  self->events_capacity = reader.header.events_count;
+  self->events = malloc(sizeof(ReplayEvent) * (self->events_capacity + 1));
+
+  ReplayEvent event;
+  while (self->events && replay_reader_next(&reader, &event)) {
+    self->events[self->header.events_count++] = event;
+  }
+
+  if (!self->events ||
+      self->header.events_count != reader.header.events_count) {
+    self->destroy(self);
+    self = NULL;
+  }
+  return self;
+}
+
+/**
+ * @brief Reads a whole file into memory.
+ *
+ * @param filename The file to read.
+ * @param size Where to store the size of the file.
+ * @return A malloc'ed buffer with the file content or NULL on failure.
+ */
+uint8_t *read_replay_file(const char *filename, size_t *size) {
+  FILE *file = filename ? fopen(filename, "rb") : NULL;
+  if (!file) return NULL;
+
+  uint8_t *buffer = NULL;
+  long length = -1;
+  if (!fseek(file, 0, SEEK_END)) length = ftell(file);
+  if (length > 0 && !fseek(file, 0, SEEK_SET)) {
+    buffer = malloc(length);
+    if (buffer && fread(buffer, 1, length, file) != (size_t)length) {
+      free(buffer);
+      buffer = NULL;
+    }
+  }
+  fclose(file);
+
+  if (buffer && size) *size = (size_t)length;
+  return buffer;
+}
+
+/**
+ * @brief Loads a replay from a file.
+ *
+ * @param filename The file to read.
+ * @return A new Replay instance or NULL if the file cannot be read or is
+ * malformed.
+ */
+Replay *load_replay(const char *filename) {
+  size_t size = 0;
+  uint8_t *buffer = read_replay_file(filename, &size);
+  Replay *replay = buffer ? decode_replay(buffer, size) : NULL;
+  free(buffer);
+  return replay;
+}
+
+/**
+ * @brief Returns a short human readable description of a verdict.
+ *
+ * @param verdict The verdict.
+ * @return A static string.
+ */
+const char *replay_verdict_str(enum ReplayVerdict verdict) {
+  static const char *names[] = {"ok", "malformed replay", "unknown brick set",
+                                "implausible timing", "score mismatch"};
+  return (verdict >= REPLAY_VERDICT_OK &&
+          verdict <= REPLAY_VERDICT_SCORE_MISMATCH)
+             ? names[verdict]
+             : "unknown";
+}
@@ -0,0 +1,211 @@
+#ifndef BRICKGAME_TETRIS_REPLAY_REPLAY_H
+#define BRICKGAME_TETRIS_REPLAY_REPLAY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define REPLAY_MAGIC "S21R"
+#define REPLAY_VERSION 3
+#define REPLAY_PLAYER_SIZE 16
+
+/**
+ * @brief Event codes stored in a replay.
+ *
+ * A replay is a log of everything that drives the engine: every call of the
+ * engine tick and every user action, each with the time elapsed since the
+ * previous event. Action codes are `UserAction_t + REPLAY_CODE_ACTION`, the
+ * hold flag is stored in the `REPLAY_CODE_HOLD` bit.
+ */
+enum ReplayCode {
+  REPLAY_CODE_TICK = 0,
+  REPLAY_CODE_ACTION = 1,
+  REPLAY_CODE_HOLD = 0x80,
+};
+
+/**
+ * @brief Header of a replay.
+ *
+ * @struct ReplayHeader
+ * @var seed The state of the brick repository generator at the game start.
+ * @var bricks_count The number of bricks in the repository at the game start
+ * (7 for the default set, 9 when custom bricks were added).
+ * @var score The final score recorded by the game (informational only, a
+ * validator trusts the simulation, not this field).
+ * @var events_count The number of events following the header.
+ * @var player Name of the player, zero terminated.
+ */
+typedef struct {
+  uint32_t seed;
+  uint8_t bricks_count;
+  int32_t score;
+  uint32_t events_count;
+  char player[REPLAY_PLAYER_SIZE];
+} ReplayHeader;
+
+/**
+ * @brief A single replay event.
+ *
+ * @struct ReplayEvent
+ * @var dt_ns Nanoseconds elapsed since the previous event (or the game start).
+ * @var code The event code, see `enum ReplayCode`.
+ */
+typedef struct {
+  uint64_t dt_ns;
+  uint8_t code;
+} ReplayEvent;
+
+/**
+ * @brief Incremental replay decoder.
+ *
+ * The reader walks an encoded replay in place and never allocates, so it can
+ * be used to stream a replay alongside a running game.
+ *
+ * @struct ReplayReader
+ * @var data The encoded replay.
+ * @var size The size of the encoded replay in bytes.
+ * @var offset The offset of the next event.
+ * @var header The decoded header.
+ * @var events_read The number of events decoded so far.
+ */
+typedef struct {
+  const uint8_t *data;
+  size_t size;
+  size_t offset;
+  ReplayHeader header;
+  uint32_t events_read;
+} ReplayReader;
+
+/**
+ * @brief Initializes a reader over an encoded replay and decodes its header.
+ *
+ * @param reader The reader to initialize.
+ * @param data The encoded replay.
+ * @param size The size of the encoded replay in bytes.
+ * @return true if the header is valid, false otherwise.
+ */
+bool replay_reader_init(ReplayReader *reader, const uint8_t *data,
+                        size_t size);
+
+/**
+ * @brief Decodes the next event of a replay.
+ *
+ * @param reader The reader.
+ * @param event Where to store the decoded event.
+ * @return true if an event was decoded, false at the end of the replay or on
+ * malformed input.
+ */
+bool replay_reader_next(ReplayReader *reader, ReplayEvent *event);
+
+/**
+ * @brief Structure representing a replay recorder and container.
+ *
+ * @struct Replay
+ * @var header The replay header.
+ * @var events The recorded events.
+ * @var events_capacity The allocated capacity of `events`.
+ * @var is_recording Whether the replay currently records events.
+ * @var _last_event Time of the last recorded event.
+ * @var begin A function pointer starting a new recording, dropping the
+ * previous one.
+ * @var record A function pointer appending an event.
+ * @var encode A function pointer serializing the replay into a new buffer.
+ * @var save A function pointer writing the replay to a file.
+ * @var destroy A function pointer freeing the replay.
+ */
+typedef struct __replay {
+  ReplayHeader header;
+  ReplayEvent *events;
+  size_t events_capacity;
+
+  bool is_recording;
+  struct timespec _last_event;
+
+  void (*begin)(struct __replay *self, uint32_t seed, size_t bricks_count,
+                struct timespec now);
+  void (*record)(struct __replay *self, uint8_t code, struct timespec now);
+  uint8_t *(*encode)(const struct __replay *self, size_t *size);
+  bool (*save)(const struct __replay *self, const char *filename);
+  void (*destroy)(struct __replay *self);
+} Replay;
+
+/**
+ * @brief Creates an empty replay.
+ *
+ * @return A pointer to the newly created Replay instance.
+ */
+Replay *new_replay();
+
+/**
+ * @brief Decodes a replay from a buffer.
+ *
+ * @param data The encoded replay.
+ * @param size The size of the encoded replay in bytes.
+ * @return A new Replay instance or NULL if the buffer is malformed.
+ */
+Replay *decode_replay(const uint8_t *data, size_t size);
+
+/**
+ * @brief Reads a whole file into memory.
+ *
+ * @param filename The file to read.
+ * @param size Where to store the size of the file.
+ * @return A malloc'ed buffer with the file content or NULL on failure.
+ */
+uint8_t *read_replay_file(const char *filename, size_t *size);
+
+/**
+ * @brief Loads a replay from a file.
+ *
+ * @param filename The file to read.
+ * @return A new Replay instance or NULL if the file cannot be read or is
+ * malformed.
+ */
+Replay *load_replay(const char *filename);
+
+/**
+ * @brief Reasons a replay simulation can be rejected for.
+ */
+enum ReplayVerdict {
+  REPLAY_VERDICT_OK = 0,
+  REPLAY_VERDICT_MALFORMED,
+  REPLAY_VERDICT_BAD_BRICKS,
+  REPLAY_VERDICT_BAD_TIMING,
+  REPLAY_VERDICT_SCORE_MISMATCH,
+};
+
+/**
+ * @brief Result of a replay simulation.
+ *
+ * @struct ReplaySimulation
+ * @var verdict The verdict of the simulation.
+ * @var score The score reached by the simulated game.
+ * @var level The level reached by the simulated game.
+ * @var ticks The number of tick events simulated.
+ * @var actions The number of action events simulated.
+ * @var duration_ns The virtual duration of the game.
+ * @var state The final state of the simulated engine (`TetriState`).
+ */
+typedef struct {
+  enum ReplayVerdict verdict;
+  int score;
+  int level;
+  size_t ticks;
+  size_t actions;
+  uint64_t duration_ns;
+  int state;
+} ReplaySimulation;
+
+/**
+ * @brief Returns a short human readable description of a verdict.
+ *
+ * @param verdict The verdict.
+ * @return A static string.
+ */
+const char *replay_verdict_str(enum ReplayVerdict verdict);
+
+#endif  // !BRICKGAME_TETRIS_REPLAY_REPLAY_H
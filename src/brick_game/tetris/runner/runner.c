@@ -0,0 +1,424 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "runner.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/**
+ * @brief Returns the monotonic time.
+ *
+ * @return The time in nanoseconds.
+ */
+static long long runner_now_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ * @brief Checks whether a game is started, not paused and not over.
+ *
+ * @param state The state of the engine.
+ * @return true if the game is running.
+ */
+static bool is_running_state(TetriState state) {
+  return state == TETRIS_SPAWN_STATE || state == TETRIS_MOVING_STATE ||
+         state == TETRIS_ATTACH_STATE;
+}
+
+/**
+ * @brief Returns the latest published snapshot.
+ *
+ * The snapshot stays valid and unchanged until the next call.
+ *
+ * @param self A pointer to the TetrisRunner instance.
+ * @return The snapshot.
+ */
+static const TetrisSnapshot *_latest(TetrisRunner *self) {
+  return tetris_snapshots_latest(&self->_snapshots);
+}
+
+/**
+ * @brief Returns the number of sent commands the latest snapshot does not
+ * reflect yet.
+ *
+ * @param self A pointer to the TetrisRunner instance.
+ * @return The number of commands.
+ */
+static size_t _pending(TetrisRunner *self) {
+  if (!self) return 0;
+  return atomic_load_explicit(&self->_tail, memory_order_relaxed) -
+         tetris_snapshots_front(&self->_snapshots)->input_sequence;
+}
+
+/**
+ * @brief Wakes the engine thread up before its next tick.
+ *
+ * @param self A pointer to the TetrisRunner instance.
+ */
+static void wake_up(TetrisRunner *self) {
+  pthread_mutex_lock(&self->_mutex);
+  self->_is_woken = true;
+  pthread_cond_signal(&self->_wakeup);
+  pthread_mutex_unlock(&self->_mutex);
+}
+
+/**
+ * @brief Puts a command into the queue, never waiting for the engine thread.
+ *
+ * @param self A pointer to the TetrisRunner instance.
+ * @param command The command, sent now unless it carries a sending time.
+ * @return true if the command was queued, false if the queue was full.
+ */
+static bool push_command(TetrisRunner *self, TetrisCommand command) {
+  size_t tail = atomic_load_explicit(&self->_tail, memory_order_relaxed);
+  size_t head = atomic_load_explicit(&self->_head, memory_order_acquire);
+  if (tail - head >= TETRIS_RUNNER_QUEUE_SIZE) {
+    self->stats.dropped++;
+    return false;
+  }
+
+  if (!command.sent_ns) command.sent_ns = runner_now_ns();
+  self->_commands[tail % TETRIS_RUNNER_QUEUE_SIZE] = command;
+  atomic_store_explicit(&self->_tail, tail + 1, memory_order_release);
+  wake_up(self);
+  return true;
+}
+
+/**
+ * @brief Sends a user action to the engine.
+ *
+ * @param self A pointer to the TetrisRunner instance.
+ * @param action The action.
+ * @param hold Whether the action is held.
+ * @return true if the action was queued, false if the queue was full.
+ */
+static bool _send(TetrisRunner *self, UserAction_t action, bool hold) {
+  if (!self) return false;
+  return push_command(self, (TetrisCommand){.type = TETRIS_COMMAND_INPUT,
+                                            .action = action,
+                                            .hold = hold});
+}
+
+/**
+ * @brief Sends a user action that happened at a given time to the engine.
+ *
+ * The time is where the input to state latency of the command starts, so a
+ * key is measured from the moment it was read, not from the moment it was
+ * sent.
+ *
+ * @param self A pointer to the TetrisRunner instance.
+ * @param action The action.
+ * @param hold Whether the action is held.
+ * @param sent_ns The monotonic time of the action, 0 for now.
+ * @return true if the action was queued, false if the queue was full.
+ */
+static bool _send_at(TetrisRunner *self, UserAction_t action, bool hold,
+                     long long sent_ns) {
+  if (!self) return false;
+  return push_command(self, (TetrisCommand){.type = TETRIS_COMMAND_INPUT,
+                                            .action = action,
+                                            .hold = hold,
+                                            .sent_ns = sent_ns});
+}
+
+/**
+ * @brief Sends a user action applied several times in a row to the engine.
+ *
+ * All the moves take a single slot of the queue and reach the engine in the
+ * same tick, so a batch of owed moves is published as one snapshot.
+ *
+ * @param self A pointer to the TetrisRunner instance.
+ * @param action The action.
+ * @param hold Whether the action is held.
+ * @param count The number of times the action is applied.
+ * @param sent_ns The monotonic time of the first of them, 0 for now.
+ * @return true if the action was queued, false if the queue was full.
+ */
+static bool _send_repeated(TetrisRunner *self, UserAction_t action, bool hold,
+                           unsigned long count, long long sent_ns) {
+  if (!self || !count) return false;
+  return push_command(self, (TetrisCommand){.type = TETRIS_COMMAND_INPUT,
+                                            .action = action,
+                                            .hold = hold,
+                                            .count = count,
+                                            .sent_ns = sent_ns});
+}
+
+/**
+ * @brief Sends a function to run with the engine on the engine thread.
+ *
+ * @param self A pointer to the TetrisRunner instance.
+ * @param call The function.
+ * @return true if the function was queued, false if the queue was full.
+ */
+static bool _call(TetrisRunner *self, void (*call)(Tetris *tetris)) {
+  if (!self || !call) return false;
+  return push_command(
+      self, (TetrisCommand){.type = TETRIS_COMMAND_CALL, .call = call});
+}
+
+/**
+ * @brief Applies every queued command to the engine.
+ *
+ * @param self A pointer to the TetrisRunner instance.
+ * @param sent_ns Where the sending times of the applied commands are stored.
+ * @return The number of applied commands.
+ */
+static size_t apply_commands(TetrisRunner *self, long long *sent_ns) {
+  size_t head = atomic_load_explicit(&self->_head, memory_order_relaxed);
+  size_t tail = atomic_load_explicit(&self->_tail, memory_order_acquire);
+
+  size_t count = 0;
+  for (; head != tail; head++, count++) {
+    TetrisCommand command = self->_commands[head % TETRIS_RUNNER_QUEUE_SIZE];
+    if (command.type == TETRIS_COMMAND_INPUT) {
+      unsigned long repeats = command.count ? command.count : 1;
+      for (unsigned long i = 0; i < repeats; i++) {
+        tetris_user_input(self->tetris, command.action, command.hold);
+      }
+    } else {
+      command.call(self->tetris);
+    }
+    sent_ns[count] = command.sent_ns;
+    self->_input_sequence++;
+  }
+
+  atomic_store_explicit(&self->_head, head, memory_order_release);
+  return count;
+}
+
+/**
+ * @brief Advances the raced ghost with the engine clock.
+ *
+ * The ghost restarts with every live game and its clock only runs while the
+ * live game runs, so both games see the same elapsed time.
+ *
+ * @param self A pointer to the TetrisRunner instance.
+ */
+static void race_ghost(TetrisRunner *self) {
+  Tetris *tetris = self->tetris;
+  struct timespec now = tetris->timer.now(&tetris->timer);
+  if (is_running_state(tetris->state)) {
+    if (self->_ghost_state == TETRIS_READY_STATE ||
+        self->_ghost_state == TETRIS_GAMEOVER_STATE) {
+      self->ghost->restart(self->ghost);
+    } else if (self->_ghost_state != TETRIS_PAUSE_STATE) {
+      self->ghost->advance(self->ghost,
+                           timespec_diff_ns(now, self->_ghost_time));
+    }
+  }
+
+  self->_ghost_state = tetris->state;
+  self->_ghost_time = now;
+}
+
+/**
+ * @brief Sleeps until a monotonic time or until a command arrives.
+ *
+ * @param self A pointer to the TetrisRunner instance.
+ * @param deadline_ns The monotonic time, 0 to sleep until a command arrives.
+ * @return false if the runner is stopping.
+ */
+static bool wait_until(TetrisRunner *self, long long deadline_ns) {
+  struct timespec deadline = {.tv_sec = deadline_ns / 1000000000LL,
+                              .tv_nsec = deadline_ns % 1000000000LL};
+
+  pthread_mutex_lock(&self->_mutex);
+  while (!self->_is_woken && !self->_is_stopping) {
+    if (!deadline_ns) {
+      pthread_cond_wait(&self->_wakeup, &self->_mutex);
+    } else if (pthread_cond_timedwait(&self->_wakeup, &self->_mutex,
+                                      &deadline) == ETIMEDOUT) {
+      break;
+    }
+  }
+  self->_is_woken = false;
+  bool is_stopping = self->_is_stopping;
+  pthread_mutex_unlock(&self->_mutex);
+  return !is_stopping;
+}
+
+/**
+ * @brief The engine thread: applies the commands as they arrive, ticks the
+ * engine at the fixed rate and publishes a snapshot after every change. Ticks
+ * that change nothing publish nothing.
+ *
+ * A tick running late is counted as jitter, ticks missed altogether are
+ * skipped. A game that is not running, before the start, paused or over, only
+ * changes on commands: the engine does not tick and the thread sleeps until
+ * the next command. The thread ends once the engine is terminated.
+ *
+ * @param arg A pointer to the TetrisRunner instance.
+ * @return NULL.
+ */
+static void *run_engine(void *arg) {
+  TetrisRunner *self = (TetrisRunner *)arg;
+  long long period_ns = 1000000000LL / self->rate;
+  long long deadline_ns = runner_now_ns() + period_ns;
+  long long sent_ns[TETRIS_RUNNER_QUEUE_SIZE];
+
+  bool is_running = true;
+  while (is_running) {
+    size_t count = apply_commands(self, sent_ns);
+
+    long long now_ns = runner_now_ns();
+    bool is_tick = now_ns >= deadline_ns;
+    if (is_tick) {
+      long long jitter_ns = now_ns - deadline_ns;
+      self->stats.ticks++;
+      self->stats.jitter_ns += jitter_ns;
+      if (jitter_ns > self->stats.max_jitter_ns) {
+        self->stats.max_jitter_ns = jitter_ns;
+      }
+
+      if (self->ghost) race_ghost(self);
+      tetris_update_state(self->tetris);
+
+      deadline_ns += period_ns;
+      if (deadline_ns <= now_ns) deadline_ns = now_ns + period_ns;
+    }
+
+    if (count ||
+        tetris_snapshots_is_stale(&self->_snapshots, self->tetris,
+                                  self->ghost)) {
+      long long published_ns = tetris_snapshots_publish(
+          &self->_snapshots, self->tetris, self->ghost, self->_input_sequence);
+      // a full pipe is readable already, the byte is not needed then
+      if (self->_published_write_fd >= 0) {
+        ssize_t written = write(self->_published_write_fd, "", 1);
+        (void)written;
+      }
+      for (size_t i = 0; i < count; i++) {
+        long long latency_ns = published_ns - sent_ns[i];
+        self->stats.commands++;
+        self->stats.latency_ns += latency_ns;
+        if (latency_ns > self->stats.max_latency_ns) {
+          self->stats.max_latency_ns = latency_ns;
+        }
+      }
+    }
+
+    bool is_idle = !is_running_state(self->tetris->state);
+    is_running = self->tetris->state != TETRIS_TERMINATED_STATE &&
+                 wait_until(self, is_idle ? 0 : deadline_ns);
+    if (is_idle) deadline_ns = runner_now_ns() + period_ns;
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Publishes the current engine state and starts the engine thread.
+ *
+ * @param self A pointer to the TetrisRunner instance.
+ * @return 0 on success, -1 if the thread cannot be created.
+ */
+static int _start(TetrisRunner *self) {
+  if (!self || self->_is_running) return -1;
+
+  tetris_snapshots_fill(&self->_snapshots, self->tetris, self->ghost,
+                        self->_input_sequence);
+  self->_is_stopping = false;
+  if (pthread_create(&self->_thread, NULL, run_engine, self)) return -1;
+  self->_is_running = true;
+  return 0;
+}
+
+/**
+ * @brief Stops and joins the engine thread.
+ *
+ * Commands still in the queue are left unapplied.
+ *
+ * @param self A pointer to the TetrisRunner instance.
+ */
+static void _stop(TetrisRunner *self) {
+  if (!self || !self->_is_running) return;
+
+  pthread_mutex_lock(&self->_mutex);
+  self->_is_stopping = true;
+  pthread_cond_signal(&self->_wakeup);
+  pthread_mutex_unlock(&self->_mutex);
+
+  pthread_join(self->_thread, NULL);
+  self->_is_running = false;
+}
+
+/**
+ * @brief Stops the engine thread and frees the runner.
+ *
+ * @param self A pointer to the TetrisRunner instance.
+ */
+static void _destroy(TetrisRunner *self) {
+  if (!self) return;
+  _stop(self);
+  if (self->published_fd >= 0) close(self->published_fd);
+  if (self->_published_write_fd >= 0) close(self->_published_write_fd);
+  pthread_cond_destroy(&self->_wakeup);
+  pthread_mutex_destroy(&self->_mutex);
+  free(self);
+}
+
+/**
+ * @brief Creates a runner for an engine.
+ *
+ * The wakeup condition waits on the monotonic clock, the tick deadlines do
+ * not move with the wall clock. Both ends of the published pipe are
+ * non-blocking, the engine thread never waits for its reader.
+ *
+ * @param tetris The engine, it must not be used by anyone else between
+ * `start` and `stop`.
+ * @param ghost The ghost raced against the engine or NULL.
+ * @param rate The number of ticks per second, 0 for `TETRIS_RUNNER_RATE`.
+ * @return A pointer to the newly created runner.
+ */
+TetrisRunner *new_tetris_runner(Tetris *tetris, Ghost *ghost, int rate) {
+  TetrisRunner *self = (TetrisRunner *)calloc(1, sizeof(TetrisRunner));
+  if (!self) {
+    fprintf(stderr, "Cannot allocate mem for TetrisRunner\n");
+    exit(-1);
+  }
+
+  self->tetris = tetris;
+  self->ghost = ghost;
+  self->rate = rate > 0 ? rate : TETRIS_RUNNER_RATE;
+
+  tetris_snapshots_init(&self->_snapshots);
+  atomic_init(&self->_head, 0);
+  atomic_init(&self->_tail, 0);
+
+  pthread_condattr_t attributes;
+  pthread_condattr_init(&attributes);
+  pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+  pthread_cond_init(&self->_wakeup, &attributes);
+  pthread_condattr_destroy(&attributes);
+  pthread_mutex_init(&self->_mutex, NULL);
+  self->_ghost_state = TETRIS_READY_STATE;
+
+  int published[2];
+  self->published_fd = -1;
+  self->_published_write_fd = -1;
+  if (!pipe(published)) {
+    for (int i = 0; i < 2; i++) {
+      fcntl(published[i], F_SETFL, fcntl(published[i], F_GETFL) | O_NONBLOCK);
+      fcntl(published[i], F_SETFD, FD_CLOEXEC);
+    }
+    self->published_fd = published[0];
+    self->_published_write_fd = published[1];
+  }
+
+  self->start = _start;
+  self->send = _send;
+  self->send_at = _send_at;
+  self->send_repeated = _send_repeated;
+  self->call = _call;
+  self->latest = _latest;
+  self->pending = _pending;
+  self->stop = _stop;
+  self->destroy = _destroy;
+  return self;
+}
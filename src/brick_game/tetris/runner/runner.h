@@ -0,0 +1,161 @@
+#ifndef BRICKGAME_TETRIS_RUNNER_RUNNER_H
+#define BRICKGAME_TETRIS_RUNNER_RUNNER_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+#include "../ghost/ghost.h"
+#include "../tetris.h"
+#include "snapshot.h"
+
+#define TETRIS_RUNNER_RATE 60
+#define TETRIS_RUNNER_QUEUE_SIZE 64
+
+/**
+ * @brief Enumeration of the commands sent to a running engine.
+ *
+ * @enum TetrisCommandType
+ * @var TETRIS_COMMAND_INPUT A user action, recorded into the replay.
+ * @var TETRIS_COMMAND_CALL A function called with the engine on the engine
+ * thread, for everything that is not a user action.
+ */
+typedef enum {
+  TETRIS_COMMAND_INPUT = 0,
+  TETRIS_COMMAND_CALL,
+} TetrisCommandType;
+
+/**
+ * @brief A command waiting in the queue of a running engine.
+ *
+ * @struct TetrisCommand
+ * @var type The type of the command.
+ * @var action The user action of an input command.
+ * @var hold Whether the user action is held.
+ * @var count The number of times the user action is applied, 0 counts as 1.
+ * @var call The function of a call command.
+ * @var sent_ns The monotonic time the command was sent at.
+ */
+typedef struct {
+  TetrisCommandType type;
+  UserAction_t action;
+  bool hold;
+  unsigned long count;
+  void (*call)(Tetris *tetris);
+  long long sent_ns;
+} TetrisCommand;
+
+/**
+ * @brief Counters of a running engine.
+ *
+ * @struct TetrisRunnerStats
+ * @var ticks Number of engine ticks.
+ * @var jitter_ns Total delay of the ticks after their schedule.
+ * @var max_jitter_ns The longest delay of a tick after its schedule.
+ * @var commands Number of applied commands.
+ * @var latency_ns Total time from sending a command to publishing the snapshot
+ * it is applied in.
+ * @var max_latency_ns The longest time from sending a command to publishing
+ * its snapshot.
+ * @var dropped Number of commands dropped because the queue was full.
+ */
+typedef struct {
+  unsigned long ticks;
+  long long jitter_ns;
+  long long max_jitter_ns;
+  unsigned long commands;
+  long long latency_ns;
+  long long max_latency_ns;
+  unsigned long dropped;
+} TetrisRunnerStats;
+
+/**
+ * @brief Runs an engine on its own thread at a fixed rate.
+ *
+ * The engine thread is the only one touching the engine once it is started.
+ * User actions reach it through a single producer, single consumer queue that
+ * never blocks the sender, and the engine state leaves it as snapshots in a
+ * triple buffer, see `TetrisSnapshots`. A snapshot is only published when a
+ * command was applied or the generation of the engine or the ghost grew, and
+ * a game that is not running is not ticked at all. Neither thread ever waits
+ * for the other, so a slow terminal delays frames but never the engine ticks,
+ * and a key is applied as soon as it is sent. A raced ghost advances on the
+ * engine thread with the same clock as the engine.
+ *
+ * Every published snapshot also makes `published_fd` readable, so the reading
+ * thread can sleep in `poll` until there is something new to show instead of
+ * checking for it at a fixed rate.
+ *
+ * @struct __tetris_runner
+ * @var tetris The engine, owned by the caller.
+ * @var ghost The raced ghost or NULL, owned by the caller.
+ * @var rate The number of ticks per second.
+ * @var stats Counters of the engine thread, read them after `stop`.
+ * @var published_fd Descriptor that becomes readable when a snapshot is
+ * published, the reader empties it, or -1 if it could not be created.
+ * @var _published_write_fd The write end of the `published_fd` pipe.
+ * @var start Function pointer starting the engine thread.
+ * @var send Function pointer sending a user action to the engine.
+ * @var send_at Function pointer sending a user action that happened at a
+ * given monotonic time, such as the time its key was read at.
+ * @var send_repeated Function pointer sending a user action applied several
+ * times in a row as a single command, such as the owed moves of a held key.
+ * @var call Function pointer sending a function to run on the engine thread.
+ * @var latest Function pointer returning the latest published snapshot.
+ * @var pending Function pointer returning the number of sent commands the
+ * snapshot returned by `latest` does not reflect yet.
+ * @var stop Function pointer stopping and joining the engine thread.
+ * @var destroy Function pointer freeing the runner, the engine is left alone.
+ */
+typedef struct __tetris_runner {
+  Tetris *tetris;
+  Ghost *ghost;
+  int rate;
+  TetrisRunnerStats stats;
+  int published_fd;
+
+  int _published_write_fd;
+  TetrisSnapshots _snapshots;
+  unsigned long _input_sequence;
+
+  TetrisCommand _commands[TETRIS_RUNNER_QUEUE_SIZE];
+  atomic_size_t _head;
+  atomic_size_t _tail;
+
+  pthread_t _thread;
+  pthread_mutex_t _mutex;
+  pthread_cond_t _wakeup;
+  bool _is_woken;
+  bool _is_stopping;
+  bool _is_running;
+
+  TetriState _ghost_state;
+  struct timespec _ghost_time;
+
+  int (*start)(struct __tetris_runner *self);
+  bool (*send)(struct __tetris_runner *self, UserAction_t action, bool hold);
+  bool (*send_at)(struct __tetris_runner *self, UserAction_t action, bool hold,
+                  long long sent_ns);
+  bool (*send_repeated)(struct __tetris_runner *self, UserAction_t action,
+                        bool hold, unsigned long count, long long sent_ns);
+  bool (*call)(struct __tetris_runner *self, void (*call)(Tetris *tetris));
+  const TetrisSnapshot *(*latest)(struct __tetris_runner *self);
+  size_t (*pending)(struct __tetris_runner *self);
+  void (*stop)(struct __tetris_runner *self);
+  void (*destroy)(struct __tetris_runner *self);
+} TetrisRunner;
+
+/**
+ * @brief Creates a runner for an engine.
+ *
+ * @param tetris The engine, it must not be used by anyone else between
+ * `start` and `stop`.
+ * @param ghost The ghost raced against the engine or NULL.
+ * @param rate The number of ticks per second, 0 for `TETRIS_RUNNER_RATE`.
+ * @return A pointer to the newly created runner.
+ */
+TetrisRunner *new_tetris_runner(Tetris *tetris, Ghost *ghost, int rate);
+
+#endif  // !BRICKGAME_TETRIS_RUNNER_RUNNER_H
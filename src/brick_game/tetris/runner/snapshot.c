@@ -0,0 +1,237 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "snapshot.h"
+
+#include <time.h>
+
+#define TETRIS_SNAPSHOTS_FRESH 0x4u
+
+/**
+ * @brief Returns the monotonic time.
+ *
+ * @return The time in nanoseconds.
+ */
+static long long snapshots_now_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ * @brief Copies a matrix of cells, a missing matrix is copied as empty cells.
+ *
+ * @param to The copy.
+ * @param from The matrix or NULL.
+ * @param height The number of rows.
+ * @param width The number of columns.
+ */
+static void copy_cells(int *to, int **from, int height, int width) {
+  for (int row = 0; row < height; row++) {
+    for (int col = 0; col < width; col++) {
+      to[row * width + col] = from ? from[row][col] : 0;
+    }
+  }
+}
+
+/**
+ * @brief Checks whether a field cell belongs to the falling brick.
+ *
+ * The brick cells are mapped onto the field the way the engine places them.
+ *
+ * @param brick The falling brick or NULL.
+ * @param row The row of the field cell.
+ * @param col The column of the field cell.
+ * @return true if the cell is a cell of the brick.
+ */
+static bool is_brick_cell(const Brick *brick, int row, int col) {
+  if (!brick) return false;
+  int brick_row = row - (brick->pos.y + (-BRICK_HEIGHT / 2) + 1);
+  int brick_col = col - (brick->pos.x + (-BRICK_WIDTH / 2));
+  return brick_row >= 0 && brick_row < BRICK_HEIGHT && brick_col >= 0 &&
+         brick_col < BRICK_WIDTH &&
+         brick->states[brick->state][brick_row][brick_col];
+}
+
+/**
+ * @brief Measures the height of the locked cells of the field.
+ *
+ * @param field The field of the engine.
+ * @param brick The falling brick or NULL.
+ * @return The number of rows from the bottom up to the highest locked cell.
+ */
+static int measure_stack(int **field, const Brick *brick) {
+  if (!field) return 0;
+  for (int row = 0; row < TETRIS_FIELD_HEIGHT; row++) {
+    for (int col = 0; col < TETRIS_FIELD_WIDTH; col++) {
+      if (field[row][col] && !is_brick_cell(brick, row, col)) {
+        return TETRIS_FIELD_HEIGHT - row;
+      }
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief Returns the generation of the whole state of the raced ghost.
+ *
+ * @param ghost The raced ghost or NULL.
+ * @return The generation, 0 without a ghost.
+ */
+static unsigned long ghost_generation(Ghost *ghost) {
+  return ghost ? ghost->tetris->generation.state : 0;
+}
+
+/**
+ * @brief Copies the engine state into a snapshot.
+ *
+ * The cells the snapshot already holds at their current generation are left
+ * as they are.
+ *
+ * @param self The snapshots.
+ * @param snapshot The snapshot, owned by the engine thread.
+ * @param tetris The engine.
+ * @param ghost The raced ghost or NULL.
+ * @param input_sequence The number of commands applied to the engine.
+ */
+static void take_snapshot(TetrisSnapshots *self, TetrisSnapshot *snapshot,
+                          Tetris *tetris, Ghost *ghost,
+                          unsigned long input_sequence) {
+  GameInfo_t info = tetris->data.info;
+  TetrisGeneration generation = tetris->generation;
+  if (snapshot->generation.field != generation.field) {
+    copy_cells(&snapshot->_field[0][0], info.field, TETRIS_FIELD_HEIGHT,
+               TETRIS_FIELD_WIDTH);
+    snapshot->stack_height =
+        measure_stack(info.field, tetris->data.current_brick);
+  }
+  if (snapshot->generation.next != generation.next) {
+    copy_cells(&snapshot->_next[0][0], info.next, BRICK_HEIGHT, BRICK_WIDTH);
+  }
+  snapshot->generation = generation;
+
+  snapshot->info = info;
+  snapshot->info.field = snapshot->_field_rows;
+  snapshot->info.next = snapshot->_next_rows;
+  snapshot->state = tetris->state;
+  snapshot->sequence = self->_sequence++;
+  snapshot->input_sequence = input_sequence;
+  snapshot->published_ns = snapshots_now_ns();
+
+  snapshot->has_ghost = ghost != NULL;
+  snapshot->ghost_field = NULL;
+  snapshot->ghost_score = 0;
+  if (ghost) {
+    GameInfo_t ghost_info = ghost->tetris->data.info;
+    if (snapshot->ghost_generation != ghost_generation(ghost)) {
+      copy_cells(&snapshot->_ghost[0][0], ghost_info.field,
+                 TETRIS_FIELD_HEIGHT, TETRIS_FIELD_WIDTH);
+    }
+    snapshot->ghost_field = snapshot->_ghost_rows;
+    snapshot->ghost_score = ghost_info.score;
+  }
+  snapshot->ghost_generation = ghost_generation(ghost);
+
+  self->published_generation = generation.state;
+  self->published_ghost_generation = snapshot->ghost_generation;
+}
+
+/**
+ * @brief Prepares empty snapshots: the row pointers of every snapshot point
+ * into its own cells.
+ *
+ * @param self The snapshots.
+ */
+void tetris_snapshots_init(TetrisSnapshots *self) {
+  if (!self) return;
+
+  for (int i = 0; i < TETRIS_SNAPSHOTS_COUNT; i++) {
+    TetrisSnapshot *snapshot = &self->_snapshots[i];
+    for (int row = 0; row < TETRIS_FIELD_HEIGHT; row++) {
+      snapshot->_field_rows[row] = snapshot->_field[row];
+      snapshot->_ghost_rows[row] = snapshot->_ghost[row];
+    }
+    for (int row = 0; row < BRICK_HEIGHT; row++) {
+      snapshot->_next_rows[row] = snapshot->_next[row];
+    }
+  }
+  self->_front = 0;
+  atomic_init(&self->_middle, 1);
+  self->_back = 2;
+}
+
+/**
+ * @brief Copies the engine state into the front snapshot.
+ *
+ * @param self The snapshots.
+ * @param tetris The engine.
+ * @param ghost The raced ghost or NULL.
+ * @param input_sequence The number of commands applied to the engine.
+ */
+void tetris_snapshots_fill(TetrisSnapshots *self, Tetris *tetris, Ghost *ghost,
+                           unsigned long input_sequence) {
+  if (!self || !tetris) return;
+  take_snapshot(self, &self->_snapshots[self->_front], tetris, ghost,
+                input_sequence);
+}
+
+/**
+ * @brief Checks whether the engine or the ghost changed since the last
+ * published snapshot.
+ *
+ * @param self The snapshots.
+ * @param tetris The engine.
+ * @param ghost The raced ghost or NULL.
+ * @return true if a new snapshot would differ from the published one.
+ */
+bool tetris_snapshots_is_stale(TetrisSnapshots *self, Tetris *tetris,
+                               Ghost *ghost) {
+  return tetris->generation.state != self->published_generation ||
+         ghost_generation(ghost) != self->published_ghost_generation;
+}
+
+/**
+ * @brief Publishes the engine state: the back snapshot is filled and swapped
+ * with the middle one.
+ *
+ * @param self The snapshots.
+ * @param tetris The engine.
+ * @param ghost The raced ghost or NULL.
+ * @param input_sequence The number of commands applied to the engine.
+ * @return The publishing time of the snapshot.
+ */
+long long tetris_snapshots_publish(TetrisSnapshots *self, Tetris *tetris,
+                                   Ghost *ghost, unsigned long input_sequence) {
+  TetrisSnapshot *snapshot = &self->_snapshots[self->_back];
+  take_snapshot(self, snapshot, tetris, ghost, input_sequence);
+  self->_back = atomic_exchange_explicit(&self->_middle,
+                                         self->_back | TETRIS_SNAPSHOTS_FRESH,
+                                         memory_order_acq_rel) &
+                ~TETRIS_SNAPSHOTS_FRESH;
+  return snapshot->published_ns;
+}
+
+/**
+ * @brief Returns the latest published snapshot.
+ *
+ * @param self The snapshots.
+ * @return The snapshot.
+ */
+const TetrisSnapshot *tetris_snapshots_latest(TetrisSnapshots *self) {
+  if (atomic_load_explicit(&self->_middle, memory_order_relaxed) &
+      TETRIS_SNAPSHOTS_FRESH) {
+    self->_front = atomic_exchange_explicit(&self->_middle, self->_front,
+                                            memory_order_acq_rel) &
+                   ~TETRIS_SNAPSHOTS_FRESH;
+  }
+  return &self->_snapshots[self->_front];
+}
+
+/**
+ * @brief Returns the snapshot returned by the last `tetris_snapshots_latest`.
+ *
+ * @param self The snapshots.
+ * @return The snapshot.
+ */
+const TetrisSnapshot *tetris_snapshots_front(TetrisSnapshots *self) {
+  return &self->_snapshots[self->_front];
+}
@@ -0,0 +1,147 @@
+#ifndef BRICKGAME_TETRIS_RUNNER_SNAPSHOT_H
+#define BRICKGAME_TETRIS_RUNNER_SNAPSHOT_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include "../ghost/ghost.h"
+#include "../tetris.h"
+
+#define TETRIS_SNAPSHOTS_COUNT 3
+
+/**
+ * @brief The state of an engine at a point in time, copied out of the engine
+ * so it can be read while the engine keeps running.
+ *
+ * A snapshot owns its cells: the field and next pointers of `info` point into
+ * the snapshot itself. The cells are only copied when their generation differs
+ * from the one the snapshot holds.
+ *
+ * @struct TetrisSnapshot
+ * @var info The game information, as returned by `updateCurrentState`.
+ * @var state The state of the engine.
+ * @var generation The change counters of the engine state.
+ * @var sequence The number of snapshots published before this one.
+ * @var input_sequence The number of commands applied to the engine.
+ * @var published_ns The monotonic time the snapshot was published at.
+ * @var stack_height The number of rows from the bottom of the field up to the
+ * highest locked cell, the falling brick left out.
+ * @var has_ghost Whether the ghost fields hold a raced ghost.
+ * @var ghost_field The field of the raced ghost or NULL without a ghost.
+ * @var ghost_score The score of the raced ghost.
+ * @var ghost_generation The generation of the whole state of the ghost engine.
+ */
+typedef struct {
+  GameInfo_t info;
+  TetriState state;
+  TetrisGeneration generation;
+  unsigned long sequence;
+  unsigned long input_sequence;
+  long long published_ns;
+  int stack_height;
+  bool has_ghost;
+  int **ghost_field;
+  int ghost_score;
+  unsigned long ghost_generation;
+
+  int _field[TETRIS_FIELD_HEIGHT][TETRIS_FIELD_WIDTH];
+  int _next[BRICK_HEIGHT][BRICK_WIDTH];
+  int _ghost[TETRIS_FIELD_HEIGHT][TETRIS_FIELD_WIDTH];
+  int *_field_rows[TETRIS_FIELD_HEIGHT];
+  int *_next_rows[BRICK_HEIGHT];
+  int *_ghost_rows[TETRIS_FIELD_HEIGHT];
+} TetrisSnapshot;
+
+/**
+ * @brief Snapshots of an engine passed from the thread running the engine to
+ * a single reading thread through a triple buffer.
+ *
+ * The engine thread fills the back snapshot and swaps it with the middle one,
+ * the reading thread swaps the middle one with its front snapshot when a newer
+ * one is there. Neither thread ever waits for the other and the snapshot read
+ * last stays unchanged until the next read.
+ *
+ * @struct TetrisSnapshots
+ * @var published_generation The generation of the engine state published last.
+ * @var published_ghost_generation The generation of the ghost published last.
+ * @var _snapshots The three snapshots.
+ * @var _middle The index of the middle snapshot, with a flag set while it is
+ * newer than the front one.
+ * @var _back The index of the snapshot filled by the engine thread.
+ * @var _front The index of the snapshot read by the reading thread.
+ * @var _sequence The number of snapshots taken so far.
+ */
+typedef struct {
+  unsigned long published_generation;
+  unsigned long published_ghost_generation;
+
+  TetrisSnapshot _snapshots[TETRIS_SNAPSHOTS_COUNT];
+  atomic_uint _middle;
+  unsigned int _back;
+  unsigned int _front;
+  unsigned long _sequence;
+} TetrisSnapshots;
+
+/**
+ * @brief Prepares empty snapshots.
+ *
+ * @param self The snapshots.
+ */
+void tetris_snapshots_init(TetrisSnapshots *self);
+
+/**
+ * @brief Copies the engine state into the front snapshot, before the reading
+ * thread reads it for the first time.
+ *
+ * @param self The snapshots.
+ * @param tetris The engine.
+ * @param ghost The raced ghost or NULL.
+ * @param input_sequence The number of commands applied to the engine.
+ */
+void tetris_snapshots_fill(TetrisSnapshots *self, Tetris *tetris, Ghost *ghost,
+                           unsigned long input_sequence);
+
+/**
+ * @brief Checks whether the engine or the ghost changed since the last
+ * published snapshot.
+ *
+ * @param self The snapshots.
+ * @param tetris The engine.
+ * @param ghost The raced ghost or NULL.
+ * @return true if a new snapshot would differ from the published one.
+ */
+bool tetris_snapshots_is_stale(TetrisSnapshots *self, Tetris *tetris,
+                               Ghost *ghost);
+
+/**
+ * @brief Publishes the engine state, on the engine thread.
+ *
+ * @param self The snapshots.
+ * @param tetris The engine.
+ * @param ghost The raced ghost or NULL.
+ * @param input_sequence The number of commands applied to the engine.
+ * @return The publishing time of the snapshot.
+ */
+long long tetris_snapshots_publish(TetrisSnapshots *self, Tetris *tetris,
+                                   Ghost *ghost, unsigned long input_sequence);
+
+/**
+ * @brief Returns the latest published snapshot, on the reading thread.
+ *
+ * The snapshot stays valid and unchanged until the next call.
+ *
+ * @param self The snapshots.
+ * @return The snapshot.
+ */
+const TetrisSnapshot *tetris_snapshots_latest(TetrisSnapshots *self);
+
+/**
+ * @brief Returns the snapshot returned by the last `tetris_snapshots_latest`,
+ * on the reading thread.
+ *
+ * @param self The snapshots.
+ * @return The snapshot.
+ */
+const TetrisSnapshot *tetris_snapshots_front(TetrisSnapshots *self);
+
+#endif  // !BRICKGAME_TETRIS_RUNNER_SNAPSHOT_H
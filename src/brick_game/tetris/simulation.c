@@ -0,0 +1,180 @@
+#include "tetris.h"
+
+#define SIMULATION_MAX_DURATION_NS (24LL * 3600 * 1000000000LL)
+#define SIMULATION_ACTIONS_WINDOW 64
+#define SIMULATION_REPEATS_WINDOW 128
+#define SIMULATION_ACTIONS_WINDOW_NS 1000000000LL
+
+/**
+ * @brief Creates a Tetris engine suitable for simulations.
+ *
+ * The engine is created with its own repository, runs on a virtual clock and
+ * has all file system hooks disabled, so any number of simulation engines can
+ * live side by side, including on different threads.
+ *
+ * @param seed The seed of the brick generator.
+ * @param bricks_count The number of bricks of the repository.
+ * @return A pointer to the newly created engine or NULL if `bricks_count` is
+ * not a known brick set.
+ */
+Tetris *new_simulation_tetris(unsigned int seed, size_t bricks_count) {
+  if (bricks_count != BRICK_DEFAULTS_COUNT &&
+      bricks_count != BRICK_DEFAULTS_COUNT + BRICK_CUSTOM_COUNT) {
+    return NULL;
+  }
+
+  TetrisBrickRepository *repository = new_brick_repository();
+  repository->populate_defaults(repository);
+  if (bricks_count > BRICK_DEFAULTS_COUNT) {
+    repository->populate_custom(repository);
+  }
+  repository->seed(repository, seed);
+
+  Tetris *tetris = new_tetris(repository);
+  tetris->timer = create_virtual_timer(tetris->timer.timeout_ns);
+  tetris->on_startup = NULL;
+  tetris->on_shutdown = NULL;
+  tetris->on_highscore = NULL;
+  tetris->on_gameover = NULL;
+  return tetris;
+}
+
+/**
+ * @brief Counts an action into a sliding window of the latest actions.
+ *
+ * The window holds the times of the last `size` actions of its kind, an
+ * action is refused when the oldest of them is less than a second old.
+ *
+ * @param window The times of the latest actions, `size` slots.
+ * @param size The number of actions allowed per second.
+ * @param count The number of actions counted so far.
+ * @param now_ns The time of the action.
+ * @return true if the action fits the window, false otherwise.
+ */
+static bool count_action(long long *window, size_t size, size_t *count,
+                         long long now_ns) {
+  size_t slot = *count % size;
+  if (*count >= size && now_ns - window[slot] < SIMULATION_ACTIONS_WINDOW_NS) {
+    return false;
+  }
+  window[slot] = now_ns;
+  (*count)++;
+  return true;
+}
+
+/**
+ * @brief Feeds all remaining events of a replay to a simulation engine.
+ *
+ * Every tick event calls the engine tick and every action event is dispatched
+ * through the FSM, each after moving the virtual clock to the recorded time.
+ * Replays that are malformed, last longer than a day or contain more actions
+ * per second than a human can produce are rejected; the score is not checked.
+ * Held left and right moves are the auto-repeat of the frontend and have a
+ * window of their own, sized for two keys repeating every frame, so a held
+ * key never uses up the key presses.
+ *
+ * @param tetris A pointer to the simulation engine.
+ * @param reader A reader positioned after the replay header.
+ * @return The result of the simulation.
+ */
+ReplaySimulation run_replay(Tetris *tetris, ReplayReader *reader) {
+  ReplaySimulation result = {.verdict = REPLAY_VERDICT_OK};
+  tetris->start(tetris);
+
+  long long now_ns = 0;
+  long long actions_window[SIMULATION_ACTIONS_WINDOW] = {0};
+  long long repeats_window[SIMULATION_REPEATS_WINDOW] = {0};
+  size_t presses = 0;
+  size_t repeats = 0;
+
+  ReplayEvent event;
+  while (result.verdict == REPLAY_VERDICT_OK &&
+         replay_reader_next(reader, &event)) {
+    now_ns += (long long)event.dt_ns;
+    if (event.dt_ns > (uint64_t)SIMULATION_MAX_DURATION_NS ||
+        now_ns > SIMULATION_MAX_DURATION_NS) {
+      result.verdict = REPLAY_VERDICT_BAD_TIMING;
+      continue;
+    }
+
+    tetris->timer.set_time(
+        &tetris->timer, (struct timespec){.tv_sec = now_ns / 1000000000LL,
+                                          .tv_nsec = now_ns % 1000000000LL});
+
+    if (event.code == REPLAY_CODE_TICK) {
+      tetris_fsm_tick(tetris);
+      result.ticks++;
+    } else {
+      int action = (event.code & ~REPLAY_CODE_HOLD) - REPLAY_CODE_ACTION;
+      if (action < Start || action > Action) {
+        result.verdict = REPLAY_VERDICT_MALFORMED;
+        continue;
+      }
+
+      bool is_repeat = (event.code & REPLAY_CODE_HOLD) &&
+                       (action == Left || action == Right);
+      bool is_plausible =
+          is_repeat ? count_action(repeats_window, SIMULATION_REPEATS_WINDOW,
+                                   &repeats, now_ns)
+                    : count_action(actions_window, SIMULATION_ACTIONS_WINDOW,
+                                   &presses, now_ns);
+      if (!is_plausible) {
+        result.verdict = REPLAY_VERDICT_BAD_TIMING;
+        continue;
+      }
+
+      tetris_dispatch(tetris, (UserAction_t)action,
+                      event.code & REPLAY_CODE_HOLD);
+      result.actions++;
+    }
+  }
+
+  if (result.verdict == REPLAY_VERDICT_OK &&
+      reader->events_read != reader->header.events_count) {
+    result.verdict = REPLAY_VERDICT_MALFORMED;
+  }
+
+  result.score = tetris->data.info.score;
+  result.level = tetris->data.info.level;
+  result.state = tetris->state;
+  result.duration_ns = now_ns;
+  return result;
+}
+
+/**
+ * @brief Re-simulates an encoded replay and checks the claimed score.
+ *
+ * The replay is decoded incrementally and fed to a fresh simulation engine by
+ * `run_replay`. Besides the final score, the simulation rejects replays that
+ * use an unknown brick set along with everything `run_replay` rejects.
+ *
+ * @param data The encoded replay.
+ * @param size The size of the encoded replay in bytes.
+ * @param claimed_score The score the replay is claimed to reach.
+ * @return The result of the simulation.
+ */
+ReplaySimulation simulate_replay(const uint8_t *data, size_t size,
+                                 int claimed_score) {
+  ReplaySimulation result = {.verdict = REPLAY_VERDICT_OK};
+
+  ReplayReader reader;
+  if (!replay_reader_init(&reader, data, size)) {
+    result.verdict = REPLAY_VERDICT_MALFORMED;
+    return result;
+  }
+
+  Tetris *tetris =
+      new_simulation_tetris(reader.header.seed, reader.header.bricks_count);
+  if (!tetris) {
+    result.verdict = REPLAY_VERDICT_BAD_BRICKS;
+    return result;
+  }
+
+  result = run_replay(tetris, &reader);
+  if (result.verdict == REPLAY_VERDICT_OK && result.score != claimed_score) {
+    result.verdict = REPLAY_VERDICT_SCORE_MISMATCH;
+  }
+
+  tetris->destroy(tetris);
+  return result;
+}
@@ -1,5 +1,21 @@
 #include "tetris.h"
 
+/**
+ * @brief Marks parts of the game state of an engine as changed.
+ *
+ * @param tetris A pointer to the Tetris game engine instance.
+ * @param changes The changed parts, a combination of `TetrisChange` flags.
+ */
+void tetris_touch(Tetris *tetris, unsigned int changes) {
+  if (!tetris) return;
+
+  tetris->generation.state++;
+  if (changes & TETRIS_CHANGE_FIELD) tetris->generation.field++;
+  if (changes & TETRIS_CHANGE_SCORE) tetris->generation.score++;
+  if (changes & TETRIS_CHANGE_NEXT) tetris->generation.next++;
+  if (changes & TETRIS_CHANGE_PAUSE) tetris->generation.pause++;
+}
+
 /**
  * @brief Clears the Tetris game field.
  *
@@ -36,16 +52,14 @@ static bool remove_brick(int **matrix, Brick *brick) {
   if (!matrix || !brick) return false;
 
   bool is_success = true;
-  int x = brick->pos.x;
-  int y = brick->pos.y;
+  // the field writes may alias the brick, so its shape is read once
+  const int(*shape)[BRICK_WIDTH] = brick->states[brick->state];
+  int x = brick->pos.x + (-BRICK_WIDTH / 2);
+  int y = brick->pos.y + (-BRICK_HEIGHT / 2) + 1;
 
   for (int row = 0; row < BRICK_HEIGHT; row++) {
     for (int col = 0; col < BRICK_WIDTH; col++) {
-      if (brick->states[brick->state][row][col]) {
-        int brick_in_matrix_pos_x = x + (-BRICK_WIDTH / 2) + col;
-        int brick_in_matrix_pos_y = y + (-BRICK_HEIGHT / 2) + 1 + row;
-        matrix[brick_in_matrix_pos_y][brick_in_matrix_pos_x] = 0;
-      }
+      if (shape[row][col]) matrix[y + row][x + col] = 0;
     }
   }
   return is_success;
@@ -71,13 +85,14 @@ static bool is_collide(int **matrix, Brick *brick) {
 
   bool result = false;
 
-  int x = brick->pos.x;
-  int y = brick->pos.y;
+  const int(*shape)[BRICK_WIDTH] = brick->states[brick->state];
+  int x = brick->pos.x + (-BRICK_WIDTH / 2);
+  int y = brick->pos.y + ((-BRICK_HEIGHT / 2) + 1);
   for (int row = 0; row < BRICK_HEIGHT && !result; row++) {
     for (int col = 0; col < BRICK_WIDTH && !result; col++) {
-      if (brick->states[brick->state][row][col]) {
-        int matrix_pos_x = x + (-BRICK_WIDTH / 2) + col;
-        int matrix_pos_y = y + ((-BRICK_HEIGHT / 2) + 1) + row;
+      if (shape[row][col]) {
+        int matrix_pos_x = x + col;
+        int matrix_pos_y = y + row;
 
         if ((matrix_pos_x < 0) || (matrix_pos_x >= TETRIS_FIELD_WIDTH)) {
           result = true;  // width excided
@@ -94,6 +109,82 @@ static bool is_collide(int **matrix, Brick *brick) {
   return result;
 }
 
+/**
+ * @brief Checks whether a placed brick is blocked from moving by one cell.
+ *
+ * The brick stays on the field while it is checked: the cell next to one of
+ * its cells in the direction of the move blocks it only if that cell is
+ * outside the field or busy and is not a cell of the brick itself. It answers
+ * what removing the brick, moving it and calling is_collide() would, without
+ * writing to the field.
+ *
+ * @param matrix A 2D array representing the game field with the brick on it.
+ * @param brick A pointer to the Brick structure placed on the field.
+ * @param dx The move along the row, -1, 0 or 1.
+ * @param dy The move along the column, 0 or 1.
+ * @return true if the brick cannot make the move, false otherwise.
+ */
+static bool is_blocked(int **matrix, Brick *brick, int dx, int dy) {
+  if (!matrix || !brick) return false;
+
+  bool result = false;
+  const int(*shape)[BRICK_WIDTH] = brick->states[brick->state];
+  int x = brick->pos.x + (-BRICK_WIDTH / 2);
+  int y = brick->pos.y + ((-BRICK_HEIGHT / 2) + 1);
+  for (int row = 0; row < BRICK_HEIGHT && !result; row++) {
+    for (int col = 0; col < BRICK_WIDTH && !result; col++) {
+      int next_row = row + dy;
+      int next_col = col + dx;
+      bool is_edge = shape[row][col] &&
+                     (next_row >= BRICK_HEIGHT || next_col < 0 ||
+                      next_col >= BRICK_WIDTH || !shape[next_row][next_col]);
+      if (is_edge) {
+        int matrix_pos_x = x + next_col;
+        int matrix_pos_y = y + next_row;
+        result = matrix_pos_x < 0 || matrix_pos_x >= TETRIS_FIELD_WIDTH ||
+                 matrix_pos_y >= TETRIS_FIELD_HEIGHT ||
+                 matrix[matrix_pos_y][matrix_pos_x];
+      }
+    }
+  }
+  return result;
+}
+
+/**
+ * @brief Counts the rows a removed brick can fall before it collides.
+ *
+ * Only the lowest cell of every vertical run of the brick can hit something,
+ * so the column below each of them is scanned once instead of calling
+ * is_collide() for every row of the drop.
+ *
+ * @param matrix A 2D array representing the game field without the brick.
+ * @param brick A pointer to the Brick structure at a free position.
+ * @return The number of free rows below the brick.
+ */
+static int drop_distance(int **matrix, Brick *brick) {
+  if (!matrix || !brick) return 0;
+
+  const int(*shape)[BRICK_WIDTH] = brick->states[brick->state];
+  int x = brick->pos.x + (-BRICK_WIDTH / 2);
+  int y = brick->pos.y + ((-BRICK_HEIGHT / 2) + 1);
+  int distance = TETRIS_FIELD_HEIGHT;
+  for (int row = 0; row < BRICK_HEIGHT; row++) {
+    for (int col = 0; col < BRICK_WIDTH; col++) {
+      if (!shape[row][col] ||
+          (row < BRICK_HEIGHT - 1 && shape[row + 1][col])) {
+        continue;
+      }
+      int rows = 0;
+      while (rows < distance && y + row + rows + 1 < TETRIS_FIELD_HEIGHT &&
+             !matrix[y + row + rows + 1][x + col]) {
+        rows++;
+      }
+      distance = rows;
+    }
+  }
+  return distance;
+}
+
 /**
  * @brief Places a brick on the game matrix at its current position.
  *
@@ -110,15 +201,14 @@ static bool is_collide(int **matrix, Brick *brick) {
 static void place_brick(int **matrix, Brick *brick) {
   if (!matrix || !brick) return;
 
-  int x = brick->pos.x;
-  int y = brick->pos.y;
+  // the field writes may alias the brick, so it is read once
+  const int(*shape)[BRICK_WIDTH] = brick->states[brick->state];
+  int color = brick->color;
+  int x = brick->pos.x + (-BRICK_WIDTH / 2);
+  int y = brick->pos.y + ((-BRICK_HEIGHT / 2) + 1);
   for (int row = 0; row < BRICK_HEIGHT; row++) {
     for (int col = 0; col < BRICK_WIDTH; col++) {
-      if (brick->states[brick->state][row][col]) {
-        int brick_in_matrix_pos_x = x + (-BRICK_WIDTH / 2) + col;
-        int brick_in_matrix_pos_y = y + ((-BRICK_HEIGHT / 2) + 1) + row;
-        matrix[brick_in_matrix_pos_y][brick_in_matrix_pos_x] = brick->color;
-      }
+      if (shape[row][col]) matrix[y + row][x + col] = color;
     }
   }
 }
@@ -191,6 +281,7 @@ static int erase_lines(int **matrix) {
 static void _on_startup(Tetris *self) {
   if (!self) return;
   self->data.info.high_score = read_highscore_from_file("highscore.txt");
+  tetris_touch(self, TETRIS_CHANGE_SCORE);
 }
 
 /**
@@ -204,6 +295,146 @@ static void _on_startup(Tetris *self) {
 static void _on_shutdown(Tetris *self) {
   if (!self) return;
   write_highscore_to_file("highscore.txt", self->data.info.high_score);
+  if (self->on_gameover) self->on_gameover(self);
+}
+
+/**
+ * @brief Persists the high score when it is beaten.
+ *
+ * This static function is the default `on_highscore` hook. Simulations replace
+ * it with NULL so that they never touch the file system.
+ *
+ * @param self A pointer to the Tetris game engine instance.
+ */
+static void _on_highscore(Tetris *self) {
+  if (!self) return;
+  write_highscore_to_file("highscore.txt", self->data.info.high_score);
+}
+
+/**
+ * @brief Saves the replay of a finished game if it set the high score.
+ *
+ * This static function is the default `on_gameover` hook. The replay is stored
+ * next to the high score file, so that a submitted high score can always be
+ * accompanied by the game that produced it.
+ *
+ * @param self A pointer to the Tetris game engine instance.
+ */
+static void _on_gameover(Tetris *self) {
+  if (!self || !self->replay) return;
+
+  Replay *replay = self->replay;
+  if (replay->header.events_count && replay->header.score > 0 &&
+      replay->header.score >= self->data.info.high_score) {
+    replay->save(replay, "highscore.replay");
+  }
+}
+
+/**
+ * @brief Records an event into the replay of the current game, if any.
+ *
+ * @param self A pointer to the Tetris game engine instance.
+ * @param code The replay event code.
+ */
+static void record_replay_event(Tetris *self, uint8_t code) {
+  if (!self || !self->replay || !self->replay->is_recording) return;
+  self->replay->record(self->replay, code, self->timer.now(&self->timer));
+}
+
+/**
+ * @brief Stops the recording of the current game and stores its final score.
+ *
+ * @param self A pointer to the Tetris game engine instance.
+ */
+static void finish_replay(Tetris *self) {
+  if (!self || !self->replay || !self->replay->is_recording) return;
+  self->replay->header.score = self->data.info.score;
+  self->replay->is_recording = false;
+}
+
+/**
+ * @brief Restarts the lock delay of the active brick after a move.
+ *
+ * A brick resting on the ground can be moved or rotated for a while before it
+ * locks. Each successful move while it rests restarts the delay, at most
+ * `TETRIS_LOCK_RESETS_MAX` times per brick, so it cannot be kept alive forever.
+ *
+ * @param self A pointer to the Tetris game engine instance.
+ */
+static void restart_lock_delay(Tetris *self) {
+  if (self->_lock_frames && self->_lock_resets < TETRIS_LOCK_RESETS_MAX) {
+    self->_lock_frames = 0;
+    self->_lock_resets++;
+  }
+}
+
+/**
+ * @brief Checks whether the active brick rests on the ground, once per field
+ * generation.
+ *
+ * Every move of the brick and every other write to the field touches
+ * `generation.field`, so the answer of is_blocked() holds until the counter
+ * changes. Generations start at 1, so the initial 0 is never a hit.
+ *
+ * @param self A pointer to the Tetris game engine instance.
+ * @param brick The active brick, placed on the field.
+ * @return true if the brick cannot move one row down, false otherwise.
+ */
+static bool is_brick_grounded(Tetris *self, Brick *brick) {
+  if (self->_ground_generation != self->generation.field) {
+    self->_is_grounded = is_blocked(self->data.info.field, brick, 0, 1);
+    self->_ground_generation = self->generation.field;
+  }
+  return self->_is_grounded;
+}
+
+/**
+ * @brief Lets the active brick fall by the gravity of one frame.
+ *
+ * The gravity of the level is added to the fallen fraction of a cell and the
+ * brick moves down by the whole cells of it, up to the ground. A brick on the
+ * ground counts frames instead and locks once it rested for
+ * `TETRIS_LOCK_DELAY_FRAMES`.
+ *
+ * @param self A pointer to the Tetris game engine instance.
+ */
+static void fall_brick(Tetris *self) {
+  Brick *brick = self->data.current_brick;
+  if (!brick) return;
+
+  int gravity = get_gravity_by_level(self->data.info.level);
+  if (gravity > TETRIS_GRAVITY_MAX) gravity = TETRIS_GRAVITY_MAX;
+  self->_gravity += gravity;
+  int cells = self->_gravity / TETRIS_GRAVITY_ONE;
+  self->_gravity %= TETRIS_GRAVITY_ONE;
+
+  int y = brick->pos.y;
+  bool is_grounded = is_brick_grounded(self, brick);
+  // most frames fall by a fraction of a cell and leave the field as it is
+  if (cells > 0 && !is_grounded) {
+    remove_brick(self->data.info.field, brick);
+    for (int i = 0; i < cells && !is_grounded; i++) {
+      brick->pos.y++;
+      if ((is_grounded = is_collide(self->data.info.field, brick))) {
+        brick->pos.y--;
+      }
+    }
+    place_brick(self->data.info.field, brick);
+    if (brick->pos.y != y) {
+      tetris_touch(self, TETRIS_CHANGE_FIELD);
+      self->_lock_frames = 0;
+    }
+    if (!is_grounded) is_grounded = is_brick_grounded(self, brick);
+  }
+
+  if (!is_grounded) {
+    self->_lock_frames = 0;
+    return;
+  }
+  self->_gravity = 0;
+  if (++self->_lock_frames >= TETRIS_LOCK_DELAY_FRAMES) {
+    self->down(self, false);
+  }
 }
 
 /**
@@ -246,6 +477,7 @@ static void _down(Tetris *self, bool hold) {
   Brick *brick = self->data.current_brick;
 
   if (brick) {
+    int y = brick->pos.y;
     remove_brick(self->data.info.field, brick);
     bool is_collided = true;
     if (!hold) {
@@ -254,16 +486,16 @@ static void _down(Tetris *self, bool hold) {
         brick->pos.y--;
       }
     } else {
-      while ((is_collided != is_collide(self->data.info.field, brick))) {
-        brick->pos.y++;
-      }
-      brick->pos.y--;
+      brick->pos.y += drop_distance(self->data.info.field, brick);
     }
 
     place_brick(self->data.info.field, brick);
+    if (brick->pos.y != y) tetris_touch(self, TETRIS_CHANGE_FIELD);
     if (is_collided) {
+      if (self->on_lock) self->on_lock(self, brick);
       self->state = TETRIS_ATTACH_STATE;
       self->data.current_brick = NULL;
+      tetris_touch(self, 0);
     }
   }
 }
@@ -285,14 +517,12 @@ static void _left(Tetris *self, bool hold) {
   (void)hold;
 
   Brick *brick = self->data.current_brick;
-  if (brick) {
+  if (brick && !is_blocked(self->data.info.field, brick, -1, 0)) {
     remove_brick(self->data.info.field, brick);
-
     brick->pos.x--;
-    if (is_collide(self->data.info.field, brick)) {
-      brick->pos.x++;
-    }
     place_brick(self->data.info.field, brick);
+    tetris_touch(self, TETRIS_CHANGE_FIELD);
+    restart_lock_delay(self);
   }
 }
 
@@ -313,13 +543,12 @@ static void _right(Tetris *self, bool hold) {
   (void)hold;
 
   Brick *brick = self->data.current_brick;
-  if (brick) {
+  if (brick && !is_blocked(self->data.info.field, brick, 1, 0)) {
     remove_brick(self->data.info.field, brick);
     brick->pos.x++;
-    if (is_collide(self->data.info.field, brick)) {
-      brick->pos.x--;
-    }
     place_brick(self->data.info.field, brick);
+    tetris_touch(self, TETRIS_CHANGE_FIELD);
+    restart_lock_delay(self);
   }
 }
 
@@ -350,6 +579,9 @@ static void _action(Tetris *self, bool hold) {
     brick->next_state(brick);
     if (is_collide(self->data.info.field, brick)) {
       brick->prev_state(brick);
+    } else {
+      tetris_touch(self, TETRIS_CHANGE_FIELD);
+      restart_lock_delay(self);
     }
 
     place_brick(self->data.info.field, brick);
@@ -381,6 +613,10 @@ static void _destroy(Tetris *self) {
     self->repository->destroy(self->repository);
     self->repository = NULL;
   }
+  if (self->replay) {
+    self->replay->destroy(self->replay);
+    self->replay = NULL;
+  }
 
   free(self);
 }
@@ -394,6 +630,10 @@ static void _destroy(Tetris *self) {
  * initial state after a game over. This includes clearing the game fields,
  * resetting the game level, score, and pause status, and spawning a new piece.
  *
+ * Every new game restarts the gravity timer and reseeds the brick generator
+ * with its own current state, so the game depends only on that seed and on the
+ * recorded events. The seed is stored in the replay, if one is attached.
+ *
  * @param self A pointer to the Tetris game engine instance.
  */
 static void _start(Tetris *self) {
@@ -408,19 +648,76 @@ static void _start(Tetris *self) {
     self->data.info.level = 1;
     self->data.info.score = 0;
     self->data.info.pause = 0;
+    tetris_touch(self, TETRIS_CHANGE_FIELD | TETRIS_CHANGE_SCORE |
+                           TETRIS_CHANGE_PAUSE);
+  }
+
+  // a replay starts from the seed alone, nothing of a previous game is kept
+  unsigned int seed = self->repository->rng_state;
+  self->repository->seed(self->repository, seed);
+  self->data.current_brick = NULL;
+  self->data.next_brick = NULL;
+  // the gravity and the replay start at the same instant
+  struct timespec now = self->timer.pin(&self->timer);
+  self->timer.reset(&self->timer);
+  if (self->replay) {
+    self->replay->begin(self->replay, seed, self->repository->items_count,
+                        now);
   }
+  self->timer.unpin(&self->timer);
 
   self->_spawn(self);
 }
 
+/**
+ * @brief Brings the engine back to the state of a newly created one.
+ *
+ * Nothing is allocated or freed: the field and the next brick preview are
+ * cleared, the counters are zeroed, the repository is reseeded and a virtual
+ * clock is moved back to zero. Hooks, the context and the replay recorder are
+ * kept as they are.
+ *
+ * @param self A pointer to the Tetris game engine instance.
+ * @param seed The new seed of the brick generator.
+ */
+static void _reset(Tetris *self, unsigned int seed) {
+  if (!self) return;
+
+  clear_tetris_fields(self);
+  for (int row = 0; row < BRICK_HEIGHT; row++) {
+    for (int col = 0; col < BRICK_WIDTH; col++) {
+      self->data.info.next[row][col] = 0;
+    }
+  }
+  self->data.current_brick = NULL;
+  self->data.next_brick = NULL;
+  self->data.info.score = 0;
+  self->data.info.high_score = 0;
+  self->data.info.level = 1;
+  self->data.info.speed = 0;
+  self->data.info.pause = 0;
+  self->state = TETRIS_READY_STATE;
+
+  self->repository->seed(self->repository, seed);
+  self->frames = 0;
+  self->_gravity = 0;
+  self->_lock_frames = 0;
+  self->_lock_resets = 0;
+  self->timer.ticks = 0;
+  self->timer.set_time(&self->timer, (struct timespec){0});
+  self->timer.reset(&self->timer);
+  tetris_touch(self, TETRIS_CHANGE_ALL);
+}
+
 /**
  * @brief Toggles the pause state of the Tetris game.
  *
  * This static function toggles the pause state of the Tetris game. If the game
- * is currently paused, it resumes the game by setting the pause flag to 0 and
- * changing the game state to TETRIS_MOVING_STATE. If the game is not paused, it
- * pauses the game by setting the pause flag to 1 and changing the game state to
- * TETRIS_PAUSE_STATE.
+ * is currently paused, it resumes the game by setting the pause flag to 0. If
+ * the game is not paused, it pauses the game by setting the pause flag to 1.
+ * The state itself is set by the dispatcher, from `TETRIS_FSM_TRANSITIONS`.
+ * Resuming resets the timer, so the first tick does not catch up the frames of
+ * the pause.
  *
  * @param self A pointer to the Tetris game engine instance.
  */
@@ -428,11 +725,12 @@ static void _pause(Tetris *self) {
   if (!self) return;
   if (self->data.info.pause) {
     self->data.info.pause = 0;
-    self->state = TETRIS_MOVING_STATE;
+    // the pause is not owed, the frames restart from the resume
+    self->timer.reset(&self->timer);
   } else {
     self->data.info.pause = 1;
-    self->state = TETRIS_PAUSE_STATE;
   }
+  tetris_touch(self, TETRIS_CHANGE_PAUSE);
 }
 
 /**
@@ -440,54 +738,78 @@ static void _pause(Tetris *self) {
  *
  * This static function is responsible for terminating the Tetris game engine
  * instance. It first checks if the instance is valid, then calls the
- * `on_shutdown` callback if it exists, and finally sets the game state to
- * `TETRIS_TERMINATED_STATE`.
+ * `on_shutdown` callback if it exists. The dispatcher sets the game state to
+ * `TETRIS_TERMINATED_STATE` afterwards.
  *
  * @param self A pointer to the Tetris game engine instance to be terminated.
  */
 static void _terminate(Tetris *self) {
   if (!self) return;
 
+  finish_replay(self);
   if (self->on_shutdown) {
     self->on_shutdown(self);
   }
-  self->state = TETRIS_TERMINATED_STATE;
+  tetris_touch(self, 0);
 }
 
 /**
  * @brief Updates the game state based on the game timer.
  *
  * This function is called periodically to update the game state based on the
- * game timer. It adjusts the game level and speed based on the current score,
- * checks if the game is in a moving state, and if so, moves the active piece
- * down. If the game is in an attach state, it checks for completed lines,
- * updates the score, and spawns a new piece.
+ * game timer. The game advances in frames of `TETRIS_FRAME_RATE`: for every
+ * frame that elapsed since the previous call, if the game is in a moving
+ * state, it lets the active piece fall by the gravity of the level, see
+ * `fall_brick`. The level itself follows the current score. If the game is in
+ * an attach state, it checks for completed lines, updates the score, and
+ * spawns a new piece.
+ *
+ * A call that comes late, after a stalled frame, applies all the frames it
+ * missed, so gravity keeps its speed whatever the rate of the calls. At most
+ * `TETRIS_CATCH_UP_FRAMES_MAX` frames are applied at once, the rest are
+ * dropped, and the frames left when the piece locks are dropped too: a new
+ * piece always starts falling on the next call.
  *
  * @param self A pointer to the Tetris game engine instance.
- * @return A boolean value indicating whether the game timer has ticked.
+ * @return The number of frames applied.
  */
-static bool __tick(Tetris *self) {
-  if (!self) return false;
+static int __tick(Tetris *self) {
+  if (!self) return 0;
 
-  self->data.info.level = get_level_by_score(self->data.info.score);
-  self->timer.timeout_sec = (11 - self->data.info.level) * 0.05;
-  self->data.info.speed = self->timer.timeout_sec * 1000;
+  int level = get_level_by_score(self->data.info.score);
+  if (level != self->data.info.level) {
+    self->data.info.level = level;
+    tetris_touch(self, TETRIS_CHANGE_SCORE);
+  }
 
-  bool is_ticked = self->timer.tick(&self->timer);
+  int frames = self->timer.tick(&self->timer);
+  if (frames > TETRIS_CATCH_UP_FRAMES_MAX) frames = TETRIS_CATCH_UP_FRAMES_MAX;
 
-  if (is_ticked && self->state == TETRIS_MOVING_STATE) {
-    self->down(self, false);
-  } else if (self->state == TETRIS_ATTACH_STATE) {
+  if (self->state == TETRIS_ATTACH_STATE) {
     int ereased = erase_lines(self->data.info.field);
+    if (self->on_erase) self->on_erase(self, ereased);
     self->data.info.score += get_reward_count(ereased);
     if (self->data.info.score > self->data.info.high_score) {
       self->data.info.high_score = self->data.info.score;
-      write_highscore_to_file("highscore.txt", self->data.info.high_score);
+      if (self->on_highscore) self->on_highscore(self);
     }
+    if (ereased) tetris_touch(self, TETRIS_CHANGE_FIELD | TETRIS_CHANGE_SCORE);
 
     self->_spawn(self);
+    frames = 0;
+  }
+
+  for (int i = 0; i < frames && self->state == TETRIS_MOVING_STATE; i++) {
+    fall_brick(self);
   }
-  return is_ticked;
+  self->frames += frames;
+
+  // the period of a cell in milliseconds, rounded
+  long long gravity = get_gravity_by_level(self->data.info.level);
+  self->data.info.speed =
+      (TETRIS_GRAVITY_ONE * 1000LL + gravity * TETRIS_FRAME_RATE / 2) /
+      (gravity * TETRIS_FRAME_RATE);
+  return frames;
 }
 
 /**
@@ -528,13 +850,20 @@ static void __spawn(Tetris *self) {
   // THIS CORDS IS CENTER OF GAME FIELD
   self->data.current_brick->pos.x = TETRIS_FIELD_WIDTH / 2;
   self->data.current_brick->pos.y = 0;
+  self->_gravity = 0;
+  self->_lock_frames = 0;
+  self->_lock_resets = 0;
 
   if (!is_collide(self->data.info.field, self->data.current_brick)) {
     place_brick(self->data.info.field, self->data.current_brick);
     self->state = TETRIS_MOVING_STATE;
+    tetris_touch(self, TETRIS_CHANGE_FIELD | TETRIS_CHANGE_NEXT);
   } else {
     self->state = TETRIS_GAMEOVER_STATE;
     self->data.info.pause = -1;
+    tetris_touch(self, TETRIS_CHANGE_NEXT | TETRIS_CHANGE_PAUSE);
+    finish_replay(self);
+    if (self->on_gameover) self->on_gameover(self);
   }
 }
 
@@ -569,16 +898,33 @@ Tetris *new_tetris(TetrisBrickRepository *repository) {
   self->start = _start;
   self->pause = _pause;
   self->terminate = _terminate;
+  self->reset = _reset;
   self->destroy = _destroy;
 
   self->on_startup = _on_startup;
   self->on_shutdown = _on_shutdown;
+  self->on_highscore = _on_highscore;
+  self->on_gameover = _on_gameover;
+  self->on_lock = NULL;
+  self->on_erase = NULL;
+  self->context = NULL;
 
-  self->timer = create_timer(0.55);
+  self->timer = create_timer(TETRIS_FRAME_NS);
   self->_spawn = __spawn;
   self->_tick = __tick;
   self->repository = repository;
+  self->replay = NULL;
   self->state = TETRIS_READY_STATE;
+  self->generation = (TetrisGeneration){1, 1, 1, 1, 1};
+  self->frames = 0;
+  self->_gravity = 0;
+  self->_lock_frames = 0;
+  self->_lock_resets = 0;
+  self->_ground_generation = 0;
+  self->_is_grounded = false;
+#ifdef TETRIS_FSM_INSTRUMENT
+  self->fsm_stats = (TetrisFsmStats){0};
+#endif
 
   self->data = (TetrisData){
       .current_brick = NULL,
@@ -613,20 +959,57 @@ Tetris *provide_tetris() {
   return tetris;
 }
 
+/**
+ * @brief Ticks a given Tetris engine instance and returns its state.
+ *
+ * The tick is recorded into the replay of the current game, if one is
+ * attached. The timer is pinned meanwhile, so the tick counts its frames at
+ * the very time the replay records and a simulation of it sees the same.
+ *
+ * @param tetris A pointer to the Tetris game engine instance.
+ * @return A GameInfo_t structure containing the updated game state.
+ */
+GameInfo_t tetris_update_state(Tetris *tetris) {
+  tetris->timer.pin(&tetris->timer);
+  record_replay_event(tetris, REPLAY_CODE_TICK);
+  tetris_fsm_tick(tetris);
+  tetris->timer.unpin(&tetris->timer);
+  return tetris->data.info;
+}
+
+/**
+ * @brief Records and dispatches a user action to a given Tetris engine
+ * instance.
+ *
+ * As for a tick, the timer is pinned to the time the replay records, for the
+ * handlers that restart it.
+ *
+ * @param tetris A pointer to the Tetris game engine instance.
+ * @param action The action to be performed.
+ * @param hold A boolean value indicating whether the action should be held.
+ */
+void tetris_user_input(Tetris *tetris, UserAction_t action, bool hold) {
+  if (!tetris) return;
+  tetris->timer.pin(&tetris->timer);
+  record_replay_event(tetris, (REPLAY_CODE_ACTION + action) |
+                                  (hold ? REPLAY_CODE_HOLD : 0));
+  tetris_dispatch(tetris, action, hold);
+  tetris->timer.unpin(&tetris->timer);
+}
+
 /**
  * @brief Updates and returns the current state of the Tetris game.
  *
  * This function retrieves the current state of the Tetris game by calling the
  * game engine's tick function and then returns the updated game information. It
  * is designed to be called from the frontend to ensure that the latest game
- * state is available for rendering or game logic updates.
+ * state is available for rendering or game logic updates. Each call is
+ * recorded into the replay of the current game, if one is attached.
  *
  * @return A GameInfo_t structure containing the updated game state.
  */
 GameInfo_t updateCurrentState() {
-  Tetris *tetris = provide_tetris();
-  tetris->_tick(tetris);
-  return tetris->data.info;
+  return tetris_update_state(provide_tetris());
 }
 
 /**
@@ -642,4 +1025,6 @@ GameInfo_t updateCurrentState() {
  * enumeration.
  * @param hold A boolean value indicating whether the action should be held.
  */
-void userInput(UserAction_t action, bool hold) { dispatch(action, hold); }
+void userInput(UserAction_t action, bool hold) {
+  tetris_user_input(provide_tetris(), action, hold);
+}
@@ -4,11 +4,22 @@
 #define TETRIS_FIELD_WIDTH 10
 #define TETRIS_FIELD_HEIGHT 20
 
+// the engine advances in frames of a fixed rate, gravity is in 16.16 fixed
+// point cells per frame
+#define TETRIS_FRAME_RATE 60
+#define TETRIS_FRAME_NS (1000000000LL / TETRIS_FRAME_RATE)
+#define TETRIS_CATCH_UP_FRAMES_MAX TETRIS_FRAME_RATE
+#define TETRIS_GRAVITY_ONE 65536
+#define TETRIS_GRAVITY_MAX (20 * TETRIS_GRAVITY_ONE)
+#define TETRIS_LOCK_DELAY_FRAMES 30
+#define TETRIS_LOCK_RESETS_MAX 15
+
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 #include "bricks/bricks.h"
+#include "replay/replay.h"
 #include "timer/timer.h"
 #include "utils/utils.h"
 
@@ -142,6 +153,74 @@ typedef enum {
   TETRIS_TERMINATED_STATE
 } TetriState;
 
+#define TETRIS_FSM_STATES (TETRIS_TERMINATED_STATE + 1)
+#define TETRIS_FSM_ACTIONS (Action + 1)
+#define TETRIS_FSM_ANY (-1)
+
+/**
+ * @brief The transitions of the engine FSM, one `X(state, action, handler,
+ * next)` per transition.
+ *
+ * `handler` names the engine function the action calls, `next` the state the
+ * dispatcher sets after it, or `TETRIS_FSM_ANY` where the handler decides: a
+ * start can end the game at once and a move down can lock the brick. An action
+ * that has no transition in the current state is ignored. The dispatch table
+ * and everything else that walks the transitions are generated from this one
+ * list.
+ */
+#define TETRIS_FSM_TRANSITIONS(X)                                              \
+  X(TETRIS_READY_STATE, Start, start, TETRIS_FSM_ANY)                          \
+  X(TETRIS_READY_STATE, Terminate, terminate, TETRIS_TERMINATED_STATE)         \
+  X(TETRIS_SPAWN_STATE, Pause, pause, TETRIS_PAUSE_STATE)                      \
+  X(TETRIS_SPAWN_STATE, Terminate, terminate, TETRIS_TERMINATED_STATE)         \
+  X(TETRIS_MOVING_STATE, Left, left, TETRIS_MOVING_STATE)                      \
+  X(TETRIS_MOVING_STATE, Right, right, TETRIS_MOVING_STATE)                    \
+  X(TETRIS_MOVING_STATE, Up, up, TETRIS_MOVING_STATE)                          \
+  X(TETRIS_MOVING_STATE, Down, down, TETRIS_FSM_ANY)                           \
+  X(TETRIS_MOVING_STATE, Action, action, TETRIS_MOVING_STATE)                  \
+  X(TETRIS_MOVING_STATE, Pause, pause, TETRIS_PAUSE_STATE)                     \
+  X(TETRIS_MOVING_STATE, Terminate, terminate, TETRIS_TERMINATED_STATE)        \
+  X(TETRIS_PAUSE_STATE, Start, pause, TETRIS_MOVING_STATE)                     \
+  X(TETRIS_PAUSE_STATE, Pause, pause, TETRIS_MOVING_STATE)                     \
+  X(TETRIS_PAUSE_STATE, Terminate, terminate, TETRIS_TERMINATED_STATE)         \
+  X(TETRIS_GAMEOVER_STATE, Start, start, TETRIS_FSM_ANY)                       \
+  X(TETRIS_GAMEOVER_STATE, Terminate, terminate, TETRIS_TERMINATED_STATE)
+
+#ifdef TETRIS_FSM_INSTRUMENT
+/**
+ * @brief Counters of a transition of the engine FSM, or of the ticks of a
+ * state.
+ *
+ * @struct TetrisFsmCounter
+ * @var count The number of times it ran.
+ * @var diverted The number of times its handler changed the state itself,
+ * although the transition declares the next one.
+ * @var ns The time spent in its handler, in nanoseconds.
+ * @var max_ns The longest run of its handler, in nanoseconds.
+ */
+typedef struct {
+  unsigned long count;
+  unsigned long diverted;
+  long long ns;
+  long long max_ns;
+} TetrisFsmCounter;
+
+/**
+ * @brief Counters of the engine FSM, only kept in a build with
+ * `TETRIS_FSM_INSTRUMENT` defined.
+ *
+ * @struct TetrisFsmStats
+ * @var transitions The counters of each state and action.
+ * @var ticks The counters of the engine ticks in each state.
+ * @var ignored The number of actions without a transition in their state.
+ */
+typedef struct {
+  TetrisFsmCounter transitions[TETRIS_FSM_STATES][TETRIS_FSM_ACTIONS];
+  TetrisFsmCounter ticks[TETRIS_FSM_STATES];
+  unsigned long ignored;
+} TetrisFsmStats;
+#endif
+
 /**
  * @brief Structure containing the current state and data of the Tetris game.
  *
@@ -163,6 +242,46 @@ typedef struct {
   Brick *next_brick;
 } TetrisData;
 
+/**
+ * @brief Change counters of the game state.
+ *
+ * Every counter only grows: a part of the state is unchanged as long as its
+ * counter is, so a frontend can skip drawing it. `state` grows with any of
+ * the others.
+ *
+ * @struct TetrisGeneration
+ * @var state The generation of the whole game state.
+ * @var field The generation of the game field.
+ * @var score The generation of the score, high score and level.
+ * @var next The generation of the next piece.
+ * @var pause The generation of the pause and game over flag.
+ */
+typedef struct {
+  unsigned long state;
+  unsigned long field;
+  unsigned long score;
+  unsigned long next;
+  unsigned long pause;
+} TetrisGeneration;
+
+/**
+ * @brief Flags of the parts of the game state, for `tetris_touch`.
+ *
+ * @enum TetrisChange
+ * @var TETRIS_CHANGE_FIELD The game field.
+ * @var TETRIS_CHANGE_SCORE The score, high score and level.
+ * @var TETRIS_CHANGE_NEXT The next piece.
+ * @var TETRIS_CHANGE_PAUSE The pause and game over flag.
+ * @var TETRIS_CHANGE_ALL Every part.
+ */
+typedef enum {
+  TETRIS_CHANGE_FIELD = 1 << 0,
+  TETRIS_CHANGE_SCORE = 1 << 1,
+  TETRIS_CHANGE_NEXT = 1 << 2,
+  TETRIS_CHANGE_PAUSE = 1 << 3,
+  TETRIS_CHANGE_ALL = (1 << 4) - 1,
+} TetrisChange;
+
 /**
  * @brief Structure representing the Tetris game engine.
  *
@@ -175,11 +294,30 @@ typedef struct {
  * @var state The current state of the game, as defined by the TetriState
  * enumeration.
  * @var data A TetrisData structure containing the current game state and data.
+ * @var generation The change counters of `data.info`, and of `state` through
+ * the counter of the whole state.
+ * @var frames The number of frames the game has advanced.
+ * @var _gravity The fraction of a cell the active brick has fallen, in 16.16
+ * fixed point.
+ * @var _lock_frames The number of frames the active brick has rested on the
+ * ground, 0 while it falls.
+ * @var _lock_resets The number of times a move restarted the lock delay of the
+ * active brick.
+ * @var _ground_generation The field generation `_is_grounded` was computed
+ * for, 0 if never.
+ * @var _is_grounded Whether the active brick rested on the ground at
+ * `_ground_generation`.
  * @var repository A pointer to a TetrisBrickRepository structure for managing
  * brick (piece) data.
+ * @var replay An optional replay recorder. When set, every tick and user action
+ * of the current game is recorded. Owned by the engine.
+ * @var fsm_stats Counters of the FSM transitions and of the ticks, only in a
+ * build with `TETRIS_FSM_INSTRUMENT` defined.
  * @var start A function pointer for starting the game.
  * @var pause A function pointer for pausing the game.
  * @var terminate A function pointer for terminating the game.
+ * @var reset A function pointer for bringing the engine back to the state of a
+ * newly created one in place, with a given brick generator seed.
  * @var up A function pointer for moving the current piece up.
  * @var down A function pointer for moving the current piece down.
  * @var left A function pointer for moving the current piece left.
@@ -187,12 +325,19 @@ typedef struct {
  * @var action A function pointer for performing the default action for the
  * current piece.
  * @var _tick A function pointer for the game's tick function, which updates the
- * game state.
+ * game state and returns the number of frames applied.
  * @var _spawn A function pointer for spawning a new piece.
  * @var on_startup A function pointer for actions to be performed on game
  * startup.
  * @var on_shutdown A function pointer for actions to be performed on game
  * shutdown.
+ * @var on_highscore A function pointer called when the high score is beaten.
+ * @var on_gameover A function pointer called when the game is over.
+ * @var on_lock A function pointer called when the active brick is locked into
+ * the field, before full lines are erased.
+ * @var on_erase A function pointer called after full lines are erased with the
+ * number of erased lines (possibly zero).
+ * @var context User data for the hooks, never touched by the engine.
  * @var destroy A function pointer for destroying the Tetris game engine
  * instance.
  */
@@ -200,12 +345,24 @@ typedef struct __tetris {
   Timer timer;
   TetriState state;
   TetrisData data;
+  TetrisGeneration generation;
+  unsigned long frames;
+  int _gravity;
+  int _lock_frames;
+  int _lock_resets;
+  unsigned long _ground_generation;
+  bool _is_grounded;
 
   TetrisBrickRepository *repository;
+  Replay *replay;
+#ifdef TETRIS_FSM_INSTRUMENT
+  TetrisFsmStats fsm_stats;
+#endif
 
   void (*start)(struct __tetris *self);
   void (*pause)(struct __tetris *self);
   void (*terminate)(struct __tetris *self);
+  void (*reset)(struct __tetris *self, unsigned int seed);
 
   void (*up)(struct __tetris *self, bool hold);
   void (*down)(struct __tetris *self, bool hold);
@@ -213,11 +370,16 @@ typedef struct __tetris {
   void (*right)(struct __tetris *self, bool hold);
   void (*action)(struct __tetris *self, bool hold);
 
-  bool (*_tick)(struct __tetris *self);
+  int (*_tick)(struct __tetris *self);
   void (*_spawn)(struct __tetris *self);
 
   void (*on_startup)(struct __tetris *self);
   void (*on_shutdown)(struct __tetris *self);
+  void (*on_highscore)(struct __tetris *self);
+  void (*on_gameover)(struct __tetris *self);
+  void (*on_lock)(struct __tetris *self, Brick *brick);
+  void (*on_erase)(struct __tetris *self, int lines);
+  void *context;
 
   void (*destroy)(struct __tetris *self);
 } Tetris;
@@ -249,4 +411,112 @@ Tetris *new_tetris(TetrisBrickRepository *repository);
  */
 Tetris *provide_tetris();
 
+/**
+ * @brief Dispatches a user action to a given Tetris engine instance.
+ *
+ * Same as `dispatch`, but works on any engine instead of the singleton, which
+ * is what replays, simulations and tools need.
+ *
+ * @param tetris A pointer to the Tetris game engine instance.
+ * @param action The action to be dispatched.
+ * @param hold A boolean value indicating whether the action should be held.
+ */
+void tetris_dispatch(Tetris *tetris, UserAction_t action, bool hold);
+
+/**
+ * @brief Ticks a given Tetris engine instance through the FSM.
+ *
+ * An instrumented build counts the tick and its time in the current state.
+ *
+ * @param tetris A pointer to the Tetris game engine instance.
+ */
+void tetris_fsm_tick(Tetris *tetris);
+
+#ifdef TETRIS_FSM_INSTRUMENT
+/**
+ * @brief Prints the transitions and ticks that ran, with their counts and
+ * handler time, one line each.
+ *
+ * @param stats The counters.
+ * @param file The file printed to.
+ */
+void tetris_fsm_print_stats(const TetrisFsmStats *stats, FILE *file);
+#endif
+
+/**
+ * @brief Ticks a given Tetris engine instance and returns its state.
+ *
+ * Same as `updateCurrentState`, but works on any engine instead of the
+ * singleton, which is what an engine running on its own thread needs.
+ *
+ * @param tetris A pointer to the Tetris game engine instance.
+ * @return A GameInfo_t structure containing the updated game state.
+ */
+GameInfo_t tetris_update_state(Tetris *tetris);
+
+/**
+ * @brief Records and dispatches a user action to a given Tetris engine
+ * instance.
+ *
+ * Same as `userInput`, but works on any engine instead of the singleton.
+ *
+ * @param tetris A pointer to the Tetris game engine instance.
+ * @param action The action to be performed.
+ * @param hold A boolean value indicating whether the action should be held.
+ */
+void tetris_user_input(Tetris *tetris, UserAction_t action, bool hold);
+
+/**
+ * @brief Marks parts of the game state of an engine as changed.
+ *
+ * The engine marks its own changes, anything changing `data.info` from outside
+ * the engine must call it.
+ *
+ * @param tetris A pointer to the Tetris game engine instance.
+ * @param changes The changed parts, a combination of `TetrisChange` flags. 0
+ * only grows the generation of the whole state.
+ */
+void tetris_touch(Tetris *tetris, unsigned int changes);
+
+/**
+ * @brief Creates a Tetris engine suitable for simulations.
+ *
+ * The engine runs on a virtual clock, owns a repository populated with
+ * `bricks_count` bricks (7 default, 9 with the custom ones) and never touches
+ * the file system.
+ *
+ * @param seed The seed of the brick generator.
+ * @param bricks_count The number of bricks of the repository.
+ * @return A pointer to the newly created engine or NULL if `bricks_count` is
+ * not a known brick set.
+ */
+Tetris *new_simulation_tetris(unsigned int seed, size_t bricks_count);
+
+/**
+ * @brief Re-simulates an encoded replay and checks the claimed score.
+ *
+ * The replay is decoded incrementally and every recorded tick and action is
+ * fed to a fresh simulation engine at its recorded virtual time.
+ *
+ * @param data The encoded replay.
+ * @param size The size of the encoded replay in bytes.
+ * @param claimed_score The score the replay is claimed to reach.
+ * @return The result of the simulation.
+ */
+ReplaySimulation simulate_replay(const uint8_t *data, size_t size,
+                                 int claimed_score);
+
+/**
+ * @brief Feeds all remaining events of a replay to a simulation engine.
+ *
+ * The engine must be created with `new_simulation_tetris` from the replay
+ * header; its hooks and context may be set to observe the game. The verdict of
+ * the result only covers the replay itself, the score is not checked.
+ *
+ * @param tetris A pointer to the simulation engine.
+ * @param reader A reader positioned after the replay header.
+ * @return The result of the simulation.
+ */
+ReplaySimulation run_replay(Tetris *tetris, ReplayReader *reader);
+
 #endif
\ No newline at end of file
@@ -1,52 +1,166 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "timer.h"
 
 #include <stdio.h>
 
 /**
- * @brief Updates timer and checks if a tick has occurred.
+ * @brief Returns the difference between two timespec values in nanoseconds.
  *
- * This function calculates the time elapsed since the last tick and determines
- * if the specified timeout has been reached. If the timeout is reached, it
- * increments the tick count and updates the last tick time. This function is
- * typically used in game loops to manage timing and game state updates.
+ * The difference is computed in integers, so the same pair of instants always
+ * gives the same result regardless of how seconds and nanoseconds are split.
  *
- * @param self A pointer to the Timer structure representing the game timer.
- * @return A boolean value indicating whether a tick has occurred (true) or not
- * (false).
+ * @param end The later time.
+ * @param start The earlier time.
+ * @return `end - start` in nanoseconds.
+ */
+long long timespec_diff_ns(struct timespec end, struct timespec start) {
+  return (long long)(end.tv_sec - start.tv_sec) * 1000000000LL +
+         (end.tv_nsec - start.tv_nsec);
+}
+
+/**
+ * @brief Returns the current time of the timer clock in nanoseconds.
+ *
+ * Real timers read `CLOCK_MONOTONIC`, virtual timers return the time set by
+ * the last `set_time` call. A pinned timer returns the time it was pinned to.
+ *
+ * @param self A pointer to the Timer structure.
+ * @return The current time of the timer clock.
  */
-static bool _tick(Timer *self) {
-  struct timespec now;
-  timespec_get(&now, TIME_UTC);
+static long long _now_ns(Timer *self) {
+  if (self->_pins) return self->_pinned_ns;
+  if (self->is_virtual) return self->_virtual_now_ns;
 
-  double time_delta_sec = (now.tv_sec - self->_last_tick.tv_sec) +
-                          ((now.tv_nsec - self->_last_tick.tv_nsec) / 1e9);
+  struct timespec now = {0};
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
 
-  bool is_ticked = time_delta_sec >= self->timeout_sec;
-  if (is_ticked) {
-    self->ticks += 1;
-    self->_last_tick = now;
+/**
+ * @brief Returns the current time of the timer clock.
+ *
+ * @param self A pointer to the Timer structure.
+ * @return The current time of the timer clock.
+ */
+static struct timespec _now(Timer *self) {
+  long long now_ns = self->now_ns(self);
+  return (struct timespec){.tv_sec = now_ns / 1000000000LL,
+                           .tv_nsec = now_ns % 1000000000LL};
+}
+
+/**
+ * @brief Moves the virtual clock of the timer.
+ *
+ * Has no effect on real timers.
+ *
+ * @param self A pointer to the Timer structure.
+ * @param now The new time of the virtual clock.
+ */
+static void _set_time(Timer *self, struct timespec now) {
+  if (self->is_virtual) {
+    self->_virtual_now_ns = now.tv_sec * 1000000000LL + now.tv_nsec;
   }
-  return is_ticked;
+}
+
+/**
+ * @brief Restarts the tick period from the current time of the timer clock.
+ *
+ * @param self A pointer to the Timer structure.
+ */
+static void _reset(Timer *self) { self->_last_tick_ns = self->now_ns(self); }
+
+/**
+ * @brief Pins the timer clock to its current time.
+ *
+ * Until the matching `unpin`, every read of the clock returns this time. A
+ * nested pin keeps the time of the outer one.
+ *
+ * @param self A pointer to the Timer structure.
+ * @return The pinned time.
+ */
+static struct timespec _pin(Timer *self) {
+  if (!self->_pins) self->_pinned_ns = self->now_ns(self);
+  self->_pins++;
+  return self->now(self);
+}
+
+/**
+ * @brief Undoes a `pin`, the clock runs again after the outermost one.
+ *
+ * @param self A pointer to the Timer structure.
+ */
+static void _unpin(Timer *self) {
+  if (self->_pins > 0) self->_pins--;
+}
+
+/**
+ * @brief Updates timer and returns the ticks that have occurred.
+ *
+ * This function calculates the time elapsed since the last tick and counts
+ * every whole timeout in it. The last tick time moves by exactly that many
+ * timeouts, not to the current time, so the part of a timeout that has
+ * already elapsed counts towards the next tick. This function is typically
+ * used in game loops to manage timing and game state updates.
+ *
+ * @param self A pointer to the Timer structure representing the game timer.
+ * @return The number of ticks that have occurred since the previous call, 0
+ * if the timeout has not been reached.
+ */
+static int _tick(Timer *self) {
+  long long elapsed_ns = self->now_ns(self) - self->_last_tick_ns;
+  if (self->timeout_ns <= 0 || elapsed_ns < self->timeout_ns) return 0;
+
+  long long ticks = elapsed_ns / self->timeout_ns;
+  self->_last_tick_ns += ticks * self->timeout_ns;
+  self->ticks += (int)ticks;
+  return (int)ticks;
 }
 
 /**
  * @brief Creates a new Timer instance with a specified timeout.
  *
  * This function initializes a new Timer structure with a given timeout in
- * seconds. It sets the initial tick count to 0 and captures the current time as
- * the last tick. The Timer structure is designed to manage timing events, such
- * as game ticks or delays.
+ * nanoseconds. It sets the initial tick count to 0 and captures the current
+ * monotonic time as the last tick. The Timer structure is designed to manage
+ * timing events, such as game ticks or delays.
  *
- * @param timeout_sec The timeout value in seconds for the Timer.
+ * @param timeout_ns The timeout value in nanoseconds for the Timer.
  * @return A Timer structure initialized with the specified timeout and current
  * time.
  */
-Timer create_timer(double timeout_sec) {
-  struct timespec last_tick = {0};
-  timespec_get(&last_tick, TIME_UTC);
+Timer create_timer(long long timeout_ns) {
+  Timer timer = {.ticks = 0,
+                 .timeout_ns = timeout_ns,
+                 .is_virtual = false,
+                 ._virtual_now_ns = 0,
+                 ._pinned_ns = 0,
+                 ._pins = 0,
+                 .tick = _tick,
+                 .now = _now,
+                 .now_ns = _now_ns,
+                 .set_time = _set_time,
+                 .reset = _reset,
+                 .pin = _pin,
+                 .unpin = _unpin};
+  timer._last_tick_ns = timer.now_ns(&timer);
+  return timer;
+}
 
-  return (Timer){.ticks = 0,
-                 .timeout_sec = timeout_sec,
-                 ._last_tick = last_tick,
-                 .tick = _tick};
+/**
+ * @brief Creates a new Timer instance driven by a virtual clock.
+ *
+ * The virtual clock and the last tick both start at zero. Time only advances
+ * through `set_time`, so a sequence of `set_time`/`tick` calls is fully
+ * reproducible.
+ *
+ * @param timeout_ns The timeout value in nanoseconds for the Timer.
+ * @return A Timer structure initialized with the specified timeout.
+ */
+Timer create_virtual_timer(long long timeout_ns) {
+  Timer timer = create_timer(timeout_ns);
+  timer.is_virtual = true;
+  timer._last_tick_ns = 0;
+  timer._virtual_now_ns = 0;
+  return timer;
 }
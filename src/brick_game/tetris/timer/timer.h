@@ -1,3 +1,6 @@
+#ifndef BRICKGAME_TETRIS_TIMER_TIMER_H
+#define BRICKGAME_TETRIS_TIMER_TIMER_H
+
 #include <stdbool.h>
 #include <time.h>
 
@@ -5,33 +8,92 @@
  * @brief Structure representing a game timer for Tetris.
  *
  * This structure encapsulates the functionality of a game timer, including the
- * number of ticks, the timeout in seconds, the last tick time, and a function
- * pointer for the tick function. The timer is used to manage the timing of game
- * events, such as piece movement and game updates.
+ * number of ticks, the timeout in nanoseconds, the last tick time, and a
+ * function pointer for the tick function. The timer is used to manage the
+ * timing of game events, such as piece movement and game updates.
+ *
+ * A timer can run on the monotonic clock or on a virtual clock. A virtual
+ * timer never reads the system time: its "now" is moved explicitly with
+ * `set_time`, which makes replays and simulations independent of real time.
+ * The monotonic clock does not jump when the system time is changed, and all
+ * the arithmetic is done in integer nanoseconds.
+ *
+ * Ticks keep their place on the clock: a late `tick` call returns every tick
+ * that elapsed since the previous one and the next tick stays due where it
+ * was, so the ticks of a long run do not drift however late they are asked
+ * for.
+ *
+ * `pin` reads the clock once and the timer keeps that time until `unpin`, so
+ * everything done at one instant, such as a tick and its replay event, sees
+ * the same time. Pins nest, the clock runs again after the last `unpin`.
  *
  * @struct Timer
  * @var ticks The number of ticks that have occurred since the timer was
  * started.
- * @var timeout_sec The timeout in seconds for the timer.
- * @var _last_tick A timespec structure representing the time of the last tick.
- * @var tick A function pointer for the tick function, which is called on each
- * tick.
+ * @var timeout_ns The timeout in nanoseconds for the timer.
+ * @var is_virtual Whether the timer runs on a virtual clock.
+ * @var _last_tick_ns The time of the last tick.
+ * @var _virtual_now_ns The current time of the virtual clock.
+ * @var _pinned_ns The time the clock is pinned to.
+ * @var _pins The number of `pin` calls not undone by `unpin` yet.
+ * @var tick A function pointer for the tick function, which returns the number
+ * of ticks that elapsed since the previous call.
+ * @var now A function pointer returning the current time of the timer clock.
+ * @var now_ns A function pointer returning the current time of the timer clock
+ * in nanoseconds.
+ * @var set_time A function pointer moving the virtual clock to a given time.
+ * @var reset A function pointer restarting the tick period from the current
+ * time.
+ * @var pin A function pointer pinning the clock to the current time and
+ * returning it.
+ * @var unpin A function pointer undoing a `pin`.
  */
 typedef struct __timer {
   int ticks;
-  double timeout_sec;
-  struct timespec _last_tick;
-  bool (*tick)(struct __timer *self);
+  long long timeout_ns;
+  bool is_virtual;
+  long long _last_tick_ns;
+  long long _virtual_now_ns;
+  long long _pinned_ns;
+  int _pins;
+  int (*tick)(struct __timer *self);
+  struct timespec (*now)(struct __timer *self);
+  long long (*now_ns)(struct __timer *self);
+  void (*set_time)(struct __timer *self, struct timespec now);
+  void (*reset)(struct __timer *self);
+  struct timespec (*pin)(struct __timer *self);
+  void (*unpin)(struct __timer *self);
 } Timer;
 
 /**
  * @brief Creates a new timer with a specified timeout.
  *
- * This function initializes a new timer with a given timeout period in seconds.
- * The timer can be used to schedule events or actions to occur after the
- * specified timeout.
+ * This function initializes a new timer with a given timeout period in
+ * nanoseconds. The timer can be used to schedule events or actions to occur
+ * after the specified timeout.
  *
- * @param timeout_sec The timeout period in seconds for the timer.
+ * @param timeout_ns The timeout period in nanoseconds for the timer.
  * @return A Timer structure representing the newly created timer.
  */
-Timer create_timer(double timeout_sec);
\ No newline at end of file
+Timer create_timer(long long timeout_ns);
+
+/**
+ * @brief Creates a new timer driven by a virtual clock.
+ *
+ * The virtual clock starts at zero and only moves when `set_time` is called.
+ *
+ * @param timeout_ns The timeout period in nanoseconds for the timer.
+ * @return A Timer structure representing the newly created virtual timer.
+ */
+Timer create_virtual_timer(long long timeout_ns);
+
+/**
+ * @brief Returns the difference between two timespec values in nanoseconds.
+ *
+ * @param end The later time.
+ * @param start The earlier time.
+ * @return `end - start` in nanoseconds.
+ */
+long long timespec_diff_ns(struct timespec end, struct timespec start);
+
+#endif  // !BRICKGAME_TETRIS_TIMER_TIMER_H
@@ -97,6 +97,26 @@ size_t get_level_by_score(int score) {
   return lvl;
 }
 
+/**
+ * @brief Returns the gravity of a level.
+ *
+ * The levels keep the periods the game always had, 500ms a cell at the first
+ * level down to 50ms at the tenth, as 30 down to 3 frames of 60Hz. Each value
+ * is rounded up, so a whole number of periods always moves the whole number of
+ * cells.
+ *
+ * @param level The level.
+ * @return The gravity of the level in 16.16 fixed point cells per frame.
+ */
+int get_gravity_by_level(int level) {
+  static const int gravities[] = {2185, 2428, 2731, 3121, 3641,
+                                  4370, 5462, 7282, 10923, 21846};
+  int count = sizeof(gravities) / sizeof(gravities[0]);
+  if (level < 1) level = 1;
+  if (level > count) level = count;
+  return gravities[level - 1];
+}
+
 /**
  * @brief Reads the highscore from a file.
  *
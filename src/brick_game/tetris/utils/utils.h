@@ -60,6 +60,18 @@ size_t get_reward_count(int ereased_lines);
  */
 size_t get_level_by_score(int score);
 
+/**
+ * @brief Returns the gravity of a level.
+ *
+ * The gravity is the distance the active brick falls in one frame, in cells in
+ * 16.16 fixed point: `TETRIS_GRAVITY_ONE` is a cell per frame. A level out of
+ * range gets the gravity of the nearest level.
+ *
+ * @param level The level.
+ * @return The gravity of the level.
+ */
+int get_gravity_by_level(int level);
+
 /**
  * @brief Reads the high score from a file.
  *
@@ -4,10 +4,16 @@
 #include <ncurses.h>
 
 #include "components/components.h"
+#include "governor/governor.h"
 #include "keyboard/keyboard.h"
 #include "layouts/layouts.h"
+#include "loop/loop.h"
+#include "recorder/recorder.h"
+#include "renderer/renderer.h"
 #include "theme/theme.h"
 #include "utils/utils.h"
+#include "views/game_view.h"
+#include "views/spectator_view.h"
 #include "views/views.h"
 
 #endif  // !CLI_H
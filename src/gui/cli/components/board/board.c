@@ -1,5 +1,36 @@
 #include "board.h"
 
+/**
+ * @brief Draws a single board cell.
+ *
+ * Empty cells are drawn as blanks with the attributes of the window
+ * background, so a redrawn empty cell looks exactly like an erased one.
+ *
+ * @param wrapper The board window.
+ * @param row The row of the cell.
+ * @param col The column of the cell.
+ * @param value The brick color of the cell or 0 if the cell is empty.
+ * @param render_type The rendering type of the board.
+ * @param is_compact Whether the cell is one column wide instead of two.
+ */
+static void draw_cell(WINDOW *wrapper, size_t row, size_t col, int value,
+                      enum BoardRenderTypeEnum render_type, bool is_compact) {
+  int brick_attr = A_NORMAL;
+  if (value) {
+    Pallete *pallete = provide_pallete();
+    brick_attr = COLOR_PAIR(pallete->get_brick_pair(value));
+    if (render_type == BOARD_RENDER_TYPE_COLORLESS) brick_attr |= WA_REVERSE;
+  }
+
+  wattrset(wrapper, brick_attr);
+  if (is_compact) {
+    mvwaddch(wrapper, row + 1, col + 1, ' ');
+  } else {
+    mvwaddstr(wrapper, row + 1, (col * 2) + 1, "  ");
+  }
+  wattrset(wrapper, A_NORMAL);
+}
+
 /**
  * @brief Renders a board component on a specified window using its properties.
  *
@@ -9,54 +40,59 @@
  * its background color, and then renders the board component based on the
  * specified render type.
  *
+ * If the properties carry a valid cache for the same position, render type and
+ * width, the frame is kept and only the cells that differ from the cache are
+ * drawn. Otherwise the whole board is drawn and the cache is filled. The
+ * subwindow is kept in the cache, so drawing with a cache allocates nothing.
+ *
  * @param window The ncurses window where the board component will be rendered.
  * @param props The properties of the board component, including data, position,
  * rendering type, and attributes.
  */
 void board_component(WINDOW *window, BoardComponentProps props) {
-  if (!window) return;
+  if (!window || !props.data.matrix) return;
+
+  BoardComponentCache *cache = props.cache;
+  bool is_incremental = cache && cache->is_valid &&
+                        cache->pos.x == props.pos.x &&
+                        cache->pos.y == props.pos.y &&
+                        cache->render_type == props.render_type &&
+                        cache->is_compact == props.is_compact;
 
+  int height = BOARD_COMPONENT_HEIGHT + 2;
+  int width = (BOARD_COMPONENT_WIDTH * (props.is_compact ? 1 : 2)) + 2;
   WINDOW *wrapper =
-      derwin(window, BOARD_COMPONENT_HEIGHT + 2,
-             (BOARD_COMPONENT_WIDTH * 2) + 2, props.pos.y, props.pos.x);
-  box(wrapper, 0, 0);
-  wbkgd(wrapper, props.attrs);
-
-  Pallete *pallete = provide_pallete();
-
-  if (props.render_type == BOARD_RENDER_TYPE_DEFAULT) {
-    for (size_t row = 0; (row < BOARD_COMPONENT_HEIGHT) && props.data.matrix;
-         row++) {
-      for (size_t col = 0; (col < BOARD_COMPONENT_WIDTH) && props.data.matrix;
-           col++) {
-        int brick_attr = props.data.matrix[row][col]
-                             ? COLOR_PAIR(pallete->get_brick_pair(
-                                   props.data.matrix[row][col]))
-                             : WA_DIM;
-        wattron(wrapper, brick_attr);
-        mvwprintw(wrapper, row + 1, (col * 2) + 1, "%s",
-                  props.data.matrix[row][col] ? "  " : "");
-        wattroff(wrapper, brick_attr);
-      }
-    }
+      cache ? provide_subwindow(&cache->wrapper, window, height, width,
+                                props.pos.y, props.pos.x)
+            : derwin(window, height, width, props.pos.y, props.pos.x);
+  if (!wrapper) return;
 
-  } else if (props.render_type == BOARD_RENDER_TYPE_COLORLESS) {
-    for (size_t row = 0; row < BOARD_COMPONENT_HEIGHT; row++) {
-      for (size_t col = 0; col < BOARD_COMPONENT_WIDTH; col++) {
-        int brick_attr = props.data.matrix[row][col]
-                             ? COLOR_PAIR(pallete->get_brick_pair(
-                                   props.data.matrix[row][col])) |
-                                   WA_REVERSE
-                             : WA_DIM;
-        wattron(wrapper, brick_attr);
-        mvwprintw(wrapper, row + 1, (col * 2) + 1,
-                  props.data.matrix[row][col] ? "  " : "");
-        wattroff(wrapper, brick_attr);
+  if (!is_incremental) {
+    box(wrapper, 0, 0);
+    wbkgd(wrapper, props.attrs);
+  }
+
+  for (size_t row = 0; row < BOARD_COMPONENT_HEIGHT; row++) {
+    for (size_t col = 0; col < BOARD_COMPONENT_WIDTH; col++) {
+      int value = props.data.matrix[row][col];
+      if (is_incremental && cache->matrix[row][col] == value) continue;
+
+      draw_cell(wrapper, row, col, value, props.render_type, props.is_compact);
+      if (cache) {
+        cache->matrix[row][col] = value;
+        cache->cells_drawn++;
       }
     }
   }
 
+  if (cache) {
+    cache->is_valid = true;
+    cache->pos = props.pos;
+    cache->render_type = props.render_type;
+    cache->is_compact = props.is_compact;
+  }
+
   wnoutrefresh(wrapper);
-  delwin(wrapper);
+  if (!cache) delwin(wrapper);
   wrapper = NULL;
 }
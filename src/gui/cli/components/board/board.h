@@ -50,25 +50,56 @@ enum BoardRenderTypeEnum {
   BOARD_RENDER_TYPE_COLORLESS,
 };
 
+/**
+ * @brief Cells of a board as they were last drawn on the screen.
+ *
+ * A board drawn with a valid cache only repaints the cells that changed since
+ * the previous frame, the frame and the unchanged cells are left as they are.
+ * The cache must be invalidated whenever the window under the board is erased.
+ *
+ * @struct BoardComponentCache
+ * @var is_valid Whether the window still shows the cached cells.
+ * @var pos The position the board was drawn at.
+ * @var render_type The render type the board was drawn with.
+ * @var is_compact Whether the board was drawn with one column per cell.
+ * @var matrix The cell values that were drawn.
+ * @var cells_drawn The number of cells drawn so far, for render statistics.
+ * @var wrapper The window of the board, kept across frames.
+ */
+typedef struct {
+  bool is_valid;
+  BoardComponentPosition pos;
+  enum BoardRenderTypeEnum render_type;
+  bool is_compact;
+  int matrix[BOARD_COMPONENT_HEIGHT][BOARD_COMPONENT_WIDTH];
+  unsigned long cells_drawn;
+  SubWindow wrapper;
+} BoardComponentCache;
+
 /**
  * @brief Defines the properties of a board component for a UI library using
  * ncurses.
  *
  * This structure encapsulates the data, position, rendering type, and
  * attributes of a board component, designed for use within a terminal-based UI
- * library that leverages the ncurses library for rendering.
+ * library that leverages the ncurses library for rendering. A compact board
+ * draws every cell one column wide instead of two, it is half as wide and its
+ * cells are no longer square.
  */
 typedef struct {
   BoardComponentData data;
   BoardComponentPosition pos;
   enum BoardRenderTypeEnum render_type;
+  bool is_compact;
   int attrs;
+  BoardComponentCache *cache;
 } BoardComponentProps;
 
 /**
  * @brief Renders a board component on a specified window using its properties.
  *
- * This function takes a window and the properties of a board component.
+ * This function takes a window and the properties of a board component. With
+ * a valid cache in the properties only the changed cells are drawn.
  *
  * @param window The ncurses window where the board component will be rendered.
  * @param props The properties of the board component, including data, position,
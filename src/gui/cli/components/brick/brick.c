@@ -1,5 +1,31 @@
 #include "brick.h"
 
+/**
+ * @brief Draws a single preview cell.
+ *
+ * Empty cells are drawn as blanks with the attributes of the window
+ * background, so a redrawn empty cell looks exactly like an erased one.
+ *
+ * @param wrapper The preview window.
+ * @param row The row of the cell.
+ * @param col The column of the cell.
+ * @param value The brick color of the cell or 0 if the cell is empty.
+ * @param render_type The rendering type of the preview.
+ */
+static void draw_cell(WINDOW *wrapper, size_t row, size_t col, int value,
+                      enum BrickComponentRenderTypeEnum render_type) {
+  int brick_attr = A_NORMAL;
+  if (value) {
+    Pallete *pallete = provide_pallete();
+    brick_attr = COLOR_PAIR(pallete->get_brick_pair(value));
+    if (render_type == BRICK_RENDER_TYPE_COLORLESS) brick_attr |= WA_REVERSE;
+  }
+
+  wattrset(wrapper, brick_attr);
+  mvwaddstr(wrapper, row + 1, (col * 2) + 2, "  ");
+  wattrset(wrapper, A_NORMAL);
+}
+
 /**
  * @brief Renders a brick component on a specified window using its properties.
  *
@@ -10,69 +36,66 @@
  * rendering type. The rendering can be either default or digits, with the
  * latter displaying the matrix values as digits.
  *
+ * If the properties carry a valid cache for the same position and render type,
+ * the frame and the title are kept and only the changed cells are drawn. The
+ * subwindow is kept in the cache, so drawing with a cache allocates nothing.
+ *
  * @param window The ncurses window where the brick component will be rendered.
  * @param props The properties of the brick component, including position, data,
  * attributes, and rendering type.
  */
 void brick_component(WINDOW *window, BrickComponentProps props) {
-  if (!window) return;
+  if (!window || !props.data.matrix) return;
+
+  BrickComponentCache *cache = props.cache;
+  bool is_incremental = cache && cache->is_valid &&
+                        cache->pos.x == props.pos.x &&
+                        cache->pos.y == props.pos.y &&
+                        cache->render_type == props.render_type;
 
   WINDOW *wrapper =
-      derwin(window, props.height, props.width, props.pos.y, props.pos.x);
-  box(wrapper, 0, 0);
-  wbkgd(wrapper, props.attrs);
+      cache ? provide_subwindow(&cache->wrapper, window, props.height,
+                                props.width, props.pos.y, props.pos.x)
+            : derwin(window, props.height, props.width, props.pos.y,
+                     props.pos.x);
+  if (!wrapper) return;
 
-  wattron(wrapper, WA_REVERSE);
-  for (size_t i = 0; i < props.width; i++) mvwprintw(wrapper, 0, i, "%c", ' ');
-  mvwprintw(wrapper, 0, (props.width - strlen(props.data.title)) / 2, "%s",
-            props.data.title);
-  wattroff(wrapper, WA_REVERSE);
-  Pallete *pallete = provide_pallete();
+  if (!is_incremental) {
+    box(wrapper, 0, 0);
+    wbkgd(wrapper, props.attrs);
 
-  if (props.render_type == BRICK_RENDER_TYPE_DEFAULT) {
-    for (size_t row = 0; (row < props.data.height) && props.data.matrix;
-         row++) {
-      for (size_t col = 0; (col < props.data.width) && props.data.matrix;
-           col++) {
-        wattron(wrapper, props.data.matrix[row][col]
-                             ? COLOR_PAIR(pallete->get_brick_pair(
-                                   props.data.matrix[row][col]))
-                             : WA_DIM);
-        mvwprintw(wrapper, row + 1, (col * 2) + 2, "%s",
-                  props.data.matrix[row][col] ? "  " : "");
-        wattroff(wrapper, WA_DIM);
-      }
+    wattron(wrapper, WA_REVERSE);
+    for (size_t i = 0; i < props.width; i++) {
+      mvwprintw(wrapper, 0, i, "%c", ' ');
     }
+    mvwprintw(wrapper, 0, (props.width - strlen(props.data.title)) / 2, "%s",
+              props.data.title);
+    wattroff(wrapper, WA_REVERSE);
+  }
 
-  } else if (props.render_type == BRICK_RENDER_TYPE_COLORLESS) {
-    // for (size_t row = 0; (row < props.data.height) && props.data.matrix;
-    //      row++) {
-    //   for (size_t col = 0; (col < props.data.width) && props.data.matrix;
-    //        col++) {
-    //     if (!props.data.matrix[row][col]) {
-    //       wattron(wrapper, WA_DIM);
-    //     }
-    //     mvwprintw(wrapper, row + 1, (col * 2) + 2, "%d ",
-    //               props.data.matrix[row][col]);
-    //     wattroff(wrapper, WA_DIM);
-    //   }
-    // }
-    for (size_t row = 0; row < props.data.height; row++) {
-      for (size_t col = 0; col < props.data.width; col++) {
-        int brick_attr = props.data.matrix[row][col]
-                             ? COLOR_PAIR(pallete->get_brick_pair(
-                                   props.data.matrix[row][col])) |
-                                   WA_REVERSE
-                             : WA_DIM;
-        wattron(wrapper, brick_attr);
-        mvwprintw(wrapper, row + 1, (col * 2) + 2,
-                  props.data.matrix[row][col] ? "  " : "");
-        wattroff(wrapper, brick_attr);
-      }
+  size_t height = props.data.height < BRICK_COMPONENT_HEIGHT
+                      ? props.data.height
+                      : BRICK_COMPONENT_HEIGHT;
+  size_t width = props.data.width < BRICK_COMPONENT_WIDTH
+                     ? props.data.width
+                     : BRICK_COMPONENT_WIDTH;
+  for (size_t row = 0; row < height; row++) {
+    for (size_t col = 0; col < width; col++) {
+      int value = props.data.matrix[row][col];
+      if (is_incremental && cache->matrix[row][col] == value) continue;
+
+      draw_cell(wrapper, row, col, value, props.render_type);
+      if (cache) cache->matrix[row][col] = value;
     }
   }
 
+  if (cache) {
+    cache->is_valid = true;
+    cache->pos = props.pos;
+    cache->render_type = props.render_type;
+  }
+
   wnoutrefresh(window);
-  delwin(wrapper);
+  if (!cache) delwin(wrapper);
   wrapper = NULL;
-}
\ No newline at end of file
+}
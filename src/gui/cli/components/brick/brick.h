@@ -50,6 +50,28 @@ enum BrickComponentRenderTypeEnum {
   BRICK_RENDER_TYPE_COLORLESS,
 };
 
+/**
+ * @brief Cells of a brick preview as they were last drawn on the screen.
+ *
+ * A preview drawn with a valid cache only repaints the cells that changed since
+ * the previous frame. The cache must be invalidated whenever the window under
+ * the preview is erased.
+ *
+ * @struct BrickComponentCache
+ * @var is_valid Whether the window still shows the cached cells.
+ * @var pos The position the preview was drawn at.
+ * @var render_type The render type the preview was drawn with.
+ * @var matrix The cell values that were drawn.
+ * @var wrapper The window of the preview, kept across frames.
+ */
+typedef struct {
+  bool is_valid;
+  BrickComponentPosition pos;
+  enum BrickComponentRenderTypeEnum render_type;
+  int matrix[BRICK_COMPONENT_HEIGHT][BRICK_COMPONENT_WIDTH];
+  SubWindow wrapper;
+} BrickComponentCache;
+
 /**
  * @brief Defines the properties of a brick component for a Tetris game.
  *
@@ -68,6 +90,8 @@ enum BrickComponentRenderTypeEnum {
  * @var enum BrickComponentRenderTypeEnum render_type The type of rendering for
  * the brick component.
  * @var int attrs Additional attributes or flags for subwin component.
+ * @var BrickComponentCache *cache The cells drawn by the previous frame or
+ * NULL to always draw the whole component.
  */
 typedef struct {
   BrickComponentData data;
@@ -76,6 +100,7 @@ typedef struct {
   size_t height;
   enum BrickComponentRenderTypeEnum render_type;
   int attrs;
+  BrickComponentCache *cache;
 } BrickComponentProps;
 
 /**
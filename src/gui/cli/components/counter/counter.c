@@ -12,6 +12,11 @@
  * current value of the counter. The value is formatted as an integer and
  * displayed in bold.
  *
+ * If the properties carry a valid cache for the same position, nothing is
+ * drawn while the value is unchanged and only the value row is redrawn when it
+ * changes. The subwindow is kept in the cache, so drawing with a cache
+ * allocates nothing.
+ *
  * @param window The ncurses window where the counter component will be
  * rendered.
  * @param props The properties of the counter component, including position,
@@ -20,17 +25,37 @@
 void counter_component(WINDOW *window, CounterComponentProps props) {
   if (!window) return;
 
+  CounterComponentCache *cache = props.cache;
+  bool is_incremental = cache && cache->is_valid &&
+                        cache->pos.x == props.pos.x &&
+                        cache->pos.y == props.pos.y;
+  if (is_incremental && cache->value == props.data.value) return;
+
   WINDOW *wrapper =
-      derwin(window, props.height, props.width, props.pos.y, props.pos.x);
-  wbkgd(wrapper, props.attrs);
-  box(wrapper, 0, 0);
+      cache ? provide_subwindow(&cache->wrapper, window, props.height,
+                                props.width, props.pos.y, props.pos.x)
+            : derwin(window, props.height, props.width, props.pos.y,
+                     props.pos.x);
+  if (!wrapper) return;
 
-  int header_attrs = WA_REVERSE;
-  wattron(wrapper, header_attrs);
-  for (size_t i = 0; i < props.width; i++) mvwprintw(wrapper, 0, i, "%c", ' ');
-  mvwprintw(wrapper, 0, (props.width - strlen(props.data.title)) / 2, "%s",
-            props.data.title);
-  wattroff(wrapper, header_attrs);
+  if (!is_incremental) {
+    wbkgd(wrapper, props.attrs);
+    box(wrapper, 0, 0);
+
+    int header_attrs = WA_REVERSE;
+    wattron(wrapper, header_attrs);
+    for (size_t i = 0; i < props.width; i++) {
+      mvwprintw(wrapper, 0, i, "%c", ' ');
+    }
+    mvwprintw(wrapper, 0, (props.width - strlen(props.data.title)) / 2, "%s",
+              props.data.title);
+    wattroff(wrapper, header_attrs);
+  } else {
+    // the new value may be shorter than the old one
+    for (size_t i = 1; i + 1 < props.width; i++) {
+      mvwaddch(wrapper, 1, i, ' ');
+    }
+  }
 
   char value_str[props.width];
   snprintf(value_str, props.width, "%d", props.data.value);
@@ -41,7 +66,13 @@ void counter_component(WINDOW *window, CounterComponentProps props) {
             props.data.value);
   wattroff(wrapper, value_attrs);
 
+  if (cache) {
+    cache->is_valid = true;
+    cache->pos = props.pos;
+    cache->value = props.data.value;
+  }
+
   wnoutrefresh(window);  // TODO: OR WRAPPER??
-  delwin(wrapper);
+  if (!cache) delwin(wrapper);
   wrapper = NULL;
 }
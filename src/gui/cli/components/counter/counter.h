@@ -4,6 +4,8 @@
 #include <ncurses.h>
 #include <string.h>
 
+#include "../../utils/utils.h"
+
 /**
  * @brief Defines the data structure for a counter component, including its
  * value and title.
@@ -29,6 +31,26 @@ typedef struct {
   int y;
 } CounterComponentPosition;
 
+/**
+ * @brief The value of a counter as it was last drawn on the screen.
+ *
+ * A counter drawn with a valid cache is left untouched while its value stays
+ * the same. The cache must be invalidated whenever the window under the
+ * counter is erased.
+ *
+ * @struct CounterComponentCache
+ * @var is_valid Whether the window still shows the cached value.
+ * @var pos The position the counter was drawn at.
+ * @var value The value that was drawn.
+ * @var wrapper The window of the counter, kept across frames.
+ */
+typedef struct {
+  bool is_valid;
+  CounterComponentPosition pos;
+  int value;
+  SubWindow wrapper;
+} CounterComponentCache;
+
 /**
  * @brief Defines the properties of a counter component, including its data,
  * position, dimensions, and attributes.
@@ -45,6 +67,7 @@ typedef struct {
   size_t width;
   size_t height;
   int attrs;
+  CounterComponentCache *cache;
 } CounterComponentProps;
 
 /**
@@ -57,7 +80,8 @@ typedef struct {
  * background color, and renders the counter component. The counter component
  * includes a header displaying its title and a value area displaying the
  * current value of the counter. The value is formatted as an integer and
- * displayed in bold.
+ * displayed in bold. With a valid cache in the properties only a changed
+ * value is drawn.
  *
  * @param window The ncurses window where the counter component will be
  * rendered.
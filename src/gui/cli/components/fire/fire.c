@@ -1,5 +1,16 @@
 #include "fire.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define FIRE_HAS_AVX2 1
+#endif
+
+#define FIRE_RUN_SIZE 64
+
+static const char fire_glyphs[] = " school21";
+// the hottest glyph, the terminating NUL is not one
+#define FIRE_GLYPH_MAX (sizeof(fire_glyphs) - 2)
+
 /**
  * @brief Initializes color pairs for the fire component.
  *
@@ -11,32 +22,359 @@ static void init_fire_component_colors() {
   init_pair(103, ON_BACKGROUND_COLOR, SURFACE_COLOR);
 }
 
+/**
+ * @brief Returns the color pair of a heat.
+ *
+ * @param heat The heat of a cell.
+ * @return The color pair.
+ */
+static short fire_pair(uint8_t heat) {
+  if (heat > 15) return 102;
+  if (heat > 9) return 101;
+  if (heat > 4) return 100;
+  return 103;
+}
+
+/**
+ * @brief Cools the cells of a row in plain C.
+ *
+ * @param top The row.
+ * @param bottom The row under it.
+ * @param out Where the cooled row is written.
+ * @param from The first cell to cool.
+ * @param width The number of cells in the row.
+ */
+static void cool_row_scalar(const uint8_t *top, const uint8_t *bottom,
+                            uint8_t *out, int from, int width) {
+  for (int x = from; x < width; x++) {
+    out[x] = (uint8_t)((top[x] + top[x + 1] + bottom[x] + bottom[x + 1]) >> 2);
+  }
+}
+
+#ifdef __SSE2__
+/**
+ * @brief Cools the cells of a row, 16 at a time.
+ *
+ * The bytes are widened to 16 bits, so the sum of the four neighbours does not
+ * overflow and the average is rounded down like in plain C.
+ *
+ * @param top The row.
+ * @param bottom The row under it.
+ * @param out Where the cooled row is written.
+ * @param width The number of cells in the row.
+ * @return The number of cooled cells, the rest is left to plain C.
+ */
+static int cool_row_sse2(const uint8_t *top, const uint8_t *bottom,
+                         uint8_t *out, int width) {
+  const __m128i zero = _mm_setzero_si128();
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m128i a = _mm_loadu_si128((const __m128i *)(top + x));
+    __m128i b = _mm_loadu_si128((const __m128i *)(top + x + 1));
+    __m128i c = _mm_loadu_si128((const __m128i *)(bottom + x));
+    __m128i d = _mm_loadu_si128((const __m128i *)(bottom + x + 1));
+
+    __m128i low = _mm_add_epi16(
+        _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)),
+        _mm_add_epi16(_mm_unpacklo_epi8(c, zero), _mm_unpacklo_epi8(d, zero)));
+    __m128i high = _mm_add_epi16(
+        _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)),
+        _mm_add_epi16(_mm_unpackhi_epi8(c, zero), _mm_unpackhi_epi8(d, zero)));
+
+    _mm_storeu_si128((__m128i *)(out + x),
+                     _mm_packus_epi16(_mm_srli_epi16(low, 2),
+                                      _mm_srli_epi16(high, 2)));
+  }
+  return x;
+}
+#endif
+
+#ifdef FIRE_HAS_AVX2
+/**
+ * @brief Cools the cells of a row, 32 at a time.
+ *
+ * Unpacking and packing both work within the 128-bit lanes, so the cells come
+ * out in order.
+ *
+ * @param top The row.
+ * @param bottom The row under it.
+ * @param out Where the cooled row is written.
+ * @param width The number of cells in the row.
+ * @return The number of cooled cells, the rest is left to plain C.
+ */
+__attribute__((target("avx2"))) static int cool_row_avx2(const uint8_t *top,
+                                                         const uint8_t *bottom,
+                                                         uint8_t *out,
+                                                         int width) {
+  const __m256i zero = _mm256_setzero_si256();
+  int x = 0;
+  for (; x + 32 <= width; x += 32) {
+    __m256i a = _mm256_loadu_si256((const __m256i *)(top + x));
+    __m256i b = _mm256_loadu_si256((const __m256i *)(top + x + 1));
+    __m256i c = _mm256_loadu_si256((const __m256i *)(bottom + x));
+    __m256i d = _mm256_loadu_si256((const __m256i *)(bottom + x + 1));
+
+    __m256i low = _mm256_add_epi16(
+        _mm256_add_epi16(_mm256_unpacklo_epi8(a, zero),
+                         _mm256_unpacklo_epi8(b, zero)),
+        _mm256_add_epi16(_mm256_unpacklo_epi8(c, zero),
+                         _mm256_unpacklo_epi8(d, zero)));
+    __m256i high = _mm256_add_epi16(
+        _mm256_add_epi16(_mm256_unpackhi_epi8(a, zero),
+                         _mm256_unpackhi_epi8(b, zero)),
+        _mm256_add_epi16(_mm256_unpackhi_epi8(c, zero),
+                         _mm256_unpackhi_epi8(d, zero)));
+
+    _mm256_storeu_si256((__m256i *)(out + x),
+                        _mm256_packus_epi16(_mm256_srli_epi16(low, 2),
+                                            _mm256_srli_epi16(high, 2)));
+  }
+  return x;
+}
+#endif
+
+/**
+ * @brief Cools the rows of a heat buffer with the fastest kernel the CPU
+ * supports.
+ *
+ * The vector kernels only cool whole vectors of a row, plain C cools the rest.
+ * Every kernel reads at most one cell past the cooled ones, the padding cell
+ * of the row.
+ *
+ * @param heat The heat, `height + 1` rows of `stride` cells.
+ * @param next Where the cooled rows are written.
+ * @param width The number of cells cooled in a row, less than `stride`.
+ * @param height The number of cooled rows.
+ * @param stride The distance between two rows.
+ */
+void cool_fire_rows(const uint8_t *heat, uint8_t *next, int width, int height,
+                    int stride) {
+#ifdef FIRE_HAS_AVX2
+  static int has_avx2 = -1;
+  if (has_avx2 < 0) has_avx2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+#endif
+
+  for (int y = 0; y < height; y++) {
+    const uint8_t *top = heat + y * stride;
+    const uint8_t *bottom = top + stride;
+    uint8_t *out = next + y * stride;
+
+    int from = 0;
+#ifdef FIRE_HAS_AVX2
+    if (has_avx2) from = cool_row_avx2(top, bottom, out, width);
+#endif
+#ifdef __SSE2__
+    from += cool_row_sse2(top + from, bottom + from, out + from, width - from);
+#endif
+    cool_row_scalar(top, bottom, out, from, width);
+  }
+}
+
+/**
+ * @brief Returns the next number of the xorshift generator of a fire.
+ *
+ * @param cache The fire simulation.
+ * @return A pseudo-random number.
+ */
+static uint32_t next_fire_random(FireComponentCache *cache) {
+  uint32_t x = cache->rng;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  cache->rng = x;
+  return x;
+}
+
+/**
+ * @brief Frees the buffers and the window of a fire simulation.
+ *
+ * @param cache The fire simulation.
+ */
+void release_fire_component(FireComponentCache *cache) {
+  if (!cache) return;
+  free(cache->_buffers);
+  cache->_buffers = NULL;
+  cache->heat = NULL;
+  cache->next = NULL;
+  cache->width = 0;
+  cache->height = 0;
+  cache->scale = 0;
+  cache->time_ns = 0;
+  release_subwindow(&cache->wrapper);
+}
+
+/**
+ * @brief Makes the buffers of a fire simulation fit the size of the fire.
+ *
+ * Both buffers come from a single zeroed allocation, the padding cells stay
+ * cold forever. A resized or rescaled fire starts cold.
+ *
+ * @param cache The fire simulation.
+ * @param height The height of the fire on the screen.
+ * @param width The width of the fire on the screen.
+ * @param scale The number of screen rows and columns a simulated cell covers.
+ */
+static void fit_fire_buffers(FireComponentCache *cache, int height, int width,
+                             int scale) {
+  height = (height + scale - 1) / scale;
+  width = (width + scale - 1) / scale;
+  if (cache->heat && cache->height == height && cache->width == width &&
+      cache->scale == scale) {
+    return;
+  }
+
+  free(cache->_buffers);
+  size_t size = (size_t)(width + 1) * (height + 1);
+  cache->_buffers = (uint8_t *)calloc(size * 2, sizeof(uint8_t));
+  if (!cache->_buffers) {
+    fprintf(stderr, "Cannot allocate mem for FireComponentCache\n");
+    exit(-1);
+  }
+  cache->heat = cache->_buffers;
+  cache->next = cache->_buffers + size;
+  cache->width = width;
+  cache->height = height;
+  cache->scale = scale;
+  cache->stride = width + 1;
+  if (!cache->rng) cache->rng = FIRE_COMPONENT_SEED;
+}
+
+/**
+ * @brief Runs a simulation step: throws sparks into the bottom row, cools the
+ * rows into the back buffer and swaps the buffers.
+ *
+ * @param cache The fire simulation.
+ */
+static void step_fire(FireComponentCache *cache) {
+  uint8_t *bottom = cache->heat + (cache->height - 1) * cache->stride;
+  for (int i = 0; i < cache->width / FIRE_COMPONENT_SPARKS_WIDTH; i++) {
+    bottom[next_fire_random(cache) % cache->width] = FIRE_COMPONENT_HEAT;
+  }
+
+  cool_fire_rows(cache->heat, cache->next, cache->width, cache->height,
+                 cache->stride);
+
+  uint8_t *heat = cache->heat;
+  cache->heat = cache->next;
+  cache->next = heat;
+  cache->steps++;
+}
+
+/**
+ * @brief Runs the simulation steps due at the time of the frame.
+ *
+ * A simulation lagging more than `FIRE_COMPONENT_MAX_STEPS` steps behind
+ * drops the rest instead of catching up, so a stalled frame does not make the
+ * next one slower.
+ *
+ * @param cache The fire simulation.
+ * @param now_ns The time of the frame or 0 for a single step.
+ * @param step_ns The time of a simulation step.
+ */
+static void advance_fire(FireComponentCache *cache, long long now_ns,
+                         long long step_ns) {
+  if (now_ns <= 0) {
+    step_fire(cache);
+    return;
+  }
+
+  if (!cache->time_ns) {
+    cache->time_ns = now_ns;
+    step_fire(cache);
+    return;
+  }
+
+  int steps = 0;
+  while (now_ns - cache->time_ns >= step_ns &&
+         steps < FIRE_COMPONENT_MAX_STEPS) {
+    step_fire(cache);
+    cache->time_ns += step_ns;
+    steps++;
+  }
+  if (now_ns - cache->time_ns >= step_ns) {
+    cache->time_ns = now_ns;
+  }
+}
+
+/**
+ * @brief Writes a run of cells of the same color.
+ *
+ * The cells carry their color and attributes, so none of them is zero and
+ * the whole run is written.
+ *
+ * @param wrapper The fire window.
+ * @param y The row of the run.
+ * @param x The column of the run.
+ * @param run The cells.
+ * @param length The number of cells.
+ */
+static void flush_fire_run(WINDOW *wrapper, int y, int x, const chtype *run,
+                           int length) {
+  if (!length) return;
+  mvwaddchnstr(wrapper, y, x, run, length);
+}
+
+/**
+ * @brief Draws the heat of the front buffer.
+ *
+ * Cells of the same color are written as one run of cells carrying their
+ * color, a simulated cell covers `scale` rows and columns. The bottom right
+ * cell is left out, ncurses cannot write it without scrolling the window.
+ *
+ * @param wrapper The fire window.
+ * @param cache The fire simulation.
+ * @param height The height of the fire on the screen.
+ * @param width The width of the fire on the screen.
+ */
+static void draw_fire(WINDOW *wrapper, const FireComponentCache *cache,
+                      int height, int width) {
+  chtype run[FIRE_RUN_SIZE];
+  for (int y = 0; y < height; y++) {
+    const uint8_t *row = cache->heat + (y / cache->scale) * cache->stride;
+    int row_width = (y == height - 1) ? width - 1 : width;
+
+    int start = 0, length = 0;
+    short pair = 0;
+    for (int x = 0; x < row_width; x++) {
+      uint8_t heat = row[x / cache->scale];
+      short cell_pair = fire_pair(heat);
+      if (length && (cell_pair != pair || length == FIRE_RUN_SIZE)) {
+        flush_fire_run(wrapper, y, start, run, length);
+        length = 0;
+      }
+      if (!length) {
+        start = x;
+        pair = cell_pair;
+      }
+      char glyph = fire_glyphs[heat > FIRE_GLYPH_MAX ? FIRE_GLYPH_MAX : heat];
+      run[length++] = (chtype)(unsigned char)glyph | COLOR_PAIR(pair) | A_DIM;
+    }
+    flush_fire_run(wrapper, y, start, run, length);
+  }
+}
+
 /**
  * @brief Renders a fire component on a specified window using its properties.
  *
  * This function renders a dynamic fire effect within a specified window,
- * utilizing the properties defined in `FireComponentProps`. It dynamically
- * allocates a buffer to store the fire effect's intensity values and
- * initializes color pairs for rendering different shades of fire. The fire
- * effect is simulated by randomly setting intensity values in the buffer, which
- * are then used to determine the color of each cell in the fire component. The
- * intensity values are averaged across neighboring cells to simulate the spread
- * of fire. The function uses ncurses to create a subwindow for the fire
- * component, sets its background color, and renders the fire effect by printing
- * characters with varying colors based on the intensity values.
+ * utilizing the properties defined in `FireComponentProps`. The heat of the
+ * cells is simulated in the cache: sparks are thrown into the bottom row and
+ * every step each cell becomes the average of itself and its right, lower and
+ * lower right neighbours, so the fire rises and cools. The simulation runs at
+ * `FIRE_COMPONENT_STEPS_PER_SECOND`, or the rate of the properties, whatever
+ * the frame rate, then the heat is drawn as glyphs colored by the heat. A
+ * scaled fire simulates a cell per `scale` rows and columns. The buffers and
+ * the subwindow are kept until the size of the fire changes.
  *
  * @param window The ncurses window where the fire component will be rendered.
  * @param props The properties of the fire component, including dimensions,
  * position, and other relevant data.
  */
 void fire_component(WINDOW *window, FireComponentProps props) {
-  static int size = 0;
-  static char *buffer = NULL;
-  if (size != (props.width * props.height)) {
-    size = props.width * props.height;
-    if (buffer) free(buffer);
-    buffer = (char *)calloc(size, sizeof(char));
-  }
+  if (!window || props.width <= 0 || props.height <= 0) return;
+
+  static FireComponentCache shared_cache = {0};
+  FireComponentCache *cache = props.cache ? props.cache : &shared_cache;
 
   static bool colors_inited = FALSE;
   if (!colors_inited) {
@@ -44,38 +382,19 @@ void fire_component(WINDOW *window, FireComponentProps props) {
     colors_inited = TRUE;
   }
 
-  WINDOW *wrapper = derwin(window, props.height, props.width, props.y, props.x);
+  WINDOW *wrapper = provide_subwindow(&cache->wrapper, window, props.height,
+                                      props.width, props.y, props.x);
+  if (!wrapper) return;
   wbkgd(wrapper, COLOR_PAIR(THEME_BACKGROUND_PAIR));
 
-  for (int i = 0; i < (props.width / 9); i++) {
-    int index = (rand() % props.width) + props.width * (props.height - 1);
-    buffer[index] = 65;
-  }
-
-  static char chars[] = " school21";
-  for (int i = 0; i < size; i++) {
-    buffer[i] = (char)(buffer[i] + buffer[i + 1] + buffer[i + props.width] +
-                       buffer[i + props.width + 1]) /
-                4;
-
-    int color = 103;
-    if (buffer[i] > 15)
-      color = 102;
-    else if (buffer[i] > 9)
-      color = 101;
-    else if (buffer[i] > 4)
-      color = 100;
-
-    if (i < size - 1) {
-      int x = i % props.width;
-      int y = i / props.width;
-      wattron(wrapper, COLOR_PAIR(color) | WA_DIM);
-      mvwaddch(wrapper, y, x, chars[buffer[i] > 9 ? 9 : buffer[i]]);
-      wattroff(wrapper, COLOR_PAIR(color) | WA_DIM);
-    }
-  }
+  int scale = props.scale > 0 ? props.scale : 1;
+  int steps_per_second = props.steps_per_second > 0
+                             ? props.steps_per_second
+                             : FIRE_COMPONENT_STEPS_PER_SECOND;
+  fit_fire_buffers(cache, props.height, props.width, scale);
+  advance_fire(cache, props.now_ns, 1000000000LL / steps_per_second);
+  draw_fire(wrapper, cache, props.height, props.width);
 
   wnoutrefresh(window);
-  delwin(wrapper);
   wrapper = NULL;
-}
\ No newline at end of file
+}
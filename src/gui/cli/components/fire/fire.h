@@ -1,11 +1,58 @@
 #ifndef CLI_COMPONENTS_FIRE_FIRE_H
 #define CLI_COMPONENTS_FIRE_FIRE_H
 
+#include <stdint.h>
+
 #include "../../theme/theme.h"
 #include "ncurses.h"
 #include "stdlib.h"
 #include "time.h"
 
+#define FIRE_COMPONENT_HEAT 65
+#define FIRE_COMPONENT_SPARKS_WIDTH 9
+#define FIRE_COMPONENT_STEPS_PER_SECOND 20
+#define FIRE_COMPONENT_STEP_NS (1000000000LL / FIRE_COMPONENT_STEPS_PER_SECOND)
+#define FIRE_COMPONENT_MAX_STEPS 4
+#define FIRE_COMPONENT_SEED 0x21u
+
+/**
+ * @brief The fire simulation kept across frames.
+ *
+ * The heat of the cells lives in two buffers: a step reads the front buffer,
+ * writes the back buffer and swaps them. Every row has a cold padding cell on
+ * its right and a cold padding row lies under the fire, so the neighbours of
+ * every cell are in the buffer. The simulation steps at a fixed rate, a frame
+ * runs as many steps as the time elapsed since the previous frame, at most
+ * `FIRE_COMPONENT_MAX_STEPS`, so the fire burns at the same speed at any frame
+ * rate.
+ *
+ * @struct FireComponentCache
+ * @var heat The front buffer, the heat of the drawn cells.
+ * @var next The back buffer.
+ * @var width The width of the simulated fire.
+ * @var height The height of the simulated fire.
+ * @var scale The number of screen rows and columns a simulated cell covers.
+ * @var stride The distance between two rows of the buffers.
+ * @var rng The state of the random generator of the sparks.
+ * @var time_ns The time the simulation has reached, 0 before the first frame.
+ * @var steps The number of simulation steps run so far.
+ * @var _buffers The allocation holding both buffers.
+ * @var wrapper The window of the fire, kept across frames.
+ */
+typedef struct {
+  uint8_t *heat;
+  uint8_t *next;
+  int width;
+  int height;
+  int scale;
+  int stride;
+  uint32_t rng;
+  long long time_ns;
+  unsigned long steps;
+  uint8_t *_buffers;
+  SubWindow wrapper;
+} FireComponentCache;
+
 /**
  * @brief Defines the properties of a fire component, including its dimensions
  * and position.
@@ -13,12 +60,25 @@
  * This structure encapsulates the essential properties for a fire component,
  * such as its width, height, and the x and y coordinates of its position within
  * a window.
+ *
+ * @var now_ns The time of the frame in nanoseconds. Without a time every
+ * frame runs a single simulation step.
+ * @var scale The number of screen rows and columns a simulated cell covers,
+ * 0 for 1. A coarser fire is cheaper to simulate.
+ * @var steps_per_second The simulation rate, 0 for
+ * `FIRE_COMPONENT_STEPS_PER_SECOND`.
+ * @var cache The simulation kept across frames or NULL for the one shared by
+ * the fires drawn without a cache.
  */
 typedef struct {
   int width;
   int height;
   int x;
   int y;
+  long long now_ns;
+  int scale;
+  int steps_per_second;
+  FireComponentCache *cache;
 } FireComponentProps;
 
 /**
@@ -34,4 +94,26 @@ typedef struct {
  */
 void fire_component(WINDOW *window, FireComponentProps props);
 
-#endif  // !CLI_COMPONENTS_FIRE_FIRE_H
\ No newline at end of file
+/**
+ * @brief Frees the buffers and the window of a fire simulation.
+ *
+ * @param cache The fire simulation.
+ */
+void release_fire_component(FireComponentCache *cache);
+
+/**
+ * @brief Cools the rows of a heat buffer: every cell becomes the average of
+ * itself and its right, lower and lower right neighbours.
+ *
+ * Runs the fastest kernel the CPU supports: AVX2, SSE2 or plain C.
+ *
+ * @param heat The heat, `height + 1` rows of `stride` cells.
+ * @param next Where the cooled rows are written.
+ * @param width The number of cells cooled in a row, less than `stride`.
+ * @param height The number of cooled rows.
+ * @param stride The distance between two rows.
+ */
+void cool_fire_rows(const uint8_t *heat, uint8_t *next, int width, int height,
+                    int stride);
+
+#endif  // !CLI_COMPONENTS_FIRE_FIRE_H
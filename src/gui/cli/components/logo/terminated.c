@@ -28,6 +28,6 @@ void terminated_screen(WINDOW *window, int timeout) {
   mvwprintw(window, y + 4, (getmaxx(window) - 25) / 2, "%s", desc);
   wattroff(window, WA_DIM | WA_BLINK);
 
-  doupdate();
-  getch();
+  // the caller presents the screen and waits for the key
+  wnoutrefresh(window);
 }
\ No newline at end of file
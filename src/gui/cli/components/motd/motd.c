@@ -21,7 +21,10 @@ static void insert_themes_block(WINDOW *window, int x, int y,
   int width = 24;
   int height = 8;
 
-  WINDOW *wrapper = derwin(window, height, width, y, x);
+  static SubWindow subwindow = {0};
+  WINDOW *wrapper =
+      provide_subwindow(&subwindow, window, height, width, y, x);
+  if (!wrapper) return;
   box(wrapper, 0, 0);
   wbkgd(wrapper, props.attrs);
 
@@ -40,7 +43,6 @@ static void insert_themes_block(WINDOW *window, int x, int y,
   wattroff(wrapper, WA_DIM);
 
   wnoutrefresh(window);
-  delwin(wrapper);
   wrapper = NULL;
 }
 
@@ -65,7 +67,10 @@ static void insert_brightness_block(WINDOW *window, int x, int y,
   int width = 24;
   int height = 7;
 
-  WINDOW *wrapper = derwin(window, height, width, y, x);
+  static SubWindow subwindow = {0};
+  WINDOW *wrapper =
+      provide_subwindow(&subwindow, window, height, width, y, x);
+  if (!wrapper) return;
   box(wrapper, 0, 0);
   wbkgd(wrapper, props.attrs);
 
@@ -82,7 +87,6 @@ static void insert_brightness_block(WINDOW *window, int x, int y,
   wattroff(wrapper, WA_DIM);
 
   wnoutrefresh(window);
-  delwin(wrapper);
   wrapper = NULL;
 }
 
@@ -108,7 +112,10 @@ static void insert_player_kb_block(WINDOW *window, int x, int y,
   int width = 30;
   int height = 15;
 
-  WINDOW *wrapper = derwin(window, height, width, y, x);
+  static SubWindow subwindow = {0};
+  WINDOW *wrapper =
+      provide_subwindow(&subwindow, window, height, width, y, x);
+  if (!wrapper) return;
   box(wrapper, 0, 0);
   wbkgd(wrapper, props.attrs);
 
@@ -146,7 +153,6 @@ static void insert_player_kb_block(WINDOW *window, int x, int y,
   wattroff(wrapper, COLOR_PAIR(THEME_PRIMARY_PAIR) | WA_DIM);
 
   wnoutrefresh(window);
-  delwin(wrapper);
   wrapper = NULL;
 }
 
@@ -243,8 +249,10 @@ void motd_component(WINDOW *window, MotdComponentProps props) {
   if (!window) return;
   (void)props;
 
-  WINDOW *wrapper =
-      derwin(window, props.height, props.width, props.pos.y, props.pos.x);
+  static SubWindow subwindow = {0};
+  WINDOW *wrapper = provide_subwindow(&subwindow, window, props.height,
+                                      props.width, props.pos.y, props.pos.x);
+  if (!wrapper) return;
   box(wrapper, 0, 0);
   wbkgd(wrapper, props.attrs);
 
@@ -269,6 +277,5 @@ void motd_component(WINDOW *window, MotdComponentProps props) {
   collor_pallete(window, (getmaxx(window) - 28) / 2, getmaxy(window) - 2);
 
   wnoutrefresh(window);
-  delwin(wrapper);
   wrapper = NULL;
 }
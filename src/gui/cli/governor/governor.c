@@ -0,0 +1,167 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "governor.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ * @brief Returns the monotonic time.
+ *
+ * @return The time in nanoseconds.
+ */
+static long long governor_now_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ * @brief Starts the measure of a frame.
+ *
+ * @param self The governor.
+ */
+static void _begin(QualityGovernor *self) {
+  if (!self) return;
+  for (int phase = 0; phase < FRAME_PHASES_COUNT; phase++) {
+    self->_frame_ns[phase] = 0;
+  }
+  self->_mark_ns = governor_now_ns();
+}
+
+/**
+ * @brief Adds time to a phase of the frame.
+ *
+ * @param self The governor.
+ * @param phase The phase.
+ * @param ns The time in nanoseconds.
+ */
+static void _add(QualityGovernor *self, FramePhase phase, long long ns) {
+  if (!self || phase < 0 || phase >= FRAME_PHASES_COUNT || ns < 0) return;
+  self->_frame_ns[phase] += ns;
+}
+
+/**
+ * @brief Ends a phase of the frame: the time since the previous mark is added
+ * to the phase.
+ *
+ * @param self The governor.
+ * @param phase The phase.
+ */
+static void _mark(QualityGovernor *self, FramePhase phase) {
+  if (!self) return;
+  long long now_ns = governor_now_ns();
+  _add(self, phase, now_ns - self->_mark_ns);
+  self->_mark_ns = now_ns;
+}
+
+/**
+ * @brief Changes the quality level and resets the counters of the thresholds.
+ *
+ * @param self The governor.
+ * @param level The new level.
+ */
+static void change_level(QualityGovernor *self, QualityLevel level) {
+  bool is_restore = level < self->level;
+  if (is_restore) {
+    self->stats.restores++;
+  } else {
+    self->stats.degrades++;
+    // the restored quality did not hold, wait longer before the next try
+    if (self->_is_restored &&
+        self->_restore_frames <
+            self->fps * QUALITY_GOVERNOR_MAX_RESTORE_SECONDS) {
+      self->_restore_frames *= 2;
+    }
+  }
+  self->level = level;
+  self->_is_restored = is_restore;
+  self->_over_frames = 0;
+  self->_under_frames = 0;
+}
+
+/**
+ * @brief Ends the frame: updates the moving average of the frame work and the
+ * quality level.
+ *
+ * The level follows the work of every frame, a single slow frame does not
+ * degrade the quality but a few in a row do. The average, weighing the last
+ * frame by 1/4, is only reported.
+ *
+ * @param self The governor.
+ * @return The quality level for the next frame.
+ */
+static QualityLevel _end_frame(QualityGovernor *self) {
+  if (!self) return QUALITY_FULL;
+
+  long long work_ns = self->_frame_ns[FRAME_PHASE_ENGINE] +
+                      self->_frame_ns[FRAME_PHASE_DRAW] +
+                      self->_frame_ns[FRAME_PHASE_PRESENT];
+  for (int phase = 0; phase < FRAME_PHASES_COUNT; phase++) {
+    self->stats.phase_ns[phase] += self->_frame_ns[phase];
+  }
+  self->stats.frames++;
+  if (work_ns > self->budget_ns) self->stats.frames_over_budget++;
+
+  self->work_ns = self->stats.frames == 1
+                      ? work_ns
+                      : self->work_ns + (work_ns - self->work_ns) / 4;
+
+  if (work_ns > self->budget_ns * 3 / 4) {
+    self->_under_frames = 0;
+    if (++self->_over_frames >= QUALITY_GOVERNOR_DEGRADE_FRAMES &&
+        self->level < QUALITY_LEVELS_COUNT - 1) {
+      change_level(self, self->level + 1);
+    }
+  } else if (work_ns < self->budget_ns / 4) {
+    self->_over_frames = 0;
+    if (++self->_under_frames >= self->_restore_frames &&
+        self->level > QUALITY_FULL) {
+      change_level(self, self->level - 1);
+    }
+  } else {
+    self->_over_frames = 0;
+    self->_under_frames = 0;
+  }
+
+  return self->level;
+}
+
+/**
+ * @brief Frees the governor.
+ *
+ * @param self The governor.
+ */
+static void _destroy(QualityGovernor *self) {
+  if (!self) return;
+  free(self);
+}
+
+/**
+ * @brief Creates a quality governor.
+ *
+ * The governor starts at the full quality.
+ *
+ * @param fps The configured frame rate.
+ * @return A pointer to the newly created governor.
+ */
+QualityGovernor *new_quality_governor(int fps) {
+  QualityGovernor *self = (QualityGovernor *)calloc(1, sizeof(QualityGovernor));
+  if (!self) {
+    fprintf(stderr, "Cannot allocate mem for QualityGovernor\n");
+    exit(-1);
+  }
+
+  self->fps = fps > 0 ? fps : 1;
+  self->budget_ns = 1000000000LL / self->fps;
+  self->level = QUALITY_FULL;
+  self->_restore_frames = self->fps * QUALITY_GOVERNOR_RESTORE_SECONDS;
+
+  self->begin = _begin;
+  self->mark = _mark;
+  self->add = _add;
+  self->end_frame = _end_frame;
+  self->destroy = _destroy;
+  return self;
+}
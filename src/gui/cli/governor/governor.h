@@ -0,0 +1,125 @@
+#ifndef CLI_GOVERNOR_GOVERNOR_H
+#define CLI_GOVERNOR_GOVERNOR_H
+
+#include <stdbool.h>
+
+#define QUALITY_GOVERNOR_DEGRADE_FRAMES 3
+#define QUALITY_GOVERNOR_RESTORE_SECONDS 2
+#define QUALITY_GOVERNOR_MAX_RESTORE_SECONDS 32
+
+/**
+ * @brief Enumeration of the phases of a frame.
+ *
+ * @enum FramePhase
+ * @var FRAME_PHASE_INPUT Reading the keyboard since the previous frame, the
+ * waits for keys left out.
+ * @var FRAME_PHASE_ENGINE The engine tick.
+ * @var FRAME_PHASE_DRAW Drawing the layouts into the virtual screen.
+ * @var FRAME_PHASE_PRESENT Putting the virtual screen on the terminal.
+ */
+typedef enum {
+  FRAME_PHASE_INPUT = 0,
+  FRAME_PHASE_ENGINE,
+  FRAME_PHASE_DRAW,
+  FRAME_PHASE_PRESENT,
+  FRAME_PHASES_COUNT,
+} FramePhase;
+
+/**
+ * @brief Enumeration of the visual quality levels, from the full quality to
+ * the cheapest frames.
+ *
+ * @enum QualityLevel
+ * @var QUALITY_FULL Everything is drawn every frame.
+ * @var QUALITY_REDUCED The fire steps at half its rate, only the components
+ * under the fire are redrawn over it and the header logo is only redrawn when
+ * the game state changes.
+ * @var QUALITY_LOW As reduced, with the fire at half its resolution and a
+ * quarter of its rate.
+ */
+typedef enum {
+  QUALITY_FULL = 0,
+  QUALITY_REDUCED,
+  QUALITY_LOW,
+  QUALITY_LEVELS_COUNT,
+} QualityLevel;
+
+/**
+ * @brief Counters of the governed frames.
+ *
+ * @struct QualityGovernorStats
+ * @var frames Number of governed frames.
+ * @var frames_over_budget Number of frames whose work exceeded the budget.
+ * @var degrades Number of quality decreases.
+ * @var restores Number of quality increases.
+ * @var phase_ns Total time spent in every phase.
+ */
+typedef struct {
+  unsigned long frames;
+  unsigned long frames_over_budget;
+  unsigned long degrades;
+  unsigned long restores;
+  long long phase_ns[FRAME_PHASES_COUNT];
+} QualityGovernorStats;
+
+/**
+ * @brief Visual quality governor.
+ *
+ * The frame loop marks the end of every phase, the governor measures the
+ * frame work: the engine tick, the drawing and the presentation. The input
+ * phase is measured but left out, the keys are read between the frames. The
+ * quality is decreased when the work takes more than 3/4 of the frame budget
+ * for a few frames in a row, so there is time left to read the keys, and
+ * increased again after the work stayed under 1/4 of the budget for a while.
+ * A restore that has to be taken back right away doubles the time
+ * the next restore waits for.
+ *
+ * @struct __quality_governor
+ * @var fps The configured frame rate.
+ * @var budget_ns The time of a frame at the configured frame rate.
+ * @var level The current quality level.
+ * @var work_ns The moving average of the frame work, for reports.
+ * @var stats Counters of the governed frames.
+ * @var _frame_ns The time spent in every phase of the current frame.
+ * @var _mark_ns The time of the last mark.
+ * @var _over_frames Number of frames in a row over the degrade threshold.
+ * @var _under_frames Number of frames in a row under the restore threshold.
+ * @var _restore_frames Number of frames under the restore threshold a
+ * restore waits for.
+ * @var _is_restored Whether the last level change was a restore.
+ * @var begin Function pointer starting the measure of a frame.
+ * @var mark Function pointer ending a phase of the frame at the current time.
+ * @var add Function pointer adding time to a phase of the frame.
+ * @var end_frame Function pointer ending the frame and updating the level.
+ * @var destroy Function pointer freeing the governor.
+ */
+typedef struct __quality_governor {
+  int fps;
+  long long budget_ns;
+  QualityLevel level;
+  long long work_ns;
+  QualityGovernorStats stats;
+
+  long long _frame_ns[FRAME_PHASES_COUNT];
+  long long _mark_ns;
+  int _over_frames;
+  int _under_frames;
+  int _restore_frames;
+  bool _is_restored;
+
+  void (*begin)(struct __quality_governor *self);
+  void (*mark)(struct __quality_governor *self, FramePhase phase);
+  void (*add)(struct __quality_governor *self, FramePhase phase, long long ns);
+  QualityLevel (*end_frame)(struct __quality_governor *self);
+  void (*destroy)(struct __quality_governor *self);
+} QualityGovernor;
+
+/**
+ * @brief Creates a quality governor.
+ *
+ * @param fps The configured frame rate.
+ * @return A pointer to the newly created governor.
+ */
+QualityGovernor *new_quality_governor(int fps);
+
+#endif  // !CLI_GOVERNOR_GOVERNOR_H
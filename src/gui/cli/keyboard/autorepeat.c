@@ -0,0 +1,190 @@
+#include "autorepeat.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @brief Finds the hold state of a key.
+ *
+ * @param self A pointer to the AutoRepeat instance.
+ * @param key The key code, -1 to find a free slot.
+ * @return The hold state or NULL if the key is not tracked.
+ */
+static AutoRepeatKey *find_key(AutoRepeat *self, int key) {
+  for (size_t i = 0; i < AUTO_REPEAT_KEYS_MAX; i++) {
+    if (self->_keys[i].key == key) return &self->_keys[i];
+  }
+  return NULL;
+}
+
+/**
+ * @brief Returns the time a key stops being held at.
+ *
+ * @param self A pointer to the AutoRepeat instance.
+ * @param state The hold state of the key.
+ * @return The monotonic time of the release, reported or expected.
+ */
+static long long released_at(AutoRepeat *self, const AutoRepeatKey *state) {
+  return state->released_ns ? state->released_ns
+                            : state->seen_ns + self->release_ns;
+}
+
+/**
+ * @brief Returns the time a repeat of a key is scheduled at.
+ *
+ * @param self A pointer to the AutoRepeat instance.
+ * @param state The hold state of the key.
+ * @param repeat The index of the repeat, from 0.
+ * @return The monotonic time of the repeat.
+ */
+static long long repeat_at(AutoRepeat *self, const AutoRepeatKey *state,
+                           unsigned long repeat) {
+  return state->pressed_ns + self->das_ns + (long long)repeat * self->arr_ns;
+}
+
+/**
+ * @brief Reports a press or a terminal repeat of a key.
+ *
+ * A report of a key that is still held only keeps it held. Any other report
+ * is a new press, which restarts the delayed auto-shift of the key.
+ *
+ * @param self A pointer to the AutoRepeat instance.
+ * @param key The key code.
+ * @param time_ns The monotonic time the key was read at.
+ * @return true if it is a new press, which moves once at once, false for a
+ * key that is still held.
+ */
+static bool _press(AutoRepeat *self, int key, long long time_ns) {
+  if (!self || key < 0) return false;
+
+  AutoRepeatKey *state = find_key(self, key);
+  if (state && !state->released_ns && time_ns <= released_at(self, state)) {
+    state->seen_ns = time_ns;
+    return false;
+  }
+
+  self->stats.presses++;
+  if (!state) state = find_key(self, -1);
+  if (state) {
+    *state = (AutoRepeatKey){
+        .key = key, .pressed_ns = time_ns, .seen_ns = time_ns};
+  }
+  return true;
+}
+
+/**
+ * @brief Reports the release of a key.
+ *
+ * @param self A pointer to the AutoRepeat instance.
+ * @param key The key code.
+ * @param time_ns The monotonic time the key was released at.
+ */
+static void _release(AutoRepeat *self, int key, long long time_ns) {
+  if (!self) return;
+  AutoRepeatKey *state = find_key(self, key);
+  if (state && time_ns < released_at(self, state)) {
+    state->released_ns = time_ns;
+  }
+}
+
+/**
+ * @brief Returns the repeats of a key that came due since the previous call.
+ *
+ * Repeats come due on their schedule up to the release of the key, however
+ * late they are asked for, so a caller that was held up gets all of them in
+ * one batch. A released key is forgotten once its last repeats are handed out.
+ *
+ * @param self A pointer to the AutoRepeat instance.
+ * @param key The key code.
+ * @param now_ns The current monotonic time.
+ * @param due_ns Where the scheduled time of the first owed repeat is stored,
+ * can be NULL.
+ * @return The number of repeats owed.
+ */
+static unsigned long _owed(AutoRepeat *self, int key, long long now_ns,
+                           long long *due_ns) {
+  if (!self || key < 0) return 0;
+  AutoRepeatKey *state = find_key(self, key);
+  if (!state) return 0;
+
+  long long released_ns = released_at(self, state);
+  long long until_ns = now_ns < released_ns ? now_ns : released_ns;
+  long long charged_ns = state->pressed_ns + self->das_ns;
+  unsigned long due =
+      until_ns < charged_ns ? 0 : (until_ns - charged_ns) / self->arr_ns + 1;
+
+  unsigned long owed = due > state->repeats ? due - state->repeats : 0;
+  if (owed) {
+    if (due_ns) *due_ns = repeat_at(self, state, state->repeats);
+    for (unsigned long i = state->repeats; i < due; i++) {
+      long long late_ns = now_ns - repeat_at(self, state, i);
+      self->stats.late_ns += late_ns;
+      if (late_ns > self->stats.max_late_ns) self->stats.max_late_ns = late_ns;
+    }
+    state->repeats = due;
+    self->stats.repeats += owed;
+    self->stats.batches++;
+  }
+
+  if (now_ns >= released_ns) state->key = -1;
+  return owed;
+}
+
+/**
+ * @brief Returns when the next repeat of any held key comes due.
+ *
+ * A repeat scheduled after the expected release of its key is left out: the
+ * next terminal repeat of the key, if any, wakes the caller up first.
+ *
+ * @param self A pointer to the AutoRepeat instance.
+ * @return The monotonic time of the next repeat, 0 if there is none.
+ */
+static long long _next_ns(AutoRepeat *self) {
+  if (!self) return 0;
+  long long next_ns = 0;
+  for (size_t i = 0; i < AUTO_REPEAT_KEYS_MAX; i++) {
+    const AutoRepeatKey *state = &self->_keys[i];
+    if (state->key < 0) continue;
+    long long repeat_ns = repeat_at(self, state, state->repeats);
+    if (repeat_ns > released_at(self, state)) continue;
+    if (!next_ns || repeat_ns < next_ns) next_ns = repeat_ns;
+  }
+  return next_ns;
+}
+
+/**
+ * @brief Frees the auto-repeat engine.
+ *
+ * @param self A pointer to the AutoRepeat instance.
+ */
+static void _destroy(AutoRepeat *self) { free(self); }
+
+/**
+ * @brief Creates an auto-repeat engine.
+ *
+ * If memory allocation fails, the function prints an error message to stderr
+ * and exits the program with a failure status.
+ *
+ * @param das_ns The delayed auto-shift, 0 for `AUTO_REPEAT_DAS_MS`.
+ * @param arr_ns The auto-repeat period, 0 for `AUTO_REPEAT_ARR_MS`.
+ * @return A pointer to the newly created engine.
+ */
+AutoRepeat *new_auto_repeat(long long das_ns, long long arr_ns) {
+  AutoRepeat *self = (AutoRepeat *)calloc(1, sizeof(AutoRepeat));
+  if (!self) {
+    fprintf(stderr, "Cannot allocate mem for AutoRepeat\n");
+    exit(-1);
+  }
+
+  self->das_ns = das_ns > 0 ? das_ns : AUTO_REPEAT_DAS_MS * 1000000LL;
+  self->arr_ns = arr_ns > 0 ? arr_ns : AUTO_REPEAT_ARR_MS * 1000000LL;
+  self->release_ns = AUTO_REPEAT_RELEASE_MS * 1000000LL;
+  for (size_t i = 0; i < AUTO_REPEAT_KEYS_MAX; i++) self->_keys[i].key = -1;
+
+  self->press = _press;
+  self->release = _release;
+  self->owed = _owed;
+  self->next_ns = _next_ns;
+  self->destroy = _destroy;
+  return self;
+}
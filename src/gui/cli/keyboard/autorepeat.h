@@ -0,0 +1,110 @@
+#ifndef CLI_KEYBOARD_AUTOREPEAT_H
+#define CLI_KEYBOARD_AUTOREPEAT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define AUTO_REPEAT_KEYS_MAX 8
+#define AUTO_REPEAT_DAS_MS 167
+#define AUTO_REPEAT_ARR_MS 33
+// one move per frame, the replay validator accepts two keys repeating at it
+#define AUTO_REPEAT_ARR_MIN_MS 16
+#define AUTO_REPEAT_RELEASE_MS 60
+
+/**
+ * @brief The hold state of a key.
+ *
+ * @struct AutoRepeatKey
+ * @var key The key code, -1 for a free slot.
+ * @var pressed_ns The monotonic time the key was pressed at.
+ * @var seen_ns The monotonic time the terminal last reported the key at.
+ * @var released_ns The monotonic time the key was released at, 0 while held.
+ * @var repeats Number of repeats of the key handed out so far.
+ */
+typedef struct {
+  int key;
+  long long pressed_ns;
+  long long seen_ns;
+  long long released_ns;
+  unsigned long repeats;
+} AutoRepeatKey;
+
+/**
+ * @brief Counters of an auto-repeat engine.
+ *
+ * @struct AutoRepeatStats
+ * @var presses Number of presses.
+ * @var repeats Number of repeats handed out.
+ * @var batches Number of times repeats were owed.
+ * @var late_ns Total time from the schedule of a repeat to handing it out.
+ * @var max_late_ns The longest time from the schedule of a repeat to handing
+ * it out.
+ */
+typedef struct {
+  unsigned long presses;
+  unsigned long repeats;
+  unsigned long batches;
+  long long late_ns;
+  long long max_late_ns;
+} AutoRepeatStats;
+
+/**
+ * @brief Delayed auto-shift and auto-repeat of held keys.
+ *
+ * A pressed key moves once at once. Held down for the delayed auto-shift
+ * (`das_ns`), it moves again, then once every auto-repeat period (`arr_ns`)
+ * until it is released. Every repeat has a fixed place on the monotonic clock,
+ * counted from the press, so the speed of a held key depends neither on the
+ * key repeat rate of the terminal nor on when the caller asks: `owed` returns
+ * every repeat that came due since the previous call at once, and `next_ns`
+ * tells when the next one comes due, to sleep exactly until then.
+ *
+ * Most terminals report no releases, only repeats of a held key. A key they
+ * stop repeating counts as released `release_ns` after it was last reported,
+ * which has to be longer than the repeat period of the terminal. The terminal
+ * only starts repeating after its own delay, until then a held key looks like
+ * a key pressed once, so the delayed auto-shift starts from the first repeat
+ * of the terminal. With terminals that report releases it starts from the
+ * press.
+ *
+ * @struct __auto_repeat
+ * @var das_ns The delayed auto-shift: how long a key is held before it
+ * repeats.
+ * @var arr_ns The auto-repeat rate: the time between two repeats.
+ * @var release_ns How long after it was last reported a key counts as
+ * released, when the terminal reports no releases.
+ * @var stats Counters of the engine.
+ * @var _keys The hold state of each key.
+ * @var press Function pointer reporting a press or a terminal repeat of a key.
+ * @var release Function pointer reporting the release of a key.
+ * @var owed Function pointer returning the repeats of a key that came due
+ * since the previous call.
+ * @var next_ns Function pointer returning when the next repeat comes due.
+ * @var destroy Function pointer freeing the engine.
+ */
+typedef struct __auto_repeat {
+  long long das_ns;
+  long long arr_ns;
+  long long release_ns;
+  AutoRepeatStats stats;
+
+  AutoRepeatKey _keys[AUTO_REPEAT_KEYS_MAX];
+
+  bool (*press)(struct __auto_repeat *self, int key, long long time_ns);
+  void (*release)(struct __auto_repeat *self, int key, long long time_ns);
+  unsigned long (*owed)(struct __auto_repeat *self, int key, long long now_ns,
+                        long long *due_ns);
+  long long (*next_ns)(struct __auto_repeat *self);
+  void (*destroy)(struct __auto_repeat *self);
+} AutoRepeat;
+
+/**
+ * @brief Creates an auto-repeat engine.
+ *
+ * @param das_ns The delayed auto-shift, 0 for `AUTO_REPEAT_DAS_MS`.
+ * @param arr_ns The auto-repeat period, 0 for `AUTO_REPEAT_ARR_MS`.
+ * @return A pointer to the newly created engine.
+ */
+AutoRepeat *new_auto_repeat(long long das_ns, long long arr_ns);
+
+#endif  // !CLI_KEYBOARD_AUTOREPEAT_H
@@ -0,0 +1,359 @@
+#include "decoder.h"
+
+#include <ncurses.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KEY_DECODER_ESC 27
+#define KEY_DECODER_CSI_FIELDS 4
+#define KEY_DECODER_CSI_SUBFIELDS 3
+
+// first code of the functional keys of the kitty protocol, in the private use
+// area of Unicode
+#define KEY_DECODER_KITTY_KP_0 57399
+#define KEY_DECODER_KITTY_KP_ENTER 57414
+#define KEY_DECODER_KITTY_KP_LEFT 57417
+
+/**
+ * @brief A control sequence: `ESC [`, parameters and a final byte.
+ *
+ * @struct CsiSequence
+ * @var marker The private marker (`?`, `<`, `=`, `>`) or 0.
+ * @var fields The parameters, 0 where a parameter is left out.
+ * @var final The final byte.
+ */
+typedef struct {
+  char marker;
+  int fields[KEY_DECODER_CSI_FIELDS][KEY_DECODER_CSI_SUBFIELDS];
+  char final;
+} CsiSequence;
+
+/**
+ * @brief Returns the key of a plain byte, as ncurses returns it.
+ *
+ * @param byte The byte.
+ * @return The key code.
+ */
+static int byte_key(unsigned char byte) {
+  if (byte == '\r') return '\n';
+  if (byte == 127) return KEY_BACKSPACE;
+  return byte;
+}
+
+/**
+ * @brief Returns the key of the final byte of a CSI or SS3 sequence.
+ *
+ * @param final The final byte.
+ * @return The key code, ERR for an unknown key.
+ */
+static int letter_key(char final) {
+  switch (final) {
+    case 'A':
+      return KEY_UP;
+    case 'B':
+      return KEY_DOWN;
+    case 'C':
+      return KEY_RIGHT;
+    case 'D':
+      return KEY_LEFT;
+    case 'H':
+      return KEY_HOME;
+    case 'F':
+      return KEY_END;
+    case 'P':
+    case 'Q':
+    case 'R':
+    case 'S':
+      return KEY_F(final - 'P' + 1);
+    case 'Z':
+      return KEY_BTAB;
+    default:
+      return ERR;
+  }
+}
+
+/**
+ * @brief Returns the key of a `CSI number ~` sequence.
+ *
+ * @param number The first parameter.
+ * @return The key code, ERR for an unknown key.
+ */
+static int tilde_key(int number) {
+  if (number >= 11 && number <= 15) return KEY_F(number - 10);
+  if (number >= 17 && number <= 21) return KEY_F(number - 11);
+  if (number >= 23 && number <= 24) return KEY_F(number - 12);
+  switch (number) {
+    case 1:
+    case 7:
+      return KEY_HOME;
+    case 2:
+      return KEY_IC;
+    case 3:
+      return KEY_DC;
+    case 4:
+    case 8:
+      return KEY_END;
+    case 5:
+      return KEY_PPAGE;
+    case 6:
+      return KEY_NPAGE;
+    default:
+      return ERR;
+  }
+}
+
+/**
+ * @brief Returns the key of a `CSI code u` sequence of the kitty protocol.
+ *
+ * A shifted key is taken as the shifted character the terminal reports with
+ * it, a key with ctrl as the control character, as without the protocol.
+ *
+ * @param sequence The sequence.
+ * @return The key code, ERR for an unknown key.
+ */
+static int kitty_key(const CsiSequence *sequence) {
+  int code = sequence->fields[0][0];
+  int modifiers = sequence->fields[1][0] ? sequence->fields[1][0] - 1 : 0;
+  if ((modifiers & 1) && sequence->fields[0][1]) code = sequence->fields[0][1];
+  if ((modifiers & 4) && code >= 'a' && code <= 'z') return code - 'a' + 1;
+
+  if (code >= KEY_DECODER_KITTY_KP_0 && code < KEY_DECODER_KITTY_KP_0 + 10) {
+    return '0' + code - KEY_DECODER_KITTY_KP_0;
+  }
+  if (code == KEY_DECODER_KITTY_KP_ENTER) return '\n';
+  if (code >= KEY_DECODER_KITTY_KP_LEFT &&
+      code < KEY_DECODER_KITTY_KP_LEFT + 4) {
+    const int keys[] = {KEY_LEFT, KEY_RIGHT, KEY_UP, KEY_DOWN};
+    return keys[code - KEY_DECODER_KITTY_KP_LEFT];
+  }
+  if (code > 0 && code < 256) return byte_key(code);
+  return ERR;
+}
+
+/**
+ * @brief Parses a control sequence.
+ *
+ * @param bytes The bytes, starting with `ESC [`.
+ * @param size The number of bytes.
+ * @param sequence Where the sequence is stored.
+ * @return The length of the sequence, 0 if it is incomplete.
+ */
+static size_t parse_csi(const unsigned char *bytes, size_t size,
+                        CsiSequence *sequence) {
+  *sequence = (CsiSequence){0};
+  size_t field = 0, subfield = 0;
+  for (size_t i = 2; i < size && i < KEY_DECODER_SEQUENCE_MAX; i++) {
+    unsigned char byte = bytes[i];
+    if (byte >= '0' && byte <= '9') {
+      if (field < KEY_DECODER_CSI_FIELDS &&
+          subfield < KEY_DECODER_CSI_SUBFIELDS) {
+        int *value = &sequence->fields[field][subfield];
+        if (*value < 1000000) *value = *value * 10 + (byte - '0');
+      }
+    } else if (byte == ';') {
+      field++;
+      subfield = 0;
+    } else if (byte == ':') {
+      subfield++;
+    } else if (byte >= '<' && byte <= '?') {
+      if (i == 2) sequence->marker = byte;
+    } else if (byte >= 0x40 && byte <= 0x7e) {
+      sequence->final = byte;
+      return i + 1;
+    } else if (byte < 0x20 || byte > 0x7e) {
+      // not a sequence after all, the bytes so far make an unknown one
+      return i;
+    }
+  }
+  return size >= KEY_DECODER_SEQUENCE_MAX ? KEY_DECODER_SEQUENCE_MAX : 0;
+}
+
+/**
+ * @brief Decodes a control sequence into a key or an answer of the terminal.
+ *
+ * @param self A pointer to the KeyDecoder instance.
+ * @param sequence The sequence.
+ * @param event Where the key and its type are stored, the key stays ERR for a
+ * sequence that is no key.
+ */
+static void decode_csi(KeyDecoder *self, const CsiSequence *sequence,
+                       KeyEvent *event) {
+  if (sequence->marker == '?') {
+    if (sequence->final == 'u') self->is_kitty = true;
+    if (sequence->final == 'c') self->is_probed = true;
+    return;
+  }
+  if (sequence->marker) return;
+
+  if (sequence->final == 'u') {
+    event->key = kitty_key(sequence);
+  } else if (sequence->final == '~') {
+    event->key = tilde_key(sequence->fields[0][0]);
+  } else {
+    event->key = letter_key(sequence->final);
+  }
+
+  int type = sequence->fields[1][1];
+  if (type >= KEY_EVENT_PRESS && type <= KEY_EVENT_RELEASE) {
+    event->type = (KeyEventType)type;
+  }
+  if (event->key == ERR) self->stats.unknown++;
+}
+
+/**
+ * @brief Decodes the key at the start of the fed bytes.
+ *
+ * @param self A pointer to the KeyDecoder instance.
+ * @param event Where the key is stored, the key stays ERR for bytes that are
+ * no key.
+ * @return The number of decoded bytes, 0 if the bytes are an incomplete
+ * sequence.
+ */
+static size_t decode(KeyDecoder *self, KeyEvent *event) {
+  const unsigned char *bytes = self->_bytes + self->_start;
+  size_t size = self->_size;
+  if (bytes[0] != KEY_DECODER_ESC) {
+    event->key = byte_key(bytes[0]);
+    return 1;
+  }
+  if (size < 2) return 0;
+
+  size_t length = 0;
+  if (bytes[1] == '[') {
+    CsiSequence sequence;
+    if (!(length = parse_csi(bytes, size, &sequence))) return 0;
+    decode_csi(self, &sequence, event);
+  } else if (bytes[1] == 'O') {
+    if (size < 3) return 0;
+    event->key = letter_key(bytes[2]);
+    if (event->key == ERR) self->stats.unknown++;
+    length = 3;
+  } else {
+    // ESC before anything else is a key of its own, like ncurses returns it
+    event->key = KEY_DECODER_ESC;
+    return 1;
+  }
+
+  self->stats.sequences++;
+  return length;
+}
+
+/**
+ * @brief Adds read bytes.
+ *
+ * @param self A pointer to the KeyDecoder instance.
+ * @param bytes The bytes.
+ * @param size The number of bytes.
+ * @param time_ns The monotonic time the bytes were read at.
+ * @return The number of bytes taken, less than `size` if there is no room.
+ */
+static size_t _feed(KeyDecoder *self, const char *bytes, size_t size,
+                    long long time_ns) {
+  if (!self) return 0;
+  if (self->_start + self->_size + size > KEY_DECODER_BUFFER_SIZE) {
+    memmove(self->_bytes, self->_bytes + self->_start, self->_size);
+    memmove(self->_times, self->_times + self->_start,
+            self->_size * sizeof(self->_times[0]));
+    self->_start = 0;
+  }
+
+  size_t room = KEY_DECODER_BUFFER_SIZE - self->_start - self->_size;
+  if (size > room) size = room;
+  size_t end = self->_start + self->_size;
+  memcpy(self->_bytes + end, bytes, size);
+  for (size_t i = 0; i < size; i++) self->_times[end + i] = time_ns;
+  self->_size += size;
+  self->stats.bytes += size;
+  return size;
+}
+
+/**
+ * @brief Returns how many bytes can be fed.
+ *
+ * @param self A pointer to the KeyDecoder instance.
+ * @return The number of bytes.
+ */
+static size_t _room(KeyDecoder *self) {
+  return self ? KEY_DECODER_BUFFER_SIZE - self->_size : 0;
+}
+
+/**
+ * @brief Decodes the next key.
+ *
+ * Answers of the terminal and unknown sequences are skipped. An incomplete
+ * sequence waits for the rest of its bytes until its deadline, see
+ * `deadline_ns`, then its ESC is taken as the ESC key.
+ *
+ * @param self A pointer to the KeyDecoder instance.
+ * @param now_ns The current monotonic time.
+ * @param event Where the key is stored.
+ * @return true if a key was decoded.
+ */
+static bool _next(KeyDecoder *self, long long now_ns, KeyEvent *event) {
+  if (!self) return false;
+  while (self->_size) {
+    KeyEvent decoded = {.key = ERR,
+                        .type = KEY_EVENT_PRESS,
+                        .time_ns = self->_times[self->_start]};
+    size_t length = decode(self, &decoded);
+    if (!length) {
+      if (now_ns < self->deadline_ns(self)) return false;
+      self->stats.timeouts++;
+      decoded.key = KEY_DECODER_ESC;
+      length = 1;
+    }
+
+    self->_start += length;
+    self->_size -= length;
+    if (!self->_size) self->_start = 0;
+    if (decoded.key != ERR) {
+      self->stats.keys++;
+      *event = decoded;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Returns when the incomplete sequence at the start of the fed bytes
+ * is given up on.
+ *
+ * @param self A pointer to the KeyDecoder instance.
+ * @return The monotonic time, 0 if no byte waits.
+ */
+static long long _deadline_ns(KeyDecoder *self) {
+  if (!self || !self->_size) return 0;
+  return self->_times[self->_start] + KEY_DECODER_ESC_TIMEOUT_MS * 1000000LL;
+}
+
+/**
+ * @brief Frees the decoder.
+ *
+ * @param self A pointer to the KeyDecoder instance.
+ */
+static void _destroy(KeyDecoder *self) { free(self); }
+
+/**
+ * @brief Creates a key decoder.
+ *
+ * If memory allocation fails, the function prints an error message to stderr
+ * and exits the program with a failure status.
+ *
+ * @return A pointer to the newly created decoder.
+ */
+KeyDecoder *new_key_decoder(void) {
+  KeyDecoder *self = (KeyDecoder *)calloc(1, sizeof(KeyDecoder));
+  if (!self) {
+    fprintf(stderr, "Cannot allocate mem for KeyDecoder\n");
+    exit(-1);
+  }
+
+  self->feed = _feed;
+  self->room = _room;
+  self->next = _next;
+  self->deadline_ns = _deadline_ns;
+  self->destroy = _destroy;
+  return self;
+}
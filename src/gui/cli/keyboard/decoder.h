@@ -0,0 +1,128 @@
+#ifndef CLI_KEYBOARD_DECODER_H
+#define CLI_KEYBOARD_DECODER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define KEY_DECODER_BUFFER_SIZE 256
+#define KEY_DECODER_SEQUENCE_MAX 32
+#define KEY_DECODER_ESC_TIMEOUT_MS 25
+
+// kitty keyboard protocol: disambiguate escape codes, report event types and
+// alternate keys
+#define KEY_DECODER_KITTY_FLAGS 7
+#define KEY_DECODER_KITTY_PROBE "\033[?u\033[c"
+#define KEY_DECODER_KITTY_PUSH "\033[>7u"
+#define KEY_DECODER_KITTY_POP "\033[<u"
+
+/**
+ * @brief Enumeration of the key event types, numbered as in the kitty
+ * keyboard protocol.
+ *
+ * @enum KeyEventType
+ * @var KEY_EVENT_PRESS The key was pressed, or a terminal that does not
+ * report event types sent it.
+ * @var KEY_EVENT_REPEAT The held key was repeated by the terminal.
+ * @var KEY_EVENT_RELEASE The key was released.
+ */
+typedef enum {
+  KEY_EVENT_PRESS = 1,
+  KEY_EVENT_REPEAT = 2,
+  KEY_EVENT_RELEASE = 3,
+} KeyEventType;
+
+/**
+ * @brief A decoded key.
+ *
+ * @struct KeyEvent
+ * @var key The key code, as `getch()` returns it: a character or a `KEY_*`
+ * code of ncurses.
+ * @var type The event type.
+ * @var time_ns The monotonic time the first byte of the key was read at.
+ */
+typedef struct {
+  int key;
+  KeyEventType type;
+  long long time_ns;
+} KeyEvent;
+
+/**
+ * @brief Counters of a key decoder.
+ *
+ * @struct KeyDecoderStats
+ * @var bytes Number of bytes fed.
+ * @var keys Number of decoded keys.
+ * @var sequences Number of decoded escape sequences.
+ * @var unknown Number of escape sequences decoded to no key.
+ * @var timeouts Number of escape sequences cut short because the rest did not
+ * arrive in time, a lone ESC key included.
+ */
+typedef struct {
+  unsigned long bytes;
+  unsigned long keys;
+  unsigned long sequences;
+  unsigned long unknown;
+  unsigned long timeouts;
+} KeyDecoderStats;
+
+/**
+ * @brief Decodes the bytes a terminal sends for keys.
+ *
+ * The decoder understands plain characters, the CSI and SS3 sequences of the
+ * cursor, editing and function keys and the key events of the kitty keyboard
+ * protocol, with their press, repeat and release types. It returns the same
+ * key codes as `getch()` with `keypad` enabled, so the listeners do not care
+ * which one read a key.
+ *
+ * An ESC byte either is the ESC key or starts a sequence. A sequence that is
+ * still incomplete `KEY_DECODER_ESC_TIMEOUT_MS` after its first byte was read
+ * is taken byte by byte instead, where ncurses waits `ESCDELAY`, a second by
+ * default. Terminals send a sequence in one write, so in practice only a
+ * lone ESC waits. With the kitty protocol the ESC key has a sequence of its
+ * own and never waits.
+ *
+ * The answers of the terminal to `KEY_DECODER_KITTY_PROBE` are decoded too:
+ * `is_kitty` is set when the terminal supports the kitty protocol, `is_probed`
+ * once the terminal answered the probe at all.
+ *
+ * @struct __key_decoder
+ * @var is_kitty Whether the terminal reported kitty protocol support.
+ * @var is_probed Whether the terminal answered the probe.
+ * @var stats Counters of the decoder.
+ * @var _bytes The bytes fed and not decoded yet.
+ * @var _times The monotonic time each byte was read at.
+ * @var _start The index of the first byte not decoded yet.
+ * @var _size The number of bytes fed and not decoded yet.
+ * @var feed Function pointer adding read bytes.
+ * @var room Function pointer returning how many bytes can be fed.
+ * @var next Function pointer decoding the next key.
+ * @var deadline_ns Function pointer returning when an incomplete sequence is
+ * given up on.
+ * @var destroy Function pointer freeing the decoder.
+ */
+typedef struct __key_decoder {
+  bool is_kitty;
+  bool is_probed;
+  KeyDecoderStats stats;
+
+  unsigned char _bytes[KEY_DECODER_BUFFER_SIZE];
+  long long _times[KEY_DECODER_BUFFER_SIZE];
+  size_t _start;
+  size_t _size;
+
+  size_t (*feed)(struct __key_decoder *self, const char *bytes, size_t size,
+                 long long time_ns);
+  size_t (*room)(struct __key_decoder *self);
+  bool (*next)(struct __key_decoder *self, long long now_ns, KeyEvent *event);
+  long long (*deadline_ns)(struct __key_decoder *self);
+  void (*destroy)(struct __key_decoder *self);
+} KeyDecoder;
+
+/**
+ * @brief Creates a key decoder.
+ *
+ * @return A pointer to the newly created decoder.
+ */
+KeyDecoder *new_key_decoder(void);
+
+#endif  // !CLI_KEYBOARD_DECODER_H
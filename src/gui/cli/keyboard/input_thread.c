@@ -0,0 +1,294 @@
+#define _GNU_SOURCE
+
+#include "input_thread.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// how long the thread sleeps before it retries a full queue
+#define INPUT_THREAD_FULL_WAIT_MS 1
+
+/**
+ * @brief Returns the monotonic time the chunks are stamped with.
+ *
+ * @return The time in nanoseconds.
+ */
+static long long input_thread_now_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ * @brief Empties an input queue.
+ *
+ * @param queue A pointer to the queue.
+ */
+void input_queue_init(InputQueue *queue) {
+  for (size_t i = 0; i < INPUT_QUEUE_SIZE; i++) {
+    atomic_init(&queue->_slots[i].sequence, i);
+  }
+  atomic_init(&queue->_tail, 0);
+  queue->_head = 0;
+}
+
+/**
+ * @brief Adds a chunk to an input queue, from any thread.
+ *
+ * A producer claims the next position only when its slot was taken by the
+ * consumer a whole turn of the ring ago, and a producer that lost the race for
+ * a position tries the next one.
+ *
+ * @param queue A pointer to the queue.
+ * @param chunk The chunk, copied.
+ * @return true if the chunk was added, false if the queue is full.
+ */
+bool input_queue_push(InputQueue *queue, const InputChunk *chunk) {
+  size_t position = atomic_load_explicit(&queue->_tail, memory_order_relaxed);
+  for (;;) {
+    InputQueueSlot *slot = &queue->_slots[position % INPUT_QUEUE_SIZE];
+    size_t sequence =
+        atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    if (sequence == position) {
+      if (atomic_compare_exchange_weak_explicit(
+              &queue->_tail, &position, position + 1, memory_order_relaxed,
+              memory_order_relaxed)) {
+        slot->chunk = *chunk;
+        atomic_store_explicit(&slot->sequence, position + 1,
+                              memory_order_release);
+        return true;
+      }
+    } else if (sequence < position) {
+      return false;
+    } else {
+      position = atomic_load_explicit(&queue->_tail, memory_order_relaxed);
+    }
+  }
+}
+
+/**
+ * @brief Takes the oldest chunk of an input queue, from the consumer thread.
+ *
+ * @param queue A pointer to the queue.
+ * @param chunk Where the chunk is stored.
+ * @return true if a chunk was taken, false if the queue is empty.
+ */
+bool input_queue_pop(InputQueue *queue, InputChunk *chunk) {
+  InputQueueSlot *slot = &queue->_slots[queue->_head % INPUT_QUEUE_SIZE];
+  size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+  if (sequence != queue->_head + 1) return false;
+
+  *chunk = slot->chunk;
+  atomic_store_explicit(&slot->sequence, queue->_head + INPUT_QUEUE_SIZE,
+                        memory_order_release);
+  queue->_head++;
+  return true;
+}
+
+/**
+ * @brief Asks for a real-time priority and a CPU for the calling thread.
+ *
+ * @param self A pointer to the InputThread instance.
+ */
+static void tune_thread(InputThread *self) {
+  if (self->_is_priority) {
+    struct sched_param param = {.sched_priority =
+                                    sched_get_priority_min(SCHED_FIFO)};
+    self->is_realtime =
+        !pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+  }
+  if (self->_cpu >= 0 && self->_cpu < CPU_SETSIZE) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(self->_cpu, &cpus);
+    self->is_pinned =
+        !pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+  }
+}
+
+/**
+ * @brief Queues a chunk, waiting for room while the queue is full.
+ *
+ * @param self A pointer to the InputThread instance.
+ * @param chunk The chunk.
+ * @return false if the thread was stopped while it waited.
+ */
+static bool queue_chunk(InputThread *self, const InputChunk *chunk) {
+  while (!input_queue_push(&self->queue, chunk)) {
+    self->stats.full++;
+    struct pollfd stop = {.fd = self->_stop_fds[0], .events = POLLIN};
+    if (poll(&stop, 1, INPUT_THREAD_FULL_WAIT_MS) > 0) return false;
+  }
+  self->stats.chunks++;
+  self->stats.bytes += chunk->size;
+
+  // a full pipe is readable already, the byte is not needed then
+  ssize_t written = write(self->_notify_write_fd, "", 1);
+  (void)written;
+  return true;
+}
+
+/**
+ * @brief The input thread: reads and queues the input until it is stopped or
+ * the input is closed.
+ *
+ * @param arg A pointer to the InputThread instance.
+ * @return NULL.
+ */
+static void *run_input(void *arg) {
+  InputThread *self = (InputThread *)arg;
+  // signals such as SIGWINCH are for the thread drawing the screen
+  sigset_t signals;
+  sigfillset(&signals);
+  pthread_sigmask(SIG_BLOCK, &signals, NULL);
+  tune_thread(self);
+
+  bool is_running = true;
+  while (is_running) {
+    struct pollfd fds[] = {
+        {.fd = self->_input_fd, .events = POLLIN},
+        {.fd = self->_stop_fds[0], .events = POLLIN},
+    };
+    if (poll(fds, 2, -1) < 0) {
+      is_running = errno == EINTR;
+      continue;
+    }
+    if (fds[1].revents) break;
+    if (!fds[0].revents) continue;
+
+    InputChunk chunk;
+    ssize_t size = read(self->_input_fd, chunk.bytes, sizeof(chunk.bytes));
+    chunk.time_ns = input_thread_now_ns();
+    if (size <= 0) {
+      // the input was closed or failed, a non-blocking one only had no bytes
+      is_running = size < 0 && (errno == EAGAIN || errno == EINTR);
+    } else {
+      chunk.size = (size_t)size;
+      is_running = queue_chunk(self, &chunk);
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief Starts the input thread.
+ *
+ * @param self A pointer to the InputThread instance.
+ * @return 0 on success, -1 if the thread runs already or cannot be created.
+ */
+static int _start(InputThread *self) {
+  if (!self || self->_is_running) return -1;
+  if (pthread_create(&self->_thread, NULL, run_input, self)) return -1;
+  self->_is_running = true;
+  return 0;
+}
+
+/**
+ * @brief Stops the input thread and waits for it. The queued chunks are kept.
+ *
+ * @param self A pointer to the InputThread instance.
+ */
+static void _stop(InputThread *self) {
+  if (!self || !self->_is_running) return;
+  ssize_t written = write(self->_stop_fds[1], "", 1);
+  (void)written;
+  pthread_join(self->_thread, NULL);
+  self->_is_running = false;
+
+  char byte;
+  while (read(self->_stop_fds[0], &byte, 1) > 0) continue;
+}
+
+/**
+ * @brief Reads what the notification descriptor holds, before the queue is
+ * emptied.
+ *
+ * @param self A pointer to the InputThread instance.
+ */
+static void _drain(InputThread *self) {
+  if (!self) return;
+  char buffer[INPUT_QUEUE_SIZE];
+  while (read(self->notify_fd, buffer, sizeof(buffer)) > 0) continue;
+}
+
+/**
+ * @brief Stops the input thread and frees it.
+ *
+ * @param self A pointer to the InputThread instance.
+ */
+static void _destroy(InputThread *self) {
+  if (!self) return;
+  self->stop(self);
+  close(self->notify_fd);
+  close(self->_notify_write_fd);
+  close(self->_stop_fds[0]);
+  close(self->_stop_fds[1]);
+  free(self);
+}
+
+/**
+ * @brief Creates a non-blocking pipe closed on exec.
+ *
+ * @param fds Where the read and the write end are stored.
+ * @return 0 on success, -1 on failure.
+ */
+static int open_pipe(int fds[2]) {
+  if (pipe(fds)) return -1;
+  for (int i = 0; i < 2; i++) {
+    fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+    fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+  }
+  return 0;
+}
+
+/**
+ * @brief Creates an input thread, not started yet.
+ *
+ * If memory allocation fails, the function prints an error message to stderr
+ * and exits the program with a failure status.
+ *
+ * @param input_fd The descriptor the input is read from.
+ * @param cpu The CPU to pin the thread to, -1 to leave it to the scheduler.
+ * @param is_priority Whether to ask for a real-time priority.
+ * @return A pointer to the newly created input thread, NULL if its pipes
+ * cannot be created.
+ */
+InputThread *new_input_thread(int input_fd, int cpu, bool is_priority) {
+  InputThread *self = (InputThread *)calloc(1, sizeof(InputThread));
+  if (!self) {
+    fprintf(stderr, "Cannot allocate mem for InputThread\n");
+    exit(-1);
+  }
+
+  int notify[2];
+  if (open_pipe(notify)) {
+    free(self);
+    return NULL;
+  }
+  if (open_pipe(self->_stop_fds)) {
+    close(notify[0]);
+    close(notify[1]);
+    free(self);
+    return NULL;
+  }
+  self->notify_fd = notify[0];
+  self->_notify_write_fd = notify[1];
+  self->_input_fd = input_fd;
+  self->_cpu = cpu;
+  self->_is_priority = is_priority;
+  input_queue_init(&self->queue);
+
+  self->start = _start;
+  self->stop = _stop;
+  self->drain = _drain;
+  self->destroy = _destroy;
+  return self;
+}
@@ -0,0 +1,165 @@
+#ifndef CLI_KEYBOARD_INPUT_THREAD_H
+#define CLI_KEYBOARD_INPUT_THREAD_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define INPUT_QUEUE_SIZE 256
+#define INPUT_CHUNK_SIZE 64
+
+/**
+ * @brief Bytes read from the input in one read.
+ *
+ * @struct InputChunk
+ * @var time_ns The monotonic time the bytes were read at.
+ * @var size The number of bytes.
+ * @var bytes The bytes.
+ */
+typedef struct {
+  long long time_ns;
+  size_t size;
+  char bytes[INPUT_CHUNK_SIZE];
+} InputChunk;
+
+/**
+ * @brief A slot of an input queue.
+ *
+ * @struct InputQueueSlot
+ * @var sequence The position the slot is written at next, plus one once it is
+ * written and not taken yet.
+ * @var chunk The chunk.
+ */
+typedef struct {
+  atomic_size_t sequence;
+  InputChunk chunk;
+} InputQueueSlot;
+
+/**
+ * @brief A bounded queue of input chunks with many producers and one
+ * consumer.
+ *
+ * The producers claim a position with a compare and swap and publish their
+ * chunk through the sequence of its slot, the consumer takes the chunks in
+ * the order the positions were claimed. Neither side takes a lock, so a
+ * producer never waits for the consumer or for another producer, and a full
+ * queue is reported instead of waited on.
+ *
+ * @struct InputQueue
+ * @var _slots The slots, used as a ring.
+ * @var _tail The next position a producer claims.
+ * @var _head The next position the consumer takes, only touched by the
+ * consumer.
+ */
+typedef struct {
+  InputQueueSlot _slots[INPUT_QUEUE_SIZE];
+  atomic_size_t _tail;
+  size_t _head;
+} InputQueue;
+
+/**
+ * @brief Empties an input queue.
+ *
+ * @param queue A pointer to the queue.
+ */
+void input_queue_init(InputQueue *queue);
+
+/**
+ * @brief Adds a chunk to an input queue, from any thread.
+ *
+ * @param queue A pointer to the queue.
+ * @param chunk The chunk, copied.
+ * @return true if the chunk was added, false if the queue is full.
+ */
+bool input_queue_push(InputQueue *queue, const InputChunk *chunk);
+
+/**
+ * @brief Takes the oldest chunk of an input queue, from the consumer thread.
+ *
+ * @param queue A pointer to the queue.
+ * @param chunk Where the chunk is stored.
+ * @return true if a chunk was taken, false if the queue is empty.
+ */
+bool input_queue_pop(InputQueue *queue, InputChunk *chunk);
+
+/**
+ * @brief Counters of an input thread, written by the thread and read once it
+ * stopped.
+ *
+ * @struct InputThreadStats
+ * @var chunks Number of chunks queued.
+ * @var bytes Number of bytes queued.
+ * @var full Number of times the queue was full and the thread waited for room.
+ */
+typedef struct {
+  unsigned long chunks;
+  unsigned long bytes;
+  unsigned long full;
+} InputThreadStats;
+
+/**
+ * @brief Reads the input on a thread of its own.
+ *
+ * The thread sleeps in `poll` on the input descriptor and reads the bytes the
+ * moment they arrive, stamps them with the monotonic time and queues them in
+ * `queue`. The time a key was pressed at then no longer depends on how long
+ * the thread reading the keys spends drawing. After each chunk a byte is
+ * written to `notify_fd`, which an event loop can wait on instead of the
+ * input itself.
+ *
+ * When it is permitted the thread runs with the lowest real-time priority, so
+ * a busy machine does not delay the reads, and on a given CPU. Both are only
+ * attempted: an unprivileged process keeps the normal priority.
+ *
+ * @struct __input_thread
+ * @var queue The chunks read and not taken yet.
+ * @var stats Counters of the thread.
+ * @var notify_fd The descriptor readable after a chunk was queued.
+ * @var is_realtime Whether the thread got a real-time priority.
+ * @var is_pinned Whether the thread was pinned to its CPU.
+ * @var _input_fd The descriptor the input is read from.
+ * @var _notify_write_fd The write end of `notify_fd`.
+ * @var _stop_fds The pipe waking the thread up to stop.
+ * @var _cpu The CPU to pin the thread to, -1 for none.
+ * @var _is_priority Whether to ask for a real-time priority.
+ * @var _thread The thread.
+ * @var _is_running Whether the thread was started and not stopped.
+ * @var start Function pointer starting the thread.
+ * @var stop Function pointer stopping the thread and waiting for it.
+ * @var drain Function pointer reading what `notify_fd` holds.
+ * @var destroy Function pointer stopping the thread and freeing it.
+ */
+typedef struct __input_thread {
+  InputQueue queue;
+  InputThreadStats stats;
+  int notify_fd;
+  bool is_realtime;
+  bool is_pinned;
+
+  int _input_fd;
+  int _notify_write_fd;
+  int _stop_fds[2];
+  int _cpu;
+  bool _is_priority;
+  pthread_t _thread;
+  bool _is_running;
+
+  int (*start)(struct __input_thread *self);
+  void (*stop)(struct __input_thread *self);
+  void (*drain)(struct __input_thread *self);
+  void (*destroy)(struct __input_thread *self);
+} InputThread;
+
+/**
+ * @brief Creates an input thread, not started yet.
+ *
+ * @param input_fd The descriptor the input is read from.
+ * @param cpu The CPU to pin the thread to, -1 to leave it to the scheduler.
+ * @param is_priority Whether to ask for a real-time priority.
+ * @return A pointer to the newly created input thread, NULL if its pipes
+ * cannot be created.
+ */
+InputThread *new_input_thread(int input_fd, int cpu, bool is_priority);
+
+#endif  // !CLI_KEYBOARD_INPUT_THREAD_H
@@ -1,77 +1,246 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "keyboard.h"
 
+#include <poll.h>
+#include <unistd.h>
+
+// keys repeated faster than this are held down
+#define KEYBOARD_HOLD_TIMEOUT_NS 75000000LL
+
+// a terminal that reports releases still gets a key released that it neither
+// repeated nor released for this long, in case the release got lost
+#define KEYBOARD_KITTY_RELEASE_NS 1000000000LL
+
 /**
- * @brief Calculates the time difference between two timespec structures.
+ * @brief Returns the monotonic time the keys are stamped with.
  *
- * This function computes the difference in time between two timespec
- * structures, returning the result as a double value representing the time
- * difference in seconds. It accounts for both seconds and nanoseconds
- * components of the timespec structures.
+ * @return The time in nanoseconds.
+ */
+static long long keyboard_now_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ * @brief Determines if a key is being held down.
  *
- * @param start The start timespec structure.
- * @param end The end timespec structure.
- * @return The time difference in seconds as a double value.
+ * A key is held down when it was already read within
+ * `KEYBOARD_HOLD_TIMEOUT_NS`, which is what the auto-repeat of a terminal
+ * sends for a key kept pressed. Other keys read in between do not matter.
+ * Both keys carry the time they were read at, so the hold state does not
+ * depend on when the keys are emitted.
+ *
+ * @param last The previous read of the same key.
+ * @param btn The key to check for a hold condition.
+ * @return TRUE if the key is being held down, FALSE otherwise.
  */
-static double time_delta(struct timespec start, struct timespec end) {
-  return (start.tv_sec - end.tv_sec) +
-         ((start.tv_nsec - end.tv_nsec) / 1000000000.0);
+static bool is_press_and_hold(Button last, Button btn) {
+  return last.key == btn.key &&
+         btn.time_ns - last.time_ns <= KEYBOARD_HOLD_TIMEOUT_NS;
 }
 
 /**
- * @brief Determines if a key is being held down for a specified duration.
- *
- * This function checks if a given key has been pressed and held for a duration
- * specified by the `hold_timeout_ms` parameter. It uses the current time and
- * the time of the last call to determine if the key press meets the hold
- * condition.
- *
- * @param key The key code to check for a hold condition.
- * @param hold_timeout_ms The duration in milliseconds for which the key must be
- * held.
- * @return TRUE if the key is being held down for the specified duration, FALSE
- * otherwise.
+ * @brief Checks whether the hold state of a key is tracked.
+ *
+ * @param key The key code.
+ * @return TRUE for the keys `getch()` returns, FALSE for ERR.
  */
-static bool is_press_and_hold(int key, double hold_timeout_ms) {
-  static struct timespec last_call = {0};
-  struct timespec now;
-  timespec_get(&now, TIME_UTC);
+static bool is_known_key(int key) {
+  return key >= 0 && key < KEYBOARD_KEYS_COUNT;
+}
 
-  bool is_hold = FALSE;
-  static int prev_key = ERR;
+/**
+ * @brief Returns the histogram bucket of a value.
+ *
+ * @param value The value, negative values count as zero.
+ * @return The index of the bucket, see `KeyboardStats`.
+ */
+static size_t histogram_bucket(long long value) {
+  size_t bucket = 0;
+  for (; value > 0 && bucket < KEYBOARD_HISTOGRAM_SIZE - 1; value >>= 1) {
+    bucket++;
+  }
+  return bucket;
+}
 
-  if (prev_key != key) {
-    prev_key = key;
-  } else {
-    is_hold = time_delta(now, last_call) <= hold_timeout_ms;
+/**
+ * @brief Finds the overflow map slot of a key.
+ *
+ * The overflow map is an open addressing hash table. A slot whose key lost its
+ * last listener is marked `KEYBOARD_FREED_KEY`, so a lookup goes on past it
+ * and stops at the first slot never taken, and a new key takes the first freed
+ * slot of its probe sequence.
+ *
+ * @param self A pointer to the KeyboardController instance.
+ * @param key The key code, outside the range of ncurses.
+ * @param is_adding Whether a slot is taken for the key if it has none.
+ * @return A pointer to the slot of the key, NULL if the key has no slot.
+ */
+static KeyboardOverflowSlot *find_slot(KeyboardController *self, int key,
+                                       bool is_adding) {
+  unsigned int hash = (unsigned int)key * 2654435761u;
+  KeyboardOverflowSlot *free_slot = NULL;
+  for (size_t i = 0; i < KEYBOARD_OVERFLOW_SIZE; i++) {
+    KeyboardOverflowSlot *slot =
+        &self->_overflow[(hash + i) % KEYBOARD_OVERFLOW_SIZE];
+    if (slot->key == key) return slot;
+    if (slot->key == KEYBOARD_FREED_KEY) {
+      if (!free_slot) free_slot = slot;
+    } else if (slot->key == KEYBOARD_NO_KEY) {
+      if (!free_slot) free_slot = slot;
+      break;
+    }
   }
+  if (!is_adding || !free_slot) return NULL;
+  *free_slot = (KeyboardOverflowSlot){.key = key, .first = -1};
+  return free_slot;
+}
+
+/**
+ * @brief Finds the first listener of a key.
+ *
+ * The keys of ncurses are looked up in the dispatch table, the other codes in
+ * the overflow map, see find_slot().
+ *
+ * @param self A pointer to the KeyboardController instance.
+ * @param key The key code.
+ * @param is_adding Whether a slot of the overflow map is taken for the key.
+ * @return A pointer to the index of the first listener of the key, NULL if the
+ * key has no slot.
+ */
+static short *find_listeners(KeyboardController *self, int key,
+                             bool is_adding) {
+  if (is_known_key(key)) return &self->_dispatch[key];
+
+  KeyboardOverflowSlot *slot = find_slot(self, key, is_adding);
+  return slot ? &slot->first : NULL;
+}
 
-  last_call = now;
-  return is_hold;
+/**
+ * @brief Appends a listener to the listeners of a key.
+ *
+ * @param self A pointer to the KeyboardController instance.
+ * @param index The index of the listener in the pool.
+ * @param key The key code.
+ * @return 0 on success, -1 if the overflow map is full.
+ */
+static int link_listener(KeyboardController *self, short index, int key) {
+  short *next = find_listeners(self, key, TRUE);
+  if (!next) return -1;
+  while (*next >= 0) next = &self->_listeners[*next].next;
+
+  self->_listeners[index].key = key;
+  self->_listeners[index].next = -1;
+  *next = index;
+  return 0;
+}
+
+/**
+ * @brief Removes a listener from the listeners of its key.
+ *
+ * The overflow map slot of a key goes back to the map with its last listener.
+ *
+ * @param self A pointer to the KeyboardController instance.
+ * @param key The key code.
+ * @param callback The callback function of the listener.
+ * @return The index of the listener in the pool, -1 if the key has no such
+ * listener.
+ */
+static short unlink_listener(KeyboardController *self, int key,
+                             listener_callback callback) {
+  short *next = find_listeners(self, key, FALSE);
+  while (next && *next >= 0) {
+    short index = *next;
+    if (self->_listeners[index].callback == callback) {
+      *next = self->_listeners[index].next;
+      KeyboardOverflowSlot *slot =
+          is_known_key(key) ? NULL : find_slot(self, key, FALSE);
+      if (slot && slot->first < 0) slot->key = KEYBOARD_FREED_KEY;
+      return index;
+    }
+    next = &self->_listeners[index].next;
+  }
+  return -1;
 }
 
 /**
  * @brief Adds a new listener for a specific key to the keyboard controller.
  *
- * This function dynamically grows the array of listeners by reallocating memory
- * to accommodate the new listener. It then initializes a new
- * KeyboardButtonListener structure with the specified key and callback
- * function, and adds it to the array. The listeners array is expanded to ensure
- * that it can hold the new listener without losing existing data, following the
- * principle of doubling the capacity to minimize the number of reallocations
- * and improve performance.
+ * The listener is taken from the fixed pool of the controller and appended to
+ * the listeners of the key, so the listeners of a key are called in the order
+ * they were added. Nothing is allocated.
  *
  * @param self A pointer to the KeyboardController instance.
  * @param key The key code for which the listener is being added.
  * @param callback The callback function to be executed when the key is pressed.
+ * @return 0 on success, -1 if the pool or the overflow map is full.
  */
-static void _add_listener(KeyboardController *self, int key,
-                          listener_callback callback) {
-  self->listeners = realloc(self->listeners, sizeof(KeyboardButtonListener) *
-                                                 (self->listeners_count + 1));
+static int _add_listener(KeyboardController *self, int key,
+                         listener_callback callback) {
+  if (!self || !callback || self->_free < 0) return -1;
 
-  KeyboardButtonListener new_listener = {.key = key, .callback = callback};
-  self->listeners[self->listeners_count] = new_listener;
+  short index = self->_free;
+  short next_free = self->_listeners[index].next;
+  if (link_listener(self, index, key)) return -1;
+  self->_free = next_free;
+  self->_listeners[index].callback = callback;
   self->listeners_count++;
+  return 0;
+}
+
+/**
+ * @brief Removes a listener of a key.
+ *
+ * The listener goes back to the pool. A listener may remove itself while it is
+ * called.
+ *
+ * @param self A pointer to the KeyboardController instance.
+ * @param key The key code of the listener.
+ * @param callback The callback function of the listener.
+ * @return 0 on success, -1 if the key has no such listener.
+ */
+static int _remove_listener(KeyboardController *self, int key,
+                            listener_callback callback) {
+  if (!self) return -1;
+  short index = unlink_listener(self, key, callback);
+  if (index < 0) return -1;
+
+  self->_listeners[index] =
+      (KeyboardButtonListener){.key = KEYBOARD_NO_KEY, .next = self->_free};
+  self->_free = index;
+  self->listeners_count--;
+  return 0;
+}
+
+/**
+ * @brief Moves a listener from a key to another key.
+ *
+ * The listener keeps its place in the pool, so rebinding allocates nothing and
+ * cannot run out of listeners. It becomes the last listener of the new key. A
+ * listener may rebind itself while it is called.
+ *
+ * The listener leaves its key before the new key takes an overflow map slot,
+ * so the slot the old key gives up can be taken. If the map is still full,
+ * the listener goes back to the end of the listeners of its old key, whose
+ * slot it has just left.
+ *
+ * @param self A pointer to the KeyboardController instance.
+ * @param key The key code of the listener.
+ * @param callback The callback function of the listener.
+ * @param new_key The key code the listener listens to from now on.
+ * @return 0 on success, -1 if the key has no such listener or the overflow map
+ * is full.
+ */
+static int _rebind_listener(KeyboardController *self, int key,
+                            listener_callback callback, int new_key) {
+  if (!self) return -1;
+  short index = unlink_listener(self, key, callback);
+  if (index < 0) return -1;
+  if (!link_listener(self, index, new_key)) return 0;
+  link_listener(self, index, key);
+  return -1;
 }
 
 /**
@@ -79,23 +248,24 @@ static void _add_listener(KeyboardController *self, int key,
  * listeners.
  *
  * This function is responsible for safely deallocating the memory used by the
- * KeyboardController instance and its associated listeners array. It first
- * checks if the KeyboardController pointer is not NULL and if the listeners
- * array exists. If so, it frees the memory allocated for the listeners array,
- * resets the listeners count to 0, and sets the listeners pointer to NULL.
- * Finally, it frees the memory allocated for the KeyboardController instance
- * itself.
+ * KeyboardController instance. The listeners live in the controller itself.
+ * The auto-repeat engine and the key decoder go with it, and the kitty
+ * keyboard protocol is turned off if it was turned on. Finally, it frees the
+ * memory allocated for the KeyboardController instance itself.
  *
  * @param self A pointer to the KeyboardController instance to be destroyed.
  */
 static void _destroy(KeyboardController *self) {
   if (!self) return;
 
-  if (self->listeners) {
-    free(self->listeners);
-    self->listeners_count = 0;
-    self->listeners = NULL;
+  if (self->_is_kitty) {
+    ssize_t written = write(self->_output_fd, KEY_DECODER_KITTY_POP,
+                            sizeof(KEY_DECODER_KITTY_POP) - 1);
+    (void)written;
   }
+  if (self->input_thread) self->input_thread->destroy(self->input_thread);
+  if (self->decoder) self->decoder->destroy(self->decoder);
+  if (self->auto_repeat) self->auto_repeat->destroy(self->auto_repeat);
   free(self);
 }
 
@@ -106,10 +276,10 @@ static void _destroy(KeyboardController *self) {
  * This function is responsible for triggering the appropriate callback
  * functions when a button press event occurs. It first checks if there is a
  * general handler (`on_emit`) registered with the KeyboardController. If so, it
- * calls this handler with the button information. Then, it iterates over the
- * array of registered listeners, checking if any of them are listening for the
- * pressed button. If a match is found, it calls the corresponding callback
- * function with the button information.
+ * calls this handler with the button information. Then, it calls the
+ * listeners of the pressed button in the order they were added. They are found
+ * in constant time whatever the number of listeners: the dispatch table is
+ * indexed by the key code.
  *
  * @param self A pointer to the KeyboardController instance.
  * @param btn The Button structure containing the button's key and hold state.
@@ -117,42 +287,383 @@ static void _destroy(KeyboardController *self) {
 static void _emit(KeyboardController *self, Button btn) {
   if (self->on_emit) self->on_emit(btn);
 
-  for (size_t i = 0; (i < self->listeners_count) && self->listeners; i++) {
-    if (self->listeners[i].key == btn.key) self->listeners[i].callback(btn);
+  short *first = find_listeners(self, btn.key, FALSE);
+  for (short i = first ? *first : -1; i >= 0;) {
+    // the listener may remove or rebind itself
+    short next = self->_listeners[i].next;
+    self->_listeners[i].callback(btn);
+    i = next;
+  }
+}
+
+/**
+ * @brief Stores a read key in the ring.
+ *
+ * The key must fit in the ring. Keys reported as repeats are held, other keys
+ * are held when they repeat quickly, unless the terminal reports repeats
+ * itself.
+ *
+ * @param self A pointer to the KeyboardController instance.
+ * @param tail The index the key is stored at, advanced past it.
+ * @param event The key.
+ */
+static void push_key(KeyboardController *self, size_t *tail, KeyEvent event) {
+  Button btn = {.key = event.key,
+                .time_ns = event.time_ns,
+                .count = 1,
+                .release = event.type == KEY_EVENT_RELEASE};
+  if (is_known_key(btn.key)) {
+    btn.hold = event.type == KEY_EVENT_REPEAT ||
+               (event.type == KEY_EVENT_PRESS && !self->_is_kitty &&
+                is_press_and_hold(self->_last_read[btn.key], btn));
+    self->_last_read[btn.key] = btn.release ? (Button){.key = ERR} : btn;
+  }
+
+  self->_ring[*tail % KEYBOARD_RING_SIZE] = btn;
+  atomic_store_explicit(&self->_tail, ++*tail, memory_order_release);
+}
+
+/**
+ * @brief Reads the pending keys with `getch()`.
+ *
+ * Only the first `getch()` waits as long as the ncurses timeout asks for, the
+ * keys after it are only taken if they are already there.
+ *
+ * @param self A pointer to the KeyboardController instance.
+ * @param head The index of the next key to emit.
+ * @param tail The index the next key is stored at, advanced past the keys.
+ * @return The number of keys read.
+ */
+static size_t read_ncurses_keys(KeyboardController *self, size_t head,
+                                size_t *tail) {
+  int delay = wgetdelay(stdscr);
+  size_t count = 0;
+  int key = ERR;
+  while (*tail - head < KEYBOARD_RING_SIZE && (key = getch()) != ERR) {
+    if (!count) wtimeout(stdscr, 0);
+    push_key(self, tail,
+             (KeyEvent){.key = key,
+                        .type = KEY_EVENT_PRESS,
+                        .time_ns = keyboard_now_ns()});
+    count++;
+  }
+  if (count) wtimeout(stdscr, delay);
+  return count;
+}
+
+/**
+ * @brief Moves the keys the decoder has ready into the ring.
+ *
+ * @param self A pointer to the KeyboardController instance.
+ * @param head The index of the next key to emit.
+ * @param tail The index the next key is stored at, advanced past the keys.
+ * @return The number of keys moved.
+ */
+static size_t decode_keys(KeyboardController *self, size_t head,
+                          size_t *tail) {
+  size_t count = 0;
+  KeyEvent event;
+  while (*tail - head < KEYBOARD_RING_SIZE &&
+         self->decoder->next(self->decoder, keyboard_now_ns(), &event)) {
+    push_key(self, tail, event);
+    count++;
+  }
+  return count;
+}
+
+/**
+ * @brief Turns the kitty keyboard protocol on once the terminal reported that
+ * it supports it.
+ *
+ * @param self A pointer to the KeyboardController instance.
+ */
+static void turn_on_kitty(KeyboardController *self) {
+  if (self->decoder->is_kitty && !self->_is_kitty) {
+    self->_is_kitty = TRUE;
+    self->auto_repeat->release_ns = KEYBOARD_KITTY_RELEASE_NS;
+    ssize_t written = write(self->_output_fd, KEY_DECODER_KITTY_PUSH,
+                            sizeof(KEY_DECODER_KITTY_PUSH) - 1);
+    (void)written;
+  }
+}
+
+/**
+ * @brief Reads the pending bytes of the input descriptor and decodes them.
+ *
+ * Until the first key, every wait lasts as long as the ncurses timeout asks
+ * for, and never past the deadline of an incomplete escape sequence, the bytes
+ * after it are only taken if they are already there. Once the terminal reports
+ * kitty protocol support, the protocol is turned on.
+ *
+ * @param self A pointer to the KeyboardController instance.
+ * @param head The index of the next key to emit.
+ * @param tail The index the next key is stored at, advanced past the keys.
+ * @return The number of keys read.
+ */
+static size_t read_raw_keys(KeyboardController *self, size_t head,
+                            size_t *tail) {
+  KeyDecoder *decoder = self->decoder;
+  int timeout_ms = wgetdelay(stdscr);
+  size_t count = decode_keys(self, head, tail);
+  while (*tail - head < KEYBOARD_RING_SIZE && decoder->room(decoder)) {
+    if (count) timeout_ms = 0;
+    long long deadline_ns = decoder->deadline_ns(decoder);
+    if (deadline_ns && timeout_ms) {
+      long long left_ms = (deadline_ns - keyboard_now_ns() + 999999) / 1000000;
+      if (left_ms < 0) left_ms = 0;
+      if (timeout_ms < 0 || left_ms < timeout_ms) timeout_ms = (int)left_ms;
+    }
+
+    struct pollfd input = {.fd = self->_input_fd, .events = POLLIN};
+    if (poll(&input, 1, timeout_ms) <= 0) break;
+    char bytes[KEY_DECODER_BUFFER_SIZE];
+    ssize_t size = read(self->_input_fd, bytes, decoder->room(decoder));
+    if (size <= 0) break;
+    decoder->feed(decoder, bytes, size, keyboard_now_ns());
+    count += decode_keys(self, head, tail);
+  }
+  count += decode_keys(self, head, tail);
+  turn_on_kitty(self);
+  return count;
+}
+
+/**
+ * @brief Decodes the bytes the input thread queued.
+ *
+ * Each chunk keeps the time the thread read it at, however long it waited in
+ * the queue. Nothing waits here: the rest of an incomplete escape sequence is
+ * taken on a later read, at the latest when its deadline wakes the caller up.
+ * A chunk the decoder has no room for stays queued.
+ *
+ * @param self A pointer to the KeyboardController instance.
+ * @param head The index of the next key to emit.
+ * @param tail The index the next key is stored at, advanced past the keys.
+ * @return The number of keys read.
+ */
+static size_t read_thread_keys(KeyboardController *self, size_t head,
+                               size_t *tail) {
+  KeyDecoder *decoder = self->decoder;
+  InputThread *thread = self->input_thread;
+  // a chunk queued after the drain writes a byte of its own
+  thread->drain(thread);
+
+  size_t count = decode_keys(self, head, tail);
+  InputChunk chunk;
+  while (*tail - head < KEYBOARD_RING_SIZE &&
+         decoder->room(decoder) >= INPUT_CHUNK_SIZE &&
+         input_queue_pop(&thread->queue, &chunk)) {
+    decoder->feed(decoder, chunk.bytes, chunk.size, chunk.time_ns);
+    count += decode_keys(self, head, tail);
+  }
+  turn_on_kitty(self);
+  return count;
+}
+
+/**
+ * @brief Reads every pending key into the ring.
+ *
+ * The keys come from `getch()`, or from the input descriptor through the key
+ * decoder once `use_raw_input` was called. Each key is stamped with the
+ * monotonic time it was read at. When the ring is full the remaining keys are
+ * left to the next read, none of them is lost.
+ *
+ * @param self A pointer to the KeyboardController instance.
+ * @return The number of keys read.
+ */
+static size_t _collect(KeyboardController *self) {
+  if (!self) return 0;
+  size_t tail = atomic_load_explicit(&self->_tail, memory_order_relaxed);
+  size_t head = atomic_load_explicit(&self->_head, memory_order_acquire);
+
+  size_t count = self->input_thread ? read_thread_keys(self, head, &tail)
+                 : self->decoder   ? read_raw_keys(self, head, &tail)
+                                   : read_ncurses_keys(self, head, &tail);
+  if (count) {
+    self->stats.keys += count;
+    self->stats.reads++;
+    self->stats.depth[histogram_bucket(tail - head)]++;
+    if (tail - head >= KEYBOARD_RING_SIZE) self->stats.deferred++;
+  }
+  return count;
+}
+
+/**
+ * @brief Reads the keys from a descriptor instead of `getch()`.
+ *
+ * The bytes are decoded by a key decoder of the controller, see `KeyDecoder`,
+ * and ncurses stops looking at the input while it draws. The terminal is
+ * asked whether it supports the kitty keyboard protocol, which is turned on
+ * when it answers that it does and turned off again by `destroy`.
+ *
+ * @param self A pointer to the KeyboardController instance.
+ * @param input_fd The input descriptor, usually the standard input.
+ * @param output_fd The descriptor of the terminal, for the protocol requests.
+ * @return 0 on success, -1 if the keys already come from a descriptor.
+ */
+static int _use_raw_input(KeyboardController *self, int input_fd,
+                          int output_fd) {
+  if (!self || self->decoder) return -1;
+  self->decoder = new_key_decoder();
+  self->_input_fd = input_fd;
+  self->_output_fd = output_fd;
+  typeahead(-1);
+
+  ssize_t written = write(output_fd, KEY_DECODER_KITTY_PROBE,
+                          sizeof(KEY_DECODER_KITTY_PROBE) - 1);
+  (void)written;
+  return 0;
+}
+
+/**
+ * @brief Reads the raw input on a thread of its own, see `InputThread`.
+ *
+ * The keys are still decoded and emitted by the thread calling `collect`, only
+ * the reads and their time stamps move to the input thread. An event loop
+ * should wait on `input_thread->notify_fd` instead of the input descriptor.
+ *
+ * @param self A pointer to the KeyboardController instance.
+ * @param cpu The CPU to pin the thread to, -1 to leave it to the scheduler.
+ * @param is_priority Whether to ask for a real-time priority.
+ * @return 0 on success, -1 if the keys do not come from a descriptor, already
+ * come from a thread, or the thread cannot be started.
+ */
+static int _use_input_thread(KeyboardController *self, int cpu,
+                             bool is_priority) {
+  if (!self || !self->decoder || self->input_thread) return -1;
+  InputThread *thread = new_input_thread(self->_input_fd, cpu, is_priority);
+  if (!thread) return -1;
+  if (thread->start(thread)) {
+    thread->destroy(thread);
+    return -1;
+  }
+  self->input_thread = thread;
+  return 0;
+}
+
+/**
+ * @brief Returns when the controller has something to do without any input.
+ *
+ * @param self A pointer to the KeyboardController instance.
+ * @return The monotonic time of the next auto-repeat or of the deadline of an
+ * incomplete escape sequence, whichever comes first, 0 if there is none.
+ */
+static long long _next_ns(KeyboardController *self) {
+  if (!self) return 0;
+  long long next_ns = self->auto_repeat->next_ns(self->auto_repeat);
+  long long deadline_ns =
+      self->decoder ? self->decoder->deadline_ns(self->decoder) : 0;
+  if (deadline_ns && (!next_ns || deadline_ns < next_ns)) next_ns = deadline_ns;
+  return next_ns;
+}
+
+/**
+ * @brief Checks whether a key is handed to the auto-repeat engine.
+ *
+ * @param self A pointer to the KeyboardController instance.
+ * @param key The key code.
+ * @return TRUE if the key is auto-repeated.
+ */
+static bool is_repeated_key(KeyboardController *self, int key) {
+  for (size_t i = 0; i < self->_repeated_count; i++) {
+    if (self->_repeated_keys[i] == key) return TRUE;
+  }
+  return FALSE;
+}
+
+/**
+ * @brief Hands the repeats of a key to the auto-repeat engine.
+ *
+ * The key is emitted once when it is pressed, the repeats of the terminal are
+ * not emitted at all, `repeat` emits the moves owed to the held key instead.
+ *
+ * @param self A pointer to the KeyboardController instance.
+ * @param key The key code.
+ */
+static void _add_auto_repeat(KeyboardController *self, int key) {
+  if (!self || !is_known_key(key) || is_repeated_key(self, key)) return;
+  if (self->_repeated_count >= AUTO_REPEAT_KEYS_MAX) return;
+  self->_repeated_keys[self->_repeated_count++] = key;
+}
+
+/**
+ * @brief Emits the moves the auto-repeat engine owes to the held keys.
+ *
+ * Each held key is emitted at most once, as a held button standing for every
+ * repeat that came due since the previous call and stamped with the time the
+ * first of them was due at.
+ *
+ * @param self A pointer to the KeyboardController instance.
+ * @param now_ns The current monotonic time.
+ * @return The number of emitted buttons.
+ */
+static size_t _repeat(KeyboardController *self, long long now_ns) {
+  if (!self) return 0;
+  size_t count = 0;
+  for (size_t i = 0; i < self->_repeated_count; i++) {
+    Button btn = {.key = self->_repeated_keys[i], .hold = TRUE};
+    btn.count = self->auto_repeat->owed(self->auto_repeat, btn.key, now_ns,
+                                        &btn.time_ns);
+    if (!btn.count) continue;
+    self->emit(self, btn);
+    count++;
   }
+  return count;
 }
 
 /**
  * @brief Listens for button presses and emits events based on the pressed key.
  *
- * This function continuously listens for button presses
- * using the `getch()` function from ncurses (any "ERR"(-1) signals will ignored
- * for listeners!!!). It creates a Button structure for each key press,
- * including whether the key is being held down. If the key is not being held
+ * This function emits the oldest key of the ring, reading every pending key
+ * with `getch()` from ncurses first when the ring is empty (any "ERR"(-1)
+ * signals will ignored for listeners!!!). Calling it until it returns ERR
+ * handles every key that arrived, in order. If the key is not being held
  * down, it emits an event immediately. If the key is being held down, it emits
  * an event only if the key was not previously hold down. This function also
- * keeps track of the last button pressed to handle hold events correctly.
+ * keeps track of the last state of each key to handle hold events correctly.
+ * The auto-repeated keys are only emitted when they are pressed, see
+ * `add_auto_repeat`.
  *
  * @param self A pointer to the KeyboardController instance.
- * @return A Button structure containing the key code and hold state of the last
- * button pressed.
+ * @return A Button structure containing the key code, hold state and reading
+ * time of the emitted button, or ERR as the key if there was none.
  */
 static Button _listen(KeyboardController *self) {
-  static Button last_btn = {0};
-  int key = getch();
+  size_t head = atomic_load_explicit(&self->_head, memory_order_relaxed);
+  if (head == atomic_load_explicit(&self->_tail, memory_order_acquire)) {
+    self->collect(self);
+  }
+  if (head == atomic_load_explicit(&self->_tail, memory_order_acquire)) {
+    return (Button){.key = ERR};
+  }
 
-  Button btn = {.key = key, .hold = is_press_and_hold(btn.key, 0.075)};
+  Button btn = self->_ring[head % KEYBOARD_RING_SIZE];
+  atomic_store_explicit(&self->_head, head + 1, memory_order_release);
+  self->stats.age[histogram_bucket((keyboard_now_ns() - btn.time_ns) / 1000)]++;
 
-  if (btn.key != ERR) {
-    if (!btn.hold) {
-      self->emit(self, btn);
-    } else if (btn.hold && !last_btn.hold) {
-      self->emit(self, btn);
+  // a release only ends the hold, listeners are only told about presses
+  if (btn.release) {
+    if (is_repeated_key(self, btn.key)) {
+      self->auto_repeat->release(self->auto_repeat, btn.key, btn.time_ns);
     }
+    if (is_known_key(btn.key)) self->_is_held[btn.key] = FALSE;
+    return btn;
+  }
 
-    last_btn = btn;
+  if (is_repeated_key(self, btn.key)) {
+    btn.hold = !self->auto_repeat->press(self->auto_repeat, btn.key,
+                                         btn.time_ns);
+    if (!btn.hold) self->emit(self, btn);
+    return btn;
   }
 
+  bool was_held = is_known_key(btn.key) && self->_is_held[btn.key];
+  if (!btn.hold) {
+    self->emit(self, btn);
+  } else if (btn.hold && !was_held) {
+    self->emit(self, btn);
+  }
+
+  if (is_known_key(btn.key)) self->_is_held[btn.key] = btn.hold;
   return btn;
 }
 
@@ -161,7 +672,8 @@ static Button _listen(KeyboardController *self) {
  *
  * This function dynamically allocates memory for a new KeyboardController
  * instance using `malloc()`. It initializes the instance's fields, including
- * setting the listeners array to NULL and the listeners count to 0. It also
+ * putting every listener of the pool in the free list, with an empty dispatch
+ * table and overflow map, and the listeners count to 0. It also
  * assigns function pointers for adding listeners, listening for button presses,
  * emitting events, and destroying the controller. If memory allocation fails,
  * the function prints an error message to stderr and exits the program with a
@@ -177,10 +689,43 @@ KeyboardController *new_keyboard() {
     exit(-1);
   }
 
-  self->listeners = NULL;
+  for (short i = 0; i < KEYBOARD_LISTENERS_MAX; i++) {
+    self->_listeners[i] = (KeyboardButtonListener){
+        .key = KEYBOARD_NO_KEY,
+        .next = i + 1 < KEYBOARD_LISTENERS_MAX ? i + 1 : -1};
+  }
+  self->_free = 0;
+  for (size_t i = 0; i < KEYBOARD_OVERFLOW_SIZE; i++) {
+    self->_overflow[i] = (KeyboardOverflowSlot){.key = KEYBOARD_NO_KEY,
+                                                .first = -1};
+  }
   self->listeners_count = 0;
+  self->on_emit = NULL;
+  self->stats = (KeyboardStats){0};
+  atomic_init(&self->_head, 0);
+  atomic_init(&self->_tail, 0);
+  self->auto_repeat = new_auto_repeat(0, 0);
+  for (int key = 0; key < KEYBOARD_KEYS_COUNT; key++) {
+    self->_last_read[key] = (Button){.key = ERR};
+    self->_is_held[key] = FALSE;
+    self->_dispatch[key] = -1;
+  }
+  self->_repeated_count = 0;
+  self->decoder = NULL;
+  self->input_thread = NULL;
+  self->_input_fd = -1;
+  self->_output_fd = -1;
+  self->_is_kitty = FALSE;
 
   self->add_listener = _add_listener;
+  self->remove_listener = _remove_listener;
+  self->rebind_listener = _rebind_listener;
+  self->add_auto_repeat = _add_auto_repeat;
+  self->repeat = _repeat;
+  self->collect = _collect;
+  self->use_raw_input = _use_raw_input;
+  self->use_input_thread = _use_input_thread;
+  self->next_ns = _next_ns;
   self->listen = _listen;
   self->emit = _emit;
   self->destroy = _destroy;
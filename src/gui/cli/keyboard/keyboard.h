@@ -1,11 +1,25 @@
 #ifndef CLI_KEYBOARD_KEYBOARD_H
 #define CLI_KEYBOARD_KEYBOARD_H
 
+#include <limits.h>
 #include <ncurses.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 
+#include "autorepeat.h"
+#include "decoder.h"
+#include "input_thread.h"
+
+#define KEYBOARD_KEYS_COUNT (KEY_MAX + 1)
+#define KEYBOARD_RING_SIZE 64
+#define KEYBOARD_HISTOGRAM_SIZE 16
+#define KEYBOARD_LISTENERS_MAX 128
+#define KEYBOARD_OVERFLOW_SIZE 16
+#define KEYBOARD_NO_KEY INT_MIN
+#define KEYBOARD_FREED_KEY (INT_MIN + 1)
+
 /**
  * @brief Structure representing a button with a key and a hold state.
  *
@@ -22,10 +36,21 @@
  *      The identifier or function of the button.
  * @var bool hold
  *      Indicates whether the button is currently being held down.
+ * @var long long time_ns
+ *      The monotonic time the key was read at, in nanoseconds.
+ * @var unsigned long count
+ *      The number of moves the button stands for: 1 for a press, the repeats
+ *      owed since the previous frame for an auto-repeated key.
+ * @var bool release
+ *      Whether the key was released, which only terminals with the kitty
+ *      keyboard protocol report. Released keys are never emitted.
  */
 typedef struct {
   int key;
   bool hold;
+  long long time_ns;
+  unsigned long count;
+  bool release;
 } Button;
 
 /**
@@ -56,55 +81,205 @@ typedef void (*listener_callback)(Button btn);
  * of type `Button`, which contains information about the button's state, such
  * as its key and whether it is being held down.
  *
+ * The listeners of a key are chained through `next`, the free listeners of
+ * the pool of a controller too.
+ *
  * @struct __keyboard_listener
  * @var int key
- *      The key code that the listener is interested in.
+ *      The key code that the listener is interested in, `KEYBOARD_NO_KEY` for a
+ * free listener.
  * @var listener_callback callback
  *      Function pointer to the callback function to be executed when the key is
  * pressed.
+ * @var short next
+ *      The index of the next listener of the same key, -1 for the last one.
  */
 typedef struct __keyboard_listener {
   int key;
   listener_callback callback;
+  short next;
 } KeyboardButtonListener;
 
+/**
+ * @brief A slot of the overflow map, for the listeners of key codes outside
+ * the range of ncurses.
+ *
+ * @struct KeyboardOverflowSlot
+ * @var int key
+ *      The key code, `KEYBOARD_NO_KEY` for a slot never taken,
+ *      `KEYBOARD_FREED_KEY` for a slot whose key lost its last listener.
+ * @var short first
+ *      The index of the first listener of the key, -1 for none.
+ */
+typedef struct {
+  int key;
+  short first;
+} KeyboardOverflowSlot;
+
+/**
+ * @brief Counters of the input ring of a keyboard controller.
+ *
+ * Both histograms have power of two buckets: bucket `i` counts the values from
+ * `2^(i-1)` up to `2^i - 1`, bucket 0 counts zeros and the last bucket every
+ * larger value.
+ *
+ * @struct KeyboardStats
+ * @var keys Number of keys read.
+ * @var reads Number of reads that found at least one key.
+ * @var deferred Number of reads that left keys behind for a full ring.
+ * @var depth Histogram of the keys waiting in the ring after each read.
+ * @var age Histogram of the microseconds from reading a key to emitting it.
+ */
+typedef struct {
+  unsigned long keys;
+  unsigned long reads;
+  unsigned long deferred;
+  unsigned long depth[KEYBOARD_HISTOGRAM_SIZE];
+  unsigned long age[KEYBOARD_HISTOGRAM_SIZE];
+} KeyboardStats;
+
 /**
  * @brief Structure representing a keyboard controller with listeners for
  * specific keys.
  *
  * This structure encapsulates a keyboard controller that manages listeners for
- * specific key presses. It contains an array of `KeyboardButtonListener`
+ * specific key presses. It contains a pool of `KeyboardButtonListener`
  * structures, each of which specifies a key and a callback function to be
  * executed when that key is pressed. The structure also includes function
- * pointers for adding a new listener, emitting a button press event, handling a
- * button press event for any button, listening for button presses, and
- * destroying the keyboard controller.
+ * pointers for adding, removing and rebinding a listener, emitting a button
+ * press event, handling a button press event for any button, listening for
+ * button presses, and destroying the keyboard controller.
+ *
+ * The listeners of a key are found in constant time: the dispatch table holds
+ * the first listener of every ncurses key code, the rare codes outside that
+ * range go to a small overflow map. A key can have several listeners, called
+ * in the order they were added. The pool is fixed, so adding, removing and
+ * rebinding listeners never allocate, even while the game runs.
+ *
+ * Keys go through a ring: a read takes every pending key at once, stamps each
+ * with the monotonic time and queues it, and the keys are then emitted one by
+ * one in the order they arrived, so a burst of keys is handled in a single
+ * frame instead of one key per frame. The ring has a single producer and a
+ * single consumer and takes no lock, so the keys could be read on another
+ * thread than the one emitting them.
+ *
+ * Whether a key is held is tracked for each key on its own. The keys added
+ * with `add_auto_repeat` do not follow the repeats of the terminal: those only
+ * keep them held, and `repeat` emits the moves the auto-repeat engine owes
+ * them, see `AutoRepeat`.
+ *
+ * The keys come from `getch()`, or, after `use_raw_input`, straight from a
+ * descriptor through a `KeyDecoder`, which waits far less than ncurses for the
+ * rest of an escape sequence and, with the kitty keyboard protocol, reports
+ * when keys are released. `use_input_thread` then moves the reads to a thread
+ * of their own, which stamps the keys the moment they arrive.
  *
  * @struct __keyboard
- * @var KeyboardButtonListener *listeners
- *      Array of KeyboardButtonListener structures, each specifying a key and a
- * callback function.
  * @var size_t listeners_count
  *      The number of listeners currently registered.
- * @var void (*add_listener)(struct __keyboard *self, int key, listener_callback
+ * @var KeyboardStats stats
+ *      Counters of the input ring.
+ * @var AutoRepeat *auto_repeat
+ *      The auto-repeat engine of the auto-repeated keys.
+ * @var KeyDecoder *decoder
+ *      The decoder of the raw input, NULL while the keys come from `getch()`.
+ * @var InputThread *input_thread
+ *      The thread reading the raw input, NULL while the keys are read by the
+ * thread calling `collect`.
+ * @var Button _ring[KEYBOARD_RING_SIZE]
+ *      The keys read and not emitted yet.
+ * @var atomic_size_t _head
+ *      The index of the next key to emit.
+ * @var atomic_size_t _tail
+ *      The index the next read key is stored at.
+ * @var Button _last_read[KEYBOARD_KEYS_COUNT]
+ *      The last read of each key, for the hold state of the next one.
+ * @var bool _is_held[KEYBOARD_KEYS_COUNT]
+ *      Whether each key was held when it was last emitted.
+ * @var int _repeated_keys[AUTO_REPEAT_KEYS_MAX]
+ *      The auto-repeated keys.
+ * @var size_t _repeated_count
+ *      The number of auto-repeated keys.
+ * @var int _input_fd
+ *      The descriptor the raw input is read from.
+ * @var int _output_fd
+ *      The descriptor of the terminal the protocol requests are written to.
+ * @var bool _is_kitty
+ *      Whether the kitty keyboard protocol was turned on.
+ * @var KeyboardButtonListener _listeners[KEYBOARD_LISTENERS_MAX]
+ *      The pool of listeners.
+ * @var short _free
+ *      The index of the first free listener of the pool, -1 if it is full.
+ * @var short _dispatch[KEYBOARD_KEYS_COUNT]
+ *      The index of the first listener of each ncurses key code, -1 for none.
+ * @var KeyboardOverflowSlot _overflow[KEYBOARD_OVERFLOW_SIZE]
+ *      The first listener of the other key codes.
+ * @var int (*add_listener)(struct __keyboard *self, int key, listener_callback
  * callback) Function pointer for adding a new listener for a specific key.
+ * @var int (*remove_listener)(struct __keyboard *self, int key,
+ * listener_callback callback) Function pointer for removing a listener.
+ * @var int (*rebind_listener)(struct __keyboard *self, int key,
+ * listener_callback callback, int new_key) Function pointer for moving a
+ * listener to another key.
+ * @var void (*add_auto_repeat)(struct __keyboard *self, int key)
+ *      Function pointer for handing the repeats of a key to the auto-repeat
+ * engine.
+ * @var size_t (*repeat)(struct __keyboard *self, long long now_ns)
+ *      Function pointer for emitting the moves owed to the auto-repeated keys.
  * @var void (*emit)(struct __keyboard *self, Button btn)
  *      Function pointer for emitting a button press event.
  * @var void (*on_emit)(Button btn)
  *      Function pointer for handling a button press event for any button.
+ * @var size_t (*collect)(struct __keyboard *self)
+ *      Function pointer for reading every pending key into the ring.
+ * @var int (*use_raw_input)(struct __keyboard *self, int input_fd, int
+ * output_fd) Function pointer for reading the keys from a descriptor.
+ * @var int (*use_input_thread)(struct __keyboard *self, int cpu, bool
+ * is_priority) Function pointer for reading the raw input on a thread.
+ * @var long long (*next_ns)(struct __keyboard *self)
+ *      Function pointer returning when the controller has something to do
+ * without any input.
  * @var Button (*listen)(struct __keyboard *self)
  *      Function pointer for listening for button presses.
  * @var void (*destroy)(struct __keyboard *self)
  *      Function pointer for destroying the keyboard controller.
  */
 typedef struct __keyboard {
-  KeyboardButtonListener *listeners;
   size_t listeners_count;
+  KeyboardStats stats;
+  AutoRepeat *auto_repeat;
+  KeyDecoder *decoder;
+  InputThread *input_thread;
+
+  Button _ring[KEYBOARD_RING_SIZE];
+  atomic_size_t _head;
+  atomic_size_t _tail;
+  Button _last_read[KEYBOARD_KEYS_COUNT];
+  bool _is_held[KEYBOARD_KEYS_COUNT];
+  int _repeated_keys[AUTO_REPEAT_KEYS_MAX];
+  size_t _repeated_count;
+  int _input_fd;
+  int _output_fd;
+  bool _is_kitty;
+  KeyboardButtonListener _listeners[KEYBOARD_LISTENERS_MAX];
+  short _free;
+  short _dispatch[KEYBOARD_KEYS_COUNT];
+  KeyboardOverflowSlot _overflow[KEYBOARD_OVERFLOW_SIZE];
 
-  void (*add_listener)(struct __keyboard *self, int key,
-                       listener_callback callback);
+  int (*add_listener)(struct __keyboard *self, int key,
+                      listener_callback callback);
+  int (*remove_listener)(struct __keyboard *self, int key,
+                         listener_callback callback);
+  int (*rebind_listener)(struct __keyboard *self, int key,
+                         listener_callback callback, int new_key);
+  void (*add_auto_repeat)(struct __keyboard *self, int key);
+  size_t (*repeat)(struct __keyboard *self, long long now_ns);
   void (*emit)(struct __keyboard *self, Button btn);
   void (*on_emit)(Button btn);  // can use for any button
+  size_t (*collect)(struct __keyboard *self);
+  int (*use_raw_input)(struct __keyboard *self, int input_fd, int output_fd);
+  int (*use_input_thread)(struct __keyboard *self, int cpu, bool is_priority);
+  long long (*next_ns)(struct __keyboard *self);
   Button (*listen)(struct __keyboard *self);
   void (*destroy)(struct __keyboard *self);
 } KeyboardController;
@@ -12,7 +12,7 @@
 static void _draw(Layout *self) {
   if (!self) return;
 
-  wclear(self->window);
+  werase(self->window);
   wbkgd(self->window, COLOR_PAIR(1));
   box(self->window, 0, 0);
 
@@ -46,7 +46,7 @@ static void _not_enaugh_sizes(Layout *layout) {
   static const char error_title[] = "SMALL TERMINAL";
   static const char error_desc[] = "required %dx%d (now %dx%d)";
 
-  wclear(layout->window);
+  werase(layout->window);
   wbkgd(layout->window, COLOR_PAIR(THEME_WARNING_PAIR));
   box(layout->window, 0, 0);
 
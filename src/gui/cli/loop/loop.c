@@ -0,0 +1,150 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "loop.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief Returns the monotonic time the deadlines are set in.
+ *
+ * @return The time in nanoseconds.
+ */
+long long event_loop_now_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ * @brief Reads what a readable descriptor holds.
+ *
+ * A single read never blocks, whatever the mode of the descriptor. Anything
+ * left over only ends the next wait early.
+ *
+ * @param fd The descriptor.
+ */
+static void drain(int fd) {
+  char buffer[256];
+  ssize_t count = read(fd, buffer, sizeof(buffer));
+  (void)count;
+}
+
+/**
+ * @brief Sets the monotonic time the next wait ends at, at the latest.
+ *
+ * @param self A pointer to the EventLoop instance.
+ * @param deadline_ns The deadline, 0 to wait without one.
+ */
+static void _set_deadline(EventLoop *self, long long deadline_ns) {
+  if (!self) return;
+  self->_deadline_ns = deadline_ns;
+}
+
+/**
+ * @brief Sleeps until the next event.
+ *
+ * A deadline that already passed ends the wait without sleeping. The timer is
+ * only armed again when the deadline changed since the previous wait.
+ *
+ * @param self A pointer to the EventLoop instance.
+ * @return The flags of the events, see `LoopEvent`.
+ */
+static int _wait(EventLoop *self) {
+  if (!self) return 0;
+  self->stats.waits++;
+
+  long long started_ns = event_loop_now_ns();
+  if (self->_deadline_ns && self->_deadline_ns <= started_ns) {
+    self->stats.deadlines++;
+    return LOOP_EVENT_DEADLINE;
+  }
+
+  if (self->_timer_fd >= 0 && self->_armed_ns != self->_deadline_ns) {
+    struct itimerspec timer = {
+        .it_value = {.tv_sec = self->_deadline_ns / 1000000000LL,
+                     .tv_nsec = self->_deadline_ns % 1000000000LL}};
+    timerfd_settime(self->_timer_fd, TFD_TIMER_ABSTIME, &timer, NULL);
+    self->_armed_ns = self->_deadline_ns;
+  }
+
+  struct pollfd fds[] = {
+      {.fd = self->input_fd, .events = POLLIN},
+      {.fd = self->state_fd, .events = POLLIN},
+      {.fd = self->_deadline_ns ? self->_timer_fd : -1, .events = POLLIN},
+  };
+  int timeout_ms = -1;
+  if (self->_timer_fd < 0 && self->_deadline_ns) {
+    timeout_ms = (int)((self->_deadline_ns - started_ns + 999999) / 1000000);
+  }
+  int ready = poll(fds, sizeof(fds) / sizeof(fds[0]), timeout_ms);
+  self->stats.sleep_ns += event_loop_now_ns() - started_ns;
+
+  int events = 0;
+  if (ready < 0) {
+    // a signal such as SIGWINCH, the caller reads the keys and redraws
+    if (errno == EINTR) events |= LOOP_EVENT_INPUT;
+    return events;
+  }
+  if (fds[0].revents) {
+    events |= LOOP_EVENT_INPUT;
+    self->stats.inputs++;
+  }
+  if (fds[1].revents) {
+    drain(self->state_fd);
+    events |= LOOP_EVENT_STATE;
+    self->stats.states++;
+  }
+  if (fds[2].revents || (!ready && timeout_ms >= 0)) {
+    if (fds[2].revents) drain(self->_timer_fd);
+    self->_armed_ns = 0;
+    events |= LOOP_EVENT_DEADLINE;
+    self->stats.deadlines++;
+  }
+  return events;
+}
+
+/**
+ * @brief Frees the loop, the input and state descriptors are left open.
+ *
+ * @param self A pointer to the EventLoop instance.
+ */
+static void _destroy(EventLoop *self) {
+  if (!self) return;
+  if (self->_timer_fd >= 0) close(self->_timer_fd);
+  free(self);
+}
+
+/**
+ * @brief Creates an event loop.
+ *
+ * If memory allocation fails, the function prints an error message to stderr
+ * and exits the program with a failure status. Without a timer the deadline
+ * is the timeout of `poll`, to the millisecond.
+ *
+ * @param input_fd The input descriptor, usually the standard input.
+ * @param state_fd The descriptor readable on a new state or -1.
+ * @return A pointer to the newly created loop.
+ */
+EventLoop *new_event_loop(int input_fd, int state_fd) {
+  EventLoop *self = (EventLoop *)calloc(1, sizeof(EventLoop));
+  if (!self) {
+    fprintf(stderr, "Cannot allocate mem for EventLoop\n");
+    exit(-1);
+  }
+
+  self->input_fd = input_fd;
+  self->state_fd = state_fd;
+  self->_timer_fd =
+      timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+  self->set_deadline = _set_deadline;
+  self->wait = _wait;
+  self->destroy = _destroy;
+  return self;
+}
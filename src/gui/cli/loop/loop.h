@@ -0,0 +1,92 @@
+#ifndef CLI_LOOP_LOOP_H
+#define CLI_LOOP_LOOP_H
+
+#include <stdbool.h>
+
+/**
+ * @brief Flags of the events a wait of the event loop returns.
+ *
+ * @enum LoopEvent
+ * @var LOOP_EVENT_INPUT The input is readable or a signal, such as a resize,
+ * interrupted the wait.
+ * @var LOOP_EVENT_STATE The state descriptor became readable: there is a new
+ * state to show.
+ * @var LOOP_EVENT_DEADLINE The deadline passed.
+ */
+typedef enum {
+  LOOP_EVENT_INPUT = 1 << 0,
+  LOOP_EVENT_STATE = 1 << 1,
+  LOOP_EVENT_DEADLINE = 1 << 2,
+} LoopEvent;
+
+/**
+ * @brief Counters of an event loop.
+ *
+ * @struct EventLoopStats
+ * @var waits Number of waits.
+ * @var inputs Number of waits ended by the input.
+ * @var states Number of waits ended by a new state.
+ * @var deadlines Number of waits ended by the deadline.
+ * @var sleep_ns Total time spent asleep in the waits.
+ */
+typedef struct {
+  unsigned long waits;
+  unsigned long inputs;
+  unsigned long states;
+  unsigned long deadlines;
+  long long sleep_ns;
+} EventLoopStats;
+
+/**
+ * @brief Sleeps until something happens: a key, a new state or a deadline.
+ *
+ * The loop polls the input descriptor, a descriptor that becomes readable when
+ * there is a new state to show, such as the published descriptor of an engine
+ * runner, and a `timerfd` armed for the deadline on the monotonic clock. The
+ * caller sleeps exactly until the next of them, never at a fixed rate, so an
+ * unchanged screen costs no wakeups at all and a key is read as soon as it
+ * arrives. The state descriptor is emptied by the wait.
+ *
+ * @struct __event_loop
+ * @var input_fd The input descriptor.
+ * @var state_fd The state descriptor or -1.
+ * @var stats Counters of the loop.
+ * @var _timer_fd The timer of the deadline.
+ * @var _deadline_ns The deadline, 0 without one.
+ * @var _armed_ns The deadline the timer is armed for, 0 if it is disarmed.
+ * @var set_deadline Function pointer setting the monotonic time the next wait
+ * ends at, at the latest.
+ * @var wait Function pointer sleeping until the next event.
+ * @var destroy Function pointer freeing the loop.
+ */
+typedef struct __event_loop {
+  int input_fd;
+  int state_fd;
+  EventLoopStats stats;
+
+  int _timer_fd;
+  long long _deadline_ns;
+  long long _armed_ns;
+
+  void (*set_deadline)(struct __event_loop *self, long long deadline_ns);
+  int (*wait)(struct __event_loop *self);
+  void (*destroy)(struct __event_loop *self);
+} EventLoop;
+
+/**
+ * @brief Creates an event loop.
+ *
+ * @param input_fd The input descriptor, usually the standard input.
+ * @param state_fd The descriptor readable on a new state or -1.
+ * @return A pointer to the newly created loop.
+ */
+EventLoop *new_event_loop(int input_fd, int state_fd);
+
+/**
+ * @brief Returns the monotonic time the deadlines are set in.
+ *
+ * @return The time in nanoseconds.
+ */
+long long event_loop_now_ns(void);
+
+#endif  // !CLI_LOOP_LOOP_H
@@ -0,0 +1,448 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "recorder.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RECORDER_RECORD_HEADER_SIZE (sizeof(long long) + sizeof(uint32_t))
+#define RECORDER_IDLE_NS 10000000L
+
+/**
+ * @brief Returns the nanoseconds elapsed between two times.
+ *
+ * @param end The later time.
+ * @param start The earlier time.
+ * @return The elapsed nanoseconds.
+ */
+static long long elapsed_ns(struct timespec end, struct timespec start) {
+  return (end.tv_sec - start.tv_sec) * 1000000000LL +
+         (end.tv_nsec - start.tv_nsec);
+}
+
+/**
+ * @brief Copies bytes into the ring storage, wrapping around its end.
+ *
+ * @param ring The ring.
+ * @param position Free running position of the first byte.
+ * @param data The bytes to copy.
+ * @param size The number of bytes.
+ */
+static void ring_write(RecorderRing *ring, size_t position, const void *data,
+                       size_t size) {
+  size_t offset = position & (ring->capacity - 1);
+  size_t room = ring->capacity - offset;
+  size_t first = size < room ? size : room;
+  memcpy(ring->data + offset, data, first);
+  memcpy(ring->data, (const uint8_t *)data + first, size - first);
+}
+
+/**
+ * @brief Copies bytes out of the ring storage, wrapping around its end.
+ *
+ * @param ring The ring.
+ * @param position Free running position of the first byte.
+ * @param data Destination buffer.
+ * @param size The number of bytes.
+ */
+static void ring_read(const RecorderRing *ring, size_t position, void *data,
+                      size_t size) {
+  size_t offset = position & (ring->capacity - 1);
+  size_t room = ring->capacity - offset;
+  size_t first = size < room ? size : room;
+  memcpy(data, ring->data + offset, first);
+  memcpy((uint8_t *)data + first, ring->data, size - first);
+}
+
+/**
+ * @brief Pushes a timestamped chunk into a ring.
+ *
+ * Only the producer calls this function. The chunk is published by the release
+ * store of `head`, after all its bytes are in place.
+ *
+ * @param ring The ring.
+ * @param timestamp_ns The time of the chunk.
+ * @param data The chunk.
+ * @param size The size of the chunk, at most RECORDER_CHUNK_SIZE.
+ * @return false if the ring has no room for the chunk, which is then dropped.
+ */
+bool recorder_ring_push(RecorderRing *ring, long long timestamp_ns,
+                        const uint8_t *data, uint32_t size) {
+  size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+  size_t needed = RECORDER_RECORD_HEADER_SIZE + size;
+  if (size > RECORDER_CHUNK_SIZE || ring->capacity - (head - tail) < needed) {
+    return false;
+  }
+
+  ring_write(ring, head, &timestamp_ns, sizeof(timestamp_ns));
+  ring_write(ring, head + sizeof(timestamp_ns), &size, sizeof(size));
+  ring_write(ring, head + RECORDER_RECORD_HEADER_SIZE, data, size);
+  atomic_store_explicit(&ring->head, head + needed, memory_order_release);
+  return true;
+}
+
+/**
+ * @brief Pops the oldest chunk from a ring.
+ *
+ * Only the consumer calls this function. The space of the chunk is handed
+ * back to the producer by the release store of `tail`.
+ *
+ * @param ring The ring.
+ * @param timestamp_ns Where to store the time of the chunk.
+ * @param data Buffer of at least RECORDER_CHUNK_SIZE bytes for the chunk.
+ * @return The size of the chunk or 0 if the ring is empty.
+ */
+uint32_t recorder_ring_pop(RecorderRing *ring, long long *timestamp_ns,
+                           uint8_t *data) {
+  size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+  if (head == tail) return 0;
+
+  uint32_t size = 0;
+  ring_read(ring, tail, timestamp_ns, sizeof(*timestamp_ns));
+  ring_read(ring, tail + sizeof(*timestamp_ns), &size, sizeof(size));
+  ring_read(ring, tail + RECORDER_RECORD_HEADER_SIZE, data, size);
+  atomic_store_explicit(&ring->tail, tail + RECORDER_RECORD_HEADER_SIZE + size,
+                        memory_order_release);
+  return size;
+}
+
+/**
+ * @brief Writes a JSON string body, escaping it as needed.
+ *
+ * NUL bytes are escaped like the other control characters.
+ *
+ * @param file The destination file.
+ * @param text The string.
+ * @param size The number of bytes of the string.
+ */
+static void write_json_text(FILE *file, const char *text, size_t size) {
+  for (const char *end = text + size; text < end; text++) {
+    unsigned char c = (unsigned char)*text;
+    if (c == '"' || c == '\\') {
+      fprintf(file, "\\%c", c);
+    } else if (c < 0x20) {
+      fprintf(file, "\\u%04x", c);
+    } else {
+      fputc(c, file);
+    }
+  }
+}
+
+/**
+ * @brief Returns the length of the UTF-8 sequence started by a byte.
+ *
+ * @param c The first byte of the sequence.
+ * @return The length of the sequence or 0 if the byte cannot start one.
+ */
+static size_t utf8_sequence_length(uint8_t c) {
+  size_t length = 0;
+  if (c < 0x80) {
+    length = 1;
+  } else if (c >= 0xC2 && c <= 0xDF) {
+    length = 2;
+  } else if (c >= 0xE0 && c <= 0xEF) {
+    length = 3;
+  } else if (c >= 0xF0 && c <= 0xF4) {
+    length = 4;
+  }
+  return length;
+}
+
+/**
+ * @brief Writes an asciicast v2 output event.
+ *
+ * asciicast strings must be valid UTF-8, so a multibyte sequence split between
+ * two chunks is carried over to the next event and invalid bytes are replaced
+ * by U+FFFD.
+ *
+ * @param self A pointer to the Recorder instance.
+ * @param timestamp_ns The time of the chunk since the session start.
+ * @param data The chunk.
+ * @param size The size of the chunk.
+ */
+static void write_asciicast_event(Recorder *self, long long timestamp_ns,
+                                  const uint8_t *data, size_t size) {
+  uint8_t buffer[sizeof(self->_utf8_carry) + RECORDER_CHUNK_SIZE];
+  memcpy(buffer, self->_utf8_carry, self->_utf8_carry_size);
+  memcpy(buffer + self->_utf8_carry_size, data, size);
+  size_t total = self->_utf8_carry_size + size;
+
+  fprintf(self->file, "[%.6f, \"o\", \"", timestamp_ns / 1e9);
+  size_t i = 0;
+  bool is_incomplete = false;
+  while (i < total && !is_incomplete) {
+    size_t length = utf8_sequence_length(buffer[i]);
+    bool is_valid = length > 0;
+    for (size_t j = 1; is_valid && j < length && i + j < total; j++) {
+      is_valid = (buffer[i + j] & 0xC0) == 0x80;
+    }
+
+    if (length == 1) {
+      write_json_text(self->file, (const char *)buffer + i, 1);
+      i++;
+    } else if (!is_valid) {
+      fputs("\\ufffd", self->file);
+      i++;
+    } else if (i + length > total) {
+      is_incomplete = true;
+    } else {
+      fwrite(buffer + i, 1, length, self->file);
+      i += length;
+    }
+  }
+  fputs("\"]\n", self->file);
+
+  self->_utf8_carry_size = total - i;
+  memcpy(self->_utf8_carry, buffer + i, self->_utf8_carry_size);
+}
+
+/**
+ * @brief Writes a ttyrec record.
+ *
+ * @param self A pointer to the Recorder instance.
+ * @param timestamp_ns The time of the chunk since the session start.
+ * @param data The chunk.
+ * @param size The size of the chunk.
+ */
+static void write_ttyrec_record(Recorder *self, long long timestamp_ns,
+                                const uint8_t *data, size_t size) {
+  long long real_ns = self->_started_at_real.tv_sec * 1000000000LL +
+                      self->_started_at_real.tv_nsec + timestamp_ns;
+  uint32_t fields[3] = {(uint32_t)(real_ns / 1000000000LL),
+                        (uint32_t)(real_ns % 1000000000LL / 1000),
+                        (uint32_t)size};
+  uint8_t header[sizeof(fields)];
+  for (size_t i = 0; i < sizeof(header); i++) {
+    header[i] = (uint8_t)(fields[i / 4] >> (8 * (i % 4)));
+  }
+  fwrite(header, 1, sizeof(header), self->file);
+  fwrite(data, 1, size, self->file);
+}
+
+/**
+ * @brief Writes an output chunk to the recording file in its format.
+ *
+ * @param self A pointer to the Recorder instance.
+ * @param timestamp_ns The time of the chunk since the session start.
+ * @param data The chunk.
+ * @param size The size of the chunk, at most RECORDER_CHUNK_SIZE.
+ */
+void recorder_write_chunk(Recorder *self, long long timestamp_ns,
+                          const uint8_t *data, size_t size) {
+  if (self->format == RECORDER_FORMAT_ASCIICAST) {
+    write_asciicast_event(self, timestamp_ns, data, size);
+  } else {
+    write_ttyrec_record(self, timestamp_ns, data, size);
+  }
+}
+
+/**
+ * @brief Writes the asciicast v2 header line.
+ *
+ * @param self A pointer to the Recorder instance.
+ */
+static void write_asciicast_header(Recorder *self) {
+  struct winsize size = {.ws_row = 24, .ws_col = 80};
+  ioctl(STDERR_FILENO, TIOCGWINSZ, &size);
+
+  fprintf(self->file,
+          "{\"version\": 2, \"width\": %d, \"height\": %d, \"timestamp\": "
+          "%lld, \"env\": {\"TERM\": \"",
+          size.ws_col, size.ws_row, (long long)self->_started_at_real.tv_sec);
+  const char *term = getenv("TERM") ? getenv("TERM") : "";
+  write_json_text(self->file, term, strlen(term));
+  fputs("\"}}\n", self->file);
+}
+
+/**
+ * @brief Tee thread forwarding the output to the terminal and the ring.
+ *
+ * The output reaches the terminal before it is recorded, so the recording
+ * never delays what the player sees. The thread ends when the pipe is closed
+ * by `stop`.
+ *
+ * @param arg A pointer to the Recorder instance.
+ * @return NULL.
+ */
+static void *tee_routine(void *arg) {
+  Recorder *self = arg;
+  uint8_t chunk[RECORDER_CHUNK_SIZE];
+
+  ssize_t size;
+  while ((size = read(self->_pipe[0], chunk, sizeof(chunk))) != 0) {
+    if (size < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+
+    ssize_t written = 0;
+    while (written < size) {
+      ssize_t n = write(self->_terminal, chunk + written, size - written);
+      if (n > 0) {
+        written += n;
+      } else if (errno != EINTR) {
+        break;
+      }
+    }
+
+    struct timespec now, pushed;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    bool is_pushed = recorder_ring_push(
+        &self->ring, elapsed_ns(now, self->_started_at), chunk, size);
+    clock_gettime(CLOCK_MONOTONIC, &pushed);
+
+    self->stats.push_ns += elapsed_ns(pushed, now);
+    if (is_pushed) {
+      self->stats.chunks++;
+      self->stats.bytes += size;
+    } else {
+      self->stats.dropped_chunks++;
+      self->stats.dropped_bytes += size;
+    }
+  }
+
+  atomic_store(&self->_is_teeing, false);
+  return NULL;
+}
+
+/**
+ * @brief Writer thread draining the ring into the recording file.
+ *
+ * @param arg A pointer to the Recorder instance.
+ * @return NULL.
+ */
+static void *writer_routine(void *arg) {
+  Recorder *self = arg;
+  uint8_t chunk[RECORDER_CHUNK_SIZE];
+  long long timestamp_ns = 0;
+
+  bool is_done = false;
+  while (!is_done) {
+    // read the flag first: once it is cleared, the ring holds everything
+    bool is_teeing = atomic_load(&self->_is_teeing);
+    uint32_t size = recorder_ring_pop(&self->ring, &timestamp_ns, chunk);
+    if (size) {
+      recorder_write_chunk(self, timestamp_ns, chunk, size);
+    } else if (is_teeing) {
+      fflush(self->file);
+      nanosleep(&(struct timespec){.tv_nsec = RECORDER_IDLE_NS}, NULL);
+    } else {
+      is_done = true;
+    }
+  }
+
+  fflush(self->file);
+  return NULL;
+}
+
+/**
+ * @brief Starts the session: replaces the standard output with a pipe and
+ * starts the tee and writer threads.
+ *
+ * Must be called before ncurses is initialized. The standard error must be the
+ * terminal, ncurses reads the terminal size and modes from it.
+ *
+ * @param self A pointer to the Recorder instance.
+ * @return 0 on success, -1 otherwise.
+ */
+static int _start(Recorder *self) {
+  if (!self || self->is_recording || !isatty(STDERR_FILENO)) return -1;
+
+  fflush(stdout);
+  self->_terminal = dup(STDOUT_FILENO);
+  if (self->_terminal < 0) return -1;
+  if (pipe(self->_pipe)) {
+    close(self->_terminal);
+    return -1;
+  }
+  dup2(self->_pipe[1], STDOUT_FILENO);
+  close(self->_pipe[1]);
+
+  clock_gettime(CLOCK_MONOTONIC, &self->_started_at);
+  clock_gettime(CLOCK_REALTIME, &self->_started_at_real);
+  if (self->format == RECORDER_FORMAT_ASCIICAST) write_asciicast_header(self);
+
+  self->is_recording = true;
+  atomic_store(&self->_is_teeing, true);
+  pthread_create(&self->_tee_thread, NULL, tee_routine, self);
+  pthread_create(&self->_writer_thread, NULL, writer_routine, self);
+  return 0;
+}
+
+/**
+ * @brief Stops the session.
+ *
+ * The terminal becomes the standard output again, which closes the pipe and
+ * lets both threads drain everything written so far.
+ *
+ * @param self A pointer to the Recorder instance.
+ */
+static void _stop(Recorder *self) {
+  if (!self || !self->is_recording) return;
+
+  fflush(stdout);
+  dup2(self->_terminal, STDOUT_FILENO);
+  close(self->_terminal);
+  pthread_join(self->_tee_thread, NULL);
+  pthread_join(self->_writer_thread, NULL);
+  close(self->_pipe[0]);
+  self->is_recording = false;
+}
+
+/**
+ * @brief Stops the session and frees the recorder.
+ *
+ * @param self A pointer to the Recorder instance.
+ */
+static void _destroy(Recorder *self) {
+  if (!self) return;
+
+  self->stop(self);
+  fclose(self->file);
+  free(self->ring.data);
+  free(self);
+}
+
+/**
+ * @brief Creates a recorder writing to a file.
+ *
+ * If memory allocation fails, the function prints an error message to stderr
+ * and exits the program with a failure status.
+ *
+ * @param filename The recording file, a `.cast` extension selects asciicast v2
+ * and anything else ttyrec.
+ * @return A pointer to the newly created Recorder instance or NULL if the file
+ * cannot be created.
+ */
+Recorder *new_recorder(const char *filename) {
+  FILE *file = fopen(filename, "wb");
+  if (!file) return NULL;
+
+  Recorder *self = (Recorder *)calloc(1, sizeof(Recorder));
+  if (self) self->ring.data = malloc(RECORDER_RING_CAPACITY);
+  if (!self || !self->ring.data) {
+    fprintf(stderr, "Cannot allocate mem for Recorder\n");
+    exit(-1);
+  }
+
+  size_t length = strlen(filename);
+  self->file = file;
+  self->format = length > 5 && !strcmp(filename + length - 5, ".cast")
+                     ? RECORDER_FORMAT_ASCIICAST
+                     : RECORDER_FORMAT_TTYREC;
+  self->ring.capacity = RECORDER_RING_CAPACITY;
+  atomic_init(&self->ring.head, 0);
+  atomic_init(&self->ring.tail, 0);
+  atomic_init(&self->_is_teeing, false);
+
+  self->start = _start;
+  self->stop = _stop;
+  self->destroy = _destroy;
+  return self;
+}
@@ -0,0 +1,165 @@
+#ifndef CLI_RECORDER_RECORDER_H
+#define CLI_RECORDER_RECORDER_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define RECORDER_RING_CAPACITY (1 << 20)
+#define RECORDER_CHUNK_SIZE 4096
+
+/**
+ * @brief Enumeration of the supported recording formats.
+ *
+ * @enum RecorderFormat
+ * @var RECORDER_FORMAT_ASCIICAST asciicast v2, one JSON line per output chunk.
+ * @var RECORDER_FORMAT_TTYREC ttyrec, a binary header per output chunk.
+ */
+typedef enum {
+  RECORDER_FORMAT_ASCIICAST = 0,
+  RECORDER_FORMAT_TTYREC,
+} RecorderFormat;
+
+/**
+ * @brief Single producer, single consumer byte ring buffer.
+ *
+ * The producer only moves `head` and the consumer only moves `tail`, both are
+ * free running counters masked by the power of two capacity, so neither side
+ * ever waits for the other.
+ *
+ * @struct RecorderRing
+ * @var data The ring storage.
+ * @var capacity The size of the storage, a power of two.
+ * @var head Total number of bytes written by the producer.
+ * @var tail Total number of bytes consumed by the consumer.
+ */
+typedef struct {
+  uint8_t *data;
+  size_t capacity;
+  atomic_size_t head;
+  atomic_size_t tail;
+} RecorderRing;
+
+/**
+ * @brief Counters of a recording session.
+ *
+ * @struct RecorderStats
+ * @var chunks Number of output chunks recorded.
+ * @var bytes Number of output bytes recorded.
+ * @var dropped_chunks Number of chunks dropped because the ring was full.
+ * @var dropped_bytes Number of bytes of the dropped chunks, they reached the
+ * terminal all the same.
+ * @var push_ns Total time spent pushing chunks into the ring.
+ */
+typedef struct {
+  unsigned long chunks;
+  unsigned long bytes;
+  unsigned long dropped_chunks;
+  unsigned long dropped_bytes;
+  long long push_ns;
+} RecorderStats;
+
+/**
+ * @brief Terminal session recorder.
+ *
+ * While recording, the standard output is a pipe: everything ncurses writes is
+ * read back by a tee thread, forwarded to the terminal and pushed with its
+ * timestamp into a lock free ring. A writer thread drains the ring into the
+ * recording file, so the render loop never waits for the disk. ncurses keeps
+ * reading the terminal size and modes from the standard error, which still is
+ * the terminal.
+ *
+ * @struct __recorder
+ * @var file The recording file.
+ * @var format The recording format.
+ * @var ring The ring between the tee and the writer threads.
+ * @var stats Counters of the session, owned by the tee thread until `stop`.
+ * @var is_recording Whether the session is running.
+ * @var _terminal Descriptor of the terminal the output is forwarded to.
+ * @var _pipe Descriptors of the pipe replacing the standard output.
+ * @var _started_at Monotonic time the session started at.
+ * @var _started_at_real Wall clock time the session started at.
+ * @var _is_teeing Cleared by the tee thread once the pipe is closed.
+ * @var _tee_thread The thread forwarding and recording the output.
+ * @var _writer_thread The thread writing the recording file.
+ * @var _utf8_carry Incomplete UTF-8 sequence left by the previous chunk.
+ * @var _utf8_carry_size Size of the incomplete sequence.
+ * @var start Function pointer starting the session.
+ * @var stop Function pointer restoring the standard output and flushing the
+ * recording.
+ * @var destroy Function pointer stopping the session and freeing the
+ * recorder.
+ */
+typedef struct __recorder {
+  FILE *file;
+  RecorderFormat format;
+  RecorderRing ring;
+  RecorderStats stats;
+  bool is_recording;
+
+  int _terminal;
+  int _pipe[2];
+  struct timespec _started_at;
+  struct timespec _started_at_real;
+  atomic_bool _is_teeing;
+  pthread_t _tee_thread;
+  pthread_t _writer_thread;
+  uint8_t _utf8_carry[4];
+  size_t _utf8_carry_size;
+
+  int (*start)(struct __recorder *self);
+  void (*stop)(struct __recorder *self);
+  void (*destroy)(struct __recorder *self);
+} Recorder;
+
+/**
+ * @brief Creates a recorder writing to a file.
+ *
+ * @param filename The recording file, a `.cast` extension selects asciicast v2
+ * and anything else ttyrec.
+ * @return A pointer to the newly created recorder or NULL if the file cannot
+ * be created.
+ */
+Recorder *new_recorder(const char *filename);
+
+/**
+ * @brief Pushes a timestamped chunk into a ring.
+ *
+ * @param ring The ring.
+ * @param timestamp_ns The time of the chunk.
+ * @param data The chunk.
+ * @param size The size of the chunk.
+ * @return false if the ring has no room for the chunk, which is then dropped.
+ */
+bool recorder_ring_push(RecorderRing *ring, long long timestamp_ns,
+                        const uint8_t *data, uint32_t size);
+
+/**
+ * @brief Pops the oldest chunk from a ring.
+ *
+ * @param ring The ring.
+ * @param timestamp_ns Where to store the time of the chunk.
+ * @param data Buffer of at least RECORDER_CHUNK_SIZE bytes for the chunk.
+ * @return The size of the chunk or 0 if the ring is empty.
+ */
+uint32_t recorder_ring_pop(RecorderRing *ring, long long *timestamp_ns,
+                           uint8_t *data);
+
+/**
+ * @brief Writes an output chunk to the recording file in its format.
+ *
+ * Called by the writer thread, an asciicast recording carries an incomplete
+ * UTF-8 sequence over to the next chunk.
+ *
+ * @param self A pointer to the Recorder instance.
+ * @param timestamp_ns The time of the chunk since the session start.
+ * @param data The chunk.
+ * @param size The size of the chunk, at most RECORDER_CHUNK_SIZE.
+ */
+void recorder_write_chunk(Recorder *self, long long timestamp_ns,
+                          const uint8_t *data, size_t size);
+
+#endif  // !CLI_RECORDER_RECORDER_H
@@ -0,0 +1,722 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "renderer.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RENDERER_UNKNOWN_PEN ((chtype)-1)
+#define RENDERER_PEN_MASK (A_ATTRIBUTES & ~A_PROTECT & ~A_INVIS)
+
+// set by the SIGWINCH handler, the size is synced by the next `present`
+static volatile sig_atomic_t is_resized = 0;
+
+/**
+ * @brief SIGWINCH handler of the ANSI backend.
+ *
+ * @param signal The signal number.
+ */
+static void on_resize(int signal) {
+  (void)signal;
+  is_resized = 1;
+}
+
+/**
+ * @brief Appends bytes to the escape stream of the current frame.
+ *
+ * The buffer grows on demand and is kept between frames, so steady frames
+ * allocate nothing.
+ *
+ * @param self A pointer to the Renderer instance.
+ * @param data The bytes.
+ * @param size The number of bytes.
+ */
+static void append(Renderer *self, const char *data, size_t size) {
+  if (self->_output_size + size > self->_output_capacity) {
+    size_t capacity = self->_output_capacity ? self->_output_capacity : 4096;
+    while (capacity < self->_output_size + size) capacity *= 2;
+    char *output = realloc(self->_output, capacity);
+    if (!output) {
+      fprintf(stderr, "Cannot allocate mem for Renderer output\n");
+      exit(-1);
+    }
+    self->_output = output;
+    self->_output_capacity = capacity;
+  }
+  memcpy(self->_output + self->_output_size, data, size);
+  self->_output_size += size;
+}
+
+/**
+ * @brief Appends a string to the escape stream.
+ *
+ * @param self A pointer to the Renderer instance.
+ * @param text The string.
+ */
+static void append_text(Renderer *self, const char *text) {
+  append(self, text, strlen(text));
+}
+
+/**
+ * @brief Appends a decimal number to the escape stream.
+ *
+ * @param self A pointer to the Renderer instance.
+ * @param value The number.
+ */
+static void append_number(Renderer *self, unsigned int value) {
+  char digits[10];
+  size_t count = 0;
+  do {
+    digits[sizeof(digits) - 1 - count++] = (char)('0' + value % 10);
+    value /= 10;
+  } while (value);
+  append(self, digits + sizeof(digits) - count, count);
+}
+
+/**
+ * @brief Appends a terminfo string capability to the escape stream.
+ *
+ * @param self A pointer to the Renderer instance.
+ * @param name The capability name.
+ */
+static void append_capability(Renderer *self, const char *name) {
+  char *value = tigetstr(name);
+  if (value && value != (char *)-1) append_text(self, value);
+}
+
+/**
+ * @brief Writes the escape stream of the current frame to the terminal.
+ *
+ * A terminal whose buffer is full refuses the rest of the stream on the
+ * non-blocking descriptor, the rest is kept and written first by the next
+ * call.
+ *
+ * @param self A pointer to the Renderer instance.
+ * @return true if the whole stream was written, false if a part is kept.
+ */
+static bool flush_output(Renderer *self) {
+  while (self->_output_sent < self->_output_size) {
+    ssize_t n = write(self->_output_fd, self->_output + self->_output_sent,
+                      self->_output_size - self->_output_sent);
+    self->stats.writes++;
+    if (n > 0) {
+      self->_output_sent += n;
+      self->stats.bytes += n;
+    } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      self->stats.refused++;
+      return false;
+    } else if (n < 0 && errno != EINTR) {
+      break;
+    }
+  }
+  self->_output_size = 0;
+  self->_output_sent = 0;
+  return true;
+}
+
+/**
+ * @brief Appends the parameters selecting a terminal color.
+ *
+ * @param self A pointer to the Renderer instance.
+ * @param color The ncurses color, negative for the default color.
+ * @param is_background Whether the background color is selected.
+ */
+static void append_color(Renderer *self, short color, bool is_background) {
+  if (color < 0) return;
+
+  if (self->is_truecolor) {
+    short rgb[3] = {0};
+    color_content(color, &rgb[0], &rgb[1], &rgb[2]);
+    append_text(self, is_background ? ";48;2" : ";38;2");
+    for (int i = 0; i < 3; i++) {
+      append_text(self, ";");
+      append_number(self, (unsigned int)(rgb[i] * 255 / 1000));
+    }
+  } else if (color < 8) {
+    append_text(self, is_background ? ";4" : ";3");
+    append_number(self, (unsigned int)color);
+  } else if (color < 16) {
+    append_text(self, is_background ? ";10" : ";9");
+    append_number(self, (unsigned int)color - 8);
+  } else {
+    append_text(self, is_background ? ";48;5;" : ";38;5;");
+    append_number(self, (unsigned int)color);
+  }
+}
+
+/**
+ * @brief Switches the terminal to the attributes, color pair and charset of a
+ * cell.
+ *
+ * The whole pen is set with one SGR sequence starting from a reset, and only
+ * when it differs from the pen of the previous cell.
+ *
+ * @param self A pointer to the Renderer instance.
+ * @param pen The attributes of the cell.
+ */
+static void set_pen(Renderer *self, chtype pen) {
+  if (pen == self->_pen) return;
+
+  chtype previous = self->_pen;
+  if (previous == RENDERER_UNKNOWN_PEN ||
+      (previous & ~A_ALTCHARSET) != (pen & ~A_ALTCHARSET)) {
+    append_text(self, "\033[0");
+    if (pen & A_BOLD) append_text(self, ";1");
+    if (pen & A_DIM) append_text(self, ";2");
+    if (pen & A_UNDERLINE) append_text(self, ";4");
+    if (pen & A_BLINK) append_text(self, ";5");
+    if (pen & (A_REVERSE | A_STANDOUT)) append_text(self, ";7");
+
+    short pair = (short)PAIR_NUMBER(pen);
+    short foreground = -1, background = -1;
+    if (pair && pair_content(pair, &foreground, &background) != ERR) {
+      append_color(self, foreground, false);
+      append_color(self, background, true);
+    }
+    append_text(self, "m");
+  }
+
+  // line drawing characters are sent in the DEC special graphics charset
+  if (previous == RENDERER_UNKNOWN_PEN ||
+      (previous & A_ALTCHARSET) != (pen & A_ALTCHARSET)) {
+    append_text(self, (pen & A_ALTCHARSET) ? "\033(0" : "\033(B");
+  }
+  self->_pen = pen;
+}
+
+/**
+ * @brief Appends the character of a cell with the current pen.
+ *
+ * @param self A pointer to the Renderer instance.
+ * @param cell The cell.
+ */
+static void append_glyph(Renderer *self, chtype cell) {
+  char glyph = (char)(cell & A_CHARTEXT);
+  if (!glyph) glyph = ' ';
+  append(self, &glyph, 1);
+}
+
+/**
+ * @brief Moves the terminal cursor to a cell with the shortest sequence.
+ *
+ * On the cursor row, a short run of unchanged cells drawn with the current pen
+ * is sent again, which is shorter than any escape sequence, and longer runs
+ * are skipped with a relative move. Anything else is an absolute move.
+ *
+ * @param self A pointer to the Renderer instance.
+ * @param y The row of the cell.
+ * @param x The column of the cell.
+ */
+static void move_cursor(Renderer *self, int y, int x) {
+  if (self->_cursor_y == y && self->_cursor_x == x) return;
+
+  if (self->_cursor_y == y && self->_cursor_x >= 0 && x > self->_cursor_x) {
+    int skipped = x - self->_cursor_x;
+    bool is_resent = skipped <= RENDERER_SKIP_LIMIT;
+    for (int i = self->_cursor_x; is_resent && i < x; i++) {
+      is_resent = (self->_row[i] & RENDERER_PEN_MASK) == self->_pen;
+    }
+
+    if (is_resent) {
+      for (int i = self->_cursor_x; i < x; i++) {
+        append_glyph(self, self->_row[i]);
+      }
+    } else {
+      append_text(self, "\033[");
+      if (skipped > 1) append_number(self, (unsigned int)skipped);
+      append_text(self, "C");
+    }
+  } else {
+    append_text(self, "\033[");
+    append_number(self, (unsigned int)y + 1);
+    if (x) {
+      append_text(self, ";");
+      append_number(self, (unsigned int)x + 1);
+    }
+    append_text(self, "H");
+  }
+
+  self->_cursor_y = y;
+  self->_cursor_x = x;
+}
+
+/**
+ * @brief Sends the palette colors ncurses changed since the previous frame.
+ *
+ * ncurses keeps the colors set by `init_color` but its output goes nowhere, so
+ * the palette is sent with OSC 4. Truecolor frames carry their colors and need
+ * no palette.
+ *
+ * @param self A pointer to the Renderer instance.
+ */
+static void sync_palette(Renderer *self) {
+  if (self->is_truecolor || !can_change_color()) return;
+
+  static const char hex[] = "0123456789abcdef";
+  int count = COLORS < RENDERER_PALETTE_SIZE ? COLORS : RENDERER_PALETTE_SIZE;
+  for (short color = 8; color < count; color++) {
+    short rgb[3] = {0};
+    color_content(color, &rgb[0], &rgb[1], &rgb[2]);
+    if (self->_is_palette_valid && !memcmp(rgb, self->_palette[color],
+                                           sizeof(rgb))) {
+      continue;
+    }
+
+    memcpy(self->_palette[color], rgb, sizeof(rgb));
+    append_text(self, "\033]4;");
+    append_number(self, (unsigned int)color);
+    append_text(self, ";rgb:");
+    for (int i = 0; i < 3; i++) {
+      int value = rgb[i] * 255 / 1000;
+      char channel[3] = {hex[value >> 4], hex[value & 15], i < 2 ? '/' : 0};
+      append(self, channel, i < 2 ? 3 : 2);
+    }
+    append_text(self, "\033\\");
+    self->_is_palette_changed = true;
+  }
+  self->_is_palette_valid = true;
+}
+
+/**
+ * @brief Makes the presented frame match the size of the virtual screen.
+ *
+ * After a SIGWINCH the ncurses screen is resized to the terminal first.
+ *
+ * @param self A pointer to the Renderer instance.
+ */
+static void sync_size(Renderer *self) {
+  if (is_resized) {
+    is_resized = 0;
+    struct winsize size = {0};
+    if (!ioctl(self->_terminal, TIOCGWINSZ, &size) && size.ws_row &&
+        size.ws_col) {
+      resizeterm(size.ws_row, size.ws_col);
+    }
+  }
+
+  int height = getmaxy(newscr), width = getmaxx(newscr);
+  if (height == self->height && width == self->width) return;
+
+  chtype *cells = realloc(self->_cells, sizeof(chtype) * height * width);
+  chtype *row = realloc(self->_row, sizeof(chtype) * (width + 1));
+  if (!cells || !row) {
+    fprintf(stderr, "Cannot allocate mem for Renderer cells\n");
+    exit(-1);
+  }
+  self->_cells = cells;
+  self->_row = row;
+  self->height = height;
+  self->width = width;
+  self->invalidate(self);
+}
+
+/**
+ * @brief Opens an ncurses screen of the requested size on /dev/null.
+ *
+ * @param self A pointer to the Renderer instance.
+ * @return 0 on success, -1 otherwise.
+ */
+static int start_headless(Renderer *self) {
+  self->_null = fopen("/dev/null", "w");
+  self->_null_input = fopen("/dev/null", "r");
+  if (!self->_null || !self->_null_input) return -1;
+
+  self->_screen = newterm(RENDERER_HEADLESS_TERM, self->_null,
+                          self->_null_input);
+  if (!self->_screen) return -1;
+
+  int height = self->height, width = self->width;
+  self->height = 0;
+  self->width = 0;
+  resizeterm(height, width);
+  sync_size(self);
+  return 0;
+}
+
+/**
+ * @brief Initializes ncurses and the terminal.
+ *
+ * The ncurses backend is a plain `initscr`, the headless backend opens a
+ * screen of its own size without any terminal. The ANSI backend gives ncurses
+ * /dev/null as its terminal, so the terminal modes, size, alternate screen and
+ * keypad mode are set by the renderer on the terminal it finds among the
+ * standard descriptors. The SIGWINCH handler is installed first, otherwise
+ * ncurses installs its own and resizes the screen to /dev/null.
+ *
+ * @param self A pointer to the Renderer instance.
+ * @return 0 on success, -1 otherwise.
+ */
+static int _start(Renderer *self) {
+  if (self->type == RENDERER_NCURSES) return initscr() ? 0 : -1;
+  if (self->type == RENDERER_HEADLESS) return start_headless(self);
+
+  int candidates[] = {self->fd, STDERR_FILENO, STDIN_FILENO};
+  self->_terminal = -1;
+  for (size_t i = 0; i < 3 && self->_terminal < 0; i++) {
+    if (isatty(candidates[i])) self->_terminal = candidates[i];
+  }
+  if (self->_terminal < 0) return -1;
+
+  struct sigaction action = {0};
+  action.sa_handler = on_resize;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGWINCH, &action, NULL);
+
+  self->_null = fopen("/dev/null", "w");
+  if (!self->_null) return -1;
+  self->_screen = newterm(NULL, self->_null, stdin);
+  if (!self->_screen) return -1;
+
+  // what cbreak() and noecho() would set on the terminal
+  tcgetattr(self->_terminal, &self->_terminal_modes);
+  struct termios modes = self->_terminal_modes;
+  modes.c_lflag &= ~(ICANON | ECHO | ECHONL);
+  modes.c_lflag |= ISIG;
+  modes.c_iflag &= ~ICRNL;
+  modes.c_cc[VMIN] = 1;
+  modes.c_cc[VTIME] = 0;
+  tcsetattr(self->_terminal, TCSADRAIN, &modes);
+
+  is_resized = 1;
+  append_capability(self, "smcup");
+  append_capability(self, "smkx");
+  append_capability(self, "civis");
+  flush_output(self);
+  sync_size(self);
+
+  // a descriptor of its own, so the terminal descriptors shared with the
+  // input stay blocking
+  if (isatty(self->fd)) {
+    int fd = open(ttyname(self->fd), O_WRONLY | O_NOCTTY | O_NONBLOCK);
+    if (fd >= 0) self->_output_fd = fd;
+  }
+  return 0;
+}
+
+/**
+ * @brief Returns the number of bytes written to a descriptor that its reader
+ * has not taken yet.
+ *
+ * Terminals and sockets report their output queue with `TIOCOUTQ`, pipes the
+ * bytes in the pipe with `FIONREAD`.
+ *
+ * @param fd The descriptor.
+ * @return The number of bytes, 0 if the descriptor cannot tell.
+ */
+static int pending_output(int fd) {
+  int pending = 0;
+  if (ioctl(fd, TIOCOUTQ, &pending) && ioctl(fd, FIONREAD, &pending)) {
+    pending = 0;
+  }
+  return pending;
+}
+
+/**
+ * @brief Checks whether the terminal still has too much of the previous
+ * frames queued to take another one.
+ *
+ * The limit is the size of the previous frame, so a terminal that drains a
+ * frame per frame period gets every frame and a slower one only the frames it
+ * has room for. A frame whose end the terminal refused holds the next frames
+ * back until the terminal took it, terminals that cannot tell their queue,
+ * such as pseudo-terminals, do this once their buffer is full.
+ *
+ * @param self A pointer to the Renderer instance.
+ * @return true if the frame is held back.
+ */
+static bool is_backlogged(Renderer *self) {
+  if (self->type == RENDERER_HEADLESS) return false;
+  if (self->_output_size && !flush_output(self)) return true;
+
+  int fd = self->type == RENDERER_ANSI ? self->fd : STDOUT_FILENO;
+  unsigned long pending = pending_output(fd);
+  if (pending > self->stats.max_backlog) self->stats.max_backlog = pending;
+
+  size_t limit = self->_frame_bytes > RENDERER_BACKLOG_MIN
+                     ? self->_frame_bytes
+                     : RENDERER_BACKLOG_MIN;
+  return pending > limit;
+}
+
+/**
+ * @brief Puts the virtual screen on the terminal.
+ *
+ * The ANSI backend compares the rows of the virtual screen touched since the
+ * previous frame with the presented frame and builds the escape stream of the
+ * changed cells, which is written at once. The headless backend only keeps the
+ * frame. A frame the terminal has no room for is held back, the touched rows
+ * of the virtual screen stay touched for the next frame.
+ *
+ * @param self A pointer to the Renderer instance.
+ */
+static void _present(Renderer *self) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  long long now_ns = now.tv_sec * 1000000000LL + now.tv_nsec;
+  if (!self->_first_ns) self->_first_ns = now_ns;
+  self->stats.elapsed_ns = now_ns - self->_first_ns;
+
+  if (is_backlogged(self)) {
+    self->stats.dropped++;
+    return;
+  }
+
+  self->stats.frames++;
+  if (self->type == RENDERER_NCURSES) {
+    doupdate();
+    return;
+  }
+
+  sync_size(self);
+  if (self->type == RENDERER_ANSI) sync_palette(self);
+
+  for (int y = 0; y < self->height; y++) {
+    // `wnoutrefresh` touches the changed lines of the virtual screen
+    if (!self->_is_invalid && !is_linetouched(newscr, y)) continue;
+
+    chtype *presented = self->_cells + (size_t)y * self->width;
+    mvwinchnstr(newscr, y, 0, self->_row, self->width);
+
+    for (int x = 0; x < self->width; x++) {
+      chtype cell = self->_row[x];
+      if (cell == presented[x]) continue;
+
+      if (self->type == RENDERER_ANSI) {
+        move_cursor(self, y, x);
+        set_pen(self, cell & RENDERER_PEN_MASK);
+        append_glyph(self, cell);
+        // the cursor stays in the last column until the next character
+        self->_cursor_x = x + 1 < self->width ? x + 1 : -1;
+      }
+      presented[x] = cell;
+      self->stats.cells++;
+    }
+  }
+
+  untouchwin(newscr);
+  self->_is_invalid = false;
+  self->_frame_bytes = self->_output_size;
+  if (self->_output_size) flush_output(self);
+}
+
+/**
+ * @brief Puts the virtual screen on the terminal once the terminal took the
+ * queued output, for the last frame before waiting for a key.
+ *
+ * @param self A pointer to the Renderer instance.
+ */
+static void _flush(Renderer *self) {
+  if (self->type == RENDERER_ANSI && self->_output_size) {
+    int fd = self->_output_fd;
+    self->_output_fd = self->fd;
+    flush_output(self);
+    self->_output_fd = fd;
+  }
+  if (self->type != RENDERER_HEADLESS) {
+    tcdrain(self->type == RENDERER_ANSI ? self->fd : STDOUT_FILENO);
+  }
+  _present(self);
+}
+
+/**
+ * @brief Makes the next frame repaint every cell.
+ *
+ * @param self A pointer to the Renderer instance.
+ */
+static void _invalidate(Renderer *self) {
+  for (size_t i = 0; i < (size_t)self->height * self->width; i++) {
+    self->_cells[i] = RENDERER_UNKNOWN_PEN;
+  }
+  self->_cursor_y = -1;
+  self->_cursor_x = -1;
+  self->_pen = RENDERER_UNKNOWN_PEN;
+  self->_is_palette_valid = false;
+  self->_is_invalid = true;
+}
+
+/**
+ * @brief Ends ncurses and restores the terminal.
+ *
+ * @param self A pointer to the Renderer instance.
+ */
+static void _stop(Renderer *self) {
+  endwin();
+  if (self->type != RENDERER_ANSI || self->_terminal < 0) return;
+
+  // the rest of a refused frame and the restoring sequences wait for the
+  // terminal
+  if (self->_output_fd != self->fd) close(self->_output_fd);
+  self->_output_fd = self->fd;
+  append_text(self, "\033[0m\033(B");
+  if (self->_is_palette_changed) append_text(self, "\033]104\033\\");
+  append_capability(self, "cnorm");
+  append_capability(self, "rmkx");
+  append_capability(self, "rmcup");
+  flush_output(self);
+  tcsetattr(self->_terminal, TCSADRAIN, &self->_terminal_modes);
+  self->_terminal = -1;
+}
+
+/**
+ * @brief Writes the name of a pen: its color pair and attributes.
+ *
+ * @param file The destination file.
+ * @param pen The attributes of a cell.
+ */
+static void dump_pen(FILE *file, chtype pen) {
+  static const struct {
+    chtype attribute;
+    const char *name;
+  } names[] = {{A_BOLD, "bold"},   {A_DIM, "dim"},     {A_UNDERLINE, "ul"},
+               {A_BLINK, "blink"}, {A_REVERSE, "rev"}, {A_STANDOUT, "so"},
+               {A_ALTCHARSET, "acs"}};
+
+  fprintf(file, "p%d", (int)PAIR_NUMBER(pen));
+  for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+    if (pen & names[i].attribute) fprintf(file, "+%s", names[i].name);
+  }
+}
+
+/**
+ * @brief Writes the presented frame as text.
+ *
+ * The text of every row comes first, line drawing characters as `+`, `-` and
+ * `|`, then the pens of every row as runs of `count:pen`, so that a golden
+ * frame diffs line by line.
+ *
+ * @param self A pointer to the Renderer instance.
+ * @param file The destination file.
+ * @return 0 on success, -1 if nothing was presented.
+ */
+static int _dump(Renderer *self, FILE *file) {
+  if (!self->_cells || self->_is_invalid) return -1;
+
+  fprintf(file, "frame %dx%d\n", self->width, self->height);
+  for (int y = 0; y < self->height; y++) {
+    const chtype *row = self->_cells + (size_t)y * self->width;
+    for (int x = 0; x < self->width; x++) {
+      int glyph = (int)(row[x] & A_CHARTEXT);
+      if (row[x] & A_ALTCHARSET) {
+        glyph = (glyph == 'q') ? '-' : (glyph == 'x') ? '|' : '+';
+      } else if (glyph < ' ' || glyph > '~') {
+        glyph = '?';
+      }
+      fputc(glyph, file);
+    }
+    fputc('\n', file);
+  }
+
+  fprintf(file, "pens\n");
+  for (int y = 0; y < self->height; y++) {
+    const chtype *row = self->_cells + (size_t)y * self->width;
+    fprintf(file, "%d:", y);
+    for (int x = 0; x < self->width;) {
+      chtype pen = row[x] & RENDERER_PEN_MASK;
+      int count = 1;
+      while (x + count < self->width &&
+             (row[x + count] & RENDERER_PEN_MASK) == pen) {
+        count++;
+      }
+      fprintf(file, " %d:", count);
+      dump_pen(file, pen);
+      x += count;
+    }
+    fputc('\n', file);
+  }
+  return ferror(file) ? -1 : 0;
+}
+
+/**
+ * @brief Frees the renderer.
+ *
+ * @param self A pointer to the Renderer instance.
+ */
+static void _destroy(Renderer *self) {
+  if (!self) return;
+
+  if (self->_output_fd != self->fd) close(self->_output_fd);
+  if (self->_screen) delscreen(self->_screen);
+  if (self->_null) fclose(self->_null);
+  if (self->_null_input) fclose(self->_null_input);
+  free(self->_cells);
+  free(self->_row);
+  free(self->_output);
+  free(self);
+}
+
+/**
+ * @brief Creates a renderer.
+ *
+ * If memory allocation fails, the function prints an error message to stderr
+ * and exits the program with a failure status.
+ *
+ * @param type The backend.
+ * @param fd Descriptor the ANSI backend writes frames to, usually the standard
+ * output.
+ * @param is_truecolor Whether colors are sent as 24-bit RGB.
+ * @return A pointer to the newly created renderer.
+ */
+Renderer *new_renderer(RendererType type, int fd, bool is_truecolor) {
+  Renderer *self = (Renderer *)calloc(1, sizeof(Renderer));
+  if (!self) {
+    fprintf(stderr, "Cannot allocate mem for Renderer\n");
+    exit(-1);
+  }
+
+  self->type = type;
+  self->fd = fd;
+  self->_output_fd = fd;
+  self->is_truecolor = is_truecolor;
+  self->_terminal = -1;
+  self->_cursor_y = -1;
+  self->_cursor_x = -1;
+  self->_pen = RENDERER_UNKNOWN_PEN;
+
+  self->start = _start;
+  self->present = _present;
+  self->flush = _flush;
+  self->invalidate = _invalidate;
+  self->stop = _stop;
+  self->dump = _dump;
+  self->destroy = _destroy;
+  return self;
+}
+
+/**
+ * @brief Creates a headless renderer.
+ *
+ * @param height The height of the screen.
+ * @param width The width of the screen.
+ * @return A pointer to the newly created renderer.
+ */
+Renderer *new_headless_renderer(int height, int width) {
+  Renderer *self = new_renderer(RENDERER_HEADLESS, -1, false);
+  self->height = height;
+  self->width = width;
+  return self;
+}
+
+/**
+ * @brief Parses a backend name.
+ *
+ * @param name "ncurses" or "ansi".
+ * @param type Where to store the backend.
+ * @return 0 on success, -1 if the name is unknown.
+ */
+int parse_renderer_type(const char *name, RendererType *type) {
+  int status = 0;
+  if (!strcmp(name, "ncurses")) {
+    *type = RENDERER_NCURSES;
+  } else if (!strcmp(name, "ansi")) {
+    *type = RENDERER_ANSI;
+  } else {
+    status = -1;
+  }
+  return status;
+}
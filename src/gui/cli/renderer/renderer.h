@@ -0,0 +1,198 @@
+#ifndef CLI_RENDERER_RENDERER_H
+#define CLI_RENDERER_RENDERER_H
+
+#include <ncurses.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <termios.h>
+
+#define RENDERER_PALETTE_SIZE 32
+#define RENDERER_SKIP_LIMIT 4
+// output queued in the terminal that never holds a frame back
+#define RENDERER_BACKLOG_MIN 512
+#define RENDERER_HEADLESS_TERM "xterm-256color"
+
+/**
+ * @brief Enumeration of the terminal output backends.
+ *
+ * @enum RendererType
+ * @var RENDERER_NCURSES ncurses writes the terminal with `doupdate`.
+ * @var RENDERER_ANSI ncurses only keeps the cells, the renderer diffs them
+ * against the previous frame and writes the escape sequences itself.
+ * @var RENDERER_HEADLESS No terminal at all: frames are only kept in memory,
+ * for golden frame tests and benchmarks.
+ */
+typedef enum {
+  RENDERER_NCURSES = 0,
+  RENDERER_ANSI,
+  RENDERER_HEADLESS,
+} RendererType;
+
+/**
+ * @brief Counters of the presented frames.
+ *
+ * Cells are counted by the ANSI and headless backends, bytes and writes only
+ * by the ANSI backend, ncurses does its own output.
+ *
+ * @struct RendererStats
+ * @var frames Number of presented frames.
+ * @var dropped Number of frames held back because the terminal had not taken
+ * the previous ones yet, their changes went out with the next presented frame.
+ * @var cells Number of cells sent to the terminal.
+ * @var bytes Number of bytes written to the terminal.
+ * @var writes Number of `write` calls.
+ * @var refused Number of `write` calls the full terminal refused, the rest of
+ * their frame was written later.
+ * @var max_backlog The most output found queued in the terminal before a
+ * frame, in bytes.
+ * @var elapsed_ns Time from the first to the last `present`.
+ */
+typedef struct {
+  unsigned long frames;
+  unsigned long dropped;
+  unsigned long cells;
+  unsigned long bytes;
+  unsigned long writes;
+  unsigned long refused;
+  unsigned long max_backlog;
+  long long elapsed_ns;
+} RendererStats;
+
+/**
+ * @brief Terminal output backend.
+ *
+ * Components keep drawing into ncurses windows and `wnoutrefresh` them into
+ * the virtual screen, `present` then puts the virtual screen on the terminal.
+ * With the ANSI backend ncurses writes to /dev/null: the touched rows of the
+ * virtual screen are compared with the previously presented frame and only the
+ * changed cells are sent, with the shortest cursor movement and only the
+ * attribute changes, in a single `write` per frame.
+ *
+ * A slow terminal, such as one behind an SSH link, drains the output slower
+ * than frames are made. Before every frame the output still queued in the
+ * terminal is checked and while it holds more than the previous frame, at
+ * least `RENDERER_BACKLOG_MIN` bytes, the frame is held back: nothing is
+ * written and the changes stay marked in the virtual screen, so the next
+ * presented frame sends them merged with its own. The terminal thus gets the
+ * latest state as fast as it takes it, and keys are not delayed behind
+ * queued frames. Pseudo-terminals do not tell their queue, their frames are
+ * written to a non-blocking descriptor instead: the part of a frame a full
+ * terminal refuses is written before anything else and holds the next frames
+ * back the same way, so the game loop never blocks on the output.
+ *
+ * @struct __renderer
+ * @var type The backend.
+ * @var is_truecolor Whether colors are sent as 24-bit RGB instead of palette
+ * indexes.
+ * @var fd Descriptor the ANSI backend writes frames to.
+ * @var height The height of the presented screen.
+ * @var width The width of the presented screen.
+ * @var stats Counters of the presented frames.
+ * @var _cells The presented frame, `height * width` cells.
+ * @var _row Row of the virtual screen being compared.
+ * @var _output The escape stream of the current frame.
+ * @var _output_size The size of the escape stream.
+ * @var _output_capacity The size of the escape stream buffer.
+ * @var _output_sent The number of bytes of the escape stream already written.
+ * @var _output_fd Descriptor the escape stream is written to: a non-blocking
+ * descriptor of the terminal of `fd` while started, `fd` otherwise.
+ * @var _frame_bytes The number of bytes the last presented frame wrote.
+ * @var _first_ns The monotonic time of the first `present`.
+ * @var _cursor_y The terminal cursor row or -1 if unknown.
+ * @var _cursor_x The terminal cursor column or -1 if unknown.
+ * @var _pen The attributes, color pair and charset of the terminal or -1 if
+ * unknown.
+ * @var _palette The palette colors sent to the terminal.
+ * @var _is_palette_valid Whether `_palette` holds what the terminal shows.
+ * @var _is_invalid Whether the next frame repaints every cell.
+ * @var _is_palette_changed Whether the terminal palette must be reset on
+ * `stop`.
+ * @var _terminal Descriptor of the terminal the modes and size come from.
+ * @var _terminal_modes The terminal modes saved by `start`.
+ * @var _null The /dev/null stream ncurses writes to.
+ * @var _null_input The /dev/null stream headless ncurses reads from.
+ * @var _screen The ncurses screen opened by `start`, NULL for `initscr`.
+ * @var start Function pointer initializing ncurses and the terminal.
+ * @var present Function pointer putting the virtual screen on the terminal,
+ * unless the terminal is still busy with the previous frames.
+ * @var flush Function pointer waiting for the terminal to take the queued
+ * output and then putting the virtual screen on it.
+ * @var invalidate Function pointer making the next frame repaint every cell.
+ * @var stop Function pointer ending ncurses and restoring the terminal.
+ * @var dump Function pointer writing the presented frame as text, headless
+ * and ANSI backends only.
+ * @var destroy Function pointer freeing the renderer.
+ */
+typedef struct __renderer {
+  RendererType type;
+  bool is_truecolor;
+  int fd;
+  int height;
+  int width;
+  RendererStats stats;
+
+  chtype *_cells;
+  chtype *_row;
+  char *_output;
+  size_t _output_size;
+  size_t _output_capacity;
+  size_t _output_sent;
+  int _output_fd;
+  size_t _frame_bytes;
+  long long _first_ns;
+  int _cursor_y;
+  int _cursor_x;
+  chtype _pen;
+  short _palette[RENDERER_PALETTE_SIZE][3];
+  bool _is_palette_valid;
+  bool _is_invalid;
+  bool _is_palette_changed;
+  int _terminal;
+  struct termios _terminal_modes;
+  FILE *_null;
+  FILE *_null_input;
+  SCREEN *_screen;
+
+  int (*start)(struct __renderer *self);
+  void (*present)(struct __renderer *self);
+  void (*flush)(struct __renderer *self);
+  void (*invalidate)(struct __renderer *self);
+  void (*stop)(struct __renderer *self);
+  int (*dump)(struct __renderer *self, FILE *file);
+  void (*destroy)(struct __renderer *self);
+} Renderer;
+
+/**
+ * @brief Creates a renderer.
+ *
+ * @param type The backend.
+ * @param fd Descriptor the ANSI backend writes frames to, usually the standard
+ * output.
+ * @param is_truecolor Whether colors are sent as 24-bit RGB.
+ * @return A pointer to the newly created renderer.
+ */
+Renderer *new_renderer(RendererType type, int fd, bool is_truecolor);
+
+/**
+ * @brief Creates a headless renderer.
+ *
+ * `start` opens an ncurses screen of the given size that needs no terminal,
+ * `present` keeps the frame and `dump` writes it out.
+ *
+ * @param height The height of the screen.
+ * @param width The width of the screen.
+ * @return A pointer to the newly created renderer.
+ */
+Renderer *new_headless_renderer(int height, int width);
+
+/**
+ * @brief Parses a backend name.
+ *
+ * @param name "ncurses" or "ansi".
+ * @param type Where to store the backend.
+ * @return 0 on success, -1 if the name is unknown.
+ */
+int parse_renderer_type(const char *name, RendererType *type);
+
+#endif  // !CLI_RENDERER_RENDERER_H
@@ -15,6 +15,39 @@ void print_window_cords(WINDOW *window) {
   mvwprintw(window, height / 2, width / 2, "width=%d height=%d", width, height);
 }
 
+WINDOW *provide_subwindow(SubWindow *self, WINDOW *parent, int height,
+                          int width, int y, int x) {
+  if (!self || !parent) return NULL;
+
+  bool is_same = self->window && self->parent == parent &&
+                 self->parent_y == getbegy(parent) &&
+                 self->parent_x == getbegx(parent) &&
+                 self->parent_height == getmaxy(parent) &&
+                 self->parent_width == getmaxx(parent) &&
+                 self->height == height && self->width == width &&
+                 self->y == y && self->x == x;
+  if (is_same) return self->window;
+
+  release_subwindow(self);
+  *self = (SubWindow){.window = derwin(parent, height, width, y, x),
+                      .parent = parent,
+                      .parent_y = getbegy(parent),
+                      .parent_x = getbegx(parent),
+                      .parent_height = getmaxy(parent),
+                      .parent_width = getmaxx(parent),
+                      .height = height,
+                      .width = width,
+                      .y = y,
+                      .x = x};
+  return self->window;
+}
+
+void release_subwindow(SubWindow *self) {
+  if (!self) return;
+  if (self->window) delwin(self->window);
+  self->window = NULL;
+}
+
 int min(int a, int b) { return a < b ? a : b; }
 int max(int a, int b) { return a > b ? a : b; }
 
@@ -10,6 +10,59 @@ int get_window_height(WINDOW *window);
 void print_window_cords(WINDOW *window);
 bool has_parent(WINDOW *window);
 
+/**
+ * @brief A derived window kept across frames.
+ *
+ * The window is created on first use and rebuilt only when its parent, its
+ * geometry or the geometry of its parent change, so a component drawing into
+ * it every frame allocates nothing.
+ *
+ * @struct SubWindow
+ * @var window The derived window or NULL before the first use.
+ * @var parent The window it is derived from.
+ * @var parent_y The y-coordinate of the parent when the window was built.
+ * @var parent_x The x-coordinate of the parent when the window was built.
+ * @var parent_height The height of the parent when the window was built.
+ * @var parent_width The width of the parent when the window was built.
+ * @var height The height of the window.
+ * @var width The width of the window.
+ * @var y The y-coordinate of the window relative to its parent.
+ * @var x The x-coordinate of the window relative to its parent.
+ */
+typedef struct {
+  WINDOW *window;
+  WINDOW *parent;
+  int parent_y;
+  int parent_x;
+  int parent_height;
+  int parent_width;
+  int height;
+  int width;
+  int y;
+  int x;
+} SubWindow;
+
+/**
+ * @brief Returns the kept window, rebuilding it if the geometry changed.
+ *
+ * @param self The kept window.
+ * @param parent The window to derive from.
+ * @param height The height of the window.
+ * @param width The width of the window.
+ * @param y The y-coordinate of the window relative to its parent.
+ * @param x The x-coordinate of the window relative to its parent.
+ * @return The derived window or NULL if it does not fit into the parent.
+ */
+WINDOW *provide_subwindow(SubWindow *self, WINDOW *parent, int height,
+                          int width, int y, int x);
+
+/**
+ * @brief Deletes the kept window, it is rebuilt on the next use.
+ *
+ * @param self The kept window.
+ */
+void release_subwindow(SubWindow *self);
+
 int min(int a, int b);
 int max(int a, int b);
 int random_between(int min, int max);
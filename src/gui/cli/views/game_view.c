@@ -0,0 +1,443 @@
+#include "game_view.h"
+
+// where the game screen takes its model from
+static game_view_model_provider model_provider = NULL;
+
+// the visual quality, lowered by the quality governor on slow terminals
+static QualityLevel quality = QUALITY_FULL;
+
+// the fire of every quality level: the resolution and the simulation rate
+static const struct {
+  int scale;
+  int steps_per_second;
+} fire_quality[QUALITY_LEVELS_COUNT] = {
+    [QUALITY_FULL] = {1, FIRE_COMPONENT_STEPS_PER_SECOND},
+    [QUALITY_REDUCED] = {1, FIRE_COMPONENT_STEPS_PER_SECOND / 2},
+    [QUALITY_LOW] = {2, FIRE_COMPONENT_STEPS_PER_SECOND / 4},
+};
+
+// what the header window shows, it is only redrawn on changes below the full
+// quality or when the model tracks its changes
+static struct {
+  bool is_valid;
+  int pause;
+  unsigned long pause_generation;
+  int width;
+  int height;
+} header_cache = {0};
+
+// what the start screen shows, it is only redrawn when its size changes
+static struct {
+  bool is_valid;
+  int width;
+  int height;
+} motd_cache = {0};
+
+// what the content window shows, so that a frame only draws what changed.
+// Anything that erases the content window must invalidate it.
+static struct {
+  bool is_valid;
+  bool is_drawn;
+  bool is_fire;
+  int width;
+  int height;
+  TetrisGeneration generation;
+  unsigned long ghost_generation;
+  BoardComponentCache board;
+  BoardComponentCache ghost_board;
+  CounterComponentCache score;
+  CounterComponentCache high_score;
+  CounterComponentCache level;
+  BrickComponentCache next;
+  FireComponentCache fire;
+} content_cache = {0};
+
+static unsigned long full_frames = 0;
+static unsigned long skipped_frames = 0;
+
+// whether the last frame showed the burning fire
+static bool is_animated = FALSE;
+
+/**
+ * @brief Sets where the game screen takes its model from.
+ *
+ * @param provider The model provider.
+ */
+void set_game_view_model_provider(game_view_model_provider provider) {
+  model_provider = provider;
+  invalidate_game_view();
+}
+
+/**
+ * @brief Sets the visual quality of the next frames.
+ *
+ * @param level The quality level.
+ */
+void set_game_view_quality(QualityLevel level) {
+  if (level < QUALITY_FULL || level >= QUALITY_LEVELS_COUNT) return;
+  quality = level;
+}
+
+/**
+ * @brief Makes the next frame redraw the whole content window and the header.
+ */
+void invalidate_game_view(void) {
+  content_cache.is_valid = FALSE;
+  content_cache.is_drawn = FALSE;
+  header_cache.is_valid = FALSE;
+  motd_cache.is_valid = FALSE;
+}
+
+/**
+ * @brief Frees the component windows of the game screen.
+ *
+ * The component windows live as long as the game screen, they are derived
+ * from the content window and must go before it.
+ */
+void release_game_view(void) {
+  release_subwindow(&content_cache.board.wrapper);
+  release_subwindow(&content_cache.ghost_board.wrapper);
+  release_subwindow(&content_cache.score.wrapper);
+  release_subwindow(&content_cache.high_score.wrapper);
+  release_subwindow(&content_cache.level.wrapper);
+  release_subwindow(&content_cache.next.wrapper);
+  release_fire_component(&content_cache.fire);
+  invalidate_game_view();
+}
+
+/**
+ * @brief Returns the drawing counters of the game screen.
+ *
+ * @return The counters.
+ */
+GameViewStats get_game_view_stats(void) {
+  return (GameViewStats){.full_frames = full_frames,
+                         .cells_drawn = content_cache.board.cells_drawn +
+                                        content_cache.ghost_board.cells_drawn,
+                         .skipped_frames = skipped_frames};
+}
+
+/**
+ * @brief Whether the game screen moves on its own: the last frame showed the
+ * burning fire, which changes every frame even without a new state.
+ *
+ * @return TRUE if the next frame differs from the last one anyway.
+ */
+bool is_game_view_animated(void) { return is_animated; }
+
+/**
+ * @brief Header layout handler of the game screen.
+ *
+ * Draws the logo of the game state: the game title, the pause or the game
+ * over logo. Below the full quality, or at any quality when the model tracks
+ * the changes of the pause flag, the logo is only redrawn when the game state
+ * or the size of the header change.
+ *
+ * @param self The header layout.
+ */
+void game_header_draw_handler(Layout *self) {
+  if (!self || !model_provider) return;
+
+  GameViewModel model = model_provider();
+  bool is_tracked = model.generation.pause != 0;
+  bool is_unchanged =
+      header_cache.is_valid && header_cache.pause == model.info.pause &&
+      (!is_tracked ||
+       header_cache.pause_generation == model.generation.pause) &&
+      header_cache.width == getmaxx(self->window) &&
+      header_cache.height == getmaxy(self->window);
+  if ((quality != QUALITY_FULL || is_tracked) && is_unchanged) return;
+  header_cache.is_valid = TRUE;
+  header_cache.pause = model.info.pause;
+  header_cache.pause_generation = model.generation.pause;
+  header_cache.width = getmaxx(self->window);
+  header_cache.height = getmaxy(self->window);
+
+  werase(self->window);
+  wbkgd(self->window, COLOR_PAIR(THEME_SURFACE_PAIR));
+
+  if (model.info.pause == 0) {
+    insert_tetris_logo(self->window, (getmaxx(self->window) - 30) / 2, 0);
+  } else if (model.info.pause == 1) {
+    insert_pause_logo(self->window, (getmaxx(self->window) - 30) / 2, 0);
+  } else if (model.info.pause == -1) {
+    insert_gameover_logo(self->window, (getmaxx(self->window) - 54) / 2, 0);
+  }
+  wnoutrefresh(self->window);
+}
+
+/**
+ * @brief Whether a component lies on rows painted by the fire.
+ *
+ * @param window The content window.
+ * @param y The first row of the component.
+ * @param height The height of the component.
+ * @return TRUE if the fire paints over the component.
+ */
+static bool is_under_fire(WINDOW *window, int y, int height) {
+  int fire_y = getmaxy(window) - GAME_VIEW_FIRE_HEIGHT;
+  return y + height > fire_y;
+}
+
+/**
+ * @brief Whether a part of the model changed since the frame that drew it.
+ *
+ * @param generation The change counter of the part in the model, 0 if not
+ * tracked.
+ * @param drawn The change counter of the part when it was drawn.
+ * @return TRUE if the part changed or is not tracked.
+ */
+static bool is_generation_changed(unsigned long generation,
+                                  unsigned long drawn) {
+  return generation == 0 || generation != drawn;
+}
+
+/**
+ * @brief Content layout handler of the game screen.
+ *
+ * Only the cells that changed since the previous frame are drawn, unless the
+ * content window was invalidated or resized or the fire of the high levels
+ * burns under the board. At the full quality the fire repaints the whole
+ * window, below it only the components under the fire are redrawn.
+ *
+ * When the model tracks its changes, components whose part of the model kept
+ * its generation are not drawn at all, and a frame where nothing changed
+ * leaves the window as it is. The fire does not burn while the game is paused
+ * or over, so such frames cost nothing.
+ *
+ * @param self The content layout.
+ */
+void game_content_draw_handler(Layout *self) {
+  if (!self || !model_provider) return;
+
+  GameViewModel view_model = model_provider();
+  GameInfo_t model = view_model.info;
+
+  // the fire animates under the board, so it repaints the whole window
+  bool is_fire = model.level >= 8;
+  bool is_burning = is_fire && model.pause == 0;
+  is_animated = is_burning;
+
+  TetrisGeneration drawn = content_cache.generation;
+  TetrisGeneration generation = view_model.generation;
+  bool is_unchanged =
+      content_cache.is_drawn && !is_burning &&
+      content_cache.is_fire == is_fire &&
+      content_cache.width == getmaxx(self->window) &&
+      content_cache.height == getmaxy(self->window) &&
+      !is_generation_changed(generation.state, drawn.state) &&
+      (!view_model.ghost_field ||
+       !is_generation_changed(view_model.ghost_generation,
+                              content_cache.ghost_generation));
+  if (is_unchanged) {
+    skipped_frames++;
+    return;
+  }
+  bool is_fire_redraw = is_burning && quality == QUALITY_FULL;
+  bool is_full = !content_cache.is_valid || is_fire_redraw ||
+                 content_cache.is_fire != is_fire ||
+                 content_cache.width != getmaxx(self->window) ||
+                 content_cache.height != getmaxy(self->window);
+  if (is_full) {
+    werase(self->window);
+    wbkgd(self->window, COLOR_PAIR(THEME_SURFACE_PAIR));
+    content_cache.board.is_valid = FALSE;
+    content_cache.ghost_board.is_valid = FALSE;
+    content_cache.score.is_valid = FALSE;
+    content_cache.high_score.is_valid = FALSE;
+    content_cache.level.is_valid = FALSE;
+    content_cache.next.is_valid = FALSE;
+    content_cache.is_valid = !is_fire_redraw;
+    content_cache.width = getmaxx(self->window);
+    content_cache.height = getmaxy(self->window);
+    full_frames++;
+  }
+  content_cache.is_fire = is_fire;
+
+  if (is_burning || (is_fire && is_full)) {
+    fire_component(
+        self->window,
+        (FireComponentProps){
+            .x = 0,
+            .y = getmaxy(self->window) - GAME_VIEW_FIRE_HEIGHT,
+            .height = GAME_VIEW_FIRE_HEIGHT,
+            .width = getmaxx(self->window),
+            .now_ns = view_model.now_ns,
+            .scale = fire_quality[quality].scale,
+            .steps_per_second = fire_quality[quality].steps_per_second,
+            .cache = &content_cache.fire});
+  }
+
+  // board, shifted to the left to make room for the ghost board
+  int ghost_width =
+      view_model.ghost_field ? (BOARD_COMPONENT_WIDTH * 2) + 2 + 3 : 0;
+  BoardComponentProps board = {
+      .attrs = COLOR_PAIR(THEME_SURFACE_PAIR),
+      .render_type = (model.pause == 1) ? BOARD_RENDER_TYPE_COLORLESS
+                                        : BOARD_RENDER_TYPE_DEFAULT,
+      .pos =
+          {
+              .x = (getmaxx(self->window) - 20 - 12 - ghost_width) / 2,
+              .y = (getmaxy(self->window) - 20) / 2,
+          },
+      .data =
+          {
+              .matrix = model.field,
+          },
+      .cache = &content_cache.board};
+
+  int stat_offset_x = board.pos.x + (BOARD_COMPONENT_WIDTH * 2) + 3;
+  int stat_offset_y = board.pos.y + 3;
+  int stat_width = 12;
+
+  // below the full quality the fire only paints its own rows, so only the
+  // components on them are redrawn over it
+  if (is_burning && !is_full) {
+    if (is_under_fire(self->window, board.pos.y, BOARD_COMPONENT_HEIGHT + 2)) {
+      content_cache.board.is_valid = FALSE;
+      content_cache.ghost_board.is_valid = FALSE;
+    }
+    if (is_under_fire(self->window, stat_offset_y, 3)) {
+      content_cache.score.is_valid = FALSE;
+    }
+    if (is_under_fire(self->window, stat_offset_y + 4, 3)) {
+      content_cache.high_score.is_valid = FALSE;
+    }
+    if (is_under_fire(self->window, stat_offset_y + 8, 3)) {
+      content_cache.level.is_valid = FALSE;
+    }
+    if (is_under_fire(self->window, stat_offset_y + 12, 6)) {
+      content_cache.next.is_valid = FALSE;
+    }
+  }
+
+  bool is_pause_changed =
+      is_generation_changed(generation.pause, drawn.pause);
+  bool is_score_changed =
+      is_generation_changed(generation.score, drawn.score);
+  if (!content_cache.board.is_valid || is_pause_changed ||
+      is_generation_changed(generation.field, drawn.field)) {
+    board_component(self->window, board);
+  }
+
+  // stat
+  if (!content_cache.score.is_valid || is_score_changed) {
+    // score
+    counter_component(self->window,
+                      (CounterComponentProps){
+                          .attrs = COLOR_PAIR(THEME_SURFACE_PAIR),
+                          .height = 3,
+                          .width = stat_width,
+                          .pos = {.x = stat_offset_x, .y = stat_offset_y},
+                          .data = {.title = "score", .value = model.score},
+                          .cache = &content_cache.score,
+                      });
+  }
+  if (!content_cache.high_score.is_valid || is_score_changed) {
+    // highscore
+    counter_component(
+        self->window,
+        (CounterComponentProps){
+            .attrs = COLOR_PAIR(THEME_SURFACE_PAIR),
+            .height = 3,
+            .width = stat_width,
+            .pos = {.x = stat_offset_x, .y = stat_offset_y + 4},
+            .data = {.title = "high score", .value = model.high_score},
+            .cache = &content_cache.high_score,
+        });
+  }
+  if (!content_cache.level.is_valid || is_score_changed) {
+    // level
+    counter_component(self->window,
+                      (CounterComponentProps){
+                          .attrs = COLOR_PAIR(THEME_SURFACE_PAIR),
+                          .height = 3,
+                          .width = stat_width,
+                          .pos = {.x = stat_offset_x, .y = stat_offset_y + 8},
+                          .data = {.title = "level", .value = model.level},
+                          .cache = &content_cache.level,
+                      });
+  }
+  if (!content_cache.next.is_valid || is_pause_changed ||
+      is_generation_changed(generation.next, drawn.next)) {
+    // next brick
+    brick_component(
+        self->window,
+        (BrickComponentProps){
+            .attrs = COLOR_PAIR(THEME_SURFACE_PAIR),
+            .render_type = (model.pause == 1) ? BRICK_RENDER_TYPE_COLORLESS
+                                              : BRICK_RENDER_TYPE_DEFAULT,
+            .width = stat_width,
+            .height = 6,
+            .data = {.title = "next",
+                     .width = 4,
+                     .height = 4,
+                     .matrix = model.next},
+            .pos = {.x = stat_offset_x, .y = stat_offset_y + 12},
+            .cache = &content_cache.next});
+  }
+
+  // ghost
+  if (view_model.ghost_field &&
+      (!content_cache.ghost_board.is_valid ||
+       is_generation_changed(view_model.ghost_generation,
+                             content_cache.ghost_generation))) {
+    int ghost_offset_x = stat_offset_x + stat_width + 3;
+    board_component(self->window,
+                    (BoardComponentProps){
+                        .attrs = COLOR_PAIR(THEME_SURFACE_PAIR),
+                        .render_type = BOARD_RENDER_TYPE_COLORLESS,
+                        .pos = {.x = ghost_offset_x, .y = board.pos.y},
+                        .data = {.matrix = view_model.ghost_field},
+                        .cache = &content_cache.ghost_board,
+                    });
+    wattron(self->window, WA_DIM);
+    mvwprintw(self->window, board.pos.y - 1, ghost_offset_x + 1,
+              "ghost %.15s %-6d",
+              view_model.ghost_player ? view_model.ghost_player : "",
+              view_model.ghost_score);
+    wattroff(self->window, WA_DIM);
+  }
+
+  if (is_full || is_fire) {
+    insert_s21_logo(self->window,
+                    getmaxx(self->window) - self->config.padding.right - 6,
+                    getmaxy(self->window) - self->config.padding.bottom - 4);
+  }
+
+  content_cache.is_drawn = TRUE;
+  content_cache.generation = generation;
+  content_cache.ghost_generation = view_model.ghost_generation;
+  wnoutrefresh(self->window);
+}
+
+/**
+ * @brief Content layout handler of the start screen.
+ *
+ * The start screen never changes, it is only redrawn when the content window
+ * was invalidated or resized.
+ *
+ * @param self The content layout.
+ */
+void motd_content_draw_handler(Layout *self) {
+  if (!self) return;
+  if (motd_cache.is_valid && motd_cache.width == getmaxx(self->window) &&
+      motd_cache.height == getmaxy(self->window)) {
+    return;
+  }
+  motd_cache.is_valid = TRUE;
+  motd_cache.width = getmaxx(self->window);
+  motd_cache.height = getmaxy(self->window);
+
+  werase(self->window);
+  wbkgd(self->window, COLOR_PAIR(THEME_SURFACE_PAIR));
+
+  motd_component(self->window,
+                 (MotdComponentProps){
+                     .attrs = COLOR_PAIR(THEME_SURFACE_PAIR),
+                     .height = 21,
+                     .width = 60,
+                     .pos = {.x = (getmaxx(self->window) - 60) / 2, .y = 2}});
+
+  wnoutrefresh(self->window);
+}
@@ -0,0 +1,125 @@
+#ifndef CLI_VIEWS_GAME_VIEW_H
+#define CLI_VIEWS_GAME_VIEW_H
+
+#include "../../../brick_game/tetris/tetris.h"
+#include "../governor/governor.h"
+#include "views.h"
+
+#define GAME_VIEW_FIRE_HEIGHT 20
+
+/**
+ * @brief What the game screen shows.
+ *
+ * @struct GameViewModel
+ * @var info The game state, as returned by `updateCurrentState`.
+ * @var ghost_field The field of the raced ghost or NULL without a ghost.
+ * @var ghost_score The score of the ghost.
+ * @var ghost_player The player of the ghost replay.
+ * @var now_ns The time of the frame in nanoseconds, it paces the animations.
+ * Without a time every frame advances them one step.
+ * @var generation The change counters of `info`. Parts whose counter did not
+ * grow since the previous frame are not drawn again, a zero counter means the
+ * part is not tracked and always drawn.
+ * @var ghost_generation The change counter of the ghost, 0 if not tracked.
+ */
+typedef struct {
+  GameInfo_t info;
+  int **ghost_field;
+  int ghost_score;
+  const char *ghost_player;
+  long long now_ns;
+  TetrisGeneration generation;
+  unsigned long ghost_generation;
+} GameViewModel;
+
+/**
+ * @brief Returns the model of the current frame.
+ */
+typedef GameViewModel (*game_view_model_provider)(void);
+
+/**
+ * @brief Drawing counters of the game screen.
+ *
+ * @struct GameViewStats
+ * @var full_frames Number of frames that redrew the whole content window.
+ * @var cells_drawn Number of board cells drawn, ghost board included.
+ * @var skipped_frames Number of frames that left the content window as it was,
+ * nothing in it changed.
+ */
+typedef struct {
+  unsigned long full_frames;
+  unsigned long cells_drawn;
+  unsigned long skipped_frames;
+} GameViewStats;
+
+/**
+ * @brief Sets where the game screen takes its model from.
+ *
+ * The game takes it from the engine, tests and benchmarks from a fixed or a
+ * simulated game.
+ *
+ * @param provider The model provider.
+ */
+void set_game_view_model_provider(game_view_model_provider provider);
+
+/**
+ * @brief Header layout handler of the game screen: the logo of the game state.
+ *
+ * @param self The header layout.
+ */
+void game_header_draw_handler(Layout *self);
+
+/**
+ * @brief Content layout handler of the game screen: the board, the counters,
+ * the next brick, the ghost and the fire of the high levels.
+ *
+ * @param self The content layout.
+ */
+void game_content_draw_handler(Layout *self);
+
+/**
+ * @brief Content layout handler of the start screen.
+ *
+ * @param self The content layout.
+ */
+void motd_content_draw_handler(Layout *self);
+
+/**
+ * @brief Sets the visual quality of the next frames.
+ *
+ * Below the full quality the fire is simulated slower and coarser, only the
+ * components under the fire are redrawn over it and the header logo is only
+ * redrawn when the game state changes.
+ *
+ * @param level The quality level.
+ */
+void set_game_view_quality(QualityLevel level);
+
+/**
+ * @brief Makes the next frame redraw the whole content window. Anything that
+ * draws over the content window must call it.
+ */
+void invalidate_game_view(void);
+
+/**
+ * @brief Frees the component windows of the game screen, before its layouts
+ * are destroyed.
+ */
+void release_game_view(void);
+
+/**
+ * @brief Whether the game screen moves on its own: the last frame showed the
+ * burning fire, which changes every frame even without a new state.
+ *
+ * @return TRUE if the next frame differs from the last one anyway.
+ */
+bool is_game_view_animated(void);
+
+/**
+ * @brief Returns the drawing counters of the game screen.
+ *
+ * @return The counters.
+ */
+GameViewStats get_game_view_stats(void);
+
+#endif  // !CLI_VIEWS_GAME_VIEW_H
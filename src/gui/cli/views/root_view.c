@@ -16,7 +16,7 @@
 static void header_draw_handler(Layout *self) {
   if (!self) return;
 
-  wclear(self->window);
+  werase(self->window);
   wbkgd(self->window, COLOR_PAIR(THEME_SURFACE_PAIR));
 
   insert_tetris_logo(self->window, 40, 0);
@@ -62,7 +62,7 @@ static void header_adjust_handler(Layout *self) {
 static void content_draw_handler(Layout *self) {
   if (!self) return;
 
-  wclear(self->window);
+  werase(self->window);
 
   print_window_cords(self->window);
   box(self->window, 0, 0);
@@ -142,7 +142,7 @@ static void content_adjust_handler(Layout *self) {
 static void footer_draw_handler(Layout *self) {
   if (!self) return;
 
-  wclear(self->window);
+  werase(self->window);
   wbkgd(self->window, COLOR_PAIR(THEME_SURFACE_PAIR));
   wattron(self->window, WA_DIM);
 
@@ -176,47 +176,60 @@ static void footer_adjust_handler(Layout *self) {
   wnoutrefresh(self->window);
 }
 
+/**
+ * @brief Creates a RootView on a parent window.
+ *
+ * The view is configured with the header, content and footer layouts of the
+ * game and their adjust and draw handlers. Unlike `provide_root_view`, every
+ * call creates a new view, so screens other than `stdscr` (offscreen renderers,
+ * tests, benchmarks) get their own.
+ *
+ * @param parent The window the view fills.
+ * @return A pointer to the newly created RootView instance.
+ */
+RootView *new_root_view(WINDOW *parent) {
+  int min_width = 64;
+  RootView *view =
+      new_view(parent, (RootViewConfig){.header = {.height = 5,
+                                                   .adjust_on_update = TRUE,
+                                                   .min_width = min_width,
+                                                   .min_height = 5},
+                                        .content = {.adjust_on_update = TRUE,
+                                                    .padding = {.top = 5 + 1,
+                                                                .bottom = 2,
+                                                                .left = 8,
+                                                                .right = 8},
+                                                    .min_height = 24,
+                                                    .min_width = min_width},
+                                        .footer = {.adjust_on_update = TRUE,
+                                                   .height = 1,
+                                                   .min_height = 1,
+                                                   .min_width = min_width}});
+
+  view->header->adjust_window = header_adjust_handler;
+  view->header->draw = header_draw_handler;
+
+  view->content->adjust_window = content_adjust_handler;
+  view->content->draw = content_draw_handler;
+
+  view->footer->adjust_window = footer_adjust_handler;
+  view->footer->draw = footer_draw_handler;
+  return view;
+}
+
 /**
  * @brief Provides a singleton instance of RootView.
  *
  * This function ensures that only one instance of RootView is created and used
- * throughout the application. It initializes the RootView with specific
- * configurations for header, content, and footer, including dimensions,
- * padding, and handlers for adjusting and drawing each component.
+ * throughout the application. It initializes the RootView on `stdscr` with
+ * `new_root_view` the first time it is called.
  *
  * @return A pointer to the singleton RootView instance.
- *         Initializes the RootView with specific configurations if it hasn't
- * been initialized before.
  */
 RootView *provide_root_view() {
   static RootView *view = NULL;
   if (!view) {
-    int min_width = 64;
-    view =
-        new_view(stdscr, (RootViewConfig){.header = {.height = 5,
-                                                     .adjust_on_update = TRUE,
-                                                     .min_width = min_width,
-                                                     .min_height = 5},
-                                          .content = {.adjust_on_update = TRUE,
-                                                      .padding = {.top = 5 + 1,
-                                                                  .bottom = 2,
-                                                                  .left = 8,
-                                                                  .right = 8},
-                                                      .min_height = 24,
-                                                      .min_width = min_width},
-                                          .footer = {.adjust_on_update = TRUE,
-                                                     .height = 1,
-                                                     .min_height = 1,
-                                                     .min_width = min_width}});
-
-    view->header->adjust_window = header_adjust_handler;
-    view->header->draw = header_draw_handler;
-
-    view->content->adjust_window = content_adjust_handler;
-    view->content->draw = content_draw_handler;
-
-    view->footer->adjust_window = footer_adjust_handler;
-    view->footer->draw = footer_draw_handler;
+    view = new_root_view(stdscr);
   }
   return view;
-}
\ No newline at end of file
+}
@@ -0,0 +1,433 @@
+#include "spectator_view.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// the label of a board is drawn in the warning colors once the stack is that
+// high, the game is close to its game over
+#define SPECTATOR_VIEW_DANGER_HEIGHT (BOARD_COMPONENT_HEIGHT * 3 / 4)
+
+#define SPECTATOR_VIEW_LABEL_SIZE 32
+#define SPECTATOR_VIEW_STATUS_SIZE 128
+
+// where the spectator screen takes its model from
+static spectator_view_model_provider model_provider = NULL;
+
+static const char *sort_names[SPECTATOR_SORTS_COUNT] = {
+    [SPECTATOR_SORT_SCORE] = "score",
+    [SPECTATOR_SORT_DANGER] = "danger",
+};
+
+// what a tile of the grid shows, so that a frame only draws the boards that
+// changed and only their changed cells
+typedef struct {
+  int game;
+  unsigned long generation;
+  int label_attrs;
+  char label[SPECTATOR_VIEW_LABEL_SIZE];
+  BoardComponentCache board;
+} SpectatorTile;
+
+// what the content window shows. Anything that erases the content window
+// must invalidate it.
+static struct {
+  bool is_valid;
+  int width;
+  int height;
+  int shown;
+  char status[SPECTATOR_VIEW_STATUS_SIZE];
+  SpectatorTile *tiles;
+  int tiles_count;
+  int *order;
+  int order_count;
+} grid_cache = {0};
+
+// the title and the key hints only change with the size of the screen
+static struct {
+  int header_width;
+  int footer_width;
+} bars_cache = {0};
+
+static SpectatorViewStats stats = {0};
+
+// the snapshots being sorted, qsort passes no context to the comparators
+static const TetrisSnapshot *const *sorted_boards = NULL;
+
+/**
+ * @brief Sets where the spectator screen takes its model from.
+ *
+ * @param provider The model provider.
+ */
+void set_spectator_view_model_provider(spectator_view_model_provider provider) {
+  model_provider = provider;
+  invalidate_spectator_view();
+}
+
+/**
+ * @brief Makes the next frame redraw the whole grid, the title and the key
+ * hints.
+ */
+void invalidate_spectator_view(void) {
+  grid_cache.is_valid = FALSE;
+  bars_cache.header_width = 0;
+  bars_cache.footer_width = 0;
+}
+
+/**
+ * @brief Frees the board windows and the tiles of the spectator screen.
+ */
+void release_spectator_view(void) {
+  for (int i = 0; i < grid_cache.tiles_count; i++) {
+    release_subwindow(&grid_cache.tiles[i].board.wrapper);
+  }
+  free(grid_cache.tiles);
+  free(grid_cache.order);
+  grid_cache.tiles = NULL;
+  grid_cache.tiles_count = 0;
+  grid_cache.order = NULL;
+  grid_cache.order_count = 0;
+  invalidate_spectator_view();
+}
+
+/**
+ * @brief Returns the drawing counters of the spectator screen.
+ *
+ * @return The counters.
+ */
+SpectatorViewStats get_spectator_view_stats(void) {
+  SpectatorViewStats result = stats;
+  for (int i = 0; i < grid_cache.tiles_count; i++) {
+    result.cells_drawn += grid_cache.tiles[i].board.cells_drawn;
+  }
+  return result;
+}
+
+/**
+ * @brief Orders games by their score, the highest first, then by their index.
+ *
+ * @param a A pointer to the index of the first game.
+ * @param b A pointer to the index of the second game.
+ * @return The order of the games, as `qsort` expects it.
+ */
+static int compare_scores(const void *a, const void *b) {
+  int first = *(const int *)a, second = *(const int *)b;
+  int first_score = sorted_boards[first]->info.score;
+  int second_score = sorted_boards[second]->info.score;
+  if (first_score != second_score) return first_score > second_score ? -1 : 1;
+  return first - second;
+}
+
+/**
+ * @brief Orders games by the height of their stack, the highest first, then
+ * by their index.
+ *
+ * @param a A pointer to the index of the first game.
+ * @param b A pointer to the index of the second game.
+ * @return The order of the games, as `qsort` expects it.
+ */
+static int compare_dangers(const void *a, const void *b) {
+  int first = *(const int *)a, second = *(const int *)b;
+  int first_height = sorted_boards[first]->stack_height;
+  int second_height = sorted_boards[second]->stack_height;
+  if (first_height != second_height) {
+    return first_height > second_height ? -1 : 1;
+  }
+  return first - second;
+}
+
+/**
+ * @brief Makes the cache hold at least a number of tiles and game indexes.
+ *
+ * New tiles show nothing yet.
+ *
+ * @param tiles_count The number of tiles.
+ * @param order_count The number of game indexes.
+ */
+static void reserve_grid(int tiles_count, int order_count) {
+  if (tiles_count > grid_cache.tiles_count) {
+    SpectatorTile *tiles = (SpectatorTile *)realloc(
+        grid_cache.tiles, tiles_count * sizeof(SpectatorTile));
+    if (!tiles) {
+      fprintf(stderr, "Cannot allocate mem for SpectatorTile\n");
+      exit(-1);
+    }
+    for (int i = grid_cache.tiles_count; i < tiles_count; i++) {
+      tiles[i] = (SpectatorTile){.game = -1};
+    }
+    grid_cache.tiles = tiles;
+    grid_cache.tiles_count = tiles_count;
+  }
+  if (order_count > grid_cache.order_count) {
+    int *order = (int *)realloc(grid_cache.order, order_count * sizeof(int));
+    if (!order) {
+      fprintf(stderr, "Cannot allocate mem for SpectatorView\n");
+      exit(-1);
+    }
+    grid_cache.order = order;
+    grid_cache.order_count = order_count;
+  }
+}
+
+/**
+ * @brief Draws the status row of the grid when its text changed.
+ *
+ * @param window The content window.
+ * @param model The model of the frame.
+ * @param page The page shown.
+ * @param pages The number of pages.
+ */
+static void draw_status(WINDOW *window, SpectatorViewModel model, int page,
+                        int pages) {
+  int best = 0, in_danger = 0;
+  for (int i = 0; i < model.count; i++) {
+    const TetrisSnapshot *board = model.boards[i];
+    if (board->info.high_score > best) best = board->info.high_score;
+    in_danger += board->stack_height >= SPECTATOR_VIEW_DANGER_HEIGHT;
+  }
+
+  char status[SPECTATOR_VIEW_STATUS_SIZE];
+  snprintf(status, sizeof(status),
+           "%d games by %s, page %d/%d, best score %d, %d in danger",
+           model.count, sort_names[model.sort], page + 1, pages, best,
+           in_danger);
+  if (!strcmp(status, grid_cache.status)) return;
+  strcpy(grid_cache.status, status);
+
+  wmove(window, 0, 0);
+  wclrtoeol(window);
+  mvwaddnstr(window, 0, 1, status, getmaxx(window) - 2);
+}
+
+/**
+ * @brief Draws a tile: the label with the number and the score of the game
+ * and its compact board.
+ *
+ * @param window The content window.
+ * @param tile The tile.
+ * @param game The index of the game.
+ * @param board The snapshot of the game.
+ * @param x The x-coordinate of the tile.
+ * @param y The y-coordinate of the tile.
+ */
+static void draw_tile(WINDOW *window, SpectatorTile *tile, int game,
+                      const TetrisSnapshot *board, int x, int y) {
+  char label[SPECTATOR_VIEW_LABEL_SIZE];
+  snprintf(label, sizeof(label), "%-4d%8d", game + 1, board->info.score);
+  int label_attrs = board->stack_height >= SPECTATOR_VIEW_DANGER_HEIGHT
+                        ? COLOR_PAIR(THEME_WARNING_PAIR)
+                        : A_DIM;
+  if (!tile->board.is_valid || tile->label_attrs != label_attrs ||
+      strcmp(tile->label, label)) {
+    wattrset(window, label_attrs);
+    mvwaddnstr(window, y, x, label, BOARD_COMPONENT_WIDTH + 2);
+    wattrset(window, A_NORMAL);
+    strcpy(tile->label, label);
+    tile->label_attrs = label_attrs;
+  }
+
+  board_component(window, (BoardComponentProps){
+                              .attrs = COLOR_PAIR(THEME_SURFACE_PAIR),
+                              .render_type = BOARD_RENDER_TYPE_DEFAULT,
+                              .is_compact = TRUE,
+                              .pos = {.x = x, .y = y + 1},
+                              .data = {.matrix = board->info.field},
+                              .cache = &tile->board,
+                          });
+  tile->game = game;
+  tile->generation = board->generation.state;
+}
+
+/**
+ * @brief Content layout handler of the spectator screen.
+ *
+ * The games are sorted every frame and the page of the model is cut out of
+ * them. A tile still showing the same game at the same generation is not
+ * drawn at all, any other tile only draws the cells that differ from what it
+ * showed, so games moving between tiles after a sort cost their changed cells
+ * alone. The whole grid is only redrawn when the window was invalidated or
+ * resized or the page has fewer games than the previous one.
+ *
+ * @param self The content layout.
+ */
+void spectator_content_draw_handler(Layout *self) {
+  if (!self || !model_provider) return;
+
+  SpectatorViewModel model = model_provider();
+  int width = getmaxx(self->window), height = getmaxy(self->window);
+  int columns = (width + 1) / SPECTATOR_VIEW_TILE_WIDTH;
+  int rows = (height - 1) / SPECTATOR_VIEW_TILE_HEIGHT;
+  int per_page = max(1, columns * rows);
+  int pages = max(1, (model.count + per_page - 1) / per_page);
+  int page = ((model.page % pages) + pages) % pages;
+  int shown = max(0, min(per_page, model.count - page * per_page));
+  reserve_grid(per_page, model.count);
+
+  bool is_full = !grid_cache.is_valid || grid_cache.width != width ||
+                 grid_cache.height != height || shown < grid_cache.shown;
+  if (is_full) {
+    werase(self->window);
+    wbkgd(self->window, COLOR_PAIR(THEME_SURFACE_PAIR));
+    for (int i = 0; i < grid_cache.tiles_count; i++) {
+      grid_cache.tiles[i].board.is_valid = FALSE;
+    }
+    grid_cache.status[0] = '\0';
+    grid_cache.is_valid = TRUE;
+    grid_cache.width = width;
+    grid_cache.height = height;
+    stats.full_frames++;
+  }
+  grid_cache.shown = shown;
+  stats.frames++;
+
+  for (int i = 0; i < model.count; i++) grid_cache.order[i] = i;
+  sorted_boards = model.boards;
+  qsort(grid_cache.order, model.count, sizeof(int),
+        model.sort == SPECTATOR_SORT_DANGER ? compare_dangers
+                                            : compare_scores);
+  sorted_boards = NULL;
+
+  draw_status(self->window, model, page, pages);
+
+  int grid_width = columns * SPECTATOR_VIEW_TILE_WIDTH - 1;
+  int offset_x = max(0, (width - grid_width) / 2);
+  for (int i = 0; i < shown; i++) {
+    SpectatorTile *tile = &grid_cache.tiles[i];
+    int game = grid_cache.order[page * per_page + i];
+    const TetrisSnapshot *board = model.boards[game];
+    if (tile->board.is_valid && tile->game == game &&
+        tile->generation == board->generation.state) {
+      stats.boards_skipped++;
+      continue;
+    }
+
+    draw_tile(self->window, tile, game, board,
+              offset_x + (i % columns) * SPECTATOR_VIEW_TILE_WIDTH,
+              1 + (i / columns) * SPECTATOR_VIEW_TILE_HEIGHT);
+    stats.boards_drawn++;
+  }
+
+  wnoutrefresh(self->window);
+}
+
+/**
+ * @brief Header layout handler of the spectator screen: the title row.
+ *
+ * @param self The header layout.
+ */
+static void spectator_header_draw_handler(Layout *self) {
+  if (!self || bars_cache.header_width == getmaxx(self->window)) return;
+  bars_cache.header_width = getmaxx(self->window);
+
+  werase(self->window);
+  wbkgd(self->window, COLOR_PAIR(THEME_SURFACE_PAIR));
+  wattron(self->window, A_BOLD);
+  mvwaddstr(self->window, 0, 1, "BRICK GAME TETRIS, bot games");
+  wattroff(self->window, A_BOLD);
+  wnoutrefresh(self->window);
+}
+
+/**
+ * @brief Footer layout handler of the spectator screen: the key hints.
+ *
+ * @param self The footer layout.
+ */
+static void spectator_footer_draw_handler(Layout *self) {
+  if (!self || bars_cache.footer_width == getmaxx(self->window)) return;
+  bars_cache.footer_width = getmaxx(self->window);
+
+  werase(self->window);
+  wbkgd(self->window, COLOR_PAIR(THEME_SURFACE_PAIR));
+  wattron(self->window, WA_DIM);
+  mvwaddstr(self->window, 0, 1,
+            "s: sort by score or danger   left/right: page   q: quit");
+  wattroff(self->window, WA_DIM);
+  wnoutrefresh(self->window);
+}
+
+/**
+ * @brief Keeps the title row as wide as the screen, at its top.
+ *
+ * @param self The header layout.
+ */
+static void spectator_header_adjust_handler(Layout *self) {
+  if (!self) return;
+  wresize(self->window, self->config.height, getmaxx(self->window->_parent));
+  mvderwin(self->window, 0, 0);
+}
+
+/**
+ * @brief Keeps the hint row as wide as the screen, at its bottom.
+ *
+ * A derived window only shows another part of its parent after `mvderwin`,
+ * it stays where it is on the screen, so the row is derived again whenever
+ * the height of the screen changes.
+ *
+ * @param self The footer layout.
+ */
+static void spectator_footer_adjust_handler(Layout *self) {
+  if (!self) return;
+  WINDOW *parent = self->window->_parent;
+  int y = getmaxy(parent) - self->config.height;
+  if (getpary(self->window) != y) {
+    WINDOW *window =
+        derwin(parent, self->config.height, getmaxx(parent), y, 0);
+    if (!window) return;
+    delwin(self->window);
+    self->window = window;
+    bars_cache.footer_width = 0;
+  }
+  wresize(self->window, self->config.height, getmaxx(parent));
+}
+
+/**
+ * @brief Keeps the grid window between the title and the hint rows.
+ *
+ * @param self The content layout.
+ */
+static void spectator_content_adjust_handler(Layout *self) {
+  if (!self) return;
+  int height = getmaxy(self->window->_parent) -
+               (self->config.padding.bottom + self->config.padding.top);
+  int width = getmaxx(self->window->_parent);
+  wresize(self->window, height, width);
+  mvderwin(self->window, self->config.padding.top, 0);
+}
+
+/**
+ * @brief Creates the spectator screen.
+ *
+ * The grid needs room for one tile at least, the title and the hint rows take
+ * a row each.
+ *
+ * @param parent The window of the screen.
+ * @return A pointer to the newly created view.
+ */
+RootView *new_spectator_view(WINDOW *parent) {
+  int min_width = SPECTATOR_VIEW_TILE_WIDTH;
+  RootView *view = new_view(
+      parent,
+      (RootViewConfig){
+          .header = {.height = 1,
+                     .adjust_on_update = TRUE,
+                     .min_width = min_width,
+                     .min_height = 1},
+          .content = {.height = 1,
+                      .adjust_on_update = TRUE,
+                      .padding = {.top = 1, .bottom = 1},
+                      .min_height = SPECTATOR_VIEW_TILE_HEIGHT + 1,
+                      .min_width = min_width},
+          .footer = {.height = 1,
+                     .adjust_on_update = TRUE,
+                     .min_height = 1,
+                     .min_width = min_width}});
+
+  view->header->adjust_window = spectator_header_adjust_handler;
+  view->header->draw = spectator_header_draw_handler;
+
+  view->content->adjust_window = spectator_content_adjust_handler;
+  view->content->draw = spectator_content_draw_handler;
+
+  view->footer->adjust_window = spectator_footer_adjust_handler;
+  view->footer->draw = spectator_footer_draw_handler;
+  return view;
+}
@@ -0,0 +1,109 @@
+#ifndef CLI_VIEWS_SPECTATOR_VIEW_H
+#define CLI_VIEWS_SPECTATOR_VIEW_H
+
+#include "../../../brick_game/tetris/runner/snapshot.h"
+#include "views.h"
+
+// a tile is a compact board with a label row above it and a gap column after
+#define SPECTATOR_VIEW_TILE_WIDTH (BOARD_COMPONENT_WIDTH + 2 + 1)
+#define SPECTATOR_VIEW_TILE_HEIGHT (BOARD_COMPONENT_HEIGHT + 2 + 1)
+
+/**
+ * @brief Enumeration of the orders of the spectated games.
+ *
+ * @enum SpectatorSort
+ * @var SPECTATOR_SORT_SCORE The highest score first.
+ * @var SPECTATOR_SORT_DANGER The highest stack first, the games closest to
+ * their game over.
+ */
+typedef enum {
+  SPECTATOR_SORT_SCORE = 0,
+  SPECTATOR_SORT_DANGER,
+  SPECTATOR_SORTS_COUNT,
+} SpectatorSort;
+
+/**
+ * @brief What the spectator screen shows.
+ *
+ * @struct SpectatorViewModel
+ * @var boards The latest snapshot of every game, they must stay unchanged
+ * while the frame is drawn.
+ * @var count The number of games.
+ * @var sort The order of the games.
+ * @var page The page of games shown, any number: it wraps around the pages
+ * that fit the screen.
+ */
+typedef struct {
+  const TetrisSnapshot *const *boards;
+  int count;
+  SpectatorSort sort;
+  int page;
+} SpectatorViewModel;
+
+/**
+ * @brief Returns the model of the current frame.
+ */
+typedef SpectatorViewModel (*spectator_view_model_provider)(void);
+
+/**
+ * @brief Drawing counters of the spectator screen.
+ *
+ * @struct SpectatorViewStats
+ * @var frames Number of drawn frames.
+ * @var full_frames Number of frames that redrew the whole grid.
+ * @var boards_drawn Number of boards drawn, only their changed cells.
+ * @var boards_skipped Number of boards left as they were, nothing in them
+ * changed.
+ * @var cells_drawn Number of board cells drawn.
+ */
+typedef struct {
+  unsigned long frames;
+  unsigned long full_frames;
+  unsigned long boards_drawn;
+  unsigned long boards_skipped;
+  unsigned long cells_drawn;
+} SpectatorViewStats;
+
+/**
+ * @brief Sets where the spectator screen takes its model from.
+ *
+ * @param provider The model provider.
+ */
+void set_spectator_view_model_provider(spectator_view_model_provider provider);
+
+/**
+ * @brief Content layout handler of the spectator screen: a grid of compact
+ * boards, as many as fit the window, in the order of the model.
+ *
+ * @param self The content layout.
+ */
+void spectator_content_draw_handler(Layout *self);
+
+/**
+ * @brief Creates the spectator screen: a title row, the grid and a row of key
+ * hints.
+ *
+ * @param parent The window of the screen.
+ * @return A pointer to the newly created view.
+ */
+RootView *new_spectator_view(WINDOW *parent);
+
+/**
+ * @brief Makes the next frame redraw the whole grid.
+ */
+void invalidate_spectator_view(void);
+
+/**
+ * @brief Frees the board windows of the spectator screen, before its layouts
+ * are destroyed.
+ */
+void release_spectator_view(void);
+
+/**
+ * @brief Returns the drawing counters of the spectator screen.
+ *
+ * @return The counters.
+ */
+SpectatorViewStats get_spectator_view_stats(void);
+
+#endif  // !CLI_VIEWS_SPECTATOR_VIEW_H
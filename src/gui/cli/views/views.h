@@ -59,6 +59,7 @@ typedef struct __view {
 } RootView;
 
 RootView *new_view(WINDOW *parent, RootViewConfig config);
+RootView *new_root_view(WINDOW *parent);
 RootView *provide_root_view();
 
 #endif  // !CLI_VIEWS_VIEWS_H
\ No newline at end of file
@@ -1,3 +1,5 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "brick_game/tetris/tetris.h"
 
 #include <locale.h>
@@ -6,8 +8,126 @@
 #include <time.h>
 #include <unistd.h>
 
+#include "brick_game/tetris/fleet/fleet.h"
+#include "brick_game/tetris/ghost/ghost.h"
+#include "brick_game/tetris/runner/runner.h"
 #include "gui/cli/cli.h"
 
+// replay raced against the live game, see `--ghost`
+static Ghost *ghost = NULL;
+
+// puts the ncurses virtual screen on the terminal, see `--renderer`
+static Renderer *renderer = NULL;
+
+// frames per second of the game loop, see `--fps`
+#define TETRIS_FPS 20
+
+// the loop sleeps until a key, a new engine state or a frame deadline
+static EventLoop *loop = NULL;
+
+// runs the engine on its own thread, frames only read its snapshots
+static TetrisRunner *runner = NULL;
+
+// the engine snapshot of the current frame
+static const TetrisSnapshot *frame = NULL;
+
+// render statistics, see `--stats`
+static struct {
+  unsigned long frames;
+  long long cpu_ns;
+  unsigned long states;
+  long long latency_ns;
+  long long max_latency_ns;
+} render_stats = {0};
+
+// what reached the terminal and what a slow terminal had no room for, ncurses
+// does its own output and counts no bytes
+static void print_output_stats(void) {
+  RendererStats stats = renderer->stats;
+  if (!stats.frames || !stats.elapsed_ns) return;
+  double seconds = stats.elapsed_ns / 1e9;
+  fprintf(stderr, "output: %.1f frames/s, %lu dropped, %lu bytes max queued",
+          stats.frames / seconds, stats.dropped, stats.max_backlog);
+  if (renderer->type == RENDERER_ANSI) {
+    fprintf(stderr, ", %.0f bytes/s, %lu writes refused",
+            stats.bytes / seconds, stats.refused);
+  }
+  fprintf(stderr, "\n");
+}
+
+// the non-empty buckets of a keyboard histogram, by their lower bound
+static void print_histogram(const char *name, const unsigned long *buckets,
+                            const char *unit) {
+  fprintf(stderr, ", %s", name);
+  for (int i = 0; i < KEYBOARD_HISTOGRAM_SIZE; i++) {
+    if (!buckets[i]) continue;
+    fprintf(stderr, " %lld%s+:%lu", i ? 1LL << (i - 1) : 0LL, unit,
+            buckets[i]);
+  }
+}
+
+// how many keys a read found and how long they waited to be emitted, what
+// the decoder of the raw input made of the bytes and how the input thread ran
+static void print_input_stats(KeyboardStats stats, const KeyDecoder *decoder,
+                              const InputThread *thread) {
+  if (!stats.keys) return;
+  fprintf(stderr, "input: %lu keys in %lu reads, %lu deferred", stats.keys,
+          stats.reads, stats.deferred);
+  print_histogram("depth", stats.depth, "");
+  print_histogram("age", stats.age, "us");
+  if (decoder) {
+    fprintf(stderr,
+            ", raw %s: %lu bytes, %lu sequences, %lu unknown, %lu timed out",
+            decoder->is_kitty ? "kitty" : "legacy", decoder->stats.bytes,
+            decoder->stats.sequences, decoder->stats.unknown,
+            decoder->stats.timeouts);
+  }
+  if (thread) {
+    fprintf(stderr, ", thread: %lu chunks, %lu full, %s priority, %s cpu",
+            thread->stats.chunks, thread->stats.full,
+            thread->is_realtime ? "real-time" : "normal",
+            thread->is_pinned ? "pinned" : "any");
+  }
+  fprintf(stderr, "\n");
+}
+
+// the game screen shows the engine and the raced ghost
+static GameViewModel provide_game_view_model(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  GameViewModel model = {.info = frame->info,
+                         .now_ns = now.tv_sec * 1000000000LL + now.tv_nsec,
+                         .generation = frame->generation};
+  if (frame->has_ghost) {
+    model.ghost_field = frame->ghost_field;
+    model.ghost_score = frame->ghost_score;
+    model.ghost_generation = frame->ghost_generation;
+    model.ghost_player = ghost->reader.header.player;
+  }
+  return model;
+}
+
+// the loop waits for the input thread instead of the input when there is one
+static int input_fd(KeyboardController *kb) {
+  return kb->input_thread ? kb->input_thread->notify_fd : STDIN_FILENO;
+}
+
+// reads every key that arrived, returns whether one of them was the given key
+static bool read_keys(KeyboardController *kb, int key) {
+  bool is_pressed = FALSE;
+  for (Button btn = kb->listen(kb); btn.key != ERR; btn = kb->listen(kb)) {
+    is_pressed = is_pressed || (btn.key == key && !btn.release);
+  }
+  return is_pressed;
+}
+
+// the monotonic time the footer clock shows its next second at
+static long long next_second_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  return event_loop_now_ns() + 1000000000LL - now.tv_nsec;
+}
+
 // theme
 void set_default_theme_hanlder(Button btn) {
   (void)btn;
@@ -39,26 +159,48 @@ void decrease_brightness(Button btn) {
   pallete->decrease_brightness(pallete);
 }
 
-void on_up_pressed(Button btn) { userInput(Up, btn.hold); }
-void on_down_pressed(Button btn) { userInput(Down, btn.hold); }
-void on_left_pressed(Button btn) { userInput(Left, btn.hold); }
-void on_right_pressed(Button btn) { userInput(Right, btn.hold); }
-void on_space_pressed(Button btn) { userInput(Action, btn.hold); }
-void on_enter_pressed(Button btn) { userInput(Start, btn.hold); }
-void on_esc_pressed(Button btn) { userInput(Pause, btn.hold); }
-void on_q_pressed(Button btn) { userInput(Terminate, btn.hold); }
+void on_up_pressed(Button btn) {
+  runner->send_at(runner, Up, btn.hold, btn.time_ns);
+}
+void on_down_pressed(Button btn) {
+  runner->send_at(runner, Down, btn.hold, btn.time_ns);
+}
+void on_left_pressed(Button btn) {
+  runner->send_repeated(runner, Left, btn.hold, btn.count, btn.time_ns);
+}
+void on_right_pressed(Button btn) {
+  runner->send_repeated(runner, Right, btn.hold, btn.count, btn.time_ns);
+}
+void on_space_pressed(Button btn) {
+  runner->send_at(runner, Action, btn.hold, btn.time_ns);
+}
+void on_enter_pressed(Button btn) {
+  runner->send_at(runner, Start, btn.hold, btn.time_ns);
+}
+void on_esc_pressed(Button btn) {
+  runner->send_at(runner, Pause, btn.hold, btn.time_ns);
+}
+void on_q_pressed(Button btn) {
+  runner->send_at(runner, Terminate, btn.hold, btn.time_ns);
+}
+
+// runs on the engine thread, the game may have started since the key
+static void populate_custom_bricks(Tetris *tetris) {
+  if (tetris->state == TETRIS_READY_STATE) {
+    tetris->repository->populate_custom(tetris->repository);
+  }
+}
 
 void __add_new_blocks(Button btn) {
   (void)btn;
 
-  Tetris *tetris = provide_tetris();
   RootView *view = provide_root_view();
 
   static bool is_populated = FALSE;
   bool is_success = FALSE;
 
-  if (!is_populated && (tetris->state == TETRIS_READY_STATE)) {
-    tetris->repository->populate_custom(tetris->repository);
+  if (!is_populated && (frame->state == TETRIS_READY_STATE)) {
+    runner->call(runner, populate_custom_bricks);
     is_populated = TRUE;
     is_success = TRUE;
   }
@@ -81,15 +223,22 @@ void __add_new_blocks(Button btn) {
     wattroff(view->content->window, COLOR_PAIR(THEME_WARNING_PAIR));
   }
 
-  wrefresh(view->content->window);
+  wnoutrefresh(view->content->window);
+  renderer->flush(renderer);
+  invalidate_game_view();
 
   napms(1000);
 }
 
+// runs on the engine thread
+static void add_exp(Tetris *tetris) {
+  tetris->data.info.score += 600;
+  tetris_touch(tetris, TETRIS_CHANGE_SCORE);
+}
+
 void __add_exp(Button btn) {
   (void)btn;
-  Tetris *tetris = provide_tetris();
-  tetris->data.info.score += 600;
+  runner->call(runner, add_exp);
 }
 
 void configure_common_keyboard() {
@@ -111,6 +260,8 @@ void configure_game_keyboard() {
   kb->add_listener(kb, KEY_DOWN, on_down_pressed);
   kb->add_listener(kb, KEY_LEFT, on_left_pressed);
   kb->add_listener(kb, KEY_RIGHT, on_right_pressed);
+  kb->add_auto_repeat(kb, KEY_LEFT);
+  kb->add_auto_repeat(kb, KEY_RIGHT);
   kb->add_listener(kb, '\n', on_enter_pressed);
   kb->add_listener(kb, ' ', on_space_pressed);
   kb->add_listener(kb, 'q', on_q_pressed);
@@ -123,185 +274,517 @@ void configure_game_keyboard() {
   kb->add_listener(kb, 'X', __add_exp);
 }
 
-void header_draw_handler(Layout *self) {
-  GameInfo_t model = updateCurrentState();
+// bot games shown instead of a game, see `--spectate`
+static TetrisFleet *fleet = NULL;
+
+// the snapshots of the bot games of the current frame
+static const TetrisSnapshot **boards = NULL;
 
-  wclear(self->window);
-  wbkgd(self->window, COLOR_PAIR(THEME_SURFACE_PAIR));
+static SpectatorSort spectator_sort = SPECTATOR_SORT_SCORE;
+static int spectator_page = 0;
+static bool is_spectating = FALSE;
 
-  if (model.pause == 0) {
-    insert_tetris_logo(self->window, (getmaxx(self->window) - 30) / 2, 0);
-  } else if (model.pause == 1) {
-    insert_pause_logo(self->window, (getmaxx(self->window) - 30) / 2, 0);
-  } else if (model.pause == -1) {
-    insert_gameover_logo(self->window, (getmaxx(self->window) - 54) / 2, 0);
+// the spectator screen shows the latest snapshot of every bot game
+static SpectatorViewModel provide_spectator_view_model(void) {
+  for (int i = 0; i < fleet->count; i++) {
+    boards[i] = fleet->latest(fleet, i);
   }
-  wnoutrefresh(self->window);
+  return (SpectatorViewModel){.boards = boards,
+                              .count = fleet->count,
+                              .sort = spectator_sort,
+                              .page = spectator_page};
+}
+
+void on_sort_pressed(Button btn) {
+  (void)btn;
+  spectator_sort = (spectator_sort + 1) % SPECTATOR_SORTS_COUNT;
+}
+
+void on_next_page_pressed(Button btn) {
+  (void)btn;
+  spectator_page++;
+}
+
+void on_previous_page_pressed(Button btn) {
+  (void)btn;
+  spectator_page--;
 }
 
-void content_draw_handler(Layout *self) {
-  if (!self) return;
+void on_spectator_quit_pressed(Button btn) {
+  (void)btn;
+  is_spectating = FALSE;
+}
 
-  GameInfo_t model = updateCurrentState();
+void configure_spectator_keyboard() {
+  KeyboardController *kb = provide_keyboard();
 
-  wclear(self->window);
-  wbkgd(self->window, COLOR_PAIR(THEME_SURFACE_PAIR));
+  kb->add_listener(kb, 's', on_sort_pressed);
+  kb->add_listener(kb, 'S', on_sort_pressed);
+  kb->add_listener(kb, KEY_RIGHT, on_next_page_pressed);
+  kb->add_listener(kb, KEY_LEFT, on_previous_page_pressed);
+  kb->add_listener(kb, 'q', on_spectator_quit_pressed);
+  kb->add_listener(kb, 'Q', on_spectator_quit_pressed);
+}
 
-  if (model.level >= 8) {
-    fire_component(self->window,
-                   (FireComponentProps){.x = 0,
-                                        .y = getmaxy(self->window) - 20,
-                                        .height = 20,
-                                        .width = getmaxx(self->window)});
+// the bot games run on the fleet threads, frames only read their snapshots
+static int spectate(int games, int speed, int fps, bool is_stats) {
+  fleet = new_tetris_fleet(games, time(NULL), speed);
+  boards = (const TetrisSnapshot **)calloc(games, sizeof(*boards));
+  if (!boards) {
+    fprintf(stderr, "Cannot allocate mem for spectated games\n");
+    exit(-1);
   }
-
-  // board
-  BoardComponentProps board = {
-      .attrs = COLOR_PAIR(THEME_SURFACE_PAIR),
-      .render_type = (model.pause == 1) ? BOARD_RENDER_TYPE_COLORLESS
-                                        : BOARD_RENDER_TYPE_DEFAULT,
-      .pos =
-          {
-              .x = (getmaxx(self->window) - 20 - 12) / 2,
-              .y = (getmaxy(self->window) - 20) / 2,
-          },
-      .data = {
-          .matrix = model.field,
-      }};
-
-  board_component(self->window, board);
-
-  int stat_offset_x = board.pos.x + (BOARD_COMPONENT_WIDTH * 2) + 3;
-  int stat_offset_y = board.pos.y + 3;
-  int stat_width = 12;
-
-  // stat
-  if (TRUE) {
-    // score
-    counter_component(self->window,
-                      (CounterComponentProps){
-                          .attrs = COLOR_PAIR(THEME_SURFACE_PAIR),
-                          .height = 3,
-                          .width = stat_width,
-                          .pos = {.x = stat_offset_x, .y = stat_offset_y},
-                          .data = {.title = "score", .value = model.score},
-                      });
-
-    // highscore
-    counter_component(
-        self->window,
-        (CounterComponentProps){
-            .attrs = COLOR_PAIR(THEME_SURFACE_PAIR),
-            .height = 3,
-            .width = stat_width,
-            .pos = {.x = stat_offset_x, .y = stat_offset_y + 4},
-            .data = {.title = "high score", .value = model.high_score},
-        });
-
-    // level
-    counter_component(self->window,
-                      (CounterComponentProps){
-                          .attrs = COLOR_PAIR(THEME_SURFACE_PAIR),
-                          .height = 3,
-                          .width = stat_width,
-                          .pos = {.x = stat_offset_x, .y = stat_offset_y + 8},
-                          .data = {.title = "level", .value = model.level},
-                      });
-
-    // next brick
-    brick_component(
-        self->window,
-        (BrickComponentProps){
-            .attrs = COLOR_PAIR(THEME_SURFACE_PAIR),
-            .render_type = (model.pause == 1) ? BRICK_RENDER_TYPE_COLORLESS
-                                              : BRICK_RENDER_TYPE_DEFAULT,
-            .width = stat_width,
-            .height = 6,
-            .data = {.title = "next",
-                     .width = 4,
-                     .height = 4,
-                     .matrix = model.next},
-            .pos = {.x = stat_offset_x, .y = stat_offset_y + 12}});
+  if (fleet->start(fleet)) {
+    renderer->stop(renderer);
+    fprintf(stderr, "Cannot start the engine threads\n");
+    return 1;
   }
 
-  insert_s21_logo(self->window,
-                  getmaxx(self->window) - self->config.padding.right - 6,
-                  getmaxy(self->window) - self->config.padding.bottom - 4);
+  KeyboardController *kb = provide_keyboard();
+  configure_common_keyboard();
+  configure_spectator_keyboard();
 
-  wnoutrefresh(self->window);
-}
+  RootView *view = new_spectator_view(stdscr);
+  set_spectator_view_model_provider(provide_spectator_view_model);
+  werase(stdscr);
+  wbkgd(stdscr, COLOR_PAIR(THEME_BACKGROUND_PAIR));
 
-void content_motd_draw_handler(Layout *self) {
-  if (!self) return;
-  wclear(self->window);
-  wbkgd(self->window, COLOR_PAIR(THEME_SURFACE_PAIR));
+  // the games always move, a frame is drawn every period and right after keys
+  loop = new_event_loop(input_fd(kb), -1);
+  long long period_ns = 1000000000LL / fps, drawn_ns = 0;
+  bool is_due = TRUE;
+  timeout(0);
+  is_spectating = TRUE;
+  while (is_spectating) {
+    long long now_ns = event_loop_now_ns();
+    if (is_due && now_ns >= drawn_ns + period_ns) {
+      struct timespec started, finished;
+      clock_gettime(CLOCK_THREAD_CPUTIME_ID, &started);
+      view->update(view);
+      renderer->present(renderer);
+      clock_gettime(CLOCK_THREAD_CPUTIME_ID, &finished);
+
+      render_stats.frames++;
+      render_stats.cpu_ns += timespec_diff_ns(finished, started);
+      drawn_ns = now_ns;
+      is_due = FALSE;
+    }
+
+    loop->set_deadline(loop, drawn_ns + period_ns);
+    if (loop->wait(loop) & LOOP_EVENT_INPUT) read_keys(kb, ERR);
+    is_due = TRUE;
+  }
+  loop->destroy(loop);
 
-  motd_component(self->window,
-                 (MotdComponentProps){
-                     .attrs = COLOR_PAIR(THEME_SURFACE_PAIR),
-                     .height = 21,
-                     .width = 60,
-                     .pos = {.x = (getmaxx(self->window) - 60) / 2, .y = 2}});
+  fleet->stop(fleet);
+  SpectatorViewStats view_stats = get_spectator_view_stats();
+  kb->destroy(kb);
+  release_spectator_view();
+  view->destroy(view);
+  renderer->stop(renderer);
+
+  if (is_stats && render_stats.frames) {
+    fprintf(stderr,
+            "spectator: %lu frames, %lu full, %.1f boards drawn and %.1f "
+            "skipped, %.0f cells drawn and %.1fus cpu per frame\n",
+            view_stats.frames, view_stats.full_frames,
+            (double)view_stats.boards_drawn / view_stats.frames,
+            (double)view_stats.boards_skipped / view_stats.frames,
+            (double)view_stats.cells_drawn / view_stats.frames,
+            render_stats.cpu_ns / 1e3 / render_stats.frames);
+    print_output_stats();
+  }
+  if (is_stats && fleet->stats.ticks) {
+    TetrisFleetStats stats = fleet->stats;
+    fprintf(stderr,
+            "fleet: %d games at %dx on %d threads, %lu ticks, %lu games "
+            "over, %.2fus per game tick\n",
+            fleet->count, fleet->speed, fleet->threads_count, stats.ticks,
+            stats.games, stats.busy_ns / 1e3 / stats.ticks);
+  }
+  fleet->destroy(fleet);
+  free(boards);
+  return 0;
+}
 
-  wnoutrefresh(self->window);
+// what a game leaves for `--stats` once its components are stopped, the
+// render stats, the loop, the engine runner and the renderer are globals
+typedef struct {
+  KeyboardStats input;
+  const KeyDecoder *decoder;
+  const InputThread *thread;
+  AutoRepeatStats repeat;
+  int das_ms;
+  int arr_ms;
+  const QualityGovernor *governor;
+  const Recorder *recorder;
+#ifdef TETRIS_FSM_INSTRUMENT
+  TetrisFsmStats fsm;
+#endif
+} GameStats;
+
+// a line for every component that ran, see `--stats`
+static void print_stats(const GameStats *stats) {
+  // the terminal bytes are counted by a recording, which has the menu and
+  // exit screens too, otherwise by the ANSI backend, ncurses writes them itself
+  long output_bytes = -1;
+  if (stats->recorder) {
+    RecorderStats recorder = stats->recorder->stats;
+    fprintf(stderr,
+            "recorder: %lu chunks, %lu bytes, %lu dropped, %.2fus per "
+            "chunk\n",
+            recorder.chunks, recorder.bytes, recorder.dropped_chunks,
+            recorder.chunks ? recorder.push_ns / 1e3 / recorder.chunks : 0.);
+    output_bytes = (long)(recorder.bytes + recorder.dropped_bytes);
+  } else if (renderer->type == RENDERER_ANSI) {
+    output_bytes = (long)renderer->stats.bytes;
+  }
+  if (render_stats.frames) {
+    GameViewStats view_stats = get_game_view_stats();
+    fprintf(stderr,
+            "render: %lu frames, %lu full, %lu skipped, %lu cells drawn, "
+            "%.1fus cpu",
+            render_stats.frames, view_stats.full_frames,
+            view_stats.skipped_frames, view_stats.cells_drawn,
+            render_stats.cpu_ns / 1e3 / render_stats.frames);
+    if (output_bytes >= 0) {
+      fprintf(stderr, " and %.0f bytes",
+              (double)output_bytes / render_stats.frames);
+    }
+    fprintf(stderr, " per frame\n");
+  }
+  if (stats->governor->stats.frames) {
+    QualityGovernorStats governor = stats->governor->stats;
+    fprintf(stderr,
+            "governor: %lu of %lu frames over %.1fms, %lu degrades, %lu "
+            "restores, %.0f/%.0f/%.0f/%.0fus input/engine/draw/present per "
+            "frame\n",
+            governor.frames_over_budget, governor.frames,
+            stats->governor->budget_ns / 1e6, governor.degrades,
+            governor.restores,
+            governor.phase_ns[FRAME_PHASE_INPUT] / 1e3 / governor.frames,
+            governor.phase_ns[FRAME_PHASE_ENGINE] / 1e3 / governor.frames,
+            governor.phase_ns[FRAME_PHASE_DRAW] / 1e3 / governor.frames,
+            governor.phase_ns[FRAME_PHASE_PRESENT] / 1e3 / governor.frames);
+  }
+  if (loop->stats.waits) {
+    EventLoopStats waits = loop->stats;
+    fprintf(stderr,
+            "loop: %lu waits, %lu/%lu/%lu woken by input/state/deadline, "
+            "%.3f/%.3fms state to screen avg/max\n",
+            waits.waits, waits.inputs, waits.states, waits.deadlines,
+            render_stats.states
+                ? render_stats.latency_ns / 1e6 / render_stats.states
+                : 0.,
+            render_stats.max_latency_ns / 1e6);
+  }
+  print_input_stats(stats->input, stats->decoder, stats->thread);
+  if (stats->repeat.presses) {
+    AutoRepeatStats repeat = stats->repeat;
+    fprintf(stderr,
+            "repeat: %dms das, %dms arr, %lu presses, %lu repeats in %lu "
+            "batches, %.3f/%.3fms late avg/max\n",
+            stats->das_ms, stats->arr_ms, repeat.presses, repeat.repeats,
+            repeat.batches,
+            repeat.repeats ? repeat.late_ns / 1e6 / repeat.repeats : 0.,
+            repeat.max_late_ns / 1e6);
+  }
+  if (runner->stats.ticks) {
+    TetrisRunnerStats engine = runner->stats;
+    fprintf(stderr,
+            "engine: %lu ticks, %.3f/%.3fms tick jitter avg/max, %lu "
+            "commands, %.3f/%.3fms input to state avg/max, %lu dropped\n",
+            engine.ticks, engine.jitter_ns / 1e6 / engine.ticks,
+            engine.max_jitter_ns / 1e6, engine.commands,
+            engine.commands ? engine.latency_ns / 1e6 / engine.commands : 0.,
+            engine.max_latency_ns / 1e6, engine.dropped);
+  }
+  if (renderer->type == RENDERER_ANSI && renderer->stats.frames) {
+    RendererStats ansi = renderer->stats;
+    fprintf(stderr,
+            "ansi: %lu frames, %.1f cells, %.0f bytes and %.2f writes per "
+            "frame\n",
+            ansi.frames, (double)ansi.cells / ansi.frames,
+            (double)ansi.bytes / ansi.frames,
+            (double)ansi.writes / ansi.frames);
+  }
+  print_output_stats();
+#ifdef TETRIS_FSM_INSTRUMENT
+  tetris_fsm_print_stats(&stats->fsm, stderr);
+#endif
 }
 
-void screen_initialize() {
-  initscr();
+int screen_initialize() {
+  if (renderer->start(renderer)) return -1;
   noecho();
   cbreak();
   nodelay(stdscr, TRUE);
   curs_set(0);
   keypad(stdscr, TRUE);
   wbkgd(stdscr, COLOR_PAIR(THEME_BACKGROUND_PAIR));
-  refresh();
+  wnoutrefresh(stdscr);
+  renderer->present(renderer);
+  return 0;
 }
 
-int main() {
-  srand(time(NULL));
+int main(int argc, char **argv) {
   setlocale(LC_ALL, "");
 
-  screen_initialize();
+  Recorder *recorder = NULL;
+  bool is_stats = FALSE;
+  RendererType renderer_type = RENDERER_NCURSES;
+  bool is_truecolor = FALSE;
+  int fps = TETRIS_FPS;
+  int spectated_games = 0;
+  int speed = 1;
+  int das_ms = AUTO_REPEAT_DAS_MS;
+  int arr_ms = AUTO_REPEAT_ARR_MS;
+  bool is_raw_input = FALSE;
+  bool is_input_thread = FALSE;
+  int input_cpu = -1;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--ghost") && i + 1 < argc && !ghost) {
+      ghost = load_ghost(argv[++i]);
+      if (!ghost) {
+        fprintf(stderr, "Cannot load ghost replay %s\n", argv[i]);
+        return 1;
+      }
+    } else if (!strcmp(argv[i], "--record") && i + 1 < argc && !recorder) {
+      recorder = new_recorder(argv[++i]);
+      if (!recorder || recorder->start(recorder)) {
+        fprintf(stderr, "Cannot record to %s\n", argv[i]);
+        return 1;
+      }
+    } else if (!strcmp(argv[i], "--stats")) {
+      is_stats = TRUE;
+    } else if (!strcmp(argv[i], "--renderer") && i + 1 < argc &&
+               !parse_renderer_type(argv[i + 1], &renderer_type)) {
+      i++;
+    } else if (!strcmp(argv[i], "--truecolor")) {
+      is_truecolor = TRUE;
+    } else if (!strcmp(argv[i], "--fps") && i + 1 < argc &&
+               atoi(argv[i + 1]) > 0 && atoi(argv[i + 1]) <= 1000) {
+      fps = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--spectate") && i + 1 < argc &&
+               atoi(argv[i + 1]) > 0 && atoi(argv[i + 1]) <= 10000) {
+      spectated_games = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--speed") && i + 1 < argc &&
+               atoi(argv[i + 1]) > 0 &&
+               atoi(argv[i + 1]) <= TETRIS_FLEET_MAX_SPEED) {
+      speed = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--das") && i + 1 < argc &&
+               atoi(argv[i + 1]) > 0 && atoi(argv[i + 1]) <= 1000) {
+      das_ms = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--arr") && i + 1 < argc &&
+               atoi(argv[i + 1]) > 0 && atoi(argv[i + 1]) <= 1000) {
+      arr_ms = atoi(argv[++i]);
+      if (arr_ms < AUTO_REPEAT_ARR_MIN_MS) arr_ms = AUTO_REPEAT_ARR_MIN_MS;
+    } else if (!strcmp(argv[i], "--input") && i + 1 < argc &&
+               (!strcmp(argv[i + 1], "ncurses") ||
+                !strcmp(argv[i + 1], "raw") ||
+                !strcmp(argv[i + 1], "thread"))) {
+      is_input_thread = !strcmp(argv[++i], "thread");
+      is_raw_input = is_input_thread || !strcmp(argv[i], "raw");
+    } else if (!strcmp(argv[i], "--input-cpu") && i + 1 < argc &&
+               atoi(argv[i + 1]) >= 0) {
+      input_cpu = atoi(argv[++i]);
+    } else {
+      fprintf(stderr,
+              "usage: %s [--ghost replay] [--record file[.cast]] [--stats] "
+              "[--renderer ncurses|ansi] [--truecolor] [--fps n] "
+              "[--das ms] [--arr ms] [--input ncurses|raw|thread] "
+              "[--input-cpu n] "
+              "[--spectate games [--speed n]]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  renderer = new_renderer(renderer_type, STDOUT_FILENO, is_truecolor);
+  if (screen_initialize()) {
+    fprintf(stderr, "Cannot initialize the terminal\n");
+    return 1;
+  }
+
+  // the keys are decoded from the terminal bytes instead of by ncurses, and
+  // read on a thread of their own if asked for
+  if (is_raw_input) {
+    KeyboardController *kb = provide_keyboard();
+    kb->use_raw_input(kb, STDIN_FILENO, STDOUT_FILENO);
+    if (is_input_thread && kb->use_input_thread(kb, input_cpu, TRUE)) {
+      fprintf(stderr, "Cannot start the input thread\n");
+    }
+  }
 
   Pallete *pallete = provide_pallete();
   pallete->change_theme(pallete, DARK_THEME);
+
+  // bot games instead of a game
+  if (spectated_games) {
+    int result = spectate(spectated_games, speed, fps, is_stats);
+    pallete->destroy(pallete);
+    if (ghost) ghost->destroy(ghost);
+    if (recorder) {
+      recorder->stop(recorder);
+      recorder->destroy(recorder);
+    }
+    renderer->destroy(renderer);
+    return result;
+  }
+
   KeyboardController *kb = provide_keyboard();
+  kb->auto_repeat->das_ns = das_ms * 1000000LL;
+  kb->auto_repeat->arr_ns = arr_ms * 1000000LL;
 
   RootView *root_view = provide_root_view();
-  root_view->header->draw = header_draw_handler;
+  set_game_view_model_provider(provide_game_view_model);
+  root_view->header->draw = game_header_draw_handler;
 
-  // MOTD
-  timeout(1000);
+  // the engine thread owns the engine from here on
+  Tetris *tetris = provide_tetris();
+  tetris->replay = new_replay();
+  if (getenv("USER")) {
+    strncpy(tetris->replay->header.player, getenv("USER"),
+            REPLAY_PLAYER_SIZE - 1);
+  }
+  runner = new_tetris_runner(tetris, ghost, TETRIS_RUNNER_RATE);
+  if (runner->start(runner)) {
+    renderer->stop(renderer);
+    fprintf(stderr, "Cannot start the engine thread\n");
+    return 1;
+  }
+
+  // MOTD, only the footer clock moves until a key
+  loop = new_event_loop(input_fd(kb), runner->published_fd);
+  timeout(0);
   configure_common_keyboard();
-  root_view->content->draw = content_motd_draw_handler;
-  do {
-    wclear(stdscr);
-    wbkgd(stdscr, COLOR_PAIR(THEME_BACKGROUND_PAIR));
+  root_view->content->draw = motd_content_draw_handler;
+  werase(stdscr);
+  wbkgd(stdscr, COLOR_PAIR(THEME_BACKGROUND_PAIR));
+  invalidate_game_view();
+  bool is_started = FALSE;
+  while (!is_started) {
+    frame = runner->latest(runner);
     root_view->update(root_view);
-  } while (kb->listen(kb).key != '\n');
+    renderer->present(renderer);
+    loop->set_deadline(loop, next_second_ns());
+    if (loop->wait(loop) & LOOP_EVENT_INPUT) is_started = read_keys(kb, '\n');
+  }
 
   // GAME
   configure_game_keyboard();
-  root_view->content->draw = content_draw_handler;
-  Tetris *tetris = provide_tetris();
-
-  timeout(1000 / 20);
-  while (tetris->state != TETRIS_TERMINATED_STATE) {
-    kb->listen(kb);
+  root_view->content->draw = game_content_draw_handler;
 
-    wclear(stdscr);
-    wbkgd(stdscr, COLOR_PAIR(THEME_BACKGROUND_PAIR));
-    root_view->update(root_view);
-
-    doupdate();
+  // the screen is erased once, every frame then only draws what changed
+  werase(stdscr);
+  wbkgd(stdscr, COLOR_PAIR(THEME_BACKGROUND_PAIR));
+  invalidate_game_view();
+
+  // slow terminals get cheaper frames instead of missed keys
+  QualityGovernor *governor = new_quality_governor(fps);
+
+  // a frame is drawn when a key, a new engine state or the clock asks for it,
+  // at most `fps` a second, the burning fire asks for every frame. The state
+  // a key leads to is drawn as soon as it is there, whatever the rate.
+  long long period_ns = 1000000000LL / fps, drawn_ns = 0, input_ns = 0;
+  unsigned long drawn_sequence = frame->sequence;
+  unsigned long drawn_input_sequence = frame->input_sequence;
+  bool is_due = TRUE;
+  while (frame->state != TETRIS_TERMINATED_STATE) {
+    long long now_ns = event_loop_now_ns();
+    // a state that applied commands the screen does not show yet is urgent,
+    // whether the engine published it before or after the loop woke up
+    bool is_urgent = FALSE;
+    if (is_due) {
+      frame = runner->latest(runner);
+      is_urgent = frame->input_sequence != drawn_input_sequence;
+    }
+    if (is_due && (is_urgent || now_ns >= drawn_ns + period_ns)) {
+      // the keys read since the previous frame, not the waits for them
+      governor->begin(governor);
+      governor->add(governor, FRAME_PHASE_INPUT, input_ns);
+      input_ns = 0;
+      frame = runner->latest(runner);
+      governor->mark(governor, FRAME_PHASE_ENGINE);
+
+      struct timespec started, finished;
+      clock_gettime(CLOCK_THREAD_CPUTIME_ID, &started);
+      root_view->update(root_view);
+      governor->mark(governor, FRAME_PHASE_DRAW);
+      renderer->present(renderer);
+      governor->mark(governor, FRAME_PHASE_PRESENT);
+      clock_gettime(CLOCK_THREAD_CPUTIME_ID, &finished);
+      set_game_view_quality(governor->end_frame(governor));
+
+      render_stats.frames++;
+      render_stats.cpu_ns += timespec_diff_ns(finished, started);
+      drawn_ns = now_ns;
+      drawn_input_sequence = frame->input_sequence;
+      is_due = FALSE;
+      if (frame->sequence != drawn_sequence) {
+        long long latency_ns = event_loop_now_ns() - frame->published_ns;
+        drawn_sequence = frame->sequence;
+        render_stats.states++;
+        render_stats.latency_ns += latency_ns;
+        if (latency_ns > render_stats.max_latency_ns) {
+          render_stats.max_latency_ns = latency_ns;
+        }
+      }
+    }
+
+    // a held key wakes the loop up right when its next repeat is due, a lone
+    // ESC of the raw input when it stops waiting for a sequence
+    long long deadline_ns = is_due || is_game_view_animated()
+                                ? drawn_ns + period_ns
+                                : next_second_ns();
+    long long keyboard_ns = kb->next_ns(kb);
+    if (keyboard_ns && keyboard_ns < deadline_ns) deadline_ns = keyboard_ns;
+    loop->set_deadline(loop, deadline_ns);
+    int events = loop->wait(loop);
+    long long woken_ns = event_loop_now_ns();
+    if (events & (LOOP_EVENT_INPUT | LOOP_EVENT_DEADLINE)) read_keys(kb, ERR);
+    kb->repeat(kb, event_loop_now_ns());
+    input_ns += event_loop_now_ns() - woken_ns;
+    // a sent command is shown with the state it leads to, not before it
+    bool is_pending = runner->pending(runner) != 0;
+    is_due = is_due || (events & (LOOP_EVENT_STATE | LOOP_EVENT_DEADLINE)) ||
+             !is_pending;
   }
 
+  runner->stop(runner);
+  GameStats stats = {.input = kb->stats,
+                     .repeat = kb->auto_repeat->stats,
+                     .das_ms = das_ms,
+                     .arr_ms = arr_ms,
+                     .governor = governor,
+                     .recorder = recorder};
+  KeyDecoder decoder = kb->decoder ? *kb->decoder : (KeyDecoder){0};
+  if (kb->decoder) stats.decoder = &decoder;
+  InputThread *thread = kb->input_thread;
+  if (thread) thread->stop(thread);
+  InputThread thread_stats = thread ? *thread : (InputThread){0};
+  if (thread) stats.thread = &thread_stats;
   kb->destroy(kb);
+#ifdef TETRIS_FSM_INSTRUMENT
+  stats.fsm = tetris->fsm_stats;
+#endif
   tetris->destroy(tetris);
+  if (ghost) ghost->destroy(ghost);
   pallete->destroy(pallete);
+  release_game_view();
   root_view->destroy(root_view);
 
   terminated_screen(stdscr, 4000);
-  endwin();
+  renderer->flush(renderer);
+  getch();
+  renderer->stop(renderer);
+
+  if (recorder) recorder->stop(recorder);
+  if (is_stats) print_stats(&stats);
+  if (recorder) recorder->destroy(recorder);
+  governor->destroy(governor);
+  loop->destroy(loop);
+  runner->destroy(runner);
+  renderer->destroy(renderer);
   return 0;
 }
\ No newline at end of file
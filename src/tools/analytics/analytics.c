@@ -0,0 +1,593 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "analytics.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define ANALYTICS_PLAYERS_INITIAL_CAPACITY 64
+
+/**
+ * @brief Counts the holes of a field.
+ *
+ * A hole is an empty cell with a filled cell anywhere above it in the same
+ * column.
+ *
+ * @param field The field, TETRIS_FIELD_HEIGHT rows of TETRIS_FIELD_WIDTH cells.
+ * @return The number of holes.
+ */
+int analytics_count_holes(int **field) {
+  int holes = 0;
+  for (int col = 0; col < TETRIS_FIELD_WIDTH; col++) {
+    bool is_covered = false;
+    for (int row = 0; row < TETRIS_FIELD_HEIGHT; row++) {
+      if (field[row][col]) {
+        is_covered = true;
+      } else if (is_covered) {
+        holes++;
+      }
+    }
+  }
+  return holes;
+}
+
+/**
+ * @brief Hashes a player name (FNV-1a).
+ *
+ * @param name The player name.
+ * @return The hash of the name.
+ */
+static size_t hash_player(const char *name) {
+  size_t hash = 2166136261u;
+  for (size_t i = 0; i < REPLAY_PLAYER_SIZE && name[i]; i++) {
+    hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+  }
+  return hash;
+}
+
+/**
+ * @brief Finds the slot of a player in an open addressing table.
+ *
+ * @param players The table.
+ * @param capacity The size of the table, a power of two.
+ * @param name The player name.
+ * @return The slot holding the player or the free slot it belongs to.
+ */
+static AnalyticsPlayer *find_player_slot(AnalyticsPlayer *players,
+                                         size_t capacity, const char *name) {
+  size_t index = hash_player(name) & (capacity - 1);
+  while (players[index].games &&
+         strncmp(players[index].name, name, REPLAY_PLAYER_SIZE)) {
+    index = (index + 1) & (capacity - 1);
+  }
+  return &players[index];
+}
+
+/**
+ * @brief Returns the entry of a player, inserting it if needed.
+ *
+ * The table is doubled once it is three quarters full.
+ *
+ * If memory allocation fails, the function prints an error message to stderr
+ * and exits the program with a failure status.
+ *
+ * @param accumulator The accumulator owning the table.
+ * @param name The player name.
+ * @return The entry of the player.
+ */
+static AnalyticsPlayer *get_player(AnalyticsAccumulator *accumulator,
+                                   const char *name) {
+  if ((accumulator->players_count + 1) * 4 >
+      accumulator->players_capacity * 3) {
+    size_t capacity = accumulator->players_capacity
+                          ? accumulator->players_capacity * 2
+                          : ANALYTICS_PLAYERS_INITIAL_CAPACITY;
+    AnalyticsPlayer *players = calloc(capacity, sizeof(AnalyticsPlayer));
+    if (!players) {
+      fprintf(stderr, "Cannot allocate mem for AnalyticsPlayer\n");
+      exit(-1);
+    }
+    for (size_t i = 0; i < accumulator->players_capacity; i++) {
+      AnalyticsPlayer *player = &accumulator->players[i];
+      if (player->games) {
+        *find_player_slot(players, capacity, player->name) = *player;
+      }
+    }
+    free(accumulator->players);
+    accumulator->players = players;
+    accumulator->players_capacity = capacity;
+  }
+
+  AnalyticsPlayer *player = find_player_slot(
+      accumulator->players, accumulator->players_capacity, name);
+  if (!player->games) {
+    strncpy(player->name, name, REPLAY_PLAYER_SIZE - 1);
+    accumulator->players_count++;
+  }
+  return player;
+}
+
+/**
+ * @brief Engine hook counting a locked piece.
+ *
+ * Called with the piece already placed into the field, so the cells of the
+ * piece are at their final position and new holes are visible.
+ *
+ * @param tetris The simulation engine.
+ * @param brick The locked brick, an item of the engine repository.
+ */
+static void on_lock(Tetris *tetris, Brick *brick) {
+  AnalyticsAccumulator *accumulator = tetris->context;
+  size_t piece = (size_t)(brick - tetris->repository->items);
+  if (piece >= ANALYTICS_PIECES) return;
+
+  accumulator->pieces++;
+  accumulator->piece_counts[piece]++;
+  for (int row = 0; row < BRICK_HEIGHT; row++) {
+    for (int col = 0; col < BRICK_WIDTH; col++) {
+      if (!brick->states[brick->state][row][col]) continue;
+      int x = brick->pos.x + (-BRICK_WIDTH / 2) + col;
+      int y = brick->pos.y + ((-BRICK_HEIGHT / 2) + 1) + row;
+      if (x >= 0 && x < TETRIS_FIELD_WIDTH && y >= 0 &&
+          y < TETRIS_FIELD_HEIGHT) {
+        accumulator->heatmap[piece][y][x]++;
+      }
+    }
+  }
+
+  int holes = analytics_count_holes(tetris->data.info.field);
+  if (holes > accumulator->_holes) {
+    accumulator->holes_created += holes - accumulator->_holes;
+  }
+  accumulator->_holes = holes;
+}
+
+/**
+ * @brief Engine hook counting erased lines.
+ *
+ * @param tetris The simulation engine.
+ * @param lines The number of erased lines.
+ */
+static void on_erase(Tetris *tetris, int lines) {
+  AnalyticsAccumulator *accumulator = tetris->context;
+  accumulator->lines[lines < ANALYTICS_MAX_LINES ? lines
+                                                 : ANALYTICS_MAX_LINES]++;
+  if (lines) {
+    accumulator->_holes = analytics_count_holes(tetris->data.info.field);
+  }
+}
+
+/**
+ * @brief Simulates a single game and adds its statistics to an accumulator.
+ *
+ * @param accumulator The accumulator to update.
+ * @param data The encoded replay.
+ * @param size The size of the encoded replay.
+ * @return The verdict of the simulation.
+ */
+enum ReplayVerdict analytics_add_game(AnalyticsAccumulator *accumulator,
+                                      const uint8_t *data, size_t size) {
+  ReplayReader reader;
+  Tetris *tetris = NULL;
+  if (replay_reader_init(&reader, data, size)) {
+    tetris =
+        new_simulation_tetris(reader.header.seed, reader.header.bricks_count);
+  }
+
+  accumulator->games++;
+  if (!tetris) {
+    accumulator->invalid_games++;
+    return REPLAY_VERDICT_MALFORMED;
+  }
+
+  tetris->context = accumulator;
+  tetris->on_lock = on_lock;
+  tetris->on_erase = on_erase;
+  accumulator->_holes = 0;
+
+  unsigned long pieces = accumulator->pieces;
+  ReplaySimulation result = run_replay(tetris, &reader);
+  tetris->destroy(tetris);
+
+  if (result.verdict != REPLAY_VERDICT_OK) accumulator->invalid_games++;
+  AnalyticsPlayer *player = get_player(accumulator, reader.header.player);
+  player->games++;
+  player->pieces += accumulator->pieces - pieces;
+  player->duration_ns += result.duration_ns;
+  return result.verdict;
+}
+
+/**
+ * @brief Adds the statistics of an accumulator to another one.
+ *
+ * @param target The accumulator to update.
+ * @param source The accumulator to add.
+ */
+void analytics_merge(AnalyticsAccumulator *target,
+                     const AnalyticsAccumulator *source) {
+  target->games += source->games;
+  target->invalid_games += source->invalid_games;
+  target->pieces += source->pieces;
+  target->holes_created += source->holes_created;
+  for (int i = 0; i <= ANALYTICS_MAX_LINES; i++) {
+    target->lines[i] += source->lines[i];
+  }
+  for (int piece = 0; piece < ANALYTICS_PIECES; piece++) {
+    target->piece_counts[piece] += source->piece_counts[piece];
+    for (int row = 0; row < TETRIS_FIELD_HEIGHT; row++) {
+      for (int col = 0; col < TETRIS_FIELD_WIDTH; col++) {
+        target->heatmap[piece][row][col] += source->heatmap[piece][row][col];
+      }
+    }
+  }
+  for (size_t i = 0; i < source->players_capacity; i++) {
+    const AnalyticsPlayer *player = &source->players[i];
+    if (!player->games) continue;
+    AnalyticsPlayer *merged = get_player(target, player->name);
+    merged->games += player->games;
+    merged->pieces += player->pieces;
+    merged->duration_ns += player->duration_ns;
+  }
+}
+
+/**
+ * @brief Frees the player table of an accumulator.
+ *
+ * @param accumulator The accumulator.
+ */
+void analytics_clear(AnalyticsAccumulator *accumulator) {
+  free(accumulator->players);
+  accumulator->players = NULL;
+  accumulator->players_count = 0;
+  accumulator->players_capacity = 0;
+}
+
+/**
+ * @brief Appends a replay to the corpus index.
+ *
+ * If memory allocation fails, the function prints an error message to stderr
+ * and exits the program with a failure status.
+ *
+ * @param self A pointer to the Analytics instance.
+ * @param game The replay to append.
+ */
+static void append_game(Analytics *self, AnalyticsGame game) {
+  if (self->games_count == self->games_capacity) {
+    size_t capacity = self->games_capacity ? self->games_capacity * 2 : 1024;
+    AnalyticsGame *games =
+        realloc(self->games, capacity * sizeof(AnalyticsGame));
+    if (!games) {
+      fprintf(stderr, "Cannot allocate mem for AnalyticsGame\n");
+      exit(-1);
+    }
+    self->games = games;
+    self->games_capacity = capacity;
+  }
+  self->games[self->games_count++] = game;
+}
+
+/**
+ * @brief Maps a corpus file and indexes its replays.
+ *
+ * Replays are located by skipping over their events, which is much cheaper
+ * than simulating them, so the index of a large corpus is built in a single
+ * sequential pass over the mapped memory.
+ *
+ * If memory allocation fails, the function prints an error message to stderr
+ * and exits the program with a failure status.
+ *
+ * @param self A pointer to the Analytics instance.
+ * @param filename The corpus file.
+ * @return The number of indexed replays or -1 if the file cannot be mapped.
+ */
+static int _add_file(Analytics *self, const char *filename) {
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) return -1;
+
+  struct stat info;
+  uint8_t *data = MAP_FAILED;
+  if (!fstat(fd, &info) && info.st_size > 0) {
+    data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (data == MAP_FAILED) return -1;
+
+  AnalyticsFile *files =
+      realloc(self->files, (self->files_count + 1) * sizeof(AnalyticsFile));
+  if (!files) {
+    fprintf(stderr, "Cannot allocate mem for AnalyticsFile\n");
+    exit(-1);
+  }
+  self->files = files;
+  self->files[self->files_count++] =
+      (AnalyticsFile){.data = data, .size = (size_t)info.st_size};
+  posix_madvise(data, (size_t)info.st_size, POSIX_MADV_SEQUENTIAL);
+
+  int count = 0;
+  size_t offset = 0;
+  ReplayReader reader;
+  ReplayEvent event;
+  while (offset < (size_t)info.st_size &&
+         replay_reader_init(&reader, data + offset,
+                            (size_t)info.st_size - offset)) {
+    while (replay_reader_next(&reader, &event)) {
+    }
+    if (reader.events_read != reader.header.events_count) break;
+
+    append_game(self, (AnalyticsGame){.data = data + offset,
+                                      .size = reader.offset});
+    offset += reader.offset;
+    count++;
+  }
+  if (offset < (size_t)info.st_size) self->broken_files++;
+  return count;
+}
+
+/**
+ * @brief State of a worker thread.
+ *
+ * @struct AnalyticsWorker
+ * @var analytics The aggregator the worker belongs to.
+ * @var accumulator The statistics of the games simulated by the worker.
+ */
+typedef struct {
+  Analytics *analytics;
+  AnalyticsAccumulator accumulator;
+} AnalyticsWorker;
+
+/**
+ * @brief Worker thread simulating batches of games.
+ *
+ * Batches are claimed with an atomic counter and the statistics go to the
+ * accumulator of the worker, so workers never wait for each other.
+ *
+ * @param arg A pointer to the AnalyticsWorker of the thread.
+ * @return NULL.
+ */
+static void *worker_routine(void *arg) {
+  AnalyticsWorker *worker = arg;
+  Analytics *self = worker->analytics;
+
+  size_t first = atomic_fetch_add(&self->_next_game, ANALYTICS_BATCH);
+  while (first < self->games_count) {
+    size_t last = first + ANALYTICS_BATCH < self->games_count
+                      ? first + ANALYTICS_BATCH
+                      : self->games_count;
+    for (size_t i = first; i < last; i++) {
+      analytics_add_game(&worker->accumulator, self->games[i].data,
+                         self->games[i].size);
+    }
+    first = atomic_fetch_add(&self->_next_game, ANALYTICS_BATCH);
+  }
+  return NULL;
+}
+
+/**
+ * @brief Simulates the whole corpus and merges the worker statistics.
+ *
+ * If memory allocation fails, the function prints an error message to stderr
+ * and exits the program with a failure status.
+ *
+ * @param self A pointer to the Analytics instance.
+ */
+static void _run(Analytics *self) {
+  AnalyticsWorker **workers = calloc(self->threads, sizeof(AnalyticsWorker *));
+  pthread_t *threads = calloc(self->threads, sizeof(pthread_t));
+  if (!workers || !threads) {
+    fprintf(stderr, "Cannot allocate mem for AnalyticsWorker\n");
+    exit(-1);
+  }
+
+  atomic_store(&self->_next_game, 0);
+  for (size_t i = 0; i < self->threads; i++) {
+    // separate allocations keep the hot counters of workers on distinct lines
+    workers[i] = calloc(1, sizeof(AnalyticsWorker));
+    if (!workers[i]) {
+      fprintf(stderr, "Cannot allocate mem for AnalyticsWorker\n");
+      exit(-1);
+    }
+    workers[i]->analytics = self;
+    pthread_create(&threads[i], NULL, worker_routine, workers[i]);
+  }
+
+  for (size_t i = 0; i < self->threads; i++) {
+    pthread_join(threads[i], NULL);
+    analytics_merge(&self->total, &workers[i]->accumulator);
+    analytics_clear(&workers[i]->accumulator);
+    free(workers[i]);
+  }
+  free(workers);
+  free(threads);
+}
+
+/**
+ * @brief Opens a CSV file of the output directory.
+ *
+ * @param directory The output directory.
+ * @param name The file name.
+ * @param columns The header line.
+ * @return The opened file or NULL.
+ */
+static FILE *open_csv(const char *directory, const char *name,
+                      const char *columns) {
+  char path[4096];
+  snprintf(path, sizeof(path), "%s/%s", directory, name);
+  FILE *file = fopen(path, "w");
+  if (file) fprintf(file, "%s\n", columns);
+  return file;
+}
+
+/**
+ * @brief Writes the merged statistics as CSV files.
+ *
+ * The directory receives summary.csv, pieces.csv, lines.csv, heatmap.csv and
+ * players.csv.
+ *
+ * @param self A pointer to the Analytics instance.
+ * @param directory An existing output directory.
+ * @return 0 on success, -1 if a file cannot be written.
+ */
+static int _write_csv(Analytics *self, const char *directory) {
+  const AnalyticsAccumulator *total = &self->total;
+  int status = 0;
+
+  FILE *file = open_csv(directory, "summary.csv", "metric,value");
+  if (file) {
+    fprintf(file, "games,%lu\n", total->games);
+    fprintf(file, "invalid_games,%lu\n", total->invalid_games);
+    fprintf(file, "pieces,%lu\n", total->pieces);
+    fprintf(file, "holes_created,%lu\n", total->holes_created);
+    fprintf(file, "holes_per_piece,%.6f\n",
+            total->pieces ? (double)total->holes_created / total->pieces : 0.);
+    status |= fclose(file);
+  } else {
+    status = -1;
+  }
+
+  file = open_csv(directory, "pieces.csv", "piece,count,share");
+  if (file) {
+    for (int piece = 0; piece < ANALYTICS_PIECES; piece++) {
+      fprintf(file, "%d,%lu,%.6f\n", piece, total->piece_counts[piece],
+              total->pieces
+                  ? (double)total->piece_counts[piece] / total->pieces
+                  : 0.);
+    }
+    status |= fclose(file);
+  } else {
+    status = -1;
+  }
+
+  file = open_csv(directory, "lines.csv", "lines,count");
+  if (file) {
+    for (int lines = 0; lines <= ANALYTICS_MAX_LINES; lines++) {
+      fprintf(file, "%d,%lu\n", lines, total->lines[lines]);
+    }
+    status |= fclose(file);
+  } else {
+    status = -1;
+  }
+
+  file = open_csv(directory, "heatmap.csv", "piece,row,col,count");
+  if (file) {
+    for (int piece = 0; piece < ANALYTICS_PIECES; piece++) {
+      for (int row = 0; row < TETRIS_FIELD_HEIGHT; row++) {
+        for (int col = 0; col < TETRIS_FIELD_WIDTH; col++) {
+          fprintf(file, "%d,%d,%d,%lu\n", piece, row, col,
+                  total->heatmap[piece][row][col]);
+        }
+      }
+    }
+    status |= fclose(file);
+  } else {
+    status = -1;
+  }
+
+  file = open_csv(directory, "players.csv",
+                  "player,games,pieces,seconds,pieces_per_sec");
+  if (file) {
+    for (size_t i = 0; i < total->players_capacity; i++) {
+      const AnalyticsPlayer *player = &total->players[i];
+      if (!player->games) continue;
+      double seconds = player->duration_ns / 1e9;
+      fprintf(file, "%s,%lu,%lu,%.3f,%.6f\n", player->name, player->games,
+              player->pieces, seconds,
+              seconds > 0 ? player->pieces / seconds : 0.);
+    }
+    status |= fclose(file);
+  } else {
+    status = -1;
+  }
+
+  return status ? -1 : 0;
+}
+
+/**
+ * @brief Writes the heatmaps as a compact binary matrix.
+ *
+ * The file starts with the magic "S21H", a version byte and the pieces, rows
+ * and columns counts as bytes, followed by the counts as little endian 64 bit
+ * values in piece, row, column order.
+ *
+ * @param self A pointer to the Analytics instance.
+ * @param filename The output file.
+ * @return 0 on success, -1 if the file cannot be written.
+ */
+static int _write_matrix(Analytics *self, const char *filename) {
+  FILE *file = fopen(filename, "wb");
+  if (!file) return -1;
+
+  uint8_t header[8] = {0};
+  memcpy(header, ANALYTICS_MATRIX_MAGIC, 4);
+  header[4] = ANALYTICS_MATRIX_VERSION;
+  header[5] = ANALYTICS_PIECES;
+  header[6] = TETRIS_FIELD_HEIGHT;
+  header[7] = TETRIS_FIELD_WIDTH;
+  bool is_written = fwrite(header, sizeof(header), 1, file) == 1;
+
+  for (int piece = 0; piece < ANALYTICS_PIECES; piece++) {
+    for (int row = 0; row < TETRIS_FIELD_HEIGHT; row++) {
+      for (int col = 0; col < TETRIS_FIELD_WIDTH; col++) {
+        uint64_t count = self->total.heatmap[piece][row][col];
+        uint8_t bytes[8];
+        for (int i = 0; i < 8; i++) bytes[i] = (uint8_t)(count >> (8 * i));
+        is_written = is_written && fwrite(bytes, sizeof(bytes), 1, file) == 1;
+      }
+    }
+  }
+
+  return fclose(file) || !is_written ? -1 : 0;
+}
+
+/**
+ * @brief Unmaps the corpus and frees the aggregator.
+ *
+ * @param self A pointer to the Analytics instance.
+ */
+static void _destroy(Analytics *self) {
+  if (!self) return;
+
+  for (size_t i = 0; i < self->files_count; i++) {
+    munmap(self->files[i].data, self->files[i].size);
+  }
+  analytics_clear(&self->total);
+  free(self->files);
+  free(self->games);
+  free(self);
+}
+
+/**
+ * @brief Creates an empty statistics aggregator.
+ *
+ * If memory allocation fails, the function prints an error message to stderr
+ * and exits the program with a failure status.
+ *
+ * @param threads Number of worker threads, 0 uses one per online CPU.
+ * @return A pointer to the newly created Analytics instance.
+ */
+Analytics *new_analytics(size_t threads) {
+  Analytics *self = (Analytics *)calloc(1, sizeof(Analytics));
+  if (!self) {
+    fprintf(stderr, "Cannot allocate mem for Analytics\n");
+    exit(-1);
+  }
+
+  if (!threads) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = cpus > 0 ? (size_t)cpus : 1;
+  }
+  self->threads = threads;
+  atomic_init(&self->_next_game, 0);
+
+  self->add_file = _add_file;
+  self->run = _run;
+  self->write_csv = _write_csv;
+  self->write_matrix = _write_matrix;
+  self->destroy = _destroy;
+  return self;
+}
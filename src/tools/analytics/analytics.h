@@ -0,0 +1,184 @@
+#ifndef TOOLS_ANALYTICS_ANALYTICS_H
+#define TOOLS_ANALYTICS_ANALYTICS_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../../brick_game/tetris/tetris.h"
+
+#define ANALYTICS_PIECES (BRICK_DEFAULTS_COUNT + BRICK_CUSTOM_COUNT)
+#define ANALYTICS_MAX_LINES 4
+#define ANALYTICS_BATCH 64
+#define ANALYTICS_MATRIX_MAGIC "S21H"
+#define ANALYTICS_MATRIX_VERSION 1
+
+/**
+ * @brief Aggregated statistics of a single player.
+ *
+ * @struct AnalyticsPlayer
+ * @var name The player name from the replay header, empty for a free slot.
+ * @var games Number of games played.
+ * @var pieces Number of pieces locked over all games.
+ * @var duration_ns Total playing time.
+ */
+typedef struct {
+  char name[REPLAY_PLAYER_SIZE];
+  unsigned long games;
+  unsigned long pieces;
+  long long duration_ns;
+} AnalyticsPlayer;
+
+/**
+ * @brief Statistics accumulated over a set of games.
+ *
+ * Every worker thread owns an accumulator, so nothing is shared while the
+ * corpus is processed; the accumulators are merged once all workers are done.
+ *
+ * @struct AnalyticsAccumulator
+ * @var games Number of simulated games.
+ * @var invalid_games Number of games whose replay was rejected by the
+ * simulation. Their statistics cover the events before the rejection.
+ * @var pieces Number of locked pieces.
+ * @var holes_created Number of holes created by locked pieces. A hole is an
+ * empty cell with a filled cell above it in the same column.
+ * @var lines Number of locks by the count of lines they cleared.
+ * @var piece_counts Number of locks by piece.
+ * @var heatmap Number of piece cells locked at every field cell by piece.
+ * @var players Open addressing table of the players.
+ * @var players_count Number of players in the table.
+ * @var players_capacity Size of the table, always a power of two.
+ * @var _holes Number of holes of the field of the game being simulated.
+ */
+typedef struct {
+  unsigned long games;
+  unsigned long invalid_games;
+  unsigned long pieces;
+  unsigned long holes_created;
+  unsigned long lines[ANALYTICS_MAX_LINES + 1];
+  unsigned long piece_counts[ANALYTICS_PIECES];
+  unsigned long heatmap[ANALYTICS_PIECES][TETRIS_FIELD_HEIGHT]
+                       [TETRIS_FIELD_WIDTH];
+
+  AnalyticsPlayer *players;
+  size_t players_count;
+  size_t players_capacity;
+
+  int _holes;
+} AnalyticsAccumulator;
+
+/**
+ * @brief A replay located in a corpus file.
+ *
+ * @struct AnalyticsGame
+ * @var data The encoded replay, pointing into the mapped corpus file.
+ * @var size The size of the encoded replay.
+ */
+typedef struct {
+  const uint8_t *data;
+  size_t size;
+} AnalyticsGame;
+
+/**
+ * @brief A memory mapped corpus file.
+ *
+ * @struct AnalyticsFile
+ * @var data The mapped contents.
+ * @var size The size of the file.
+ */
+typedef struct {
+  uint8_t *data;
+  size_t size;
+} AnalyticsFile;
+
+/**
+ * @brief Streaming statistics aggregator over replay corpora.
+ *
+ * Corpus files are concatenations of encoded replays. They are memory mapped
+ * and indexed by `add_file`; `run` then re-simulates every game on `threads`
+ * workers which claim batches of games with an atomic counter and observe the
+ * engines through their lock and erase hooks.
+ *
+ * @struct __analytics
+ * @var threads Number of worker threads.
+ * @var files The mapped corpus files.
+ * @var files_count Number of mapped corpus files.
+ * @var games The index of all replays of the corpus.
+ * @var games_count Number of indexed replays.
+ * @var games_capacity Capacity of the index.
+ * @var broken_files Number of corpus files with trailing bytes that are not a
+ * replay; indexing stops at the first broken replay of a file.
+ * @var total The merged statistics, valid after `run`.
+ * @var _next_game Index of the next batch of games to claim.
+ * @var add_file Function pointer mapping and indexing a corpus file.
+ * @var run Function pointer processing the whole corpus.
+ * @var write_csv Function pointer writing the merged statistics as CSV.
+ * @var write_matrix Function pointer writing the heatmaps as a binary matrix.
+ * @var destroy Function pointer unmapping the corpus and freeing the
+ * aggregator.
+ */
+typedef struct __analytics {
+  size_t threads;
+
+  AnalyticsFile *files;
+  size_t files_count;
+  AnalyticsGame *games;
+  size_t games_count;
+  size_t games_capacity;
+  size_t broken_files;
+
+  AnalyticsAccumulator total;
+  atomic_size_t _next_game;
+
+  int (*add_file)(struct __analytics *self, const char *filename);
+  void (*run)(struct __analytics *self);
+  int (*write_csv)(struct __analytics *self, const char *directory);
+  int (*write_matrix)(struct __analytics *self, const char *filename);
+  void (*destroy)(struct __analytics *self);
+} Analytics;
+
+/**
+ * @brief Creates an empty statistics aggregator.
+ *
+ * @param threads Number of worker threads, 0 uses one per online CPU.
+ * @return A pointer to the newly created aggregator.
+ */
+Analytics *new_analytics(size_t threads);
+
+/**
+ * @brief Simulates a single game and adds its statistics to an accumulator.
+ *
+ * @param accumulator The accumulator to update.
+ * @param data The encoded replay.
+ * @param size The size of the encoded replay.
+ * @return The verdict of the simulation.
+ */
+enum ReplayVerdict analytics_add_game(AnalyticsAccumulator *accumulator,
+                                      const uint8_t *data, size_t size);
+
+/**
+ * @brief Adds the statistics of an accumulator to another one.
+ *
+ * @param target The accumulator to update.
+ * @param source The accumulator to add.
+ */
+void analytics_merge(AnalyticsAccumulator *target,
+                     const AnalyticsAccumulator *source);
+
+/**
+ * @brief Frees the player table of an accumulator.
+ *
+ * @param accumulator The accumulator.
+ */
+void analytics_clear(AnalyticsAccumulator *accumulator);
+
+/**
+ * @brief Counts the holes of a field.
+ *
+ * @param field The field, TETRIS_FIELD_HEIGHT rows of TETRIS_FIELD_WIDTH cells.
+ * @return The number of empty cells with a filled cell above them.
+ */
+int analytics_count_holes(int **field);
+
+#endif  // !TOOLS_ANALYTICS_ANALYTICS_H
@@ -0,0 +1,88 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "analytics.h"
+
+/**
+ * @brief Prints the command line usage.
+ *
+ * @param name The program name.
+ */
+static void usage(const char *name) {
+  fprintf(stderr,
+          "usage: %s [-j threads] [-o directory] [-m matrix] corpus...\n"
+          "  -j threads    worker threads, defaults to the number of CPUs\n"
+          "  -o directory  write summary, pieces, lines, heatmap and players "
+          "CSV files\n"
+          "  -m matrix     write the heatmaps as a binary matrix\n",
+          name);
+}
+
+int main(int argc, char **argv) {
+  size_t threads = 0;
+  const char *directory = NULL;
+  const char *matrix = NULL;
+
+  int option;
+  while ((option = getopt(argc, argv, "j:o:m:")) != -1) {
+    if (option == 'j') {
+      threads = strtoul(optarg, NULL, 10);
+    } else if (option == 'o') {
+      directory = optarg;
+    } else if (option == 'm') {
+      matrix = optarg;
+    } else {
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (optind >= argc) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  Analytics *analytics = new_analytics(threads);
+  int status = EXIT_SUCCESS;
+  for (int i = optind; i < argc; i++) {
+    if (analytics->add_file(analytics, argv[i]) < 0) {
+      fprintf(stderr, "analytics: cannot read %s\n", argv[i]);
+      status = EXIT_FAILURE;
+    }
+  }
+  if (analytics->broken_files) {
+    fprintf(stderr, "analytics: %zu corpus files end with a broken replay\n",
+            analytics->broken_files);
+  }
+
+  struct timespec started, finished;
+  clock_gettime(CLOCK_MONOTONIC, &started);
+  analytics->run(analytics);
+  clock_gettime(CLOCK_MONOTONIC, &finished);
+  double seconds = (finished.tv_sec - started.tv_sec) +
+                   (finished.tv_nsec - started.tv_nsec) / 1e9;
+
+  const AnalyticsAccumulator *total = &analytics->total;
+  fprintf(stderr,
+          "analytics: games=%lu invalid=%lu pieces=%lu players=%zu "
+          "threads=%zu %.2fs (%.0f games/s)\n",
+          total->games, total->invalid_games, total->pieces,
+          total->players_count, analytics->threads, seconds,
+          seconds > 0 ? total->games / seconds : 0.);
+
+  if (directory && analytics->write_csv(analytics, directory)) {
+    fprintf(stderr, "analytics: cannot write CSV files to %s\n", directory);
+    status = EXIT_FAILURE;
+  }
+  if (matrix && analytics->write_matrix(analytics, matrix)) {
+    fprintf(stderr, "analytics: cannot write %s\n", matrix);
+    status = EXIT_FAILURE;
+  }
+
+  analytics->destroy(analytics);
+  return status;
+}
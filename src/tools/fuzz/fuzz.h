@@ -0,0 +1,44 @@
+#ifndef TOOLS_FUZZ_FUZZ_H
+#define TOOLS_FUZZ_FUZZ_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../../brick_game/tetris/tetris.h"
+
+/*
+ * Fuzz input layout:
+ *
+ *   u32 seed (little endian) | u8 flags | u8 step...
+ *
+ * Every step byte runs `(step >> 6)` engine ticks, then dispatches the action
+ * `step & 7` with the hold flag `step & 8`, `((step >> 4) & 3) + 1` times.
+ *
+ * Ticks are one engine frame of virtual time apart, so every tick runs exactly
+ * one frame of gravity and lock delay, as a tick of the game does when it is
+ * on time. Bricks get down through the down and action bytes, a frame alone
+ * rarely moves them.
+ */
+#define FUZZ_HEADER_SIZE 5
+#define FUZZ_FLAG_CUSTOM_BRICKS 0x01
+#define FUZZ_FLAG_AUTOSTART 0x02
+#define FUZZ_STEP_ACTION_MASK 0x07
+#define FUZZ_STEP_HOLD 0x08
+#define FUZZ_STEP_REPEAT_SHIFT 4
+#define FUZZ_STEP_REPEAT_MASK 0x03
+#define FUZZ_STEP_TICKS_SHIFT 6
+#define FUZZ_TICK_NS TETRIS_FRAME_NS
+
+/**
+ * @brief libFuzzer entry point, also called by the standalone driver.
+ *
+ * Runs the engine on the input and aborts with a message on stderr as soon as
+ * an invariant is violated.
+ *
+ * @param data The fuzz input.
+ * @param size The size of the fuzz input.
+ * @return Always 0.
+ */
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+#endif  // !TOOLS_FUZZ_FUZZ_H
@@ -0,0 +1,276 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "fuzz.h"
+
+#define STATE_BIT(state) (1u << (state))
+
+/**
+ * @brief The states every state may move to within a single tick or action.
+ */
+static const unsigned int allowed_transitions[] = {
+    [TETRIS_READY_STATE] = STATE_BIT(TETRIS_READY_STATE) |
+                           STATE_BIT(TETRIS_MOVING_STATE) |
+                           STATE_BIT(TETRIS_TERMINATED_STATE),
+    [TETRIS_SPAWN_STATE] =
+        STATE_BIT(TETRIS_SPAWN_STATE) | STATE_BIT(TETRIS_MOVING_STATE) |
+        STATE_BIT(TETRIS_GAMEOVER_STATE) | STATE_BIT(TETRIS_PAUSE_STATE) |
+        STATE_BIT(TETRIS_TERMINATED_STATE),
+    [TETRIS_MOVING_STATE] =
+        STATE_BIT(TETRIS_MOVING_STATE) | STATE_BIT(TETRIS_ATTACH_STATE) |
+        STATE_BIT(TETRIS_PAUSE_STATE) | STATE_BIT(TETRIS_TERMINATED_STATE),
+    [TETRIS_ATTACH_STATE] = STATE_BIT(TETRIS_ATTACH_STATE) |
+                            STATE_BIT(TETRIS_MOVING_STATE) |
+                            STATE_BIT(TETRIS_GAMEOVER_STATE),
+    [TETRIS_GAMEOVER_STATE] = STATE_BIT(TETRIS_GAMEOVER_STATE) |
+                              STATE_BIT(TETRIS_MOVING_STATE) |
+                              STATE_BIT(TETRIS_TERMINATED_STATE),
+    [TETRIS_PAUSE_STATE] = STATE_BIT(TETRIS_PAUSE_STATE) |
+                           STATE_BIT(TETRIS_MOVING_STATE) |
+                           STATE_BIT(TETRIS_TERMINATED_STATE),
+    [TETRIS_TERMINATED_STATE] = STATE_BIT(TETRIS_TERMINATED_STATE),
+};
+
+/**
+ * @brief State of the current fuzz execution.
+ *
+ * @struct FuzzRun
+ * @var tetris The engine under test.
+ * @var now_ns The virtual time.
+ * @var step The index of the current step, for error messages.
+ * @var expected_score The score computed from the erased lines.
+ * @var state The engine state before the current step.
+ * @var is_field_dirty Whether the field changed since it was last checked.
+ * @var checked_brick The active brick when it was last checked.
+ * @var checked_pos The position of the active brick when it was last checked.
+ * @var checked_rotation The rotation of the active brick when it was last
+ * checked.
+ */
+typedef struct {
+  Tetris *tetris;
+  long long now_ns;
+  size_t step;
+  int expected_score;
+  TetriState state;
+  bool is_field_dirty;
+  const Brick *checked_brick;
+  BrickPosition checked_pos;
+  int checked_rotation;
+} FuzzRun;
+
+/**
+ * @brief Reports a violated invariant and aborts, which the fuzzer records as
+ * a crash.
+ *
+ * @param run The current execution.
+ * @param message What went wrong.
+ */
+static void fail(const FuzzRun *run, const char *message) {
+  fprintf(stderr, "fuzz: %s (step %zu, state %d -> %d, score %d)\n", message,
+          run->step, run->state, run->tetris->state,
+          run->tetris->data.info.score);
+  abort();
+}
+
+/**
+ * @brief Checks that every cell of a brick lies inside the field.
+ *
+ * `place_brick` and `remove_brick` write the cells of the brick without bounds
+ * checks, so a brick outside of the field is an out of bounds write.
+ *
+ * @param run The current execution.
+ * @param brick The brick to check.
+ * @param is_placed Whether the brick cells must hold the brick color.
+ */
+static void check_brick(const FuzzRun *run, const Brick *brick,
+                        bool is_placed) {
+  int **field = run->tetris->data.info.field;
+  for (int row = 0; row < BRICK_HEIGHT; row++) {
+    for (int col = 0; col < BRICK_WIDTH; col++) {
+      if (!brick->states[brick->state][row][col]) continue;
+      int x = brick->pos.x + (-BRICK_WIDTH / 2) + col;
+      int y = brick->pos.y + ((-BRICK_HEIGHT / 2) + 1) + row;
+      if (x < 0 || x >= TETRIS_FIELD_WIDTH || y < 0 ||
+          y >= TETRIS_FIELD_HEIGHT) {
+        fail(run, "brick outside of the field");
+      }
+      if (is_placed && field[y][x] != brick->color) {
+        fail(run, "brick not placed into the field");
+      }
+    }
+  }
+}
+
+/**
+ * @brief Engine hook checking a locked brick.
+ *
+ * Locking writes only the cells of the brick, which are checked here, so the
+ * field is not scanned again. The next brick may be the same repository item,
+ * so it is checked whatever its position.
+ *
+ * @param tetris The engine under test.
+ * @param brick The locked brick.
+ */
+static void on_lock(Tetris *tetris, Brick *brick) {
+  FuzzRun *run = tetris->context;
+  check_brick(run, brick, true);
+  run->checked_brick = NULL;
+}
+
+/**
+ * @brief Engine hook keeping the expected score.
+ *
+ * @param tetris The engine under test.
+ * @param lines The number of erased lines.
+ */
+static void on_erase(Tetris *tetris, int lines) {
+  FuzzRun *run = tetris->context;
+  if (lines < 0 || lines > BRICK_HEIGHT) fail(run, "impossible line count");
+  run->expected_score += (int)get_reward_count(lines);
+  run->is_field_dirty = true;
+}
+
+/**
+ * @brief Checks that every field cell holds a brick color.
+ *
+ * @param run The current execution.
+ */
+static void check_field(const FuzzRun *run) {
+  int **field = run->tetris->data.info.field;
+  for (int row = 0; row < TETRIS_FIELD_HEIGHT; row++) {
+    for (int col = 0; col < TETRIS_FIELD_WIDTH; col++) {
+      if (field[row][col] < 0 || field[row][col] > BrickMagentaColor) {
+        fail(run, "invalid field cell");
+      }
+    }
+  }
+}
+
+/**
+ * @brief Checks the engine invariants after a tick or an action.
+ *
+ * The whole field is only scanned after lines are erased or the game is
+ * started, and the active brick only after it moved. Most actions
+ * change nothing, so the check stays cheaper than the action itself.
+ *
+ * @param run The current execution.
+ */
+static void check_invariants(FuzzRun *run) {
+  Tetris *tetris = run->tetris;
+  GameInfo_t *info = &tetris->data.info;
+
+  if ((unsigned int)tetris->state > TETRIS_TERMINATED_STATE ||
+      !(allowed_transitions[run->state] & STATE_BIT(tetris->state))) {
+    fail(run, "invalid state transition");
+  }
+  if ((run->state == TETRIS_READY_STATE ||
+       run->state == TETRIS_GAMEOVER_STATE) &&
+      tetris->state == TETRIS_MOVING_STATE) {
+    run->expected_score = 0;
+    run->is_field_dirty = true;
+  }
+  run->state = tetris->state;
+
+  const Brick *brick = tetris->data.current_brick;
+  if (tetris->state == TETRIS_MOVING_STATE ||
+      tetris->state == TETRIS_PAUSE_STATE) {
+    if (!brick) fail(run, "no active brick");
+    if (run->is_field_dirty || brick != run->checked_brick ||
+        brick->pos.x != run->checked_pos.x ||
+        brick->pos.y != run->checked_pos.y ||
+        brick->state != run->checked_rotation) {
+      check_brick(run, brick, true);
+      run->checked_brick = brick;
+      run->checked_pos = brick->pos;
+      run->checked_rotation = brick->state;
+    }
+  }
+
+  if (run->is_field_dirty) {
+    check_field(run);
+    run->is_field_dirty = false;
+  }
+
+  if (info->score != run->expected_score) fail(run, "inconsistent score");
+  if (info->high_score < info->score) fail(run, "high score below score");
+  if (info->level < 1 || info->level > (int)get_level_by_score(info->score)) {
+    fail(run, "inconsistent level");
+  }
+  if ((info->pause == 1) != (tetris->state == TETRIS_PAUSE_STATE)) {
+    fail(run, "inconsistent pause flag");
+  }
+}
+
+/**
+ * @brief Provides the engine for a brick set, reset in place between runs.
+ *
+ * @param is_custom Whether the custom bricks are used.
+ * @return The engine.
+ */
+static Tetris *provide_fuzz_tetris(bool is_custom) {
+  static Tetris *engines[2] = {NULL, NULL};
+  if (!engines[is_custom]) {
+    engines[is_custom] = new_simulation_tetris(
+        0, BRICK_DEFAULTS_COUNT + (is_custom ? BRICK_CUSTOM_COUNT : 0));
+    engines[is_custom]->on_lock = on_lock;
+    engines[is_custom]->on_erase = on_erase;
+  }
+  return engines[is_custom];
+}
+
+/**
+ * @brief libFuzzer entry point, also called by the standalone driver.
+ *
+ * @param data The fuzz input.
+ * @param size The size of the fuzz input.
+ * @return Always 0.
+ */
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  if (size < FUZZ_HEADER_SIZE) return 0;
+
+  unsigned int seed = (unsigned int)data[0] | (unsigned int)data[1] << 8 |
+                      (unsigned int)data[2] << 16 |
+                      (unsigned int)data[3] << 24;
+  uint8_t flags = data[4];
+
+  // the field is scanned once the game starts, which clears it again
+  FuzzRun run = {.tetris = provide_fuzz_tetris(flags & FUZZ_FLAG_CUSTOM_BRICKS),
+                 .state = TETRIS_READY_STATE,
+                 .is_field_dirty = false};
+  Tetris *tetris = run.tetris;
+  tetris->context = &run;
+  tetris->reset(tetris, seed);
+  check_invariants(&run);
+
+  if (flags & FUZZ_FLAG_AUTOSTART) {
+    tetris->start(tetris);
+    check_invariants(&run);
+  }
+
+  for (size_t i = FUZZ_HEADER_SIZE;
+       i < size && tetris->state != TETRIS_TERMINATED_STATE; i++) {
+    run.step = i - FUZZ_HEADER_SIZE;
+    uint8_t step = data[i];
+
+    for (int tick = 0; tick < step >> FUZZ_STEP_TICKS_SHIFT; tick++) {
+      run.now_ns += FUZZ_TICK_NS;
+      tetris->timer.set_time(
+          &tetris->timer,
+          (struct timespec){.tv_sec = run.now_ns / 1000000000LL,
+                            .tv_nsec = run.now_ns % 1000000000LL});
+      tetris->_tick(tetris);
+      check_invariants(&run);
+    }
+
+    int repeat = (step >> FUZZ_STEP_REPEAT_SHIFT) & FUZZ_STEP_REPEAT_MASK;
+    for (int n = 0; n <= repeat; n++) {
+      tetris_dispatch(tetris, (UserAction_t)(step & FUZZ_STEP_ACTION_MASK),
+                      step & FUZZ_STEP_HOLD);
+      check_invariants(&run);
+    }
+  }
+
+  tetris->context = NULL;
+  return 0;
+}
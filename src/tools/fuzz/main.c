@@ -0,0 +1,130 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "fuzz.h"
+
+#define FUZZ_MAX_INPUT_SIZE (1 << 20)
+#define FUZZ_BENCH_INPUT_SIZE 64
+
+// Standalone driver of the engine fuzz harness. Without libFuzzer the harness
+// is linked with this driver, which runs files (the AFL `@@` convention),
+// directories of files (a corpus or crash directory), the standard input, or a
+// benchmark of random inputs.
+
+/**
+ * @brief Runs the harness on a file.
+ *
+ * @param filename The input file.
+ * @return 0 on success, -1 if the file cannot be read.
+ */
+static int run_file(const char *filename) {
+  FILE *file = fopen(filename, "rb");
+  if (!file) return -1;
+
+  uint8_t *data = malloc(FUZZ_MAX_INPUT_SIZE);
+  if (!data) {
+    fprintf(stderr, "Cannot allocate mem for fuzz input\n");
+    exit(-1);
+  }
+  size_t size = fread(data, 1, FUZZ_MAX_INPUT_SIZE, file);
+  fclose(file);
+
+  LLVMFuzzerTestOneInput(data, size);
+  free(data);
+  return 0;
+}
+
+/**
+ * @brief Runs the harness on a file or on every file of a directory.
+ *
+ * @param path The file or directory.
+ * @return The number of executed inputs or -1 if the path cannot be read.
+ */
+static long run_path(const char *path) {
+  struct stat info;
+  if (stat(path, &info)) return -1;
+  if (!S_ISDIR(info.st_mode)) return run_file(path) ? -1 : 1;
+
+  DIR *directory = opendir(path);
+  if (!directory) return -1;
+
+  long count = 0;
+  struct dirent *entry;
+  char filename[4096];
+  while ((entry = readdir(directory))) {
+    if (entry->d_name[0] == '.') continue;
+    snprintf(filename, sizeof(filename), "%s/%s", path, entry->d_name);
+    if (!stat(filename, &info) && S_ISREG(info.st_mode) &&
+        !run_file(filename)) {
+      count++;
+    }
+  }
+  closedir(directory);
+  return count;
+}
+
+/**
+ * @brief Runs the harness on random inputs and reports the execution rate.
+ *
+ * Inputs always start the game, so the benchmark measures real game play
+ * rather than inputs stuck in the ready state.
+ *
+ * @param runs The number of executions.
+ * @param min_rate The lowest acceptable rate in executions per second.
+ * @return EXIT_SUCCESS if the rate is at least `min_rate`.
+ */
+static int run_bench(long runs, double min_rate) {
+  uint8_t data[FUZZ_BENCH_INPUT_SIZE];
+  unsigned int state = 0x2545F491u;
+
+  struct timespec started, finished;
+  clock_gettime(CLOCK_MONOTONIC, &started);
+  for (long run = 0; run < runs; run++) {
+    for (size_t i = 0; i < sizeof(data); i++) {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      data[i] = (uint8_t)state;
+    }
+    data[4] |= FUZZ_FLAG_AUTOSTART;
+    // keep Terminate rare so that most inputs play until the end
+    for (size_t i = FUZZ_HEADER_SIZE; i < sizeof(data); i++) {
+      if ((data[i] & FUZZ_STEP_ACTION_MASK) == Terminate) data[i] ^= 1;
+    }
+    LLVMFuzzerTestOneInput(data, (size_t)(run % sizeof(data)) + 1);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &finished);
+
+  double seconds = (finished.tv_sec - started.tv_sec) +
+                   (finished.tv_nsec - started.tv_nsec) / 1e9;
+  double rate = seconds > 0 ? runs / seconds : 0;
+  printf("fuzz: %ld execs in %.2fs, %.0f execs/sec\n", runs, seconds, rate);
+  return rate >= min_rate ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char **argv) {
+  int status = EXIT_SUCCESS;
+
+  if (argc >= 3 && !strcmp(argv[1], "-bench")) {
+    status = run_bench(atol(argv[2]), argc > 3 ? atof(argv[3]) : 0);
+  } else if (argc == 1) {
+    status = run_file("/dev/stdin") ? EXIT_FAILURE : EXIT_SUCCESS;
+  } else {
+    for (int i = 1; i < argc; i++) {
+      long count = run_path(argv[i]);
+      if (count < 0) {
+        fprintf(stderr, "fuzz: cannot read %s\n", argv[i]);
+        status = EXIT_FAILURE;
+      } else {
+        printf("fuzz: %s: %ld inputs passed\n", argv[i], count);
+      }
+    }
+  }
+  return status;
+}
@@ -0,0 +1,90 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "input_bench.h"
+
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief Returns the time of a clock in nanoseconds.
+ *
+ * @param clock The clock.
+ * @return The time.
+ */
+static long long clock_ns(clockid_t clock) {
+  struct timespec now;
+  clock_gettime(clock, &now);
+  return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ * @brief Writes every byte, the reader drains the pipe in between.
+ *
+ * @param fd The descriptor.
+ * @param bytes The bytes.
+ * @param size The number of bytes.
+ * @return true if every byte was written.
+ */
+static bool write_all(int fd, const char *bytes, size_t size) {
+  while (size) {
+    ssize_t written = write(fd, bytes, size);
+    if (written <= 0) return false;
+    bytes += written;
+    size -= written;
+  }
+  return true;
+}
+
+InputBenchResult run_input_bench(KeyboardController *kb, int fd,
+                                 unsigned long keys) {
+  const int pattern[INPUT_BENCH_PATTERN_KEYS] = {'a', KEY_LEFT, KEY_DC, 'q',
+                                                 KEY_PPAGE};
+  static char burst[sizeof(INPUT_BENCH_PATTERN) * INPUT_BENCH_BURST];
+  size_t size = 0;
+  for (size_t i = 0; i < INPUT_BENCH_BURST; i++) {
+    memcpy(burst + size, INPUT_BENCH_PATTERN, sizeof(INPUT_BENCH_PATTERN) - 1);
+    size += sizeof(INPUT_BENCH_PATTERN) - 1;
+  }
+
+  InputBenchResult result = {0};
+  timeout(0);
+  long long wall_ns = clock_ns(CLOCK_MONOTONIC);
+  long long cpu_ns = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+  while (result.keys < keys) {
+    if (!write_all(fd, burst, size)) break;
+    result.bytes += size;
+    unsigned long read_keys = 0;
+    for (Button btn = kb->listen(kb); btn.key != ERR; btn = kb->listen(kb)) {
+      if (btn.key != pattern[read_keys % INPUT_BENCH_PATTERN_KEYS]) {
+        result.wrong++;
+      }
+      read_keys++;
+    }
+    result.keys += read_keys;
+    if (read_keys != INPUT_BENCH_BURST * INPUT_BENCH_PATTERN_KEYS) break;
+  }
+  result.wall_ns = clock_ns(CLOCK_MONOTONIC) - wall_ns;
+  result.cpu_ns = clock_ns(CLOCK_PROCESS_CPUTIME_ID) - cpu_ns;
+  return result;
+}
+
+InputBenchLatency run_key_latency_bench(KeyboardController *kb, int fd,
+                                        const char *bytes, int key,
+                                        unsigned long rounds) {
+  InputBenchLatency result = {0};
+  timeout(-1);
+  for (unsigned long i = 0; i < rounds; i++) {
+    long long sent_ns = clock_ns(CLOCK_MONOTONIC);
+    if (!write_all(fd, bytes, strlen(bytes))) break;
+    Button btn = kb->listen(kb);
+    long long latency_ns = clock_ns(CLOCK_MONOTONIC) - sent_ns;
+
+    result.rounds++;
+    if (btn.key != key) result.wrong++;
+    result.total_ns += latency_ns;
+    if (latency_ns > result.max_ns) result.max_ns = latency_ns;
+  }
+  timeout(0);
+  return result;
+}
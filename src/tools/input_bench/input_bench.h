@@ -0,0 +1,78 @@
+#ifndef TOOLS_INPUT_BENCH_INPUT_BENCH_H
+#define TOOLS_INPUT_BENCH_INPUT_BENCH_H
+
+#include <stdbool.h>
+
+#include "../../gui/cli/cli.h"
+
+// a letter, an arrow in keypad mode, delete, another letter and page up, as
+// an xterm sends them
+#define INPUT_BENCH_PATTERN "a\033OD\033[3~q\033[5~"
+#define INPUT_BENCH_PATTERN_KEYS 5
+#define INPUT_BENCH_BURST 200
+
+/**
+ * @brief Cost of reading a stream of keys.
+ *
+ * @struct InputBenchResult
+ * @var keys Number of keys read.
+ * @var wrong Number of keys read as another key than the one sent.
+ * @var bytes Number of bytes sent.
+ * @var wall_ns Wall time spent reading the keys.
+ * @var cpu_ns CPU time spent reading the keys.
+ */
+typedef struct {
+  unsigned long keys;
+  unsigned long wrong;
+  unsigned long bytes;
+  long long wall_ns;
+  long long cpu_ns;
+} InputBenchResult;
+
+/**
+ * @brief Time from sending a key to reading it.
+ *
+ * @struct InputBenchLatency
+ * @var rounds Number of keys sent.
+ * @var wrong Number of keys read as another key than the one sent.
+ * @var total_ns Total time from sending a key to reading it.
+ * @var max_ns The longest time from sending a key to reading it.
+ */
+typedef struct {
+  unsigned long rounds;
+  unsigned long wrong;
+  long long total_ns;
+  long long max_ns;
+} InputBenchLatency;
+
+/**
+ * @brief Sends bursts of `INPUT_BENCH_PATTERN` and reads them back with a
+ * keyboard controller.
+ *
+ * The screen must read its input from the other end of `fd`, and so must the
+ * controller when it reads raw input.
+ *
+ * @param kb The keyboard controller.
+ * @param fd The descriptor the keys are sent to.
+ * @param keys The number of keys to send, rounded up to whole bursts.
+ * @return The cost of reading the keys.
+ */
+InputBenchResult run_input_bench(KeyboardController *kb, int fd,
+                                 unsigned long keys);
+
+/**
+ * @brief Sends a key and waits until a keyboard controller reads it, rounds
+ * times.
+ *
+ * @param kb The keyboard controller.
+ * @param fd The descriptor the key is sent to.
+ * @param bytes The bytes of the key.
+ * @param key The key code the bytes stand for.
+ * @param rounds The number of times the key is sent.
+ * @return The time from sending the key to reading it.
+ */
+InputBenchLatency run_key_latency_bench(KeyboardController *kb, int fd,
+                                        const char *bytes, int key,
+                                        unsigned long rounds);
+
+#endif  // !TOOLS_INPUT_BENCH_INPUT_BENCH_H
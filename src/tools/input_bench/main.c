@@ -0,0 +1,97 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "input_bench.h"
+
+#define INPUT_BENCH_KEYS 100000
+#define INPUT_BENCH_ESC_ROUNDS 3
+#define INPUT_BENCH_KITTY_ROUNDS 100
+
+// Compares reading keys with `getch()` to the key decoder of the raw input.
+// Both read the same bytes from a pipe the screen takes its input from: a
+// stream of letters and escape sequences, for the cost of a key, then a lone
+// ESC, which ncurses only returns after `ESCDELAY` and the decoder after its
+// own timeout, and the ESC key of the kitty keyboard protocol, which never
+// waits.
+
+/**
+ * @brief Prints a result line of the key stream.
+ *
+ * @param reader The reader name.
+ * @param result The result.
+ */
+static void print_result(const char *reader, InputBenchResult result) {
+  unsigned long keys = result.keys ? result.keys : 1;
+  printf("%-8s %10lu %12.0f %10.1f %12.1f %8lu\n", reader, result.keys,
+         result.keys * 1e9 / (result.wall_ns ? result.wall_ns : 1),
+         (double)result.wall_ns / keys, (double)result.cpu_ns / keys,
+         result.wrong);
+}
+
+/**
+ * @brief Prints a result line of the ESC key.
+ *
+ * @param reader The reader name.
+ * @param bytes The sent bytes, as printed.
+ * @param result The result.
+ */
+static void print_latency(const char *reader, const char *bytes,
+                          InputBenchLatency result) {
+  unsigned long rounds = result.rounds ? result.rounds : 1;
+  printf("%-8s %-10s %8lu %10.3f %10.3f %8lu\n", reader, bytes, result.rounds,
+         result.total_ns / 1e6 / rounds, result.max_ns / 1e6, result.wrong);
+}
+
+int main(int argc, char **argv) {
+  unsigned long keys = argc > 1 ? strtoul(argv[1], NULL, 10) : 0;
+  if (!keys) keys = INPUT_BENCH_KEYS;
+
+  int input[2];
+  FILE *output = fopen("/dev/null", "w");
+  FILE *terminal = NULL;
+  SCREEN *screen = NULL;
+  if (output && !pipe(input) && (terminal = fdopen(input[0], "r"))) {
+    screen = newterm("xterm-256color", output, terminal);
+  }
+  if (!screen) {
+    fprintf(stderr, "input_bench: cannot open the screen\n");
+    return EXIT_FAILURE;
+  }
+  keypad(stdscr, TRUE);
+
+  KeyboardController *ncurses_kb = new_keyboard();
+  KeyboardController *raw_kb = new_keyboard();
+  raw_kb->use_raw_input(raw_kb, input[0], fileno(output));
+
+  printf("%-8s %10s %12s %10s %12s %8s\n", "reader", "keys", "keys/sec",
+         "ns/key", "cpu ns/key", "wrong");
+  print_result("ncurses", run_input_bench(ncurses_kb, input[1], keys));
+  print_result("decoder", run_input_bench(raw_kb, input[1], keys));
+
+  printf("\n%-8s %-10s %8s %10s %10s %8s\n", "reader", "esc key", "rounds",
+         "avg ms", "max ms", "wrong");
+  print_latency("ncurses", "ESC",
+                run_key_latency_bench(ncurses_kb, input[1], "\033", 27,
+                                      INPUT_BENCH_ESC_ROUNDS));
+  print_latency("decoder", "ESC",
+                run_key_latency_bench(raw_kb, input[1], "\033", 27,
+                                      INPUT_BENCH_ESC_ROUNDS));
+  print_latency("decoder", "CSI 27u",
+                run_key_latency_bench(raw_kb, input[1], "\033[27u", 27,
+                                      INPUT_BENCH_KITTY_ROUNDS));
+  printf("ncurses waits ESCDELAY, %dms here\n", get_escdelay());
+
+  ncurses_kb->destroy(ncurses_kb);
+  raw_kb->destroy(raw_kb);
+  endwin();
+  delscreen(screen);
+  fclose(output);
+  fclose(terminal);
+  close(input[1]);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,232 @@
+#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 700
+
+#include "latency_bench.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LATENCY_BENCH_LEFT "\033OD"
+#define LATENCY_BENCH_RIGHT "\033OC"
+#define LATENCY_BENCH_START_MS 1000
+#define LATENCY_BENCH_SETTLE_MS 500
+#define LATENCY_BENCH_MISSES_MAX 3
+#define LATENCY_BENCH_READ_SIZE 65536
+
+/**
+ * @brief A game running on a pseudo-terminal.
+ *
+ * @struct LatencyBenchGame
+ * @var pid The process of the game.
+ * @var fd The master side of the pseudo-terminal.
+ * @var directory The temporary directory the game runs in.
+ * @var screen The model of the terminal of the game.
+ * @var bytes Number of bytes the game wrote.
+ */
+typedef struct {
+  pid_t pid;
+  int fd;
+  char directory[32];
+  TerminalScreen *screen;
+  unsigned long bytes;
+} LatencyBenchGame;
+
+/**
+ * @brief Returns the monotonic time in nanoseconds.
+ *
+ * @return The time.
+ */
+static long long now_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ * @brief Starts the game on a new pseudo-terminal, in a new temporary
+ * directory.
+ *
+ * @param game Where the game is stored.
+ * @param argv The command of the game and its arguments.
+ * @return 0 on success, -1 on failure.
+ */
+static int spawn_game(LatencyBenchGame *game, char **argv) {
+  strcpy(game->directory, "/tmp/latency_bench.XXXXXX");
+  if (!mkdtemp(game->directory)) return -1;
+  char *command = realpath(argv[0], NULL);
+  if (!command) return -1;
+
+  game->fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (game->fd < 0 || grantpt(game->fd) || unlockpt(game->fd)) {
+    free(command);
+    return -1;
+  }
+  struct winsize size = {.ws_row = LATENCY_BENCH_HEIGHT,
+                         .ws_col = LATENCY_BENCH_WIDTH};
+  ioctl(game->fd, TIOCSWINSZ, &size);
+
+  game->pid = fork();
+  if (game->pid == 0) {
+    int terminal = open(ptsname(game->fd), O_RDWR);
+    if (setsid() < 0 || terminal < 0 || chdir(game->directory)) _exit(127);
+    ioctl(terminal, TIOCSCTTY, 0);
+    dup2(terminal, STDIN_FILENO);
+    dup2(terminal, STDOUT_FILENO);
+    dup2(terminal, STDERR_FILENO);
+    close(terminal);
+    close(game->fd);
+    setenv("TERM", "xterm-256color", 1);
+    execv(command, argv);
+    _exit(127);
+  }
+  free(command);
+  if (game->pid < 0) return -1;
+
+  game->screen = new_terminal_screen(LATENCY_BENCH_HEIGHT, LATENCY_BENCH_WIDTH);
+  return 0;
+}
+
+/**
+ * @brief Reads what the game writes until a time, or until the screen shows
+ * a move.
+ *
+ * @param game The game.
+ * @param until_ns The monotonic time to stop at.
+ * @param before The cells before the move or NULL to read until the time.
+ * @param direction The direction of the move.
+ * @return The monotonic time of the read that completed the move, 0 if there
+ * was none.
+ */
+static long long pump(LatencyBenchGame *game, long long until_ns,
+                      const unsigned int *before, int direction) {
+  static char bytes[LATENCY_BENCH_READ_SIZE];
+  for (long long left_ns; (left_ns = until_ns - now_ns()) > 0;) {
+    struct pollfd output = {.fd = game->fd, .events = POLLIN};
+    int timeout_ms = (int)((left_ns + 999999) / 1000000);
+    if (poll(&output, 1, timeout_ms) <= 0) continue;
+    ssize_t size = read(game->fd, bytes, sizeof(bytes));
+    long long read_ns = now_ns();
+    if (size <= 0) return 0;
+
+    game->bytes += size;
+    game->screen->feed(game->screen, bytes, size);
+    if (before && is_brick_moved(before, game->screen->cells,
+                                 game->screen->height, game->screen->width,
+                                 direction)) {
+      return read_ns;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief Sends keys to the game.
+ *
+ * @param game The game.
+ * @param keys The bytes of the keys.
+ */
+static void send_keys(LatencyBenchGame *game, const char *keys) {
+  ssize_t written = write(game->fd, keys, strlen(keys));
+  (void)written;
+}
+
+/**
+ * @brief Quits the game and removes its directory.
+ *
+ * @param game The game.
+ */
+static void stop_game(LatencyBenchGame *game) {
+  send_keys(game, "q");
+  pump(game, now_ns() + LATENCY_BENCH_SETTLE_MS * 1000000LL, NULL, 0);
+  send_keys(game, "\n");
+  pump(game, now_ns() + LATENCY_BENCH_SETTLE_MS * 1000000LL, NULL, 0);
+  if (waitpid(game->pid, NULL, WNOHANG) == 0) {
+    kill(game->pid, SIGTERM);
+    waitpid(game->pid, NULL, 0);
+  }
+  close(game->fd);
+  game->screen->destroy(game->screen);
+
+  DIR *directory = opendir(game->directory);
+  for (struct dirent *entry; directory && (entry = readdir(directory));) {
+    char path[sizeof(game->directory) + sizeof(entry->d_name) + 1];
+    snprintf(path, sizeof(path), "%s/%s", game->directory, entry->d_name);
+    if (strcmp(entry->d_name, ".") && strcmp(entry->d_name, "..")) {
+      unlink(path);
+    }
+  }
+  if (directory) closedir(directory);
+  rmdir(game->directory);
+}
+
+int run_latency_bench(LatencyBenchOptions options, LatencyBenchResult *result) {
+  *result = (LatencyBenchResult){0};
+  result->latencies_ns =
+      (long long *)calloc(options.inputs, sizeof(*result->latencies_ns));
+  if (!result->latencies_ns) {
+    fprintf(stderr, "Cannot allocate mem for latencies\n");
+    exit(-1);
+  }
+  LatencyBenchGame game = {0};
+  if (spawn_game(&game, options.argv)) return -1;
+
+  size_t cells_size = (size_t)game.screen->height * game.screen->width;
+  unsigned int *before = (unsigned int *)calloc(cells_size, sizeof(*before));
+  if (!before) {
+    fprintf(stderr, "Cannot allocate mem for latencies\n");
+    exit(-1);
+  }
+
+  // the first enter leaves the message of the day, the second starts a game
+  const long long ms = 1000000LL;
+  pump(&game, now_ns() + LATENCY_BENCH_START_MS * ms, NULL, 0);
+  for (int i = 0; i < 2; i++) {
+    send_keys(&game, "\n");
+    pump(&game, now_ns() + LATENCY_BENCH_SETTLE_MS * ms, NULL, 0);
+  }
+
+  unsigned int seed = 1;
+  int misses = 0;
+  for (unsigned long i = 0; i < options.inputs; i++) {
+    int gap_ms = options.min_gap_ms +
+                 rand_r(&seed) % (options.max_gap_ms - options.min_gap_ms + 1);
+    pump(&game, now_ns() + gap_ms * ms, NULL, 0);
+
+    int direction = i % 2 ? 1 : -1;
+    memcpy(before, game.screen->cells, cells_size * sizeof(*before));
+    long long sent_ns = now_ns();
+    send_keys(&game, direction < 0 ? LATENCY_BENCH_LEFT : LATENCY_BENCH_RIGHT);
+    result->sent++;
+    long long shown_ns =
+        pump(&game, sent_ns + options.timeout_ms * ms, before, direction);
+    if (shown_ns) {
+      result->latencies_ns[result->latencies_count++] = shown_ns - sent_ns;
+      misses = 0;
+      continue;
+    }
+
+    // the stack reached the top, enter starts a new game
+    result->missed++;
+    if (++misses >= LATENCY_BENCH_MISSES_MAX) {
+      send_keys(&game, "\n");
+      pump(&game, now_ns() + LATENCY_BENCH_SETTLE_MS * ms, NULL, 0);
+      result->restarts++;
+      misses = 0;
+    }
+  }
+
+  free(before);
+  result->bytes = game.bytes;
+  stop_game(&game);
+  return 0;
+}
@@ -0,0 +1,174 @@
+#ifndef TOOLS_LATENCY_BENCH_LATENCY_BENCH_H
+#define TOOLS_LATENCY_BENCH_LATENCY_BENCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define LATENCY_BENCH_HEIGHT 40
+#define LATENCY_BENCH_WIDTH 120
+#define LATENCY_BENCH_PARAMS_MAX 16
+
+/**
+ * @brief States of the escape sequence parser of a terminal screen.
+ *
+ * @enum TerminalParserState
+ * @var TERMINAL_GROUND Plain characters.
+ * @var TERMINAL_ESCAPE After an ESC.
+ * @var TERMINAL_CSI Inside a control sequence.
+ * @var TERMINAL_STRING Inside an OSC, DCS or APC string, until its terminator.
+ * @var TERMINAL_STRING_ESCAPE After an ESC inside a string.
+ * @var TERMINAL_CHARSET After the ESC of a character set designation.
+ */
+typedef enum {
+  TERMINAL_GROUND = 0,
+  TERMINAL_ESCAPE,
+  TERMINAL_CSI,
+  TERMINAL_STRING,
+  TERMINAL_STRING_ESCAPE,
+  TERMINAL_CHARSET,
+} TerminalParserState;
+
+/**
+ * @brief A model of the cells of a terminal, fed with what a program writes.
+ *
+ * Only what a cell looks like from afar is kept: the color it is filled
+ * with, that is its background, or its foreground when it is drawn in reverse
+ * video. The board of the game draws bricks as colored blanks, so a brick
+ * that moves changes the colors of its cells and nothing else needs to be
+ * known about them. The cursor moves, erases, insertions, deletions, scroll
+ * regions and repeats ncurses and the ANSI renderer send for an xterm are
+ * understood, other sequences are skipped.
+ *
+ * Colors are coded as 0 for the default, 1 + n for the palette color n and
+ * `TERMINAL_RGB` with the red, green and blue bytes for a 24-bit color.
+ *
+ * @struct __terminal_screen
+ * @var height The number of rows.
+ * @var width The number of columns.
+ * @var cells The fill color of every cell, row after row.
+ * @var _row The cursor row.
+ * @var _col The cursor column, `width` while a wrap is pending.
+ * @var _saved_row The row saved with ESC 7.
+ * @var _saved_col The column saved with ESC 7.
+ * @var _top The first row of the scroll region.
+ * @var _bottom The last row of the scroll region.
+ * @var _fg The foreground color of the written characters.
+ * @var _bg The background color of the written characters.
+ * @var _is_reverse Whether the characters are written in reverse video.
+ * @var _last The fill color of the last written character, for repeats.
+ * @var _state The state of the parser.
+ * @var _params The parameters of the current control sequence.
+ * @var _params_count The number of parameters.
+ * @var _marker The private marker of the current control sequence or 0.
+ * @var feed Function pointer applying written bytes to the cells.
+ * @var destroy Function pointer freeing the screen.
+ */
+typedef struct __terminal_screen {
+  int height;
+  int width;
+  unsigned int *cells;
+
+  int _row;
+  int _col;
+  int _saved_row;
+  int _saved_col;
+  int _top;
+  int _bottom;
+  unsigned int _fg;
+  unsigned int _bg;
+  bool _is_reverse;
+  unsigned int _last;
+  TerminalParserState _state;
+  int _params[LATENCY_BENCH_PARAMS_MAX];
+  size_t _params_count;
+  char _marker;
+
+  void (*feed)(struct __terminal_screen *self, const char *bytes, size_t size);
+  void (*destroy)(struct __terminal_screen *self);
+} TerminalScreen;
+
+#define TERMINAL_RGB 0x1000000u
+
+/**
+ * @brief Creates a blank terminal screen.
+ *
+ * @param height The number of rows.
+ * @param width The number of columns.
+ * @return A pointer to the newly created screen.
+ */
+TerminalScreen *new_terminal_screen(int height, int width);
+
+/**
+ * @brief Checks whether the cells changed like a brick moved one column.
+ *
+ * In every row that changed, some cells were filled with one color and as
+ * many cells lost that same color, and all the filled cells lie on the side
+ * of the move. Rows that did not change are ignored, so the rest of the brick
+ * may stay in place.
+ *
+ * @param before The cells before the move.
+ * @param after The cells after the move.
+ * @param height The number of rows.
+ * @param width The number of columns.
+ * @param direction -1 for a move to the left, 1 for a move to the right.
+ * @return true if the brick moved.
+ */
+bool is_brick_moved(const unsigned int *before, const unsigned int *after,
+                    int height, int width, int direction);
+
+/**
+ * @brief What a latency benchmark run sends.
+ *
+ * @struct LatencyBenchOptions
+ * @var argv The command of the game and its arguments, NULL terminated.
+ * @var inputs The number of moves to send.
+ * @var min_gap_ms The shortest time between two moves.
+ * @var max_gap_ms The longest time between two moves.
+ * @var timeout_ms How long a move may take to show before it counts as
+ * missed.
+ */
+typedef struct {
+  char **argv;
+  unsigned long inputs;
+  int min_gap_ms;
+  int max_gap_ms;
+  int timeout_ms;
+} LatencyBenchOptions;
+
+/**
+ * @brief Key to screen latencies of a benchmark run.
+ *
+ * @struct LatencyBenchResult
+ * @var sent Number of moves sent.
+ * @var missed Number of moves that did not show in time, a brick against a
+ * wall or on the stack included.
+ * @var restarts Number of games started again after a game over.
+ * @var latencies_ns The latency of every move that showed, in nanoseconds.
+ * @var latencies_count Number of moves that showed.
+ * @var bytes Number of bytes the game wrote.
+ */
+typedef struct {
+  unsigned long sent;
+  unsigned long missed;
+  unsigned long restarts;
+  long long *latencies_ns;
+  size_t latencies_count;
+  unsigned long bytes;
+} LatencyBenchResult;
+
+/**
+ * @brief Runs the game on a pseudo-terminal and measures how long the moves
+ * of the falling brick take to show.
+ *
+ * The game is started in a new temporary directory, so its high score files
+ * are not left behind. Left and right alternate, so the brick stays in the
+ * middle of the board, at random times between the gaps, so they do not beat
+ * in time with the frames.
+ *
+ * @param options What to send.
+ * @param result Where the latencies are stored, free `latencies_ns` after.
+ * @return 0 on success, -1 if the game cannot be started.
+ */
+int run_latency_bench(LatencyBenchOptions options, LatencyBenchResult *result);
+
+#endif  // !TOOLS_LATENCY_BENCH_LATENCY_BENCH_H
@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "latency_bench.h"
+
+#define LATENCY_BENCH_INPUTS 1000
+#define LATENCY_BENCH_MIN_GAP_MS 60
+#define LATENCY_BENCH_MAX_GAP_MS 120
+#define LATENCY_BENCH_TIMEOUT_MS 500
+
+// Runs the game on a pseudo-terminal, moves the falling brick left and right
+// and measures the time from writing a key to reading the output that shows
+// the brick in its new place, with a model of the terminal the output is
+// applied to. No display is needed.
+
+/**
+ * @brief Compares two latencies, for sorting.
+ *
+ * @param a The first latency.
+ * @param b The second latency.
+ * @return A negative, zero or positive value.
+ */
+static int compare_latencies(const void *a, const void *b) {
+  long long first = *(const long long *)a, second = *(const long long *)b;
+  return (first > second) - (first < second);
+}
+
+/**
+ * @brief Returns a percentile of sorted latencies.
+ *
+ * @param latencies The sorted latencies.
+ * @param count The number of latencies.
+ * @param percent The percentile.
+ * @return The latency in milliseconds.
+ */
+static double percentile_ms(const long long *latencies, size_t count,
+                            double percent) {
+  size_t index = (size_t)(count * percent / 100);
+  if (index >= count) index = count - 1;
+  return latencies[index] / 1e6;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 3 || !strtoul(argv[1], NULL, 10)) {
+    fprintf(stderr, "usage: %s inputs tetris [arguments...]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  LatencyBenchOptions options = {.argv = argv + 2,
+                                 .inputs = strtoul(argv[1], NULL, 10),
+                                 .min_gap_ms = LATENCY_BENCH_MIN_GAP_MS,
+                                 .max_gap_ms = LATENCY_BENCH_MAX_GAP_MS,
+                                 .timeout_ms = LATENCY_BENCH_TIMEOUT_MS};
+  LatencyBenchResult result;
+  if (run_latency_bench(options, &result)) {
+    fprintf(stderr, "latency_bench: cannot start %s\n", argv[2]);
+    free(result.latencies_ns);
+    return EXIT_FAILURE;
+  }
+
+  size_t count = result.latencies_count;
+  printf("%lu moves sent, %zu shown, %lu missed, %lu restarts, %.0f bytes "
+         "per move\n",
+         result.sent, count, result.missed, result.restarts,
+         result.sent ? (double)result.bytes / result.sent : 0.);
+  if (count) {
+    qsort(result.latencies_ns, count, sizeof(*result.latencies_ns),
+          compare_latencies);
+    double total_ms = 0;
+    for (size_t i = 0; i < count; i++) {
+      total_ms += result.latencies_ns[i] / 1e6;
+    }
+    printf("key to screen ms: p50 %.3f, p90 %.3f, p99 %.3f, max %.3f, mean "
+           "%.3f\n",
+           percentile_ms(result.latencies_ns, count, 50),
+           percentile_ms(result.latencies_ns, count, 90),
+           percentile_ms(result.latencies_ns, count, 99),
+           result.latencies_ns[count - 1] / 1e6, total_ms / count);
+  }
+  free(result.latencies_ns);
+  return count ? EXIT_SUCCESS : EXIT_FAILURE;
+}
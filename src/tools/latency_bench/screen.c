@@ -0,0 +1,527 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "latency_bench.h"
+
+#define TERMINAL_ESC 27
+#define TERMINAL_TAB_WIDTH 8
+
+/**
+ * @brief Returns a parameter of the current control sequence.
+ *
+ * @param self A pointer to the TerminalScreen instance.
+ * @param index The index of the parameter.
+ * @param fallback The value of a missing or zero parameter.
+ * @return The parameter.
+ */
+static int param(TerminalScreen *self, size_t index, int fallback) {
+  if (index >= self->_params_count || !self->_params[index]) return fallback;
+  return self->_params[index];
+}
+
+/**
+ * @brief Returns a pointer to the first cell of a row.
+ *
+ * @param self A pointer to the TerminalScreen instance.
+ * @param row The row.
+ * @return The cells of the row.
+ */
+static unsigned int *row_cells(TerminalScreen *self, int row) {
+  return self->cells + (size_t)row * self->width;
+}
+
+/**
+ * @brief Fills cells of a row with the background color, like the erases of
+ * a terminal with background color erase.
+ *
+ * @param self A pointer to the TerminalScreen instance.
+ * @param row The row.
+ * @param from The first column.
+ * @param to The column after the last one.
+ */
+static void erase_cells(TerminalScreen *self, int row, int from, int to) {
+  if (from < 0) from = 0;
+  if (to > self->width) to = self->width;
+  for (int col = from; col < to; col++) row_cells(self, row)[col] = self->_bg;
+}
+
+/**
+ * @brief Moves rows of the scroll region up, blank rows come in at the
+ * bottom.
+ *
+ * @param self A pointer to the TerminalScreen instance.
+ * @param top The first moved row.
+ * @param count The number of rows, negative to move them down instead.
+ */
+static void scroll_rows(TerminalScreen *self, int top, int count) {
+  int bottom = self->_bottom, rows = bottom - top + 1;
+  if (top < self->_top || top > bottom || !count) return;
+  if (count >= rows || -count >= rows) count = count > 0 ? rows : -rows;
+
+  size_t row_size = self->width * sizeof(*self->cells);
+  if (count > 0) {
+    memmove(row_cells(self, top), row_cells(self, top + count),
+            (rows - count) * row_size);
+    for (int row = bottom - count + 1; row <= bottom; row++) {
+      erase_cells(self, row, 0, self->width);
+    }
+  } else {
+    memmove(row_cells(self, top - count), row_cells(self, top),
+            (rows + count) * row_size);
+    for (int row = top; row < top - count; row++) {
+      erase_cells(self, row, 0, self->width);
+    }
+  }
+}
+
+/**
+ * @brief Moves the cursor one row down, scrolling at the bottom of the scroll
+ * region.
+ *
+ * @param self A pointer to the TerminalScreen instance.
+ */
+static void line_feed(TerminalScreen *self) {
+  if (self->_row == self->_bottom) {
+    scroll_rows(self, self->_top, 1);
+  } else if (self->_row < self->height - 1) {
+    self->_row++;
+  }
+}
+
+/**
+ * @brief Moves the cursor, kept on the screen.
+ *
+ * @param self A pointer to the TerminalScreen instance.
+ * @param row The row.
+ * @param col The column.
+ */
+static void move_cursor(TerminalScreen *self, int row, int col) {
+  self->_row = row < 0 ? 0 : row >= self->height ? self->height - 1 : row;
+  self->_col = col < 0 ? 0 : col >= self->width ? self->width - 1 : col;
+}
+
+/**
+ * @brief Writes a character with the current colors.
+ *
+ * @param self A pointer to the TerminalScreen instance.
+ */
+static void put_char(TerminalScreen *self) {
+  if (self->_col >= self->width) {
+    self->_col = 0;
+    line_feed(self);
+  }
+  self->_last = self->_is_reverse ? self->_fg : self->_bg;
+  row_cells(self, self->_row)[self->_col++] = self->_last;
+}
+
+/**
+ * @brief Reads an extended color of a SGR sequence: `5;n` or `2;r;g;b`.
+ *
+ * @param self A pointer to the TerminalScreen instance.
+ * @param index The index of the parameter after 38 or 48, advanced past the
+ * color.
+ * @return The color.
+ */
+static unsigned int extended_color(TerminalScreen *self, size_t *index) {
+  if (param(self, *index + 1, 0) == 5) {
+    *index += 2;
+    return 1 + (param(self, *index, 0) & 0xff);
+  }
+  if (param(self, *index + 1, 0) == 2) {
+    unsigned int red = param(self, *index + 2, 0) & 0xff;
+    unsigned int green = param(self, *index + 3, 0) & 0xff;
+    unsigned int blue = param(self, *index + 4, 0) & 0xff;
+    unsigned int rgb = TERMINAL_RGB | red << 16 | green << 8 | blue;
+    *index += 4;
+    return rgb;
+  }
+  return 0;
+}
+
+/**
+ * @brief Applies a SGR sequence to the current colors.
+ *
+ * @param self A pointer to the TerminalScreen instance.
+ */
+static void select_graphic_rendition(TerminalScreen *self) {
+  if (!self->_params_count) self->_params[self->_params_count++] = 0;
+  for (size_t i = 0; i < self->_params_count; i++) {
+    int value = self->_params[i];
+    if (value == 0) {
+      self->_fg = self->_bg = 0;
+      self->_is_reverse = false;
+    } else if (value == 7 || value == 27) {
+      self->_is_reverse = value == 7;
+    } else if ((value >= 30 && value <= 37) || (value >= 90 && value <= 97)) {
+      self->_fg = 1 + (value >= 90 ? value - 90 + 8 : value - 30);
+    } else if ((value >= 40 && value <= 47) ||
+               (value >= 100 && value <= 107)) {
+      self->_bg = 1 + (value >= 100 ? value - 100 + 8 : value - 40);
+    } else if (value == 38 || value == 48) {
+      unsigned int color = extended_color(self, &i);
+      if (value == 38) self->_fg = color;
+      if (value == 48) self->_bg = color;
+    } else if (value == 39) {
+      self->_fg = 0;
+    } else if (value == 49) {
+      self->_bg = 0;
+    }
+  }
+}
+
+/**
+ * @brief Applies an erase in display or in line.
+ *
+ * @param self A pointer to the TerminalScreen instance.
+ * @param mode 0 from the cursor, 1 up to the cursor, 2 everything.
+ * @param is_display Whether the whole display is erased instead of the line.
+ */
+static void erase(TerminalScreen *self, int mode, bool is_display) {
+  int row = self->_row, col = self->_col;
+  if (mode == 0) erase_cells(self, row, col, self->width);
+  if (mode == 1) erase_cells(self, row, 0, col + 1);
+  if (mode == 2) erase_cells(self, row, 0, self->width);
+  if (!is_display) return;
+
+  int from = mode == 0 ? row + 1 : 0, to = mode == 1 ? row : self->height;
+  if (mode == 2) from = 0;
+  for (int other = from; other < to; other++) {
+    if (other != row) erase_cells(self, other, 0, self->width);
+  }
+}
+
+/**
+ * @brief Inserts blank cells at the cursor or deletes the cells there, the
+ * rest of the row moves along.
+ *
+ * @param self A pointer to the TerminalScreen instance.
+ * @param count The number of cells, negative to delete them.
+ */
+static void shift_cells(TerminalScreen *self, int count) {
+  unsigned int *cells = row_cells(self, self->_row);
+  int col = self->_col < self->width ? self->_col : self->width - 1;
+  int rest = self->width - col, size = count > 0 ? count : -count;
+  if (size > rest) size = rest;
+
+  if (count > 0) {
+    memmove(cells + col + size, cells + col,
+            (rest - size) * sizeof(*cells));
+    erase_cells(self, self->_row, col, col + size);
+  } else {
+    memmove(cells + col, cells + col + size, (rest - size) * sizeof(*cells));
+    erase_cells(self, self->_row, self->width - size, self->width);
+  }
+}
+
+/**
+ * @brief Applies a complete control sequence.
+ *
+ * @param self A pointer to the TerminalScreen instance.
+ * @param final The final byte.
+ */
+static void control_sequence(TerminalScreen *self, char final) {
+  if (self->_marker) return;
+  int row = self->_row, col = self->_col < self->width ? self->_col
+                                                       : self->width - 1;
+  int count = param(self, 0, 1);
+  switch (final) {
+    case 'A':
+      move_cursor(self, row - count, col);
+      break;
+    case 'B':
+      move_cursor(self, row + count, col);
+      break;
+    case 'C':
+      move_cursor(self, row, col + count);
+      break;
+    case 'D':
+      move_cursor(self, row, col - count);
+      break;
+    case 'E':
+      move_cursor(self, row + count, 0);
+      break;
+    case 'F':
+      move_cursor(self, row - count, 0);
+      break;
+    case 'G':
+    case '`':
+      move_cursor(self, row, count - 1);
+      break;
+    case 'd':
+      move_cursor(self, count - 1, col);
+      break;
+    case 'H':
+    case 'f':
+      move_cursor(self, count - 1, param(self, 1, 1) - 1);
+      break;
+    case 'J':
+    case 'K':
+      erase(self, param(self, 0, 0), final == 'J');
+      break;
+    case 'X':
+      erase_cells(self, row, col, col + count);
+      break;
+    case '@':
+      shift_cells(self, count);
+      break;
+    case 'P':
+      shift_cells(self, -count);
+      break;
+    case 'L':
+      scroll_rows(self, row, -count);
+      break;
+    case 'M':
+      scroll_rows(self, row, count);
+      break;
+    case 'S':
+      scroll_rows(self, self->_top, count);
+      break;
+    case 'T':
+      scroll_rows(self, self->_top, -count);
+      break;
+    case 'r':
+      self->_top = param(self, 0, 1) - 1;
+      self->_bottom = param(self, 1, self->height) - 1;
+      if (self->_top < 0 || self->_bottom >= self->height ||
+          self->_top >= self->_bottom) {
+        self->_top = 0;
+        self->_bottom = self->height - 1;
+      }
+      move_cursor(self, 0, 0);
+      break;
+    case 'b':
+      for (int i = 0; i < count; i++) {
+        if (self->_col >= self->width) {
+          self->_col = 0;
+          line_feed(self);
+        }
+        row_cells(self, self->_row)[self->_col++] = self->_last;
+      }
+      break;
+    case 'm':
+      select_graphic_rendition(self);
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * @brief Applies the byte after an ESC.
+ *
+ * @param self A pointer to the TerminalScreen instance.
+ * @param byte The byte.
+ */
+static void escape(TerminalScreen *self, unsigned char byte) {
+  self->_state = TERMINAL_GROUND;
+  switch (byte) {
+    case '[':
+      self->_state = TERMINAL_CSI;
+      self->_params_count = 0;
+      self->_params[0] = 0;
+      self->_marker = 0;
+      break;
+    case ']':
+    case 'P':
+    case '_':
+    case '^':
+      self->_state = TERMINAL_STRING;
+      break;
+    case '(':
+    case ')':
+    case '*':
+    case '+':
+      self->_state = TERMINAL_CHARSET;
+      break;
+    case 'D':
+      line_feed(self);
+      break;
+    case 'E':
+      self->_col = 0;
+      line_feed(self);
+      break;
+    case 'M':
+      if (self->_row == self->_top) {
+        scroll_rows(self, self->_top, -1);
+      } else if (self->_row > 0) {
+        self->_row--;
+      }
+      break;
+    case '7':
+      self->_saved_row = self->_row;
+      self->_saved_col = self->_col;
+      break;
+    case '8':
+      move_cursor(self, self->_saved_row, self->_saved_col);
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * @brief Applies a byte of a control sequence.
+ *
+ * @param self A pointer to the TerminalScreen instance.
+ * @param byte The byte.
+ */
+static void control_sequence_byte(TerminalScreen *self, unsigned char byte) {
+  if (byte >= '0' && byte <= '9') {
+    if (!self->_params_count) self->_params_count = 1;
+    int *value = &self->_params[self->_params_count - 1];
+    if (*value < 100000) *value = *value * 10 + (byte - '0');
+  } else if (byte == ';' || byte == ':') {
+    if (!self->_params_count) self->_params_count = 1;
+    if (self->_params_count < LATENCY_BENCH_PARAMS_MAX) {
+      self->_params[self->_params_count++] = 0;
+    }
+  } else if (byte >= '<' && byte <= '?') {
+    self->_marker = byte;
+  } else if (byte >= 0x40 && byte <= 0x7e) {
+    control_sequence(self, byte);
+    self->_state = TERMINAL_GROUND;
+  } else if (byte == TERMINAL_ESC) {
+    self->_state = TERMINAL_ESCAPE;
+  }
+}
+
+/**
+ * @brief Applies written bytes to the cells.
+ *
+ * @param self A pointer to the TerminalScreen instance.
+ * @param bytes The bytes.
+ * @param size The number of bytes.
+ */
+static void _feed(TerminalScreen *self, const char *bytes, size_t size) {
+  if (!self) return;
+  for (size_t i = 0; i < size; i++) {
+    unsigned char byte = bytes[i];
+    switch (self->_state) {
+      case TERMINAL_ESCAPE:
+        escape(self, byte);
+        continue;
+      case TERMINAL_CSI:
+        control_sequence_byte(self, byte);
+        continue;
+      case TERMINAL_STRING:
+        if (byte == 7) self->_state = TERMINAL_GROUND;
+        if (byte == TERMINAL_ESC) self->_state = TERMINAL_STRING_ESCAPE;
+        continue;
+      case TERMINAL_STRING_ESCAPE:
+        self->_state = byte == '\\' ? TERMINAL_GROUND : TERMINAL_STRING;
+        continue;
+      case TERMINAL_CHARSET:
+        self->_state = TERMINAL_GROUND;
+        continue;
+      default:
+        break;
+    }
+
+    if (byte == TERMINAL_ESC) {
+      self->_state = TERMINAL_ESCAPE;
+    } else if (byte == '\r') {
+      self->_col = 0;
+    } else if (byte == '\n' || byte == '\v' || byte == '\f') {
+      line_feed(self);
+    } else if (byte == '\b') {
+      if (self->_col >= self->width) self->_col = self->width - 1;
+      if (self->_col > 0) self->_col--;
+    } else if (byte == '\t') {
+      int col = (self->_col / TERMINAL_TAB_WIDTH + 1) * TERMINAL_TAB_WIDTH;
+      self->_col = col < self->width ? col : self->width - 1;
+    } else if (byte >= 0x20 && byte != 0x7f && (byte < 0x80 || byte >= 0xc0)) {
+      // a UTF-8 character takes one cell, its continuation bytes none
+      put_char(self);
+    }
+  }
+}
+
+/**
+ * @brief Frees the screen.
+ *
+ * @param self A pointer to the TerminalScreen instance.
+ */
+static void _destroy(TerminalScreen *self) {
+  if (!self) return;
+  free(self->cells);
+  free(self);
+}
+
+/**
+ * @brief Creates a blank terminal screen.
+ *
+ * If memory allocation fails, the function prints an error message to stderr
+ * and exits the program with a failure status.
+ *
+ * @param height The number of rows.
+ * @param width The number of columns.
+ * @return A pointer to the newly created screen.
+ */
+TerminalScreen *new_terminal_screen(int height, int width) {
+  TerminalScreen *self = (TerminalScreen *)calloc(1, sizeof(TerminalScreen));
+  unsigned int *cells =
+      self ? (unsigned int *)calloc((size_t)height * width, sizeof(*cells))
+           : NULL;
+  if (!cells) {
+    fprintf(stderr, "Cannot allocate mem for TerminalScreen\n");
+    exit(-1);
+  }
+
+  self->height = height;
+  self->width = width;
+  self->cells = cells;
+  self->_bottom = height - 1;
+
+  self->feed = _feed;
+  self->destroy = _destroy;
+  return self;
+}
+
+bool is_brick_moved(const unsigned int *before, const unsigned int *after,
+                    int height, int width, int direction) {
+  bool is_changed = false, has_brick = false;
+  unsigned int brick = 0;
+  for (int row = 0; row < height; row++) {
+    const unsigned int *old = before + (size_t)row * width;
+    const unsigned int *new = after + (size_t)row * width;
+    int filled = 0, emptied = 0;
+    int first_filled = width, last_filled = -1;
+    int first_emptied = width, last_emptied = -1;
+    for (int col = 0; col < width; col++) {
+      if (old[col] == new[col]) continue;
+
+      // the brick color is the color of the cell on the side of the move
+      if (!has_brick) {
+        has_brick = true;
+        brick = new[col];
+        if (direction > 0) {
+          for (int last = width - 1; last >= col; last--) {
+            if (old[last] != new[last]) {
+              brick = new[last];
+              break;
+            }
+          }
+        }
+      }
+      if (new[col] == brick) {
+        filled++;
+        if (col < first_filled) first_filled = col;
+        last_filled = col;
+      } else if (old[col] == brick) {
+        emptied++;
+        if (col < first_emptied) first_emptied = col;
+        last_emptied = col;
+      } else {
+        return false;
+      }
+    }
+    if (!filled && !emptied) continue;
+
+    is_changed = true;
+    if (filled != emptied) return false;
+    if (direction < 0 && last_filled > first_emptied) return false;
+    if (direction > 0 && first_filled < last_emptied) return false;
+  }
+  return is_changed;
+}
@@ -0,0 +1,155 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "render_bench.h"
+
+#define RENDER_BENCH_FRAMES 1000
+
+// Compares the terminal output of the ncurses and ANSI renderers. Both draw
+// the same game into the same ncurses screen, the output goes to /dev/null
+// and every `write` call of the process, ncurses included, is counted here.
+// With `--pipeline` it measures the frame rate of the whole game screen on the
+// headless renderer instead.
+
+extern ssize_t __write(int fd, const void *data, size_t size);
+
+static RenderBenchResult *counted_result = NULL;
+static int counted_fd = -1;
+
+/**
+ * @brief Counts the writes on the descriptor of the measured renderer.
+ *
+ * @param result Where the calls are counted or NULL to stop counting.
+ * @param fd The descriptor.
+ */
+void render_bench_count_writes(RenderBenchResult *result, int fd) {
+  counted_result = result;
+  counted_fd = fd;
+}
+
+ssize_t write(int fd, const void *data, size_t size) {
+  ssize_t written = __write(fd, data, size);
+  if (counted_result && fd == counted_fd) {
+    counted_result->writes++;
+    if (written > 0) counted_result->bytes += written;
+  }
+  return written;
+}
+
+/**
+ * @brief Prints a result line.
+ *
+ * @param scene The scene name.
+ * @param renderer The renderer name.
+ * @param result The result.
+ */
+static void print_result(const char *scene, const char *renderer,
+                         RenderBenchResult result) {
+  printf("%-6s %-15s %12.1f %13.2f %10.1f\n", scene, renderer,
+         (double)result.bytes / result.frames,
+         (double)result.writes / result.frames,
+         result.cpu_ns / 1e3 / result.frames);
+}
+
+/**
+ * @brief Prints the frame rate of the full UI pipeline for every scene.
+ *
+ * @param frames The number of measured frames per scene.
+ * @return The exit status.
+ */
+static int run_pipeline(unsigned long frames) {
+  Renderer *renderer =
+      new_headless_renderer(RENDER_BENCH_HEIGHT, RENDER_BENCH_WIDTH);
+  if (renderer->start(renderer)) {
+    fprintf(stderr, "render_bench: cannot open the headless screen\n");
+    renderer->destroy(renderer);
+    return EXIT_FAILURE;
+  }
+  Pallete *pallete = provide_pallete();
+  pallete->change_theme(pallete, DARK_THEME);
+
+  const char *scenes[] = {"idle", "play", "fire"};
+  const char *qualities[] = {"full", "reduced", "low"};
+  printf("%-6s %-8s %12s %10s %10s %12s\n", "scene", "quality", "frames/sec",
+         "us/frame", "cpu us", "full frames");
+  for (int scene = RENDER_BENCH_IDLE; scene <= RENDER_BENCH_FIRE; scene++) {
+    for (int quality = QUALITY_FULL; quality < QUALITY_LEVELS_COUNT;
+         quality++) {
+      RenderPipelineResult result = run_render_pipeline_bench(
+          renderer, (RenderBenchScene)scene, (QualityLevel)quality, frames);
+      printf("%-6s %-8s %12.0f %10.1f %10.1f %12lu\n", scenes[scene],
+             qualities[quality],
+             result.frames * 1e9 / (result.wall_ns ? result.wall_ns : 1),
+             result.wall_ns / 1e3 / result.frames,
+             result.cpu_ns / 1e3 / result.frames, result.full_frames);
+    }
+  }
+
+  pallete->destroy(pallete);
+  renderer->stop(renderer);
+  renderer->destroy(renderer);
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+  bool is_pipeline = argc > 1 && strcmp(argv[1], "--pipeline") == 0;
+  if (is_pipeline) {
+    argc--;
+    argv++;
+  }
+  unsigned long frames = argc > 1 ? strtoul(argv[1], NULL, 10) : 0;
+  if (!frames) frames = RENDER_BENCH_FRAMES;
+  if (is_pipeline) return run_pipeline(frames);
+
+  FILE *output = fopen("/dev/null", "w");
+  FILE *input = fopen("/dev/null", "r");
+  int ansi_fd = open("/dev/null", O_WRONLY);
+  SCREEN *screen = output && input && ansi_fd >= 0
+                       ? newterm("xterm-256color", output, input)
+                       : NULL;
+  if (!screen) {
+    fprintf(stderr, "render_bench: cannot open the screen\n");
+    return EXIT_FAILURE;
+  }
+  resizeterm(RENDER_BENCH_HEIGHT, RENDER_BENCH_WIDTH);
+  Pallete *pallete = provide_pallete();
+  pallete->change_theme(pallete, DARK_THEME);
+
+  struct {
+    const char *name;
+    RendererType type;
+    bool is_truecolor;
+  } renderers[] = {
+      {"ncurses", RENDERER_NCURSES, false},
+      {"ansi", RENDERER_ANSI, false},
+      {"ansi-truecolor", RENDERER_ANSI, true},
+  };
+  const char *scenes[] = {"idle", "play", "fire"};
+
+  printf("%-6s %-15s %12s %13s %10s\n", "scene", "renderer", "bytes/frame",
+         "writes/frame", "us/frame");
+  for (int scene = RENDER_BENCH_IDLE; scene <= RENDER_BENCH_FIRE; scene++) {
+    for (size_t i = 0; i < sizeof(renderers) / sizeof(renderers[0]); i++) {
+      int fd = renderers[i].type == RENDERER_ANSI ? ansi_fd : fileno(output);
+      Renderer *renderer =
+          new_renderer(renderers[i].type, fd, renderers[i].is_truecolor);
+      RenderBenchResult result = run_render_bench(
+          renderer, fd, (RenderBenchScene)scene, frames);
+      print_result(scenes[scene], renderers[i].name, result);
+      renderer->destroy(renderer);
+    }
+  }
+
+  pallete->destroy(pallete);
+  endwin();
+  delscreen(screen);
+  fclose(output);
+  fclose(input);
+  close(ansi_fd);
+  return EXIT_SUCCESS;
+}
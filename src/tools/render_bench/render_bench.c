@@ -0,0 +1,264 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "render_bench.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ * @brief What a scene keeps between frames.
+ *
+ * @struct RenderBenchState
+ * @var window The window the scene is drawn into.
+ * @var tetris The engine of the played game.
+ * @var now_ns The virtual time of the engine.
+ * @var board The cache of the board component.
+ * @var score The cache of the score component.
+ * @var level The cache of the level component.
+ * @var next The cache of the next brick component.
+ */
+typedef struct {
+  WINDOW *window;
+  Tetris *tetris;
+  long long now_ns;
+  BoardComponentCache board;
+  CounterComponentCache score;
+  CounterComponentCache level;
+  BrickComponentCache next;
+} RenderBenchState;
+
+/**
+ * @brief Plays one frame of the game: a random move and, every few frames, a
+ * gravity tick.
+ *
+ * @param state The scene state.
+ * @param frame The index of the frame.
+ */
+static void play_frame(RenderBenchState *state, unsigned long frame) {
+  Tetris *tetris = state->tetris;
+  if (tetris->state == TETRIS_GAMEOVER_STATE) {
+    tetris_dispatch(tetris, Start, false);
+  }
+
+  tetris_dispatch(tetris, (UserAction_t)(Left + rand() % (Action - Left + 1)),
+                  false);
+  if (frame % RENDER_BENCH_TICK_FRAMES == 0) {
+    state->now_ns += 500000000LL;
+    tetris->timer.set_time(
+        &tetris->timer,
+        (struct timespec){.tv_sec = state->now_ns / 1000000000LL,
+                          .tv_nsec = state->now_ns % 1000000000LL});
+    tetris->_tick(tetris);
+  }
+}
+
+/**
+ * @brief Draws a frame of the game screen like the game does: only the
+ * changed cells, or everything over the fire.
+ *
+ * @param state The scene state.
+ * @param is_fire Whether the fire burns under the board.
+ */
+static void draw_frame(RenderBenchState *state, bool is_fire) {
+  WINDOW *window = state->window;
+  GameInfo_t *info = &state->tetris->data.info;
+
+  if (is_fire) {
+    werase(window);
+    wbkgd(window, COLOR_PAIR(THEME_SURFACE_PAIR));
+    state->board.is_valid = FALSE;
+    state->score.is_valid = FALSE;
+    state->level.is_valid = FALSE;
+    state->next.is_valid = FALSE;
+    fire_component(window,
+                   (FireComponentProps){.x = 0,
+                                        .y = getmaxy(window) - 20,
+                                        .height = 20,
+                                        .width = getmaxx(window)});
+  }
+
+  int x = (getmaxx(window) - 32) / 2, y = (getmaxy(window) - 20) / 2;
+  board_component(window, (BoardComponentProps){
+                              .attrs = COLOR_PAIR(THEME_SURFACE_PAIR),
+                              .pos = {.x = x, .y = y},
+                              .data = {.matrix = info->field},
+                              .cache = &state->board,
+                          });
+  counter_component(window, (CounterComponentProps){
+                                .attrs = COLOR_PAIR(THEME_SURFACE_PAIR),
+                                .height = 3,
+                                .width = 12,
+                                .pos = {.x = x + 23, .y = y + 3},
+                                .data = {.title = "score",
+                                         .value = info->score},
+                                .cache = &state->score,
+                            });
+  counter_component(window, (CounterComponentProps){
+                                .attrs = COLOR_PAIR(THEME_SURFACE_PAIR),
+                                .height = 3,
+                                .width = 12,
+                                .pos = {.x = x + 23, .y = y + 7},
+                                .data = {.title = "level",
+                                         .value = info->level},
+                                .cache = &state->level,
+                            });
+  brick_component(window, (BrickComponentProps){
+                              .attrs = COLOR_PAIR(THEME_SURFACE_PAIR),
+                              .width = 12,
+                              .height = 6,
+                              .data = {.title = "next",
+                                       .width = 4,
+                                       .height = 4,
+                                       .matrix = info->next},
+                              .pos = {.x = x + 23, .y = y + 11},
+                              .cache = &state->next,
+                          });
+  wnoutrefresh(window);
+}
+
+/**
+ * @brief Returns the time of a clock.
+ *
+ * @param clock The clock.
+ * @return The time in nanoseconds.
+ */
+static long long clock_now_ns(clockid_t clock) {
+  struct timespec now;
+  clock_gettime(clock, &now);
+  return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ * @brief Returns the CPU time of the process.
+ *
+ * @return The CPU time in nanoseconds.
+ */
+static long long cpu_now_ns(void) {
+  return clock_now_ns(CLOCK_PROCESS_CPUTIME_ID);
+}
+
+/**
+ * @brief Draws and presents frames of a scene, counting what reaches the
+ * terminal.
+ *
+ * The first frames paint the whole screen and are left out of the counts.
+ *
+ * @param renderer The renderer.
+ * @param fd The descriptor the renderer writes to.
+ * @param scene The scene.
+ * @param frames The number of measured frames.
+ * @return The terminal output of the measured frames.
+ */
+RenderBenchResult run_render_bench(Renderer *renderer, int fd,
+                                   RenderBenchScene scene,
+                                   unsigned long frames) {
+  srand(1);
+  RenderBenchState state = {
+      .window = newwin(RENDER_BENCH_HEIGHT, RENDER_BENCH_WIDTH, 0, 0),
+      .tetris = new_simulation_tetris(1, BRICK_DEFAULTS_COUNT),
+  };
+  state.tetris->start(state.tetris);
+  wbkgd(state.window, COLOR_PAIR(THEME_SURFACE_PAIR));
+  if (scene == RENDER_BENCH_IDLE) tetris_dispatch(state.tetris, Pause, false);
+
+  RenderBenchResult result = {0};
+  long long started_ns = 0;
+  for (unsigned long frame = 0; frame < RENDER_BENCH_WARMUP_FRAMES + frames;
+       frame++) {
+    if (frame == RENDER_BENCH_WARMUP_FRAMES) {
+      render_bench_count_writes(&result, fd);
+      started_ns = cpu_now_ns();
+    }
+
+    if (scene != RENDER_BENCH_IDLE) play_frame(&state, frame);
+    draw_frame(&state, scene == RENDER_BENCH_FIRE);
+    renderer->present(renderer);
+  }
+  result.cpu_ns = cpu_now_ns() - started_ns;
+  result.frames = frames;
+  render_bench_count_writes(NULL, -1);
+
+  release_subwindow(&state.board.wrapper);
+  release_subwindow(&state.score.wrapper);
+  release_subwindow(&state.level.wrapper);
+  release_subwindow(&state.next.wrapper);
+  delwin(state.window);
+  state.tetris->destroy(state.tetris);
+  return result;
+}
+
+// the game the pipeline scenes show
+static RenderBenchState *pipeline_state = NULL;
+static bool is_pipeline_fire = false;
+static long long pipeline_now_ns = 0;
+
+/**
+ * @brief Model provider of the game screen for the pipeline scenes.
+ *
+ * @return The state of the played game.
+ */
+static GameViewModel provide_pipeline_model(void) {
+  GameInfo_t info = pipeline_state->tetris->data.info;
+  if (is_pipeline_fire && info.level < 8) info.level = 8;
+  return (GameViewModel){.info = info, .now_ns = pipeline_now_ns};
+}
+
+/**
+ * @brief Runs frames of a scene through the full UI pipeline.
+ *
+ * @param renderer The headless renderer.
+ * @param scene The scene.
+ * @param quality The visual quality of the game screen.
+ * @param frames The number of measured frames.
+ * @return The frame rate of the measured frames.
+ */
+RenderPipelineResult run_render_pipeline_bench(Renderer *renderer,
+                                               RenderBenchScene scene,
+                                               QualityLevel quality,
+                                               unsigned long frames) {
+  srand(1);
+  RenderBenchState state = {
+      .tetris = new_simulation_tetris(1, BRICK_DEFAULTS_COUNT),
+  };
+  state.tetris->start(state.tetris);
+  if (scene == RENDER_BENCH_IDLE) tetris_dispatch(state.tetris, Pause, false);
+
+  pipeline_state = &state;
+  is_pipeline_fire = scene == RENDER_BENCH_FIRE;
+  RootView *view = new_root_view(stdscr);
+  view->header->draw = game_header_draw_handler;
+  view->content->draw = game_content_draw_handler;
+  set_game_view_model_provider(provide_pipeline_model);
+  set_game_view_quality(quality);
+  renderer->invalidate(renderer);
+
+  RenderPipelineResult result = {0};
+  long long started_ns = 0, started_cpu_ns = 0;
+  unsigned long started_full_frames = 0;
+  for (unsigned long frame = 0; frame < RENDER_BENCH_WARMUP_FRAMES + frames;
+       frame++) {
+    if (frame == RENDER_BENCH_WARMUP_FRAMES) {
+      started_ns = clock_now_ns(CLOCK_MONOTONIC);
+      started_cpu_ns = cpu_now_ns();
+      started_full_frames = get_game_view_stats().full_frames;
+    }
+
+    // the frames come at 60 per second of the virtual time
+    pipeline_now_ns = 1000000000LL + frame * (1000000000LL / 60);
+    if (scene != RENDER_BENCH_IDLE) play_frame(&state, frame);
+    view->update(view);
+    renderer->present(renderer);
+  }
+  result.wall_ns = clock_now_ns(CLOCK_MONOTONIC) - started_ns;
+  result.cpu_ns = cpu_now_ns() - started_cpu_ns;
+  result.full_frames = get_game_view_stats().full_frames - started_full_frames;
+  result.frames = frames;
+
+  release_game_view();
+  set_game_view_quality(QUALITY_FULL);
+  set_game_view_model_provider(NULL);
+  view->destroy(view);
+  pipeline_state = NULL;
+  state.tetris->destroy(state.tetris);
+  return result;
+}
@@ -0,0 +1,105 @@
+#ifndef TOOLS_RENDER_BENCH_RENDER_BENCH_H
+#define TOOLS_RENDER_BENCH_RENDER_BENCH_H
+
+#include <stdbool.h>
+
+#include "../../brick_game/tetris/tetris.h"
+#include "../../gui/cli/cli.h"
+
+#define RENDER_BENCH_HEIGHT 40
+#define RENDER_BENCH_WIDTH 120
+#define RENDER_BENCH_WARMUP_FRAMES 10
+#define RENDER_BENCH_TICK_FRAMES 5
+
+/**
+ * @brief Enumeration of the benchmarked scenes.
+ *
+ * @enum RenderBenchScene
+ * @var RENDER_BENCH_IDLE A paused game, no cell changes.
+ * @var RENDER_BENCH_PLAY A game played by random moves.
+ * @var RENDER_BENCH_FIRE A game played by random moves over the fire of the
+ * high levels.
+ */
+typedef enum {
+  RENDER_BENCH_IDLE = 0,
+  RENDER_BENCH_PLAY,
+  RENDER_BENCH_FIRE,
+} RenderBenchScene;
+
+/**
+ * @brief Terminal output of a benchmark run.
+ *
+ * @struct RenderBenchResult
+ * @var frames Number of measured frames.
+ * @var bytes Number of bytes written to the terminal.
+ * @var writes Number of `write` calls on the terminal.
+ * @var cpu_ns CPU time spent drawing and presenting the frames.
+ */
+typedef struct {
+  unsigned long frames;
+  unsigned long bytes;
+  unsigned long writes;
+  long long cpu_ns;
+} RenderBenchResult;
+
+/**
+ * @brief Counts a `write` call, provided by the benchmark driver.
+ *
+ * @param result Where the calls on the terminal descriptor are counted.
+ * @param fd The terminal descriptor.
+ */
+void render_bench_count_writes(RenderBenchResult *result, int fd);
+
+/**
+ * @brief Draws and presents frames of a scene, counting what reaches the
+ * terminal.
+ *
+ * The screen must be open. Every run plays the same game, so runs of
+ * different renderers are comparable.
+ *
+ * @param renderer The renderer.
+ * @param fd The descriptor the renderer writes to.
+ * @param scene The scene.
+ * @param frames The number of measured frames.
+ * @return The terminal output of the measured frames.
+ */
+RenderBenchResult run_render_bench(Renderer *renderer, int fd,
+                                   RenderBenchScene scene,
+                                   unsigned long frames);
+
+/**
+ * @brief Frame rate of the full UI pipeline.
+ *
+ * @struct RenderPipelineResult
+ * @var frames Number of measured frames.
+ * @var wall_ns Wall time spent on the frames.
+ * @var cpu_ns CPU time spent on the frames.
+ * @var full_frames Number of frames that redrew the whole content window.
+ */
+typedef struct {
+  unsigned long frames;
+  long long wall_ns;
+  long long cpu_ns;
+  unsigned long full_frames;
+} RenderPipelineResult;
+
+/**
+ * @brief Runs frames of a scene through the full UI pipeline: the root view
+ * with the layout handlers of the game screen, every component, and a
+ * presented frame of the headless renderer.
+ *
+ * The headless renderer must be started. The fire scene forces the level of
+ * the played game to the fire levels.
+ *
+ * @param renderer The headless renderer.
+ * @param scene The scene.
+ * @param quality The visual quality of the game screen.
+ * @param frames The number of measured frames.
+ * @return The frame rate of the measured frames.
+ */
+RenderPipelineResult run_render_pipeline_bench(Renderer *renderer,
+                                               RenderBenchScene scene,
+                                               QualityLevel quality,
+                                               unsigned long frames);
+
+#endif  // !TOOLS_RENDER_BENCH_RENDER_BENCH_H
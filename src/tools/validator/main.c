@@ -0,0 +1,130 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "validator.h"
+
+static Validator *running_validator = NULL;
+
+/**
+ * @brief Stops the running service on SIGINT/SIGTERM.
+ *
+ * @param signum The received signal.
+ */
+static void on_stop_signal(int signum) {
+  (void)signum;
+  if (running_validator) running_validator->is_running = false;
+}
+
+/**
+ * @brief Prints the command line usage.
+ *
+ * @param name The program name.
+ */
+static void usage(const char *name) {
+  fprintf(stderr,
+          "usage:\n"
+          "  %s serve <socket> [workers] [queue]  run the validation service\n"
+          "  %s submit <socket> <score> <replay>  submit a replay\n"
+          "  %s stats <socket>                    print service stats\n"
+          "  %s check <score> <replay>            validate a replay locally\n",
+          name, name, name, name);
+}
+
+/**
+ * @brief Runs the validation service until interrupted.
+ */
+static int serve_command(int argc, char **argv) {
+  ValidatorConfig config = {.socket_path = argv[2],
+                            .workers = argc > 3 ? strtoul(argv[3], NULL, 10)
+                                                : 4,
+                            .queue_capacity =
+                                argc > 4 ? strtoul(argv[4], NULL, 10) : 64,
+                            .report_interval_sec = 10};
+
+  struct sigaction action = {.sa_handler = on_stop_signal};
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+
+  running_validator = new_validator(config);
+  fprintf(stderr, "validator: listening on %s (%zu workers, queue %zu)\n",
+          config.socket_path, running_validator->config.workers,
+          running_validator->config.queue_capacity);
+  int status = running_validator->serve(running_validator);
+
+  ValidatorStats stats = running_validator->get_stats(running_validator);
+  running_validator->destroy(running_validator);
+  running_validator = NULL;
+
+  fprintf(stderr,
+          "validator: accepted=%lu rejected=%lu busy=%lu p50=%.3fms "
+          "p99=%.3fms\n",
+          stats.accepted, stats.rejected, stats.busy, stats.p50_ms,
+          stats.p99_ms);
+  return status ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/**
+ * @brief Submits a replay file to a running service.
+ */
+static int submit_command(char **argv) {
+  size_t size = 0;
+  uint8_t *replay = read_replay_file(argv[4], &size);
+  if (!replay) {
+    fprintf(stderr, "validator: cannot read %s\n", argv[4]);
+    return EXIT_FAILURE;
+  }
+
+  char reply[VALIDATOR_REPLY_SIZE];
+  int status = submit_replay(argv[2], atoi(argv[3]), replay, size, reply,
+                             sizeof(reply));
+  free(replay);
+  if (status) {
+    fprintf(stderr, "validator: cannot connect to %s\n", argv[2]);
+    return EXIT_FAILURE;
+  }
+  fputs(reply, stdout);
+  return strncmp(reply, "ACCEPT", 6) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/**
+ * @brief Validates a replay file in process.
+ */
+static int check_command(char **argv) {
+  size_t size = 0;
+  uint8_t *replay = read_replay_file(argv[3], &size);
+  if (!replay) {
+    fprintf(stderr, "validator: cannot read %s\n", argv[3]);
+    return EXIT_FAILURE;
+  }
+
+  ReplaySimulation result = simulate_replay(replay, size, atoi(argv[2]));
+  free(replay);
+  printf("%s score=%d level=%d ticks=%zu actions=%zu duration=%.1fs\n",
+         replay_verdict_str(result.verdict), result.score, result.level,
+         result.ticks, result.actions, result.duration_ns / 1e9);
+  return result.verdict == REPLAY_VERDICT_OK ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char **argv) {
+  signal(SIGPIPE, SIG_IGN);
+
+  int status = EXIT_FAILURE;
+  if (argc >= 3 && !strcmp(argv[1], "serve")) {
+    status = serve_command(argc, argv);
+  } else if (argc == 5 && !strcmp(argv[1], "submit")) {
+    status = submit_command(argv);
+  } else if (argc == 3 && !strcmp(argv[1], "stats")) {
+    char reply[VALIDATOR_REPLY_SIZE];
+    status = request_validator_stats(argv[2], reply, sizeof(reply));
+    if (!status) fputs(reply, stdout);
+  } else if (argc == 4 && !strcmp(argv[1], "check")) {
+    status = check_command(argv);
+  } else {
+    usage(argv[0]);
+  }
+  return status;
+}
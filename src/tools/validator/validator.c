@@ -0,0 +1,627 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "validator.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * @brief Returns the current monotonic time.
+ *
+ * @return The current CLOCK_MONOTONIC time.
+ */
+static struct timespec monotonic_now() {
+  struct timespec now = {0};
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now;
+}
+
+/**
+ * @brief Returns the monotonic time some milliseconds from now.
+ *
+ * @param ms The number of milliseconds.
+ * @return The time.
+ */
+static struct timespec deadline_in(long ms) {
+  struct timespec deadline = monotonic_now();
+  deadline.tv_sec += ms / 1000;
+  deadline.tv_nsec += ms % 1000 * 1000000L;
+  if (deadline.tv_nsec >= 1000000000L) {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000L;
+  }
+  return deadline;
+}
+
+/**
+ * @brief Writes exactly `size` bytes to a socket.
+ *
+ * @param fd The socket.
+ * @param buffer Source buffer.
+ * @param size Number of bytes to write.
+ * @return true if all bytes were written, false on error.
+ */
+static bool write_exact(int fd, const void *buffer, size_t size) {
+  size_t done = 0;
+  while (done < size) {
+    ssize_t put = write(fd, (const uint8_t *)buffer + done, size - done);
+    if (put < 0 && errno == EINTR) continue;
+    if (put <= 0) return false;
+    done += (size_t)put;
+  }
+  return true;
+}
+
+/**
+ * @brief Writes a reply line and closes the client socket.
+ *
+ * @param client The client socket.
+ * @param reply The zero terminated reply line.
+ */
+static void reply_and_close(int client, const char *reply) {
+  write_exact(client, reply, strlen(reply));
+  close(client);
+}
+
+/**
+ * @brief Comparator for qsort over latency samples.
+ */
+static int compare_latency(const void *a, const void *b) {
+  long long lhs = *(const long long *)a;
+  long long rhs = *(const long long *)b;
+  return (lhs > rhs) - (lhs < rhs);
+}
+
+/**
+ * @brief Computes the current counters and latency percentiles.
+ *
+ * Percentiles are computed over the last VALIDATOR_LATENCY_SAMPLES samples.
+ *
+ * @param self A pointer to the Validator instance.
+ * @return A snapshot of the stats.
+ */
+static ValidatorStats _get_stats(Validator *self) {
+  long long sorted[VALIDATOR_LATENCY_SAMPLES];
+
+  pthread_mutex_lock(&self->lock);
+  ValidatorStats stats = self->stats;
+  size_t count = self->latencies_count < VALIDATOR_LATENCY_SAMPLES
+                     ? self->latencies_count
+                     : VALIDATOR_LATENCY_SAMPLES;
+  memcpy(sorted, self->latencies, count * sizeof(long long));
+  pthread_mutex_unlock(&self->lock);
+
+  qsort(sorted, count, sizeof(long long), compare_latency);
+  stats.samples = count;
+  if (count) {
+    stats.p50_ms = sorted[(count - 1) / 2] / 1e6;
+    stats.p99_ms = sorted[((count - 1) * 99) / 100] / 1e6;
+  }
+  return stats;
+}
+
+/**
+ * @brief Formats the stats as a single line.
+ *
+ * @param stats The stats to format.
+ * @param line Destination buffer.
+ * @param size Size of the destination buffer.
+ */
+static void format_stats(ValidatorStats stats, char *line, size_t size) {
+  snprintf(line, size,
+           "STATS accepted=%lu rejected=%lu busy=%lu samples=%zu "
+           "p50_ms=%.3f p99_ms=%.3f\n",
+           stats.accepted, stats.rejected, stats.busy, stats.samples,
+           stats.p50_ms, stats.p99_ms);
+}
+
+/**
+ * @brief Worker thread: pops submissions, simulates their replays and
+ * answers.
+ *
+ * @param arg A pointer to the Validator instance.
+ * @return NULL.
+ */
+static void *worker_routine(void *arg) {
+  Validator *self = (Validator *)arg;
+
+  while (true) {
+    pthread_mutex_lock(&self->lock);
+    while (self->is_running && !self->jobs_count) {
+      pthread_cond_wait(&self->has_jobs, &self->lock);
+    }
+    if (!self->jobs_count) {
+      pthread_mutex_unlock(&self->lock);
+      break;
+    }
+    ValidatorJob job = self->jobs[self->jobs_head];
+    self->jobs_head = (self->jobs_head + 1) % self->config.queue_capacity;
+    self->jobs_count--;
+    pthread_mutex_unlock(&self->lock);
+
+    ReplaySimulation result =
+        simulate_replay(job.replay, job.replay_size, job.claimed_score);
+    free(job.replay);
+
+    char reply[VALIDATOR_REPLY_SIZE];
+    if (result.verdict == REPLAY_VERDICT_OK) {
+      snprintf(reply, sizeof(reply), "ACCEPT score=%d level=%d ticks=%zu\n",
+               result.score, result.level, result.ticks);
+    } else {
+      snprintf(reply, sizeof(reply), "REJECT %s score=%d\n",
+               replay_verdict_str(result.verdict), result.score);
+    }
+    reply_and_close(job.client, reply);
+
+    long long latency = timespec_diff_ns(monotonic_now(), job.enqueued_at);
+    pthread_mutex_lock(&self->lock);
+    if (result.verdict == REPLAY_VERDICT_OK) {
+      self->stats.accepted++;
+    } else {
+      self->stats.rejected++;
+    }
+    self->latencies[self->latencies_count % VALIDATOR_LATENCY_SAMPLES] =
+        latency;
+    self->latencies_count++;
+    pthread_mutex_unlock(&self->lock);
+  }
+  return NULL;
+}
+
+/**
+ * @brief Refuses a client with BUSY and closes it.
+ *
+ * @param self A pointer to the Validator instance.
+ * @param client The client socket.
+ * @param reply The zero terminated BUSY line.
+ */
+static void refuse_busy(Validator *self, int client, const char *reply) {
+  pthread_mutex_lock(&self->lock);
+  self->stats.busy++;
+  pthread_mutex_unlock(&self->lock);
+  reply_and_close(client, reply);
+}
+
+/**
+ * @brief Pushes a complete submission to the queue of the workers.
+ *
+ * @param self A pointer to the Validator instance.
+ * @param job The submission, its replay belongs to the queue once queued.
+ * @return true if it was queued, false if the queue is full.
+ */
+static bool queue_job(Validator *self, ValidatorJob job) {
+  pthread_mutex_lock(&self->lock);
+  bool is_full = self->jobs_count >= self->config.queue_capacity;
+  if (!is_full) {
+    size_t tail = (self->jobs_head + self->jobs_count) %
+                  self->config.queue_capacity;
+    self->jobs[tail] = job;
+    self->jobs_count++;
+    pthread_cond_signal(&self->has_jobs);
+  }
+  pthread_mutex_unlock(&self->lock);
+  return !is_full;
+}
+
+/**
+ * @brief Returns whether the queue of the workers is full.
+ *
+ * @param self A pointer to the Validator instance.
+ * @return true if a submission would be refused.
+ */
+static bool is_queue_full(Validator *self) {
+  pthread_mutex_lock(&self->lock);
+  bool is_full = self->jobs_count >= self->config.queue_capacity;
+  pthread_mutex_unlock(&self->lock);
+  return is_full;
+}
+
+/**
+ * @brief Answers a request that did not arrive whole and closes it.
+ *
+ * @param connection The pending connection.
+ */
+static void drop_connection(ValidatorConnection *connection) {
+  ValidatorJob *job = &connection->job;
+  if (job->replay) {
+    reply_and_close(job->client, "REJECT truncated replay\n");
+  } else if (connection->header_read >= 4) {
+    reply_and_close(job->client, "REJECT bad request\n");
+  } else {
+    close(job->client);
+  }
+  free(job->replay);
+  job->replay = NULL;
+}
+
+/**
+ * @brief Handles a complete request header.
+ *
+ * Stats requests are answered at once. A submission with a bad size is
+ * rejected and one that finds the queue full gets BUSY before its replay is
+ * read, otherwise the buffer of its replay is allocated.
+ *
+ * @param self A pointer to the Validator instance.
+ * @param connection The pending connection.
+ * @return true if the replay is to be read, false if the connection was
+ * answered and closed.
+ */
+static bool handle_header(Validator *self, ValidatorConnection *connection) {
+  ValidatorJob *job = &connection->job;
+  const uint8_t *header = connection->header;
+  if (!memcmp(header, VALIDATOR_STATS_MAGIC, 4)) {
+    char line[VALIDATOR_REPLY_SIZE];
+    format_stats(self->get_stats(self), line, sizeof(line));
+    reply_and_close(job->client, line);
+    return false;
+  }
+  if (memcmp(header, VALIDATOR_SUBMIT_MAGIC, 4)) {
+    reply_and_close(job->client, "REJECT bad request\n");
+    return false;
+  }
+  if (connection->header_read < VALIDATOR_HEADER_SIZE) return true;
+
+  int32_t score = 0;
+  uint32_t size = 0;
+  for (int i = 0; i < 4; i++) {
+    score |= (int32_t)header[4 + i] << (8 * i);
+    size |= (uint32_t)header[8 + i] << (8 * i);
+  }
+  if (!size || size > VALIDATOR_MAX_REPLAY_SIZE) {
+    reply_and_close(job->client, "REJECT bad size\n");
+    return false;
+  }
+  if (is_queue_full(self)) {
+    refuse_busy(self, job->client, "BUSY queue full\n");
+    return false;
+  }
+  job->claimed_score = score;
+  job->replay_size = size;
+  job->replay = malloc(size);
+  if (!job->replay) {
+    refuse_busy(self, job->client, "BUSY out of memory\n");
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Reads everything a pending client sent so far, without blocking.
+ *
+ * The header is read in two steps, the magic first, since a stats request has
+ * nothing else. A submission is queued once its whole replay arrived, so a
+ * worker never waits for a client.
+ *
+ * @param self A pointer to the Validator instance.
+ * @param connection The pending connection.
+ * @return true while the request is incomplete, false once the connection
+ * was queued or closed.
+ */
+static bool read_connection(Validator *self, ValidatorConnection *connection) {
+  ValidatorJob *job = &connection->job;
+  while (true) {
+    bool is_header = connection->header_read < VALIDATOR_HEADER_SIZE;
+    uint8_t *buffer = is_header ? connection->header + connection->header_read
+                                : job->replay + connection->replay_read;
+    size_t size = is_header ? (connection->header_read < 4
+                                   ? 4 - connection->header_read
+                                   : VALIDATOR_HEADER_SIZE -
+                                         connection->header_read)
+                            : job->replay_size - connection->replay_read;
+
+    ssize_t got = read(job->client, buffer, size);
+    if (got < 0 && errno == EINTR) continue;
+    if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+    if (got <= 0) {
+      drop_connection(connection);
+      return false;
+    }
+
+    if (is_header) {
+      connection->header_read += (size_t)got;
+      if (connection->header_read >= 4 && !handle_header(self, connection)) {
+        return false;
+      }
+    } else if ((connection->replay_read += (size_t)got) == job->replay_size) {
+      int flags = fcntl(job->client, F_GETFL);
+      fcntl(job->client, F_SETFL, flags & ~O_NONBLOCK);
+      job->enqueued_at = monotonic_now();
+      if (!queue_job(self, *job)) {
+        free(job->replay);
+        refuse_busy(self, job->client, "BUSY queue full\n");
+      }
+      return false;
+    }
+  }
+}
+
+/**
+ * @brief Accepts a client and adds it to the pending connections.
+ *
+ * A client that finds all `pending_capacity` connections taken is answered
+ * with BUSY at once. The others must send their whole request within
+ * `VALIDATOR_REQUEST_TIMEOUT_MS`.
+ *
+ * @param self A pointer to the Validator instance.
+ * @param server The listening socket.
+ */
+static void accept_connection(Validator *self, int server) {
+  int client = accept(server, NULL, NULL);
+  if (client < 0) return;
+  if (self->pending_count >= self->config.pending_capacity) {
+    refuse_busy(self, client, "BUSY too many clients\n");
+    return;
+  }
+
+  int flags = fcntl(client, F_GETFL);
+  fcntl(client, F_SETFL, flags | O_NONBLOCK);
+  self->pending[self->pending_count++] = (ValidatorConnection){
+      .job = {.client = client},
+      .deadline = deadline_in(VALIDATOR_REQUEST_TIMEOUT_MS)};
+}
+
+/**
+ * @brief Returns the milliseconds until the earliest pending deadline.
+ *
+ * @param self A pointer to the Validator instance.
+ * @param limit_ms The longest wait.
+ * @return The wait, at most `limit_ms`.
+ */
+static int next_deadline_ms(Validator *self, int limit_ms) {
+  struct timespec now = monotonic_now();
+  long long wait_ms = limit_ms;
+  for (size_t i = 0; i < self->pending_count; i++) {
+    long long left_ms =
+        (timespec_diff_ns(self->pending[i].deadline, now) + 999999) / 1000000;
+    if (left_ms < wait_ms) wait_ms = left_ms > 0 ? left_ms : 0;
+  }
+  return (int)wait_ms;
+}
+
+/**
+ * @brief Binds the service socket and runs the accept loop until `stop`.
+ *
+ * A single `poll` waits for new clients and for the requests of the pending
+ * ones, and wakes up for the earliest deadline of a request, so a slow client
+ * only ever holds its own connection slot.
+ *
+ * @param self A pointer to the Validator instance.
+ * @return 0 on a clean shutdown, -1 if the socket cannot be bound.
+ */
+static int _serve(Validator *self) {
+  int server = socket(AF_UNIX, SOCK_STREAM, 0);
+  struct sockaddr_un address = {.sun_family = AF_UNIX};
+  strncpy(address.sun_path, self->config.socket_path,
+          sizeof(address.sun_path) - 1);
+  unlink(self->config.socket_path);
+
+  if (server < 0 ||
+      bind(server, (struct sockaddr *)&address, sizeof(address)) < 0 ||
+      listen(server, 64) < 0) {
+    perror("validator");
+    if (server >= 0) close(server);
+    return -1;
+  }
+
+  struct pollfd *fds = calloc(self->config.pending_capacity + 1,
+                              sizeof(struct pollfd));
+  if (!fds) {
+    fprintf(stderr, "Cannot allocate mem for Validator\n");
+    exit(-1);
+  }
+
+  struct timespec last_report = monotonic_now();
+  while (self->is_running) {
+    fds[0] = (struct pollfd){.fd = server, .events = POLLIN};
+    for (size_t i = 0; i < self->pending_count; i++) {
+      fds[i + 1] =
+          (struct pollfd){.fd = self->pending[i].job.client, .events = POLLIN};
+    }
+    int ready = poll(fds, self->pending_count + 1, next_deadline_ms(self, 200));
+
+    // backwards, a finished connection is replaced by the last one, which
+    // was already handled
+    struct timespec now = monotonic_now();
+    for (size_t i = self->pending_count; i-- > 0;) {
+      ValidatorConnection *connection = &self->pending[i];
+      bool is_pending = true;
+      if (ready > 0 && fds[i + 1].revents) {
+        is_pending = read_connection(self, connection);
+      } else if (timespec_diff_ns(connection->deadline, now) <= 0) {
+        drop_connection(connection);
+        is_pending = false;
+      }
+      if (!is_pending) {
+        *connection = self->pending[--self->pending_count];
+      }
+    }
+    if (ready > 0 && (fds[0].revents & POLLIN)) {
+      accept_connection(self, server);
+    }
+
+    if (self->config.report_interval_sec > 0 &&
+        timespec_diff_ns(now, last_report) / 1000000000LL >=
+            self->config.report_interval_sec) {
+      char line[VALIDATOR_REPLY_SIZE];
+      format_stats(self->get_stats(self), line, sizeof(line));
+      fputs(line, stderr);
+      last_report = now;
+    }
+  }
+
+  for (size_t i = 0; i < self->pending_count; i++) {
+    drop_connection(&self->pending[i]);
+  }
+  self->pending_count = 0;
+  free(fds);
+  close(server);
+  unlink(self->config.socket_path);
+  return 0;
+}
+
+/**
+ * @brief Stops the accept loop and wakes up the workers.
+ *
+ * Queued submissions are still validated before the workers exit.
+ *
+ * @param self A pointer to the Validator instance.
+ */
+static void _stop(Validator *self) {
+  if (!self) return;
+  pthread_mutex_lock(&self->lock);
+  self->is_running = false;
+  pthread_cond_broadcast(&self->has_jobs);
+  pthread_mutex_unlock(&self->lock);
+}
+
+/**
+ * @brief Joins the workers and frees the service.
+ *
+ * @param self A pointer to the Validator instance.
+ */
+static void _destroy(Validator *self) {
+  if (!self) return;
+
+  self->stop(self);
+  for (size_t i = 0; i < self->config.workers; i++) {
+    pthread_join(self->threads[i], NULL);
+  }
+  pthread_cond_destroy(&self->has_jobs);
+  pthread_mutex_destroy(&self->lock);
+  free(self->threads);
+  free(self->jobs);
+  free(self->pending);
+  free(self);
+}
+
+/**
+ * @brief Allocates the service and starts its worker threads.
+ *
+ * If memory allocation fails, the function prints an error message to stderr
+ * and exits the program with a failure status.
+ *
+ * @param config The service configuration.
+ * @return A pointer to the newly created Validator instance.
+ */
+Validator *new_validator(ValidatorConfig config) {
+  if (!config.workers) config.workers = 1;
+  if (!config.queue_capacity) config.queue_capacity = 1;
+  if (!config.pending_capacity) config.pending_capacity = VALIDATOR_PENDING_MAX;
+
+  Validator *self = (Validator *)calloc(1, sizeof(Validator));
+  if (self) {
+    self->pending =
+        calloc(config.pending_capacity, sizeof(ValidatorConnection));
+    self->jobs = calloc(config.queue_capacity, sizeof(ValidatorJob));
+    self->threads = calloc(config.workers, sizeof(pthread_t));
+  }
+  if (!self || !self->pending || !self->jobs || !self->threads) {
+    fprintf(stderr, "Cannot allocate mem for Validator\n");
+    exit(-1);
+  }
+
+  self->config = config;
+  self->is_running = true;
+  pthread_mutex_init(&self->lock, NULL);
+  pthread_cond_init(&self->has_jobs, NULL);
+
+  self->serve = _serve;
+  self->stop = _stop;
+  self->get_stats = _get_stats;
+  self->destroy = _destroy;
+
+  for (size_t i = 0; i < config.workers; i++) {
+    pthread_create(&self->threads[i], NULL, worker_routine, self);
+  }
+  return self;
+}
+
+/**
+ * @brief Connects to the service socket.
+ *
+ * @param socket_path Path of the service socket.
+ * @return The connected socket or -1.
+ */
+static int connect_validator(const char *socket_path) {
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  struct sockaddr_un address = {.sun_family = AF_UNIX};
+  strncpy(address.sun_path, socket_path, sizeof(address.sun_path) - 1);
+  if (fd >= 0 &&
+      connect(fd, (struct sockaddr *)&address, sizeof(address)) < 0) {
+    close(fd);
+    fd = -1;
+  }
+  return fd;
+}
+
+/**
+ * @brief Reads a reply line until EOF.
+ *
+ * @param fd The connected socket.
+ * @param reply Destination buffer.
+ * @param reply_size Size of the destination buffer.
+ */
+static void read_reply(int fd, char *reply, size_t reply_size) {
+  size_t done = 0;
+  ssize_t got = 0;
+  while (done + 1 < reply_size &&
+         (got = read(fd, reply + done, reply_size - done - 1)) > 0) {
+    done += (size_t)got;
+  }
+  reply[done] = '\0';
+}
+
+/**
+ * @brief Submits a replay to a running service and waits for the verdict.
+ *
+ * @param socket_path Path of the service socket.
+ * @param score The claimed score.
+ * @param replay The encoded replay.
+ * @param size The size of the encoded replay.
+ * @param reply Buffer for the verdict line.
+ * @param reply_size Size of the reply buffer.
+ * @return 0 on success, -1 if the service cannot be reached.
+ */
+int submit_replay(const char *socket_path, int score, const uint8_t *replay,
+                  size_t size, char *reply, size_t reply_size) {
+  int fd = connect_validator(socket_path);
+  if (fd < 0) return -1;
+
+  uint8_t header[12];
+  memcpy(header, VALIDATOR_SUBMIT_MAGIC, 4);
+  for (int i = 0; i < 4; i++) {
+    header[4 + i] = (uint8_t)((uint32_t)score >> (8 * i));
+    header[8 + i] = (uint8_t)((uint32_t)size >> (8 * i));
+  }
+  // the service may answer BUSY before the body is sent, ignore EPIPE then
+  if (write_exact(fd, header, sizeof(header))) write_exact(fd, replay, size);
+  read_reply(fd, reply, reply_size);
+  close(fd);
+  return 0;
+}
+
+/**
+ * @brief Requests the stats line of a running service.
+ *
+ * @param socket_path Path of the service socket.
+ * @param reply Buffer for the stats line.
+ * @param reply_size Size of the reply buffer.
+ * @return 0 on success, -1 if the service cannot be reached.
+ */
+int request_validator_stats(const char *socket_path, char *reply,
+                            size_t reply_size) {
+  int fd = connect_validator(socket_path);
+  if (fd < 0) return -1;
+
+  write_exact(fd, VALIDATOR_STATS_MAGIC, 4);
+  read_reply(fd, reply, reply_size);
+  close(fd);
+  return 0;
+}
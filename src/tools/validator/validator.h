@@ -0,0 +1,186 @@
+#ifndef TOOLS_VALIDATOR_VALIDATOR_H
+#define TOOLS_VALIDATOR_VALIDATOR_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../../brick_game/tetris/tetris.h"
+
+#define VALIDATOR_SUBMIT_MAGIC "S21V"
+#define VALIDATOR_STATS_MAGIC "S21S"
+#define VALIDATOR_MAX_REPLAY_SIZE (16 * 1024 * 1024)
+#define VALIDATOR_LATENCY_SAMPLES 4096
+#define VALIDATOR_REPLY_SIZE 128
+#define VALIDATOR_HEADER_SIZE 12
+// connections being read at once, when config.pending_capacity is 0
+#define VALIDATOR_PENDING_MAX 64
+// how long a client may take to send its whole request
+#define VALIDATOR_REQUEST_TIMEOUT_MS 10000
+
+/**
+ * @brief Configuration of the validation service.
+ *
+ * @struct ValidatorConfig
+ * @var socket_path Path of the Unix socket the service listens on.
+ * @var workers Number of simulation worker threads.
+ * @var queue_capacity Maximum number of submissions waiting for a worker.
+ * Submissions arriving while the queue is full are answered with BUSY.
+ * @var pending_capacity Maximum number of connections whose request is still
+ * being read, 0 for `VALIDATOR_PENDING_MAX`. Clients connecting while all of
+ * them are taken are answered with BUSY.
+ * @var report_interval_sec Interval of the periodic stats report, 0 disables
+ * it.
+ */
+typedef struct {
+  const char *socket_path;
+  size_t workers;
+  size_t queue_capacity;
+  size_t pending_capacity;
+  int report_interval_sec;
+} ValidatorConfig;
+
+/**
+ * @brief A submission waiting for validation.
+ *
+ * @struct ValidatorJob
+ * @var client The client socket the verdict is written to.
+ * @var claimed_score The submitted score.
+ * @var replay The encoded replay, owned by the job.
+ * @var replay_size The size of the encoded replay.
+ * @var enqueued_at Monotonic time the submission was queued at.
+ */
+typedef struct {
+  int client;
+  int claimed_score;
+  uint8_t *replay;
+  size_t replay_size;
+  struct timespec enqueued_at;
+} ValidatorJob;
+
+/**
+ * @brief A connection whose request is still being read.
+ *
+ * @struct ValidatorConnection
+ * @var header The request header read so far.
+ * @var header_read The number of header bytes read.
+ * @var job The submission, once its header is complete.
+ * @var replay_read The number of replay bytes read.
+ * @var deadline The monotonic time the whole request must have arrived by.
+ */
+typedef struct {
+  uint8_t header[VALIDATOR_HEADER_SIZE];
+  size_t header_read;
+  ValidatorJob job;
+  size_t replay_read;
+  struct timespec deadline;
+} ValidatorConnection;
+
+/**
+ * @brief Counters and latency percentiles of the service.
+ *
+ * @struct ValidatorStats
+ * @var accepted Submissions whose replay reproduced the claimed score.
+ * @var rejected Submissions rejected by the simulation.
+ * @var busy Submissions refused because the queue or the pending
+ * connections were full.
+ * @var samples Number of latency samples the percentiles are computed from.
+ * @var p50_ms Median validation latency (queue wait included).
+ * @var p99_ms 99th percentile of the validation latency.
+ */
+typedef struct {
+  unsigned long accepted;
+  unsigned long rejected;
+  unsigned long busy;
+  size_t samples;
+  double p50_ms;
+  double p99_ms;
+} ValidatorStats;
+
+/**
+ * @brief Replay based high score validation service.
+ *
+ * The accepting thread reads the requests of up to `pending_capacity` clients
+ * at once, without blocking, and pushes every complete submission to a
+ * bounded queue. `workers` threads re-simulate the queued replays on a
+ * virtual clock and answer the client with ACCEPT or REJECT.
+ *
+ * @struct __validator
+ * @var config The service configuration.
+ * @var pending The connections whose request is still being read.
+ * @var pending_count Number of pending connections.
+ * @var jobs Ring buffer of queued submissions.
+ * @var jobs_head Index of the oldest queued submission.
+ * @var jobs_count Number of queued submissions.
+ * @var lock Protects the queue and the stats.
+ * @var has_jobs Signalled when a submission is queued or the service stops.
+ * @var threads The worker threads.
+ * @var is_running Cleared to stop the service.
+ * @var stats Verdict counters.
+ * @var latencies Ring buffer of the last latency samples in nanoseconds.
+ * @var latencies_count Total number of latency samples recorded.
+ * @var serve Function pointer running the accept loop until `stop`.
+ * @var stop Function pointer stopping the service.
+ * @var get_stats Function pointer computing the current stats.
+ * @var destroy Function pointer joining the workers and freeing the service.
+ */
+typedef struct __validator {
+  ValidatorConfig config;
+
+  ValidatorConnection *pending;
+  size_t pending_count;
+
+  ValidatorJob *jobs;
+  size_t jobs_head;
+  size_t jobs_count;
+  pthread_mutex_t lock;
+  pthread_cond_t has_jobs;
+
+  pthread_t *threads;
+  volatile bool is_running;
+
+  ValidatorStats stats;
+  long long latencies[VALIDATOR_LATENCY_SAMPLES];
+  size_t latencies_count;
+
+  int (*serve)(struct __validator *self);
+  void (*stop)(struct __validator *self);
+  ValidatorStats (*get_stats)(struct __validator *self);
+  void (*destroy)(struct __validator *self);
+} Validator;
+
+/**
+ * @brief Creates a validation service and starts its worker threads.
+ *
+ * @param config The service configuration.
+ * @return A pointer to the newly created service.
+ */
+Validator *new_validator(ValidatorConfig config);
+
+/**
+ * @brief Submits a replay to a running service and waits for the verdict.
+ *
+ * @param socket_path Path of the service socket.
+ * @param score The claimed score.
+ * @param replay The encoded replay.
+ * @param size The size of the encoded replay.
+ * @param reply Buffer for the verdict line.
+ * @param reply_size Size of the reply buffer.
+ * @return 0 on success, -1 if the service cannot be reached.
+ */
+int submit_replay(const char *socket_path, int score, const uint8_t *replay,
+                  size_t size, char *reply, size_t reply_size);
+
+/**
+ * @brief Requests the stats line of a running service.
+ *
+ * @param socket_path Path of the service socket.
+ * @param reply Buffer for the stats line.
+ * @param reply_size Size of the reply buffer.
+ * @return 0 on success, -1 if the service cannot be reached.
+ */
+int request_validator_stats(const char *socket_path, char *reply,
+                            size_t reply_size);
+
+#endif  // !TOOLS_VALIDATOR_VALIDATOR_H
@@ -0,0 +1,20 @@
+#ifndef TESTS_GUI_TEST_GUI_H
+#define TESTS_GUI_TEST_GUI_H
+
+#include <check.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../../src/gui/cli/cli.h"
+
+Suite *suite_gui__components(void);
+Suite *suite_gui__renderer(void);
+Suite *suite_gui__game_view(void);
+Suite *suite_gui__governor(void);
+Suite *suite_gui__spectator_view(void);
+Suite *suite_gui__loop(void);
+Suite *suite_gui__keyboard(void);
+Suite *suite_gui__recorder(void);
+
+#endif  // !TESTS_GUI_TEST_GUI_H
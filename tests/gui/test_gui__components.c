@@ -0,0 +1,279 @@
+#include "test_gui.h"
+
+// Every heap allocation of the test process is counted, ncurses included, so
+// a test can assert that drawing a frame allocates nothing.
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static unsigned long allocations = 0;
+
+void *malloc(size_t size) {
+  allocations++;
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+  allocations++;
+  return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+  allocations++;
+  return __libc_realloc(ptr, size);
+}
+
+typedef struct {
+  int cells[BOARD_COMPONENT_HEIGHT][BOARD_COMPONENT_WIDTH];
+  int *field[BOARD_COMPONENT_HEIGHT];
+  int next_cells[BRICK_COMPONENT_HEIGHT][BRICK_COMPONENT_WIDTH];
+  int *next[BRICK_COMPONENT_HEIGHT];
+  int score;
+} Model;
+
+typedef struct {
+  BoardComponentCache board;
+  CounterComponentCache score;
+  BrickComponentCache next;
+} Caches;
+
+static SCREEN *open_screen(void) {
+  FILE *output = fopen("/dev/null", "w");
+  FILE *input = fopen("/dev/null", "r");
+  SCREEN *screen = newterm("xterm", output, input);
+  if (screen) provide_pallete();
+  return screen;
+}
+
+static void init_model(Model *model) {
+  *model = (Model){0};
+  for (int row = 0; row < BOARD_COMPONENT_HEIGHT; row++) {
+    model->field[row] = model->cells[row];
+  }
+  for (int row = 0; row < BRICK_COMPONENT_HEIGHT; row++) {
+    model->next[row] = model->next_cells[row];
+  }
+}
+
+// changes a few cells and the score, like a frame of a running game
+static void step_model(Model *model, int frame) {
+  model->cells[(frame * 7) % BOARD_COMPONENT_HEIGHT][frame % 10] =
+      (frame % 8);
+  model->next_cells[frame % 4][(frame / 4) % 4] = (frame % 2) ? 3 : 0;
+  model->score = (frame % 5) ? model->score + 100 : 0;
+}
+
+static void draw_model(WINDOW *window, const Model *model, Caches *caches) {
+  board_component(window, (BoardComponentProps){
+                              .pos = {.x = 1, .y = 1},
+                              .data = {.matrix = (int **)model->field},
+                              .cache = caches ? &caches->board : NULL,
+                          });
+  counter_component(window, (CounterComponentProps){
+                                .pos = {.x = 26, .y = 1},
+                                .width = 12,
+                                .height = 3,
+                                .data = {.title = "score",
+                                         .value = model->score},
+                                .cache = caches ? &caches->score : NULL,
+                            });
+  brick_component(window, (BrickComponentProps){
+                              .pos = {.x = 26, .y = 5},
+                              .width = 12,
+                              .height = 6,
+                              .data = {.title = "next",
+                                       .width = 4,
+                                       .height = 4,
+                                       .matrix = (int **)model->next},
+                              .cache = caches ? &caches->next : NULL,
+                          });
+}
+
+static void release_caches(Caches *caches) {
+  release_subwindow(&caches->board.wrapper);
+  release_subwindow(&caches->score.wrapper);
+  release_subwindow(&caches->next.wrapper);
+}
+
+START_TEST(gui_components__no_allocations_per_frame) {
+  SCREEN *screen = open_screen();
+  ck_assert_ptr_nonnull(screen);
+
+  WINDOW *window = newwin(30, 60, 0, 0);
+  Model model;
+  init_model(&model);
+  Caches caches = {0};
+
+  // the first frames build the windows and the ncurses buffers
+  for (int frame = 0; frame < 3; frame++) {
+    step_model(&model, frame);
+    draw_model(window, &model, &caches);
+    fire_component(window, (FireComponentProps){
+                               .x = 0, .y = 10, .width = 60, .height = 20});
+    wnoutrefresh(window);
+    doupdate();
+  }
+
+  allocations = 0;
+  for (int frame = 3; frame < 200; frame++) {
+    step_model(&model, frame);
+    draw_model(window, &model, &caches);
+    fire_component(window, (FireComponentProps){
+                               .x = 0, .y = 10, .width = 60, .height = 20});
+    wnoutrefresh(window);
+    doupdate();
+  }
+  ck_assert_uint_eq(allocations, 0);
+
+  // a resized parent rebuilds the windows once
+  WINDOW *board_window = caches.board.wrapper.window;
+  wresize(window, 32, 64);
+  draw_model(window, &model, &caches);
+  ck_assert_ptr_ne(caches.board.wrapper.window, board_window);
+  ck_assert_uint_gt(allocations, 0);
+
+  release_caches(&caches);
+  delwin(window);
+  endwin();
+  delscreen(screen);
+}
+END_TEST
+
+START_TEST(gui_components__incremental_matches_full) {
+  SCREEN *screen = open_screen();
+  ck_assert_ptr_nonnull(screen);
+
+  WINDOW *incremental = newwin(24, 40, 0, 0);
+  WINDOW *full = newwin(24, 40, 0, 0);
+  Model model;
+  init_model(&model);
+  Caches caches = {0};
+
+  for (int frame = 0; frame < 100; frame++) {
+    step_model(&model, frame);
+    draw_model(incremental, &model, &caches);
+
+    werase(full);
+    draw_model(full, &model, NULL);
+
+    for (int y = 0; y < getmaxy(full); y++) {
+      for (int x = 0; x < getmaxx(full); x++) {
+        ck_assert_uint_eq(mvwinch(incremental, y, x), mvwinch(full, y, x));
+      }
+    }
+  }
+
+  release_caches(&caches);
+  delwin(incremental);
+  delwin(full);
+  endwin();
+  delscreen(screen);
+}
+END_TEST
+
+START_TEST(gui_components__fire_kernel_matches_scalar) {
+  enum { HEIGHT = 6, MAX_WIDTH = 100 };
+  static uint8_t heat[(MAX_WIDTH + 1) * (HEIGHT + 1)];
+  static uint8_t next[(MAX_WIDTH + 1) * (HEIGHT + 1)];
+
+  srand(21);
+  for (int width = 1; width <= MAX_WIDTH; width++) {
+    int stride = width + 1;
+    for (int i = 0; i < stride * (HEIGHT + 1); i++) {
+      heat[i] = (uint8_t)(rand() % (FIRE_COMPONENT_HEAT + 1));
+    }
+    cool_fire_rows(heat, next, width, HEIGHT, stride);
+
+    for (int y = 0; y < HEIGHT; y++) {
+      for (int x = 0; x < width; x++) {
+        const uint8_t *cell = heat + y * stride + x;
+        int expected =
+            (cell[0] + cell[1] + cell[stride] + cell[stride + 1]) / 4;
+        ck_assert_int_eq(next[y * stride + x], expected);
+      }
+    }
+  }
+}
+END_TEST
+
+START_TEST(gui_components__fire_runs_at_fixed_rate) {
+  SCREEN *screen = open_screen();
+  ck_assert_ptr_nonnull(screen);
+
+  WINDOW *window = newwin(20, 61, 0, 0);
+  FireComponentCache cache = {0};
+  FireComponentProps props = {
+      .width = 61, .height = 20, .now_ns = 1000000000LL, .cache = &cache};
+
+  fire_component(window, props);
+  ck_assert_uint_eq(cache.steps, 1);
+
+  // frames faster than the simulation redraw the same fire
+  fire_component(window, props);
+  props.now_ns += FIRE_COMPONENT_STEP_NS / 2;
+  fire_component(window, props);
+  ck_assert_uint_eq(cache.steps, 1);
+
+  props.now_ns += FIRE_COMPONENT_STEP_NS * 2;
+  fire_component(window, props);
+  ck_assert_uint_eq(cache.steps, 3);
+
+  // a stall does not have to be caught up
+  props.now_ns += FIRE_COMPONENT_STEP_NS * 1000;
+  fire_component(window, props);
+  ck_assert_uint_eq(cache.steps, 3 + FIRE_COMPONENT_MAX_STEPS);
+  props.now_ns += FIRE_COMPONENT_STEP_NS;
+  fire_component(window, props);
+  ck_assert_uint_eq(cache.steps, 4 + FIRE_COMPONENT_MAX_STEPS);
+
+  // the fire stays in the glyphs of its heat however long it burns
+  for (int frame = 0; frame < 500; frame++) {
+    props.now_ns += FIRE_COMPONENT_STEP_NS;
+    fire_component(window, props);
+  }
+  for (int i = 0; i < cache.width * cache.height; i++) {
+    ck_assert_uint_le(cache.heat[(i / cache.width) * cache.stride +
+                                 i % cache.width],
+                      FIRE_COMPONENT_HEAT);
+  }
+  // every cell is drawn, the hot ones in the hot colors
+  int hot_cells = 0;
+  for (int y = 0; y < 20; y++) {
+    for (int x = 0; x < 61; x++) {
+      if (y == 19 && x == 60) continue;
+      chtype cell = mvwinch(window, y, x);
+      char glyph = (char)(cell & A_CHARTEXT);
+      ck_assert_int_ne(glyph, '\0');
+      ck_assert_ptr_nonnull(strchr(" school21", glyph));
+
+      uint8_t heat = cache.heat[(y / cache.scale) * cache.stride +
+                                x / cache.scale];
+      if (heat > 9) {
+        ck_assert_int_eq(PAIR_NUMBER(cell), heat > 15 ? 102 : 101);
+        ck_assert_int_eq(glyph, '1');
+        hot_cells++;
+      }
+    }
+  }
+  ck_assert_int_gt(hot_cells, 0);
+
+  release_fire_component(&cache);
+  ck_assert_ptr_null(cache.heat);
+  delwin(window);
+  endwin();
+  delscreen(screen);
+}
+END_TEST
+
+Suite *suite_gui__components(void) {
+  Suite *s = suite_create("gui__components");
+  TCase *tc_core = tcase_create("default");
+  suite_add_tcase(s, tc_core);
+
+  tcase_add_test(tc_core, gui_components__no_allocations_per_frame);
+  tcase_add_test(tc_core, gui_components__incremental_matches_full);
+  tcase_add_test(tc_core, gui_components__fire_kernel_matches_scalar);
+  tcase_add_test(tc_core, gui_components__fire_runs_at_fixed_rate);
+
+  return s;
+}
@@ -0,0 +1,221 @@
+#include "test_gui.h"
+
+#define GOLDEN_HEIGHT 40
+#define GOLDEN_WIDTH 120
+#define GOLDEN_MAX_SIZE (1 << 16)
+
+// Golden frames of the game screen. The frames are drawn by the game handlers
+// into a headless renderer and compared with tests/gui/golden. After an
+// intended change of the screen, run the tests with GOLDEN_UPDATE=1 and review
+// the diff of the golden files.
+
+static int field_cells[BOARD_COMPONENT_HEIGHT][BOARD_COMPONENT_WIDTH];
+static int *field[BOARD_COMPONENT_HEIGHT];
+static int ghost_cells[BOARD_COMPONENT_HEIGHT][BOARD_COMPONENT_WIDTH];
+static int *ghost_field[BOARD_COMPONENT_HEIGHT];
+static int next_cells[BRICK_COMPONENT_HEIGHT][BRICK_COMPONENT_WIDTH];
+static int *next[BRICK_COMPONENT_HEIGHT];
+static GameViewModel model;
+
+static GameViewModel provide_model(void) { return model; }
+
+static void init_model(int pause, bool has_ghost) {
+  for (int row = 0; row < BOARD_COMPONENT_HEIGHT; row++) {
+    field[row] = field_cells[row];
+    ghost_field[row] = ghost_cells[row];
+    for (int col = 0; col < BOARD_COMPONENT_WIDTH; col++) {
+      field_cells[row][col] = (row >= 16 && col != 4) ? 1 + (row + col) % 7 : 0;
+      ghost_cells[row][col] = (row >= 18 && col % 3) ? 2 : 0;
+    }
+  }
+  for (int row = 0; row < BRICK_COMPONENT_HEIGHT; row++) {
+    next[row] = next_cells[row];
+    for (int col = 0; col < BRICK_COMPONENT_WIDTH; col++) {
+      next_cells[row][col] = (row == 1) ? 3 : 0;
+    }
+  }
+  field_cells[0][4] = field_cells[1][4] = field_cells[1][5] = 5;
+
+  model = (GameViewModel){.info = {.field = field,
+                                   .next = next,
+                                   .score = 1200,
+                                   .high_score = 5400,
+                                   .level = 3,
+                                   .pause = pause}};
+  if (has_ghost) {
+    model.ghost_field = ghost_field;
+    model.ghost_score = 900;
+    model.ghost_player = "player";
+  }
+}
+
+// opens a headless screen showing the game screen of the model
+static RootView *open_game_screen(Renderer *renderer) {
+  ck_assert_int_eq(renderer->start(renderer), 0);
+  Pallete *pallete = provide_pallete();
+  pallete->change_theme(pallete, DARK_THEME);
+
+  RootView *view = new_root_view(stdscr);
+  view->header->draw = game_header_draw_handler;
+  view->content->draw = game_content_draw_handler;
+  view->footer->draw = NULL;  // the footer shows the time
+  set_game_view_model_provider(provide_model);
+  return view;
+}
+
+static void close_game_screen(Renderer *renderer, RootView *view) {
+  release_game_view();
+  view->destroy(view);
+  renderer->stop(renderer);
+  renderer->destroy(renderer);
+}
+
+static size_t dump_frame(Renderer *renderer, char *frame, size_t size) {
+  FILE *file = tmpfile();
+  ck_assert_ptr_nonnull(file);
+  ck_assert_int_eq(renderer->dump(renderer, file), 0);
+  rewind(file);
+  size_t length = fread(frame, 1, size - 1, file);
+  frame[length] = '\0';
+  fclose(file);
+  return length;
+}
+
+// draws the game screen and dumps the frame
+static size_t render_game_screen(char *frame, size_t size) {
+  Renderer *renderer = new_headless_renderer(GOLDEN_HEIGHT, GOLDEN_WIDTH);
+  RootView *view = open_game_screen(renderer);
+
+  view->update(view);
+  renderer->present(renderer);
+  size_t length = dump_frame(renderer, frame, size);
+
+  close_game_screen(renderer, view);
+  return length;
+}
+
+static void check_golden(const char *name, const char *frame, size_t length) {
+  char path[256];
+  snprintf(path, sizeof(path), "tests/gui/golden/%s.txt", name);
+
+  if (getenv("GOLDEN_UPDATE")) {
+    FILE *file = fopen(path, "w");
+    ck_assert_ptr_nonnull(file);
+    fwrite(frame, 1, length, file);
+    fclose(file);
+  }
+
+  static char golden[GOLDEN_MAX_SIZE];
+  FILE *file = fopen(path, "r");
+  ck_assert_msg(file != NULL, "missing golden frame %s", path);
+  size_t golden_length = fread(golden, 1, sizeof(golden) - 1, file);
+  golden[golden_length] = '\0';
+  fclose(file);
+
+  if (strcmp(frame, golden)) {
+    snprintf(path, sizeof(path), "tests/gui/golden/%s.actual.txt", name);
+    file = fopen(path, "w");
+    if (file) {
+      fwrite(frame, 1, length, file);
+      fclose(file);
+    }
+  }
+  ck_assert_msg(!strcmp(frame, golden), "frame differs from golden, see %s",
+                path);
+}
+
+START_TEST(gui_game_view__playing_matches_golden) {
+  static char frame[GOLDEN_MAX_SIZE];
+  init_model(0, false);
+  size_t length = render_game_screen(frame, sizeof(frame));
+  check_golden("playing", frame, length);
+}
+END_TEST
+
+START_TEST(gui_game_view__paused_with_ghost_matches_golden) {
+  static char frame[GOLDEN_MAX_SIZE];
+  init_model(1, true);
+  size_t length = render_game_screen(frame, sizeof(frame));
+  check_golden("paused_ghost", frame, length);
+}
+END_TEST
+
+START_TEST(gui_game_view__incremental_frame_matches_full) {
+  static char incremental[GOLDEN_MAX_SIZE], full[GOLDEN_MAX_SIZE];
+  init_model(0, false);
+
+  Renderer *renderer = new_headless_renderer(GOLDEN_HEIGHT, GOLDEN_WIDTH);
+  RootView *view = open_game_screen(renderer);
+
+  // a frame drawn over the previous one equals a frame drawn from scratch
+  view->update(view);
+  renderer->present(renderer);
+  model.info.score = 1300;
+  field_cells[0][4] = 0;
+  field_cells[2][4] = 5;
+  view->update(view);
+  renderer->present(renderer);
+
+  dump_frame(renderer, incremental, sizeof(incremental));
+
+  invalidate_game_view();
+  view->update(view);
+  renderer->present(renderer);
+  dump_frame(renderer, full, sizeof(full));
+
+  ck_assert_str_eq(incremental, full);
+  ck_assert_uint_eq(get_game_view_stats().full_frames, 2);
+
+  close_game_screen(renderer, view);
+}
+END_TEST
+
+START_TEST(gui_game_view__unchanged_generation_skips_frame) {
+  static char skipped[GOLDEN_MAX_SIZE], full[GOLDEN_MAX_SIZE];
+  init_model(1, false);
+  model.generation = (TetrisGeneration){1, 1, 1, 1, 1};
+
+  Renderer *renderer = new_headless_renderer(GOLDEN_HEIGHT, GOLDEN_WIDTH);
+  RootView *view = open_game_screen(renderer);
+  view->update(view);
+  renderer->present(renderer);
+  unsigned long skipped_frames = get_game_view_stats().skipped_frames;
+
+  // a paused game keeps its generation, its frames draw nothing and show the
+  // same as a frame drawn from scratch
+  view->update(view);
+  renderer->present(renderer);
+  ck_assert_uint_eq(get_game_view_stats().skipped_frames, skipped_frames + 1);
+  dump_frame(renderer, skipped, sizeof(skipped));
+
+  invalidate_game_view();
+  view->update(view);
+  renderer->present(renderer);
+  dump_frame(renderer, full, sizeof(full));
+  ck_assert_str_eq(skipped, full);
+
+  // a change under an unchanged generation is not drawn, a grown one is
+  model.info.score = 1300;
+  view->update(view);
+  ck_assert_uint_eq(get_game_view_stats().skipped_frames, skipped_frames + 2);
+  model.generation.state++;
+  model.generation.score++;
+  view->update(view);
+  ck_assert_uint_eq(get_game_view_stats().skipped_frames, skipped_frames + 2);
+
+  close_game_screen(renderer, view);
+}
+END_TEST
+
+Suite *suite_gui__game_view(void) {
+  Suite *s = suite_create("gui__game_view");
+  TCase *tc_core = tcase_create("default");
+  suite_add_tcase(s, tc_core);
+
+  tcase_add_test(tc_core, gui_game_view__playing_matches_golden);
+  tcase_add_test(tc_core, gui_game_view__paused_with_ghost_matches_golden);
+  tcase_add_test(tc_core, gui_game_view__incremental_frame_matches_full);
+  tcase_add_test(tc_core, gui_game_view__unchanged_generation_skips_frame);
+
+  return s;
+}
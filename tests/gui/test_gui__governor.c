@@ -0,0 +1,110 @@
+#include "test_gui.h"
+
+#define GOVERNOR_FPS 20
+#define BUDGET_NS (1000000000LL / GOVERNOR_FPS)
+
+// runs frames whose draw phase takes the given share of the budget
+static QualityLevel run_frames(QualityGovernor *governor, int frames,
+                               long long draw_ns) {
+  QualityLevel level = governor->level;
+  for (int frame = 0; frame < frames; frame++) {
+    governor->begin(governor);
+    governor->add(governor, FRAME_PHASE_DRAW, draw_ns);
+    level = governor->end_frame(governor);
+  }
+  return level;
+}
+
+START_TEST(gui_governor__degrades_and_restores) {
+  QualityGovernor *governor = new_quality_governor(GOVERNOR_FPS);
+  ck_assert_int_eq(governor->level, QUALITY_FULL);
+
+  // a single slow frame is not enough
+  run_frames(governor, 1, BUDGET_NS * 2);
+  ck_assert_int_eq(run_frames(governor, 1, BUDGET_NS / 10), QUALITY_FULL);
+
+  ck_assert_int_eq(run_frames(governor, QUALITY_GOVERNOR_DEGRADE_FRAMES,
+                              BUDGET_NS * 2),
+                   QUALITY_REDUCED);
+  ck_assert_int_eq(run_frames(governor, QUALITY_GOVERNOR_DEGRADE_FRAMES,
+                              BUDGET_NS * 2),
+                   QUALITY_LOW);
+  ck_assert_int_eq(run_frames(governor, 10, BUDGET_NS * 2), QUALITY_LOW);
+  ck_assert_uint_eq(governor->stats.degrades, 2);
+
+  // frames between the thresholds keep the level
+  ck_assert_int_eq(run_frames(governor, 200, BUDGET_NS / 2), QUALITY_LOW);
+
+  int restore_frames = GOVERNOR_FPS * QUALITY_GOVERNOR_RESTORE_SECONDS;
+  ck_assert_int_eq(run_frames(governor, restore_frames - 1, BUDGET_NS / 10),
+                   QUALITY_LOW);
+  ck_assert_int_eq(run_frames(governor, 1, BUDGET_NS / 10), QUALITY_REDUCED);
+  ck_assert_int_eq(run_frames(governor, restore_frames, BUDGET_NS / 10),
+                   QUALITY_FULL);
+  ck_assert_uint_eq(governor->stats.restores, 2);
+  ck_assert_uint_eq(governor->stats.frames_over_budget,
+                    1 + QUALITY_GOVERNOR_DEGRADE_FRAMES * 2 + 10);
+
+  governor->destroy(governor);
+}
+END_TEST
+
+START_TEST(gui_governor__failed_restore_waits_longer) {
+  QualityGovernor *governor = new_quality_governor(GOVERNOR_FPS);
+  int restore_frames = GOVERNOR_FPS * QUALITY_GOVERNOR_RESTORE_SECONDS;
+
+  run_frames(governor, QUALITY_GOVERNOR_DEGRADE_FRAMES, BUDGET_NS * 2);
+  run_frames(governor, restore_frames, BUDGET_NS / 10);
+  ck_assert_int_eq(governor->level, QUALITY_FULL);
+
+  // the full quality is still too slow
+  ck_assert_int_eq(run_frames(governor, QUALITY_GOVERNOR_DEGRADE_FRAMES,
+                              BUDGET_NS * 2),
+                   QUALITY_REDUCED);
+  ck_assert_int_eq(run_frames(governor, restore_frames, BUDGET_NS / 10),
+                   QUALITY_REDUCED);
+  ck_assert_int_eq(run_frames(governor, restore_frames, BUDGET_NS / 10),
+                   QUALITY_FULL);
+
+  governor->destroy(governor);
+}
+END_TEST
+
+START_TEST(gui_governor__input_wait_is_not_work) {
+  QualityGovernor *governor = new_quality_governor(GOVERNOR_FPS);
+
+  for (int frame = 0; frame < 100; frame++) {
+    governor->begin(governor);
+    governor->add(governor, FRAME_PHASE_INPUT, BUDGET_NS);
+    governor->add(governor, FRAME_PHASE_ENGINE, BUDGET_NS / 100);
+    governor->add(governor, FRAME_PHASE_PRESENT, BUDGET_NS / 100);
+    governor->end_frame(governor);
+  }
+  ck_assert_int_eq(governor->level, QUALITY_FULL);
+  ck_assert_uint_eq(governor->stats.frames_over_budget, 0);
+  ck_assert_int_eq(governor->stats.phase_ns[FRAME_PHASE_INPUT],
+                   BUDGET_NS * 100);
+
+  // marks measure the time between them
+  long long present_ns = governor->stats.phase_ns[FRAME_PHASE_PRESENT];
+  governor->begin(governor);
+  for (volatile int i = 0; i < 100000; i++) continue;
+  governor->mark(governor, FRAME_PHASE_PRESENT);
+  governor->end_frame(governor);
+  ck_assert_int_gt(governor->stats.phase_ns[FRAME_PHASE_PRESENT], present_ns);
+
+  governor->destroy(governor);
+}
+END_TEST
+
+Suite *suite_gui__governor(void) {
+  Suite *s = suite_create("gui__governor");
+  TCase *tc_core = tcase_create("default");
+  suite_add_tcase(s, tc_core);
+
+  tcase_add_test(tc_core, gui_governor__degrades_and_restores);
+  tcase_add_test(tc_core, gui_governor__failed_restore_waits_longer);
+  tcase_add_test(tc_core, gui_governor__input_wait_is_not_work);
+
+  return s;
+}
@@ -0,0 +1,573 @@
+#include "test_gui.h"
+
+#define KEYS_MAX 128
+
+static Button emitted[KEYS_MAX];
+static size_t emitted_count = 0;
+
+static void on_key(Button btn) {
+  if (emitted_count < KEYS_MAX) emitted[emitted_count++] = btn;
+}
+
+// ncurses returns the pushed back keys last in, first out, behind the resize
+// the screen was opened with
+static void press(const int *keys, size_t count) {
+  while (getch() != ERR) continue;
+  for (size_t i = count; i > 0; i--) ck_assert_int_eq(ungetch(keys[i - 1]), OK);
+}
+
+static size_t count_histogram(const unsigned long *buckets) {
+  size_t total = 0;
+  for (int i = 0; i < KEYBOARD_HISTOGRAM_SIZE; i++) total += buckets[i];
+  return total;
+}
+
+START_TEST(gui_keyboard__burst_is_emitted_in_order) {
+  Renderer *renderer = new_headless_renderer(10, 10);
+  ck_assert_int_eq(renderer->start(renderer), 0);
+  timeout(0);
+  KeyboardController *kb = new_keyboard();
+  kb->on_emit = on_key;
+  emitted_count = 0;
+
+  const int keys[] = {'a', 'b', KEY_LEFT, 'c'};
+  press(keys, 4);
+
+  // a single read takes the whole burst
+  Button btn = kb->listen(kb);
+  ck_assert_int_eq(btn.key, 'a');
+  ck_assert_uint_eq(kb->stats.reads, 1);
+  ck_assert_uint_eq(kb->stats.depth[3], 1);
+  while (btn.key != ERR) btn = kb->listen(kb);
+
+  ck_assert_uint_eq(emitted_count, 4);
+  for (size_t i = 0; i < emitted_count; i++) {
+    ck_assert_int_eq(emitted[i].key, keys[i]);
+    ck_assert_int_gt(emitted[i].time_ns, 0);
+    if (i) ck_assert_int_ge(emitted[i].time_ns, emitted[i - 1].time_ns);
+  }
+  ck_assert_uint_eq(kb->stats.keys, 4);
+  ck_assert_uint_eq(count_histogram(kb->stats.age), 4);
+  ck_assert_int_eq(wgetdelay(stdscr), 0);
+
+  kb->destroy(kb);
+  renderer->stop(renderer);
+  renderer->destroy(renderer);
+}
+END_TEST
+
+START_TEST(gui_keyboard__full_ring_defers_keys) {
+  Renderer *renderer = new_headless_renderer(10, 10);
+  ck_assert_int_eq(renderer->start(renderer), 0);
+  timeout(0);
+  KeyboardController *kb = new_keyboard();
+  kb->on_emit = on_key;
+  emitted_count = 0;
+
+  int keys[KEYBOARD_RING_SIZE + 2];
+  for (size_t i = 0; i < KEYBOARD_RING_SIZE + 2; i++) keys[i] = ' ' + i;
+  press(keys, KEYBOARD_RING_SIZE + 2);
+
+  // the keys that did not fit are read once the ring is empty again
+  ck_assert_uint_eq(kb->collect(kb), KEYBOARD_RING_SIZE);
+  ck_assert_uint_eq(kb->stats.deferred, 1);
+  while (kb->listen(kb).key != ERR) continue;
+
+  ck_assert_uint_eq(kb->stats.keys, KEYBOARD_RING_SIZE + 2);
+  ck_assert_uint_eq(kb->stats.reads, 2);
+  ck_assert_uint_eq(emitted_count, KEYBOARD_RING_SIZE + 2);
+  for (size_t i = 0; i < emitted_count; i++) {
+    ck_assert_int_eq(emitted[i].key, keys[i]);
+  }
+
+  kb->destroy(kb);
+  renderer->stop(renderer);
+  renderer->destroy(renderer);
+}
+END_TEST
+
+START_TEST(gui_keyboard__auto_repeat_follows_its_schedule) {
+  const long long ms = 1000000LL, start_ns = 1000 * ms;
+  AutoRepeat *repeat = new_auto_repeat(100 * ms, 20 * ms);
+
+  // the terminal repeats keep the key held, the repeats keep their schedule
+  ck_assert(repeat->press(repeat, KEY_LEFT, start_ns));
+  for (int i = 1; i <= 3; i++) {
+    ck_assert(!repeat->press(repeat, KEY_LEFT, start_ns + i * 30 * ms));
+  }
+  ck_assert_uint_eq(repeat->owed(repeat, KEY_LEFT, start_ns + 99 * ms, NULL),
+                    0);
+  ck_assert_int_eq(repeat->next_ns(repeat), start_ns + 100 * ms);
+
+  long long due_ns = 0;
+  ck_assert_uint_eq(
+      repeat->owed(repeat, KEY_LEFT, start_ns + 100 * ms + ms / 2, &due_ns), 1);
+  ck_assert_int_eq(due_ns, start_ns + 100 * ms);
+  ck_assert_int_eq(repeat->stats.max_late_ns, ms / 2);
+
+  // a late caller gets every repeat up to the release in one batch
+  ck_assert_uint_eq(
+      repeat->owed(repeat, KEY_LEFT, start_ns + 500 * ms, &due_ns), 2);
+  ck_assert_int_eq(due_ns, start_ns + 120 * ms);
+  ck_assert_int_eq(repeat->next_ns(repeat), 0);
+
+  // a terminal that reports releases keeps the key held until the release
+  repeat->release_ns = 10000 * ms;
+  ck_assert(repeat->press(repeat, KEY_LEFT, start_ns + 600 * ms));
+  repeat->release(repeat, KEY_LEFT, start_ns + 750 * ms);
+  ck_assert_uint_eq(repeat->owed(repeat, KEY_LEFT, start_ns + 2000 * ms, NULL),
+                    3);
+  ck_assert_uint_eq(repeat->stats.presses, 2);
+  ck_assert_uint_eq(repeat->stats.repeats, 6);
+  ck_assert_uint_eq(repeat->stats.batches, 3);
+
+  repeat->destroy(repeat);
+}
+END_TEST
+
+START_TEST(gui_keyboard__terminal_repeats_are_not_emitted) {
+  Renderer *renderer = new_headless_renderer(10, 10);
+  ck_assert_int_eq(renderer->start(renderer), 0);
+  timeout(0);
+  KeyboardController *kb = new_keyboard();
+  kb->on_emit = on_key;
+  kb->add_auto_repeat(kb, KEY_LEFT);
+  kb->auto_repeat->das_ns = 10000000LL;
+  kb->auto_repeat->arr_ns = 10000000LL;
+  emitted_count = 0;
+
+  const int keys[] = {KEY_LEFT, KEY_LEFT, KEY_LEFT, KEY_DOWN, KEY_DOWN};
+  press(keys, 5);
+  Button btn = kb->listen(kb);
+  long long pressed_ns = btn.time_ns;
+  while (btn.key != ERR) btn = kb->listen(kb);
+
+  // the held down key is emitted pressed and held, each key on its own
+  ck_assert_uint_eq(emitted_count, 3);
+  ck_assert_int_eq(emitted[0].key, KEY_LEFT);
+  ck_assert(!emitted[0].hold);
+  ck_assert_int_eq(emitted[1].key, KEY_DOWN);
+  ck_assert(!emitted[1].hold);
+  ck_assert(emitted[2].hold);
+
+  // the repeats owed until the key counts as released come as one button
+  ck_assert_uint_eq(kb->repeat(kb, pressed_ns + 1000000000LL), 1);
+  ck_assert_uint_eq(emitted_count, 4);
+  ck_assert_int_eq(emitted[3].key, KEY_LEFT);
+  ck_assert(emitted[3].hold);
+  ck_assert_uint_ge(emitted[3].count, 5);
+  ck_assert_int_eq(emitted[3].time_ns, pressed_ns + 10000000LL);
+  ck_assert_uint_eq(kb->repeat(kb, pressed_ns + 2000000000LL), 0);
+
+  kb->destroy(kb);
+  renderer->stop(renderer);
+  renderer->destroy(renderer);
+}
+END_TEST
+
+static int calls[KEYS_MAX];
+static size_t calls_count = 0;
+
+static void on_first(Button btn) {
+  (void)btn;
+  if (calls_count < KEYS_MAX) calls[calls_count++] = 1;
+}
+
+static void on_second(Button btn) {
+  (void)btn;
+  if (calls_count < KEYS_MAX) calls[calls_count++] = 2;
+}
+
+// moves itself to the next key each time it is called
+static void on_moving(Button btn) {
+  if (calls_count < KEYS_MAX) calls[calls_count++] = 3;
+  provide_keyboard()->rebind_listener(provide_keyboard(), btn.key, on_moving,
+                                      btn.key + 1);
+}
+
+START_TEST(gui_keyboard__listeners_are_dispatched_by_key) {
+  KeyboardController *kb = new_keyboard();
+  calls_count = 0;
+
+  // several listeners of a key are called in the order they were added
+  ck_assert_int_eq(kb->add_listener(kb, 'a', on_first), 0);
+  ck_assert_int_eq(kb->add_listener(kb, 'a', on_second), 0);
+  ck_assert_int_eq(kb->add_listener(kb, 'b', on_second), 0);
+  kb->emit(kb, (Button){.key = 'a'});
+  kb->emit(kb, (Button){.key = 'b'});
+  kb->emit(kb, (Button){.key = 'c'});
+  ck_assert_uint_eq(calls_count, 3);
+  ck_assert_int_eq(calls[0], 1);
+  ck_assert_int_eq(calls[1], 2);
+  ck_assert_int_eq(calls[2], 2);
+
+  // codes outside the ncurses range go to the overflow map
+  ck_assert_int_eq(kb->add_listener(kb, KEY_MAX + 1000, on_first), 0);
+  ck_assert_int_eq(kb->add_listener(kb, -5, on_second), 0);
+  calls_count = 0;
+  kb->emit(kb, (Button){.key = KEY_MAX + 1000});
+  kb->emit(kb, (Button){.key = -5});
+  kb->emit(kb, (Button){.key = KEY_MAX + 1001});
+  ck_assert_uint_eq(calls_count, 2);
+  ck_assert_int_eq(calls[0], 1);
+  ck_assert_int_eq(calls[1], 2);
+
+  // a rebound listener moves to the end of the listeners of its new key
+  ck_assert_int_eq(kb->rebind_listener(kb, 'a', on_first, 'b'), 0);
+  ck_assert_int_eq(kb->rebind_listener(kb, 'a', on_first, 'b'), -1);
+  calls_count = 0;
+  kb->emit(kb, (Button){.key = 'a'});
+  kb->emit(kb, (Button){.key = 'b'});
+  ck_assert_uint_eq(calls_count, 3);
+  ck_assert_int_eq(calls[0], 2);
+  ck_assert_int_eq(calls[1], 2);
+  ck_assert_int_eq(calls[2], 1);
+
+  ck_assert_int_eq(kb->remove_listener(kb, 'b', on_second), 0);
+  ck_assert_int_eq(kb->remove_listener(kb, 'b', on_second), -1);
+  ck_assert_uint_eq(kb->listeners_count, 4);
+
+  // the pool is fixed, a removed listener makes room again
+  size_t added = kb->listeners_count;
+  while (kb->add_listener(kb, 'z', on_first) == 0) added++;
+  ck_assert_uint_eq(added, KEYBOARD_LISTENERS_MAX);
+  ck_assert_int_eq(kb->remove_listener(kb, 'z', on_first), 0);
+  ck_assert_int_eq(kb->add_listener(kb, 'y', on_first), 0);
+
+  kb->destroy(kb);
+}
+END_TEST
+
+START_TEST(gui_keyboard__overflow_slots_are_reused) {
+  KeyboardController *kb = new_keyboard();
+  int key = KEY_MAX + 1;
+
+  // every slot of the overflow map is taken
+  for (int i = 0; i < KEYBOARD_OVERFLOW_SIZE; i++) {
+    ck_assert_int_eq(kb->add_listener(kb, key + i, on_first), 0);
+  }
+  ck_assert_int_eq(kb->add_listener(kb, key + 100, on_first), -1);
+  ck_assert_uint_eq(kb->listeners_count, KEYBOARD_OVERFLOW_SIZE);
+
+  // a key losing its last listener gives its slot back, again and again
+  for (int i = 0; i < 100; i++) {
+    ck_assert_int_eq(kb->remove_listener(kb, key, on_first), 0);
+    ck_assert_int_eq(kb->add_listener(kb, key + 100 + i, on_first), 0);
+    ck_assert_int_eq(kb->remove_listener(kb, key + 100 + i, on_first), 0);
+    ck_assert_int_eq(kb->add_listener(kb, key, on_first), 0);
+  }
+
+  // the keys behind a freed slot are still found
+  calls_count = 0;
+  for (int i = 0; i < KEYBOARD_OVERFLOW_SIZE; i++) {
+    kb->emit(kb, (Button){.key = key + i});
+  }
+  ck_assert_uint_eq(calls_count, KEYBOARD_OVERFLOW_SIZE);
+
+  // the only listener of a key takes the slot it leaves to its new key
+  ck_assert_int_eq(kb->rebind_listener(kb, key, on_first, key + 100), 0);
+  calls_count = 0;
+  kb->emit(kb, (Button){.key = key});
+  kb->emit(kb, (Button){.key = key + 100});
+  ck_assert_uint_eq(calls_count, 1);
+
+  // with the map full, a listener whose key keeps its slot stays on it
+  ck_assert_int_eq(kb->add_listener(kb, key + 1, on_second), 0);
+  ck_assert_int_eq(kb->rebind_listener(kb, key + 1, on_first, key + 200), -1);
+  calls_count = 0;
+  kb->emit(kb, (Button){.key = key + 1});
+  kb->emit(kb, (Button){.key = key + 200});
+  ck_assert_uint_eq(calls_count, 2);
+  ck_assert_int_eq(calls[0], 2);
+  ck_assert_int_eq(calls[1], 1);
+  ck_assert_uint_eq(kb->listeners_count, KEYBOARD_OVERFLOW_SIZE + 1);
+
+  kb->destroy(kb);
+}
+END_TEST
+
+START_TEST(gui_keyboard__listener_rebinds_itself) {
+  KeyboardController *kb = provide_keyboard();
+  calls_count = 0;
+
+  ck_assert_int_eq(kb->add_listener(kb, 'a', on_moving), 0);
+  ck_assert_int_eq(kb->add_listener(kb, 'a', on_first), 0);
+  kb->emit(kb, (Button){.key = 'a'});
+  kb->emit(kb, (Button){.key = 'a'});
+  kb->emit(kb, (Button){.key = 'b'});
+  ck_assert_uint_eq(calls_count, 4);
+  ck_assert_int_eq(calls[0], 3);
+  ck_assert_int_eq(calls[1], 1);
+  ck_assert_int_eq(calls[2], 1);
+  ck_assert_int_eq(calls[3], 3);
+
+  ck_assert_int_eq(kb->remove_listener(kb, 'c', on_moving), 0);
+  ck_assert_int_eq(kb->remove_listener(kb, 'a', on_first), 0);
+}
+END_TEST
+
+// feeds the bytes at once and decodes every key ready at the given time
+static size_t decode_all(KeyDecoder *decoder, const char *bytes,
+                         long long time_ns, long long now_ns,
+                         KeyEvent *events) {
+  decoder->feed(decoder, bytes, strlen(bytes), time_ns);
+  size_t count = 0;
+  while (count < KEYS_MAX && decoder->next(decoder, now_ns, &events[count])) {
+    count++;
+  }
+  return count;
+}
+
+START_TEST(gui_keyboard__decoder_maps_sequences_to_keys) {
+  KeyDecoder *decoder = new_key_decoder();
+  KeyEvent events[KEYS_MAX];
+
+  size_t count = decode_all(decoder, "a\033OD\033[C\033[3~\033[5;2~\r\177",
+                            1000, 1000, events);
+  const int keys[] = {'a', KEY_LEFT, KEY_RIGHT, KEY_DC, KEY_PPAGE, '\n',
+                      KEY_BACKSPACE};
+  ck_assert_uint_eq(count, 7);
+  for (size_t i = 0; i < count; i++) {
+    ck_assert_int_eq(events[i].key, keys[i]);
+    ck_assert_int_eq(events[i].type, KEY_EVENT_PRESS);
+    ck_assert_int_eq(events[i].time_ns, 1000);
+  }
+  ck_assert_uint_eq(decoder->stats.sequences, 4);
+
+  // a sequence split across two reads waits for its rest
+  ck_assert_uint_eq(decode_all(decoder, "\033[", 2000, 2000, events), 0);
+  ck_assert_int_eq(decoder->deadline_ns(decoder),
+                   2000 + KEY_DECODER_ESC_TIMEOUT_MS * 1000000LL);
+  ck_assert_uint_eq(decode_all(decoder, "B", 3000, 3000, events), 1);
+  ck_assert_int_eq(events[0].key, KEY_DOWN);
+  ck_assert_int_eq(events[0].time_ns, 2000);
+  ck_assert_int_eq(decoder->deadline_ns(decoder), 0);
+
+  // an unknown sequence is skipped
+  ck_assert_uint_eq(decode_all(decoder, "\033[99~x", 4000, 4000, events), 1);
+  ck_assert_int_eq(events[0].key, 'x');
+  ck_assert_uint_eq(decoder->stats.unknown, 1);
+
+  decoder->destroy(decoder);
+}
+END_TEST
+
+START_TEST(gui_keyboard__decoder_waits_for_a_lone_esc) {
+  const long long ms = 1000000LL;
+  KeyDecoder *decoder = new_key_decoder();
+  KeyEvent events[KEYS_MAX];
+
+  // a lone ESC might start a sequence until its deadline
+  ck_assert_uint_eq(decode_all(decoder, "\033", ms, ms, events), 0);
+  long long deadline_ns = decoder->deadline_ns(decoder);
+  ck_assert_int_eq(deadline_ns, ms + KEY_DECODER_ESC_TIMEOUT_MS * ms);
+  ck_assert(!decoder->next(decoder, deadline_ns - 1, &events[0]));
+  ck_assert(decoder->next(decoder, deadline_ns, &events[0]));
+  ck_assert_int_eq(events[0].key, 27);
+  ck_assert_uint_eq(decoder->stats.timeouts, 1);
+
+  // ESC followed by a key is two keys, like alt+key in ncurses
+  ck_assert_uint_eq(decode_all(decoder, "\033q", 2 * ms, 2 * ms, events), 2);
+  ck_assert_int_eq(events[0].key, 27);
+  ck_assert_int_eq(events[1].key, 'q');
+
+  // the kitty protocol gives the ESC key a sequence of its own
+  ck_assert_uint_eq(decode_all(decoder, "\033[27u", 3 * ms, 3 * ms, events), 1);
+  ck_assert_int_eq(events[0].key, 27);
+  ck_assert_uint_eq(decoder->stats.timeouts, 1);
+
+  decoder->destroy(decoder);
+}
+END_TEST
+
+START_TEST(gui_keyboard__decoder_reads_kitty_events) {
+  KeyDecoder *decoder = new_key_decoder();
+  KeyEvent events[KEYS_MAX];
+
+  // the answers to the probe are no keys
+  ck_assert_uint_eq(decode_all(decoder, "\033[?7u\033[?62;22c", 0, 0, events),
+                    0);
+  ck_assert(decoder->is_kitty);
+  ck_assert(decoder->is_probed);
+
+  size_t count = decode_all(
+      decoder, "\033[1;1:1D\033[1;1:2D\033[1;1:3D\033[97;2:3u\033[13u", 0,
+      0, events);
+  ck_assert_uint_eq(count, 5);
+  ck_assert_int_eq(events[0].key, KEY_LEFT);
+  ck_assert_int_eq(events[0].type, KEY_EVENT_PRESS);
+  ck_assert_int_eq(events[1].type, KEY_EVENT_REPEAT);
+  ck_assert_int_eq(events[2].type, KEY_EVENT_RELEASE);
+  ck_assert_int_eq(events[3].key, 'a');
+  ck_assert_int_eq(events[3].type, KEY_EVENT_RELEASE);
+  ck_assert_int_eq(events[4].key, '\n');
+
+  // shifted keys come as the shifted character, ctrl+c as the control one
+  count = decode_all(decoder, "\033[49:33;2u\033[99;5u", 0, 0, events);
+  ck_assert_uint_eq(count, 2);
+  ck_assert_int_eq(events[0].key, '!');
+  ck_assert_int_eq(events[1].key, 3);
+
+  decoder->destroy(decoder);
+}
+END_TEST
+
+START_TEST(gui_keyboard__raw_input_reports_releases) {
+  Renderer *renderer = new_headless_renderer(10, 10);
+  ck_assert_int_eq(renderer->start(renderer), 0);
+  timeout(0);
+  KeyboardController *kb = new_keyboard();
+  kb->on_emit = on_key;
+  kb->add_auto_repeat(kb, KEY_LEFT);
+  emitted_count = 0;
+
+  int input[2], output[2];
+  ck_assert_int_eq(pipe(input), 0);
+  ck_assert_int_eq(pipe(output), 0);
+  ck_assert_int_eq(kb->use_raw_input(kb, input[0], output[1]), 0);
+  char probe[sizeof(KEY_DECODER_KITTY_PROBE)] = {0};
+  ck_assert_int_eq(read(output[0], probe, sizeof(probe) - 1),
+                   sizeof(probe) - 1);
+  ck_assert_str_eq(probe, KEY_DECODER_KITTY_PROBE);
+
+  // the terminal supports the protocol, so it is turned on
+  const char answer[] = "\033[?0u\033[?62c";
+  ck_assert_int_eq(write(input[1], answer, sizeof(answer) - 1),
+                   sizeof(answer) - 1);
+  ck_assert_uint_eq(kb->collect(kb), 0);
+  char push[sizeof(KEY_DECODER_KITTY_PUSH)] = {0};
+  ck_assert_int_eq(read(output[0], push, sizeof(push) - 1), sizeof(push) - 1);
+  ck_assert_str_eq(push, KEY_DECODER_KITTY_PUSH);
+
+  // the release is not emitted, it ends the hold of the key
+  const char keys[] = "\033[1;1:1D\033[1;1:2D\033[1;1:3Dq";
+  ck_assert_int_eq(write(input[1], keys, sizeof(keys) - 1), sizeof(keys) - 1);
+  Button btn = kb->listen(kb);
+  while (btn.key != ERR) btn = kb->listen(kb);
+  ck_assert_uint_eq(emitted_count, 2);
+  ck_assert_int_eq(emitted[0].key, KEY_LEFT);
+  ck_assert(!emitted[0].hold);
+  ck_assert_int_eq(emitted[1].key, 'q');
+  ck_assert_uint_eq(kb->stats.keys, 4);
+  ck_assert_int_eq(kb->auto_repeat->next_ns(kb->auto_repeat), 0);
+
+  // the protocol is turned off with the controller
+  kb->destroy(kb);
+  char pop[sizeof(KEY_DECODER_KITTY_POP)] = {0};
+  ck_assert_int_eq(read(output[0], pop, sizeof(pop) - 1), sizeof(pop) - 1);
+  ck_assert_str_eq(pop, KEY_DECODER_KITTY_POP);
+
+  for (int i = 0; i < 2; i++) {
+    close(input[i]);
+    close(output[i]);
+  }
+  renderer->stop(renderer);
+  renderer->destroy(renderer);
+}
+END_TEST
+
+#define QUEUE_PRODUCERS 4
+#define QUEUE_CHUNKS 2000
+
+static InputQueue queue;
+
+static void *produce_chunks(void *arg) {
+  InputChunk chunk = {.size = 2};
+  chunk.bytes[0] = (char)(size_t)arg;
+  for (int i = 0; i < QUEUE_CHUNKS; i++) {
+    chunk.time_ns = i;
+    while (!input_queue_push(&queue, &chunk)) sched_yield();
+  }
+  return NULL;
+}
+
+START_TEST(gui_keyboard__input_queue_takes_many_producers) {
+  input_queue_init(&queue);
+  pthread_t producers[QUEUE_PRODUCERS];
+  for (size_t i = 0; i < QUEUE_PRODUCERS; i++) {
+    ck_assert_int_eq(
+        pthread_create(&producers[i], NULL, produce_chunks, (void *)i), 0);
+  }
+
+  // every chunk arrives once, and the chunks of a producer in order
+  long long next[QUEUE_PRODUCERS] = {0};
+  for (int taken = 0; taken < QUEUE_PRODUCERS * QUEUE_CHUNKS;) {
+    InputChunk chunk;
+    if (!input_queue_pop(&queue, &chunk)) continue;
+    int producer = chunk.bytes[0];
+    ck_assert_int_lt(producer, QUEUE_PRODUCERS);
+    ck_assert_int_eq(chunk.time_ns, next[producer]++);
+    taken++;
+  }
+  for (size_t i = 0; i < QUEUE_PRODUCERS; i++) {
+    pthread_join(producers[i], NULL);
+  }
+  InputChunk chunk;
+  ck_assert(!input_queue_pop(&queue, &chunk));
+}
+END_TEST
+
+START_TEST(gui_keyboard__input_thread_stamps_keys_on_arrival) {
+  Renderer *renderer = new_headless_renderer(10, 10);
+  ck_assert_int_eq(renderer->start(renderer), 0);
+  timeout(0);
+  KeyboardController *kb = new_keyboard();
+  kb->on_emit = on_key;
+  emitted_count = 0;
+
+  int input[2], output[2];
+  ck_assert_int_eq(pipe(input), 0);
+  ck_assert_int_eq(pipe(output), 0);
+  ck_assert_int_eq(kb->use_input_thread(kb, -1, false), -1);
+  ck_assert_int_eq(kb->use_raw_input(kb, input[0], output[1]), 0);
+  ck_assert_int_eq(kb->use_input_thread(kb, -1, false), 0);
+
+  EventLoop *loop = new_event_loop(kb->input_thread->notify_fd, -1);
+  long long written_ns = event_loop_now_ns();
+  ck_assert_int_eq(write(input[1], "ab", 2), 2);
+  loop->set_deadline(loop, written_ns + 1000000000LL);
+  ck_assert_int_eq(loop->wait(loop), LOOP_EVENT_INPUT);
+  loop->destroy(loop);
+
+  // a slow frame before the keys are collected does not delay their stamps
+  while (event_loop_now_ns() - written_ns < 50000000LL) continue;
+  Button btn = kb->listen(kb);
+  while (btn.key != ERR) btn = kb->listen(kb);
+  ck_assert_uint_eq(emitted_count, 2);
+  ck_assert_int_eq(emitted[0].key, 'a');
+  ck_assert_int_eq(emitted[1].key, 'b');
+  ck_assert_int_ge(emitted[0].time_ns, written_ns);
+  ck_assert_int_lt(emitted[0].time_ns - written_ns, 40000000LL);
+  ck_assert_uint_eq(kb->input_thread->stats.bytes, 2);
+
+  kb->destroy(kb);
+  for (int i = 0; i < 2; i++) {
+    close(input[i]);
+    close(output[i]);
+  }
+  renderer->stop(renderer);
+  renderer->destroy(renderer);
+}
+END_TEST
+
+Suite *suite_gui__keyboard(void) {
+  Suite *s = suite_create("gui__keyboard");
+  TCase *tc_core = tcase_create("default");
+  suite_add_tcase(s, tc_core);
+
+  tcase_add_test(tc_core, gui_keyboard__burst_is_emitted_in_order);
+  tcase_add_test(tc_core, gui_keyboard__full_ring_defers_keys);
+  tcase_add_test(tc_core, gui_keyboard__auto_repeat_follows_its_schedule);
+  tcase_add_test(tc_core, gui_keyboard__terminal_repeats_are_not_emitted);
+  tcase_add_test(tc_core, gui_keyboard__listeners_are_dispatched_by_key);
+  tcase_add_test(tc_core, gui_keyboard__overflow_slots_are_reused);
+  tcase_add_test(tc_core, gui_keyboard__listener_rebinds_itself);
+  tcase_add_test(tc_core, gui_keyboard__decoder_maps_sequences_to_keys);
+  tcase_add_test(tc_core, gui_keyboard__decoder_waits_for_a_lone_esc);
+  tcase_add_test(tc_core, gui_keyboard__decoder_reads_kitty_events);
+  tcase_add_test(tc_core, gui_keyboard__raw_input_reports_releases);
+  tcase_add_test(tc_core, gui_keyboard__input_queue_takes_many_producers);
+  tcase_add_test(tc_core, gui_keyboard__input_thread_stamps_keys_on_arrival);
+
+  return s;
+}
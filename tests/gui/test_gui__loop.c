@@ -0,0 +1,62 @@
+#include "test_gui.h"
+
+#define DEADLINE_NS 20000000LL
+
+START_TEST(gui_loop__sleeps_until_deadline) {
+  int input[2];
+  ck_assert_int_eq(pipe(input), 0);
+  EventLoop *loop = new_event_loop(input[0], -1);
+
+  long long started_ns = event_loop_now_ns();
+  loop->set_deadline(loop, started_ns + DEADLINE_NS);
+  ck_assert_int_eq(loop->wait(loop), LOOP_EVENT_DEADLINE);
+  ck_assert_int_ge(event_loop_now_ns() - started_ns, DEADLINE_NS);
+
+  // a passed deadline ends the wait without sleeping
+  ck_assert_int_eq(loop->wait(loop), LOOP_EVENT_DEADLINE);
+  ck_assert_uint_eq(loop->stats.deadlines, 2);
+
+  loop->destroy(loop);
+  close(input[0]);
+  close(input[1]);
+}
+END_TEST
+
+START_TEST(gui_loop__wakes_up_on_input_and_state) {
+  int input[2], state[2];
+  ck_assert_int_eq(pipe(input), 0);
+  ck_assert_int_eq(pipe(state), 0);
+  EventLoop *loop = new_event_loop(input[0], state[0]);
+  loop->set_deadline(loop, event_loop_now_ns() + 10 * DEADLINE_NS);
+
+  // the state descriptor is emptied, the input is left to its reader
+  ck_assert_int_eq(write(state[1], "ab", 2), 2);
+  ck_assert_int_eq(loop->wait(loop), LOOP_EVENT_STATE);
+  ck_assert_int_eq(write(input[1], "k", 1), 1);
+  ck_assert_int_eq(loop->wait(loop), LOOP_EVENT_INPUT);
+  ck_assert_int_eq(loop->wait(loop), LOOP_EVENT_INPUT);
+
+  char key;
+  ck_assert_int_eq(read(input[0], &key, 1), 1);
+  ck_assert_int_eq(loop->wait(loop), LOOP_EVENT_DEADLINE);
+  ck_assert_uint_eq(loop->stats.waits, 4);
+  ck_assert_uint_eq(loop->stats.states, 1);
+
+  loop->destroy(loop);
+  for (int i = 0; i < 2; i++) {
+    close(input[i]);
+    close(state[i]);
+  }
+}
+END_TEST
+
+Suite *suite_gui__loop(void) {
+  Suite *s = suite_create("gui__loop");
+  TCase *tc_core = tcase_create("default");
+  suite_add_tcase(s, tc_core);
+
+  tcase_add_test(tc_core, gui_loop__sleeps_until_deadline);
+  tcase_add_test(tc_core, gui_loop__wakes_up_on_input_and_state);
+
+  return s;
+}
@@ -0,0 +1,135 @@
+#include "test_gui.h"
+
+#define RING_CAPACITY 64
+#define CAST_PATH "/tmp/test_gui__recorder.cast"
+#define TTYREC_PATH "/tmp/test_gui__recorder.ttyrec"
+
+// an empty ring over the given storage
+static RecorderRing make_ring(uint8_t *data) {
+  RecorderRing ring = {.data = data, .capacity = RING_CAPACITY};
+  atomic_init(&ring.head, 0);
+  atomic_init(&ring.tail, 0);
+  return ring;
+}
+
+// the recording written so far, NUL terminated
+static size_t read_recording(Recorder *recorder, const char *path,
+                             char *buffer, size_t capacity) {
+  fflush(recorder->file);
+  FILE *file = fopen(path, "rb");
+  ck_assert_ptr_nonnull(file);
+  size_t size = fread(buffer, 1, capacity - 1, file);
+  buffer[size] = '\0';
+  fclose(file);
+  return size;
+}
+
+START_TEST(gui_recorder__ring_wraps_around) {
+  uint8_t storage[RING_CAPACITY];
+  RecorderRing ring = make_ring(storage);
+  uint8_t chunk[RECORDER_CHUNK_SIZE];
+  long long timestamp_ns = 0;
+
+  ck_assert_uint_eq(recorder_ring_pop(&ring, &timestamp_ns, chunk), 0);
+
+  // records of 12 header bytes and 10 chunk bytes start at every offset of
+  // the storage in turn, so headers and chunks are split by its end
+  for (int i = 0; i < 40; i++) {
+    uint8_t data[10];
+    for (size_t j = 0; j < sizeof(data); j++) data[j] = (uint8_t)(i + j);
+    ck_assert(recorder_ring_push(&ring, 1000LL * i, data, sizeof(data)));
+    ck_assert(recorder_ring_push(&ring, 1000LL * i + 1, data, 3));
+
+    ck_assert_uint_eq(recorder_ring_pop(&ring, &timestamp_ns, chunk), 10);
+    ck_assert_int_eq(timestamp_ns, 1000LL * i);
+    ck_assert_int_eq(memcmp(chunk, data, sizeof(data)), 0);
+    ck_assert_uint_eq(recorder_ring_pop(&ring, &timestamp_ns, chunk), 3);
+    ck_assert_int_eq(timestamp_ns, 1000LL * i + 1);
+    ck_assert_int_eq(memcmp(chunk, data, 3), 0);
+  }
+  ck_assert_uint_eq(recorder_ring_pop(&ring, &timestamp_ns, chunk), 0);
+}
+END_TEST
+
+START_TEST(gui_recorder__full_ring_drops_chunks) {
+  uint8_t storage[RING_CAPACITY];
+  RecorderRing ring = make_ring(storage);
+  uint8_t chunk[RECORDER_CHUNK_SIZE] = {0};
+  long long timestamp_ns = 0;
+
+  // two records of 32 bytes fill the ring, the third is dropped whole
+  const uint8_t *first = (const uint8_t *)"first chunk of 20 b";
+  const uint8_t *other = (const uint8_t *)"other chunk of 20 b";
+  ck_assert(recorder_ring_push(&ring, 1, first, 20));
+  ck_assert(recorder_ring_push(&ring, 2, other, 20));
+  ck_assert(!recorder_ring_push(&ring, 3, (const uint8_t *)"x", 1));
+  ck_assert(!recorder_ring_push(&ring, 4, chunk, RECORDER_CHUNK_SIZE + 1));
+
+  // the dropped chunk left nothing behind, popping frees the room again
+  ck_assert_uint_eq(recorder_ring_pop(&ring, &timestamp_ns, chunk), 20);
+  ck_assert_int_eq(timestamp_ns, 1);
+  ck_assert(recorder_ring_push(&ring, 5, (const uint8_t *)"y", 1));
+  ck_assert_uint_eq(recorder_ring_pop(&ring, &timestamp_ns, chunk), 20);
+  ck_assert_int_eq(timestamp_ns, 2);
+  ck_assert_int_eq(memcmp(chunk, other, 20), 0);
+  ck_assert_uint_eq(recorder_ring_pop(&ring, &timestamp_ns, chunk), 1);
+  ck_assert_int_eq(timestamp_ns, 5);
+  ck_assert_uint_eq(recorder_ring_pop(&ring, &timestamp_ns, chunk), 0);
+}
+END_TEST
+
+START_TEST(gui_recorder__asciicast_escapes_text) {
+  Recorder *recorder = new_recorder(CAST_PATH);
+  ck_assert_ptr_nonnull(recorder);
+  ck_assert_int_eq(recorder->format, RECORDER_FORMAT_ASCIICAST);
+
+  // quotes, backslashes and control characters are escaped, NUL included,
+  // the first byte of the split "é" waits for the next chunk
+  const uint8_t first[] = {'a', '"', 'b', '\\', '\n', '\0', 0xC3};
+  const uint8_t second[] = {0xA9, 0xFF, '!'};
+  recorder_write_chunk(recorder, 1500000, first, sizeof(first));
+  recorder_write_chunk(recorder, 2000000000, second, sizeof(second));
+
+  char text[256];
+  read_recording(recorder, CAST_PATH, text, sizeof(text));
+  ck_assert_str_eq(text,
+                   "[0.001500, \"o\", \"a\\\"b\\\\\\u000a\\u0000\"]\n"
+                   "[2.000000, \"o\", \"\xC3\xA9\\ufffd!\"]\n");
+
+  recorder->destroy(recorder);
+  remove(CAST_PATH);
+}
+END_TEST
+
+START_TEST(gui_recorder__ttyrec_header_layout) {
+  Recorder *recorder = new_recorder(TTYREC_PATH);
+  ck_assert_ptr_nonnull(recorder);
+  ck_assert_int_eq(recorder->format, RECORDER_FORMAT_TTYREC);
+  recorder->_started_at_real = (struct timespec){10, 500000000};
+
+  // seconds, microseconds and length, 32 bit little endian, then the chunk
+  recorder_write_chunk(recorder, 1250000000, (const uint8_t *)"abc", 3);
+  char data[64];
+  ck_assert_uint_eq(read_recording(recorder, TTYREC_PATH, data, sizeof(data)),
+                    15);
+  const uint8_t expected[] = {11, 0, 0, 0, 0xB0, 0x71, 0x0B, 0,
+                              3,  0, 0, 0, 'a',  'b',  'c'};
+  ck_assert_int_eq(memcmp(data, expected, sizeof(expected)), 0);
+
+  recorder->destroy(recorder);
+  remove(TTYREC_PATH);
+}
+END_TEST
+
+Suite *suite_gui__recorder(void) {
+  Suite *s = suite_create("gui__recorder");
+  TCase *tc_core = tcase_create("default");
+  suite_add_tcase(s, tc_core);
+
+  tcase_add_test(tc_core, gui_recorder__ring_wraps_around);
+  tcase_add_test(tc_core, gui_recorder__full_ring_drops_chunks);
+  tcase_add_test(tc_core, gui_recorder__asciicast_escapes_text);
+  tcase_add_test(tc_core, gui_recorder__ttyrec_header_layout);
+
+  return s;
+}
@@ -0,0 +1,161 @@
+#include "test_gui.h"
+
+typedef struct {
+  SCREEN *screen;
+  WINDOW *window;
+  Renderer *renderer;
+  int pipe[2];
+} Terminal;
+
+static void open_terminal(Terminal *terminal) {
+  FILE *output = fopen("/dev/null", "w");
+  FILE *input = fopen("/dev/null", "r");
+  terminal->screen = newterm("xterm", output, input);
+  ck_assert_ptr_nonnull(terminal->screen);
+  ck_assert_int_eq(pipe(terminal->pipe), 0);
+
+  terminal->window = newwin(getmaxy(stdscr), getmaxx(stdscr), 0, 0);
+  terminal->renderer = new_renderer(RENDERER_ANSI, terminal->pipe[1], FALSE);
+}
+
+static void close_terminal(Terminal *terminal) {
+  terminal->renderer->destroy(terminal->renderer);
+  delwin(terminal->window);
+  endwin();
+  delscreen(terminal->screen);
+  close(terminal->pipe[0]);
+  close(terminal->pipe[1]);
+}
+
+// presents a frame and returns what reached the terminal
+static size_t present(Terminal *terminal, char *output, size_t size) {
+  wnoutrefresh(terminal->window);
+  unsigned long writes = terminal->renderer->stats.writes;
+  terminal->renderer->present(terminal->renderer);
+
+  ssize_t count = 0;
+  if (terminal->renderer->stats.writes != writes) {
+    count = read(terminal->pipe[0], output, size - 1);
+  }
+  output[count > 0 ? count : 0] = '\0';
+  return count > 0 ? (size_t)count : 0;
+}
+
+START_TEST(gui_renderer__first_frame_paints_every_cell) {
+  Terminal terminal;
+  open_terminal(&terminal);
+  char output[16384];
+
+  mvwaddstr(terminal.window, 2, 5, "hello");
+  present(&terminal, output, sizeof(output));
+  ck_assert_ptr_nonnull(strstr(output, "hello"));
+  ck_assert_uint_eq(terminal.renderer->stats.writes, 1);
+  ck_assert_uint_eq(terminal.renderer->stats.cells,
+                    (unsigned long)getmaxy(stdscr) * getmaxx(stdscr));
+
+  close_terminal(&terminal);
+}
+END_TEST
+
+START_TEST(gui_renderer__unchanged_frame_writes_nothing) {
+  Terminal terminal;
+  open_terminal(&terminal);
+  char output[16384];
+
+  mvwaddstr(terminal.window, 2, 5, "hello");
+  present(&terminal, output, sizeof(output));
+  mvwaddstr(terminal.window, 2, 5, "hello");
+  ck_assert_uint_eq(present(&terminal, output, sizeof(output)), 0);
+  ck_assert_uint_eq(terminal.renderer->stats.frames, 2);
+  ck_assert_uint_eq(terminal.renderer->stats.writes, 1);
+
+  close_terminal(&terminal);
+}
+END_TEST
+
+START_TEST(gui_renderer__sends_changed_cells_only) {
+  Terminal terminal;
+  open_terminal(&terminal);
+  char output[16384];
+  present(&terminal, output, sizeof(output));
+
+  // an absolute move to the first cell, the unchanged blank between both
+  // cells is sent again instead of a move
+  mvwaddch(terminal.window, 3, 10, 'X');
+  mvwaddch(terminal.window, 3, 12, 'Y');
+  present(&terminal, output, sizeof(output));
+  ck_assert_str_eq(output, "\033[4;11HX Y");
+
+  // a long gap is skipped with a relative move
+  mvwaddch(terminal.window, 3, 10, 'A');
+  mvwaddch(terminal.window, 3, 30, 'B');
+  present(&terminal, output, sizeof(output));
+  ck_assert_str_eq(output, "\033[4;11HA\033[19CB");
+
+  // attributes are only sent when they change
+  wattron(terminal.window, A_REVERSE);
+  mvwaddstr(terminal.window, 5, 0, "ab");
+  wattroff(terminal.window, A_REVERSE);
+  present(&terminal, output, sizeof(output));
+  ck_assert_str_eq(output, "\033[6H\033[0;7mab");
+
+  close_terminal(&terminal);
+}
+END_TEST
+
+START_TEST(gui_renderer__busy_terminal_merges_frames) {
+  Terminal terminal;
+  open_terminal(&terminal);
+  Renderer *renderer = terminal.renderer;
+  char output[16384];
+
+  // the first frame stays unread, the terminal is still busy with it
+  mvwaddstr(terminal.window, 2, 5, "hello");
+  wnoutrefresh(terminal.window);
+  renderer->present(renderer);
+  ck_assert_uint_gt(renderer->stats.bytes, RENDERER_BACKLOG_MIN);
+
+  // up to a frame may wait in the terminal, more frames are held back
+  mvwaddch(terminal.window, 3, 10, 'A');
+  wnoutrefresh(terminal.window);
+  renderer->present(renderer);
+  mvwaddch(terminal.window, 4, 10, 'B');
+  wnoutrefresh(terminal.window);
+  renderer->present(renderer);
+  mvwaddch(terminal.window, 4, 10, 'C');
+  mvwaddch(terminal.window, 6, 10, 'D');
+  wnoutrefresh(terminal.window);
+  renderer->present(renderer);
+  ck_assert_uint_eq(renderer->stats.frames, 2);
+  ck_assert_uint_eq(renderer->stats.dropped, 2);
+  ck_assert_uint_eq(renderer->stats.writes, 2);
+  ck_assert_uint_gt(renderer->stats.max_backlog, RENDERER_BACKLOG_MIN);
+
+  // once the terminal took it all, the latest state goes out in one frame
+  size_t queued = renderer->stats.bytes;
+  while (queued) {
+    ssize_t count = read(terminal.pipe[0], output,
+                         queued < sizeof(output) ? queued : sizeof(output));
+    ck_assert_int_gt(count, 0);
+    queued -= count;
+  }
+  present(&terminal, output, sizeof(output));
+  ck_assert_str_eq(output, "\033[5;11HC\033[7;11HD");
+  ck_assert_uint_eq(renderer->stats.frames, 3);
+
+  close_terminal(&terminal);
+}
+END_TEST
+
+Suite *suite_gui__renderer(void) {
+  Suite *s = suite_create("gui__renderer");
+  TCase *tc_core = tcase_create("default");
+  suite_add_tcase(s, tc_core);
+
+  tcase_add_test(tc_core, gui_renderer__first_frame_paints_every_cell);
+  tcase_add_test(tc_core, gui_renderer__unchanged_frame_writes_nothing);
+  tcase_add_test(tc_core, gui_renderer__sends_changed_cells_only);
+  tcase_add_test(tc_core, gui_renderer__busy_terminal_merges_frames);
+
+  return s;
+}
@@ -0,0 +1,133 @@
+#include "test_gui.h"
+
+#define SCREEN_HEIGHT 40
+#define SCREEN_WIDTH 120
+#define FRAME_MAX_SIZE (1 << 16)
+#define GAMES_COUNT 20
+
+static TetrisSnapshot snapshots[GAMES_COUNT];
+static const TetrisSnapshot *boards[GAMES_COUNT];
+static SpectatorViewModel model;
+
+static SpectatorViewModel provide_model(void) { return model; }
+
+// every game gets a stack as high as its index and the score of its index
+static void init_model(SpectatorSort sort) {
+  for (int i = 0; i < GAMES_COUNT; i++) {
+    TetrisSnapshot *snapshot = &snapshots[i];
+    *snapshot = (TetrisSnapshot){0};
+    for (int row = 0; row < TETRIS_FIELD_HEIGHT; row++) {
+      snapshot->_field_rows[row] = snapshot->_field[row];
+      for (int col = 0; col < TETRIS_FIELD_WIDTH; col++) {
+        snapshot->_field[row][col] =
+            (row >= TETRIS_FIELD_HEIGHT - i && col != i % TETRIS_FIELD_WIDTH)
+                ? 1 + col % 7
+                : 0;
+      }
+    }
+    snapshot->info.field = snapshot->_field_rows;
+    snapshot->info.score = 100 * i;
+    snapshot->stack_height = i;
+    snapshot->generation.state = 1;
+    boards[i] = snapshot;
+  }
+  model = (SpectatorViewModel){
+      .boards = boards, .count = GAMES_COUNT, .sort = sort, .page = 0};
+}
+
+static RootView *open_spectator_screen(Renderer *renderer) {
+  ck_assert_int_eq(renderer->start(renderer), 0);
+  Pallete *pallete = provide_pallete();
+  pallete->change_theme(pallete, DARK_THEME);
+
+  RootView *view = new_spectator_view(stdscr);
+  set_spectator_view_model_provider(provide_model);
+  return view;
+}
+
+static void close_spectator_screen(Renderer *renderer, RootView *view) {
+  release_spectator_view();
+  view->destroy(view);
+  renderer->stop(renderer);
+  renderer->destroy(renderer);
+}
+
+static void dump_frame(Renderer *renderer, char *frame, size_t size) {
+  FILE *file = tmpfile();
+  ck_assert_ptr_nonnull(file);
+  ck_assert_int_eq(renderer->dump(renderer, file), 0);
+  rewind(file);
+  size_t length = fread(frame, 1, size - 1, file);
+  frame[length] = '\0';
+  fclose(file);
+}
+
+START_TEST(gui_spectator_view__danger_sort_shows_highest_stack_first) {
+  static char frame[FRAME_MAX_SIZE];
+  init_model(SPECTATOR_SORT_DANGER);
+
+  Renderer *renderer = new_headless_renderer(SCREEN_HEIGHT, SCREEN_WIDTH);
+  RootView *view = open_spectator_screen(renderer);
+  view->update(view);
+  renderer->present(renderer);
+  dump_frame(renderer, frame, sizeof(frame));
+
+  // the game with the highest stack opens the first page, the one without a
+  // stack is on a later page
+  char label[32];
+  snprintf(label, sizeof(label), "%-4d%8d", GAMES_COUNT,
+           100 * (GAMES_COUNT - 1));
+  ck_assert_ptr_nonnull(strstr(frame, label));
+  ck_assert_ptr_null(strstr(frame, "1          0"));
+  ck_assert_ptr_nonnull(strstr(frame, "games by danger, page 1/"));
+
+  close_spectator_screen(renderer, view);
+}
+END_TEST
+
+START_TEST(gui_spectator_view__unchanged_boards_are_skipped) {
+  static char incremental[FRAME_MAX_SIZE], full[FRAME_MAX_SIZE];
+  init_model(SPECTATOR_SORT_SCORE);
+
+  Renderer *renderer = new_headless_renderer(SCREEN_HEIGHT, SCREEN_WIDTH);
+  RootView *view = open_spectator_screen(renderer);
+  unsigned long first_drawn = get_spectator_view_stats().boards_drawn;
+  view->update(view);
+  renderer->present(renderer);
+  SpectatorViewStats before = get_spectator_view_stats();
+  unsigned long shown = before.boards_drawn - first_drawn;
+  ck_assert_uint_gt(shown, 0);
+
+  // only the changed game is drawn again
+  snapshots[GAMES_COUNT - 1]._field[0][0] = 3;
+  snapshots[GAMES_COUNT - 1].generation.state++;
+  view->update(view);
+  renderer->present(renderer);
+  SpectatorViewStats after = get_spectator_view_stats();
+  ck_assert_uint_eq(after.boards_drawn, before.boards_drawn + 1);
+  ck_assert_uint_eq(after.boards_skipped,
+                    before.boards_skipped + shown - 1);
+  ck_assert_uint_eq(after.full_frames, before.full_frames);
+  dump_frame(renderer, incremental, sizeof(incremental));
+
+  invalidate_spectator_view();
+  view->update(view);
+  renderer->present(renderer);
+  dump_frame(renderer, full, sizeof(full));
+  ck_assert_str_eq(incremental, full);
+
+  close_spectator_screen(renderer, view);
+}
+END_TEST
+
+Suite *suite_gui__spectator_view(void) {
+  Suite *s = suite_create("gui__spectator_view");
+  TCase *tc_core = tcase_create("default");
+  suite_add_tcase(s, tc_core);
+
+  tcase_add_test(tc_core,
+                 gui_spectator_view__danger_sort_shows_highest_stack_first);
+  tcase_add_test(tc_core, gui_spectator_view__unchanged_boards_are_skipped);
+
+  return s;
+}
@@ -5,6 +5,18 @@ int main(void) {
       suite_tetris(),
       suite_tetris__fsm(),
       suite_tetris__repository(),
+      suite_tetris__replay(),
+      suite_tetris__runner(),
+      suite_tetris__fleet(),
+      suite_tetris__validator(),
+      suite_gui__components(),
+      suite_gui__renderer(),
+      suite_gui__game_view(),
+      suite_gui__governor(),
+      suite_gui__spectator_view(),
+      suite_gui__loop(),
+      suite_gui__keyboard(),
+      suite_gui__recorder(),
   };
 
   for (size_t i = 0; i < (sizeof(cases) / sizeof(Suite *)); i++) {
@@ -6,6 +6,7 @@
 #include <unistd.h>
 
 
+#include "gui/test_gui.h"
 #include "tetris/test_tetris.h"
 
 
@@ -59,15 +59,161 @@ START_TEST(tetris_timer_is_ticked) {
   int last_y = tetris->data.current_brick->pos.y;
   ck_assert_int_eq(tetris->state, TETRIS_MOVING_STATE);
 
+  // a second is two periods of the first level, both are applied at once
   sleep(1);
-  tetris->_tick(tetris);
+  ck_assert_int_eq(tetris->_tick(tetris), TETRIS_FRAME_RATE);
+  ck_assert_int_eq(tetris->data.current_brick->pos.y, last_y + 2);
+
+  tetris->destroy(tetris);
+  tetris = NULL;
+}
+END_TEST
+
+START_TEST(tetris_timer_catches_up) {
+  Tetris *tetris = new_tetris(new_brick_repository());
+  tetris->repository->populate_custom(tetris->repository);
+  tetris->timer = create_virtual_timer(tetris->timer.timeout_ns);
+
+  tetris->start(tetris);
+  int last_y = tetris->data.current_brick->pos.y;
+
+  // a stalled call of 0.75s owes 45 frames, a cell and a half of gravity
+  tetris->timer.set_time(&tetris->timer, (struct timespec){0, 750000000});
+  ck_assert_int_eq(tetris->_tick(tetris), 45);
   ck_assert_int_eq(tetris->data.current_brick->pos.y, last_y + 1);
 
+  // the half cell fallen counts towards the next one
+  tetris->timer.set_time(&tetris->timer, (struct timespec){1, 0});
+  ck_assert_int_eq(tetris->_tick(tetris), 15);
+  ck_assert_int_eq(tetris->data.current_brick->pos.y, last_y + 2);
+
+  // a longer stall is capped
+  tetris->timer.set_time(&tetris->timer, (struct timespec){5, 0});
+  ck_assert_int_eq(tetris->_tick(tetris), TETRIS_CATCH_UP_FRAMES_MAX);
+  ck_assert_int_eq(tetris->data.current_brick->pos.y, last_y + 4);
+  ck_assert_int_eq(tetris->frames, 60 + TETRIS_CATCH_UP_FRAMES_MAX);
+
+  tetris->destroy(tetris);
+  tetris = NULL;
+}
+END_TEST
+
+START_TEST(tetris_timer_resumes_without_catching_up) {
+  Tetris *tetris = new_tetris(new_brick_repository());
+  tetris->repository->populate_custom(tetris->repository);
+  tetris->timer = create_virtual_timer(TETRIS_FRAME_NS);
+
+  tetris->start(tetris);
+  tetris->data.info.level = 10;
+  int last_y = tetris->data.current_brick->pos.y;
+  tetris->pause(tetris);
+
+  // the runner does not tick while paused, the pause is not owed on resume
+  tetris->timer.set_time(&tetris->timer, (struct timespec){1, 0});
+  tetris->pause(tetris);
+  tetris->timer.set_time(&tetris->timer,
+                         (struct timespec){1, TETRIS_FRAME_NS});
+  ck_assert_int_eq(tetris->_tick(tetris), 1);
+  ck_assert_int_le(tetris->data.current_brick->pos.y, last_y + 1);
+
+  tetris->destroy(tetris);
+  tetris = NULL;
+}
+END_TEST
+
+static void tick_frame(Tetris *tetris, long long frame) {
+  long long now_ns = frame * TETRIS_FRAME_NS;
+  tetris->timer.set_time(&tetris->timer,
+                         (struct timespec){now_ns / 1000000000LL,
+                                           now_ns % 1000000000LL});
+  tetris->_tick(tetris);
+}
+
+START_TEST(tetris_lock_delay) {
+  Tetris *tetris = new_tetris(new_brick_repository());
+  tetris->repository->populate_custom(tetris->repository);
+  tetris->timer = create_virtual_timer(TETRIS_FRAME_NS);
+  tetris->start(tetris);
+
+  long long frame = 0;
+  while (!tetris->_lock_frames) {
+    tick_frame(tetris, ++frame);
+    ck_assert_int_eq(tetris->state, TETRIS_MOVING_STATE);
+  }
+
+  // a move on the ground restarts the delay
+  for (int i = 1; i < TETRIS_LOCK_DELAY_FRAMES / 2; i++) {
+    tick_frame(tetris, ++frame);
+  }
+  tetris->left(tetris, false);
+  ck_assert_int_eq(tetris->_lock_frames, 0);
+  ck_assert_int_eq(tetris->_lock_resets, 1);
+
+  for (int i = 1; i < TETRIS_LOCK_DELAY_FRAMES; i++) {
+    tick_frame(tetris, ++frame);
+    ck_assert_int_eq(tetris->state, TETRIS_MOVING_STATE);
+  }
+  tick_frame(tetris, ++frame);
+  ck_assert_int_eq(tetris->state, TETRIS_ATTACH_STATE);
+
   tetris->destroy(tetris);
   tetris = NULL;
 }
 END_TEST
 
+START_TEST(tetris_gravity_table) {
+  // the levels keep their periods of 500ms down to 50ms
+  for (int level = 1; level <= 10; level++) {
+    int frames = (11 - level) * 3;
+    ck_assert_int_ge(get_gravity_by_level(level) * frames, TETRIS_GRAVITY_ONE);
+    ck_assert_int_lt(get_gravity_by_level(level) * (frames - 1),
+                     TETRIS_GRAVITY_ONE);
+  }
+  ck_assert_int_eq(get_gravity_by_level(0), get_gravity_by_level(1));
+  ck_assert_int_eq(get_gravity_by_level(99), get_gravity_by_level(10));
+  ck_assert_int_le(get_gravity_by_level(99), TETRIS_GRAVITY_MAX);
+}
+END_TEST
+
+START_TEST(tetris_timer_does_not_drift) {
+  Timer timer = create_virtual_timer(500000000LL);
+
+  // ten minutes of frames of 16.7ms give or take 3ms
+  long long now_ns = 0;
+  int ticks = 0;
+  for (int frame = 0; now_ns < 600000000000LL; frame++) {
+    now_ns += 16666667LL + (frame % 7 - 3) * 1000000LL;
+    timer.set_time(&timer, (struct timespec){now_ns / 1000000000LL,
+                                             now_ns % 1000000000LL});
+    ticks += timer.tick(&timer);
+  }
+
+  ck_assert_int_eq(ticks, now_ns / 500000000LL);
+  ck_assert_int_eq(timer.ticks, ticks);
+  ck_assert_int_ge(ticks, 1200);
+}
+END_TEST
+
+START_TEST(tetris_timer_pins_the_clock) {
+  Timer timer = create_virtual_timer(TETRIS_FRAME_NS);
+  timer.set_time(&timer, (struct timespec){1, 0});
+
+  // a pinned clock keeps its time, nested pins included
+  struct timespec pinned = timer.pin(&timer);
+  ck_assert_int_eq(pinned.tv_sec, 1);
+  timer.set_time(&timer, (struct timespec){2, 0});
+  ck_assert_int_eq(timer.pin(&timer).tv_sec, 1);
+  timer.unpin(&timer);
+  ck_assert_int_eq(timer.now_ns(&timer), 1000000000LL);
+  ck_assert_int_eq(timer.tick(&timer), 1000000000LL / TETRIS_FRAME_NS);
+
+  timer.unpin(&timer);
+  ck_assert_int_eq(timer.now_ns(&timer), 2000000000LL);
+  timer.unpin(&timer);
+  ck_assert_int_eq(timer.now_ns(&timer), 2000000000LL);
+}
+END_TEST
+
 START_TEST(tetris_movement) {
   Tetris *tetris = new_tetris(new_brick_repository());
   tetris->repository->populate_custom(tetris->repository);
@@ -86,7 +232,7 @@ START_TEST(tetris_movement) {
     tetris->down(tetris, false);
   }
 
-  tetris->terminate(tetris);
+  tetris_dispatch(tetris, Terminate, false);
   ck_assert_int_eq(tetris->state, TETRIS_TERMINATED_STATE);
 
   tetris->destroy(tetris);
@@ -182,6 +328,82 @@ START_TEST(tetris_leveling) {
 }
 END_TEST
 
+START_TEST(tetris_reset_in_place) {
+  Tetris *tetris = new_simulation_tetris(7, BRICK_DEFAULTS_COUNT);
+  Tetris *fresh = new_simulation_tetris(7, BRICK_DEFAULTS_COUNT);
+  int **field = tetris->data.info.field;
+
+  tetris->start(tetris);
+  for (size_t i = 0; i < 3; i++) {
+    tetris->down(tetris, true);
+    tetris->_tick(tetris);
+  }
+  tetris->pause(tetris);
+
+  tetris->reset(tetris, 7);
+  ck_assert_int_eq(tetris->state, TETRIS_READY_STATE);
+  ck_assert_ptr_null(tetris->data.current_brick);
+  ck_assert_ptr_null(tetris->data.next_brick);
+  ck_assert_ptr_eq(tetris->data.info.field, field);
+  ck_assert_int_eq(tetris->data.info.score, 0);
+  ck_assert_int_eq(tetris->data.info.pause, 0);
+  ck_assert_int_eq(tetris->data.info.level, 1);
+  for (int row = 0; row < TETRIS_FIELD_HEIGHT; row++) {
+    for (int col = 0; col < TETRIS_FIELD_WIDTH; col++) {
+      ck_assert_int_eq(field[row][col], 0);
+    }
+  }
+
+  tetris->start(tetris);
+  fresh->start(fresh);
+  for (size_t i = 0; i < 3; i++) {
+    ck_assert_int_eq(tetris->data.current_brick->color,
+                     fresh->data.current_brick->color);
+    tetris->down(tetris, true);
+    tetris->_tick(tetris);
+    fresh->down(fresh, true);
+    fresh->_tick(fresh);
+  }
+
+  tetris->destroy(tetris);
+  fresh->destroy(fresh);
+}
+END_TEST
+
+START_TEST(tetris_generation_tracks_changes) {
+  Tetris *tetris = new_simulation_tetris(3, BRICK_DEFAULTS_COUNT);
+  TetrisGeneration before = tetris->generation;
+  ck_assert_uint_gt(before.state, 0);
+
+  // ticks of a game that is not running change nothing
+  tetris_update_state(tetris);
+  ck_assert_uint_eq(tetris->generation.state, before.state);
+
+  tetris_user_input(tetris, Start, false);
+  TetrisGeneration started = tetris->generation;
+  ck_assert_uint_gt(started.state, before.state);
+  ck_assert_uint_gt(started.field, before.field);
+  ck_assert_uint_gt(started.next, before.next);
+
+  tetris_user_input(tetris, Left, false);
+  ck_assert_uint_gt(tetris->generation.field, started.field);
+  ck_assert_uint_eq(tetris->generation.score, started.score);
+  ck_assert_uint_eq(tetris->generation.next, started.next);
+
+  TetrisGeneration moved = tetris->generation;
+  tetris_user_input(tetris, Pause, false);
+  ck_assert_uint_gt(tetris->generation.pause, moved.pause);
+  ck_assert_uint_eq(tetris->generation.field, moved.field);
+
+  TetrisGeneration paused = tetris->generation;
+  tetris_user_input(tetris, Left, false);
+  tetris_update_state(tetris);
+  ck_assert_uint_eq(tetris->generation.state, paused.state);
+
+  tetris->destroy(tetris);
+}
+END_TEST
+
 Suite *suite_tetris(void) {
   Suite *s = suite_create("tetris");
   TCase *tc_core = tcase_create("default");
@@ -189,6 +411,12 @@ Suite *suite_tetris(void) {
 
   tcase_add_test(tc_core, tetris_default_case);
   tcase_add_test(tc_core, tetris_timer_is_ticked);
+  tcase_add_test(tc_core, tetris_timer_catches_up);
+  tcase_add_test(tc_core, tetris_timer_resumes_without_catching_up);
+  tcase_add_test(tc_core, tetris_lock_delay);
+  tcase_add_test(tc_core, tetris_gravity_table);
+  tcase_add_test(tc_core, tetris_timer_does_not_drift);
+  tcase_add_test(tc_core, tetris_timer_pins_the_clock);
   tcase_add_test(tc_core, tetris_movement);
   tcase_add_test(tc_core, tetris_action);
   tcase_add_test(tc_core, tetris_erease_lines);
@@ -196,6 +424,8 @@ Suite *suite_tetris(void) {
 
   tcase_add_test(tc_core, tetris_reward);
   tcase_add_test(tc_core, tetris_leveling);
+  tcase_add_test(tc_core, tetris_reset_in_place);
+  tcase_add_test(tc_core, tetris_generation_tracks_changes);
 
   return s;
 }
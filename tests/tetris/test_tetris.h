@@ -10,5 +10,9 @@
 Suite *suite_tetris(void);
 Suite *suite_tetris__fsm(void);
 Suite *suite_tetris__repository(void);
+Suite *suite_tetris__replay(void);
+Suite *suite_tetris__runner(void);
+Suite *suite_tetris__fleet(void);
+Suite *suite_tetris__validator(void);
 
 #endif // !TESTS_TETRIS_TEST_TETRIS_H
\ No newline at end of file
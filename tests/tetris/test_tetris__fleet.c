@@ -0,0 +1,74 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <time.h>
+
+#include "../../src/brick_game/tetris/fleet/fleet.h"
+#include "test_tetris.h"
+
+#define BOT_TICK_NS 16666666LL
+#define BOT_TICKS 20000
+
+START_TEST(bot_clears_lines) {
+  Tetris *tetris = new_simulation_tetris(1, BRICK_DEFAULTS_COUNT);
+  TetrisBot *bot = new_tetris_bot(tetris);
+  ck_assert(!bot->play(bot));
+
+  tetris_user_input(tetris, Start, false);
+  long long clock_ns = 0;
+  for (int tick = 0;
+       tick < BOT_TICKS && tetris->state != TETRIS_GAMEOVER_STATE; tick++) {
+    clock_ns += BOT_TICK_NS;
+    tetris->timer.set_time(
+        &tetris->timer,
+        (struct timespec){.tv_sec = clock_ns / 1000000000LL,
+                          .tv_nsec = clock_ns % 1000000000LL});
+    bot->play(bot);
+    tetris_update_state(tetris);
+  }
+
+  // a bot playing every tick clears lines up to the fastest gravity
+  ck_assert_int_gt(tetris->data.info.score, 10000);
+  ck_assert_uint_gt(bot->stats.plans, 200);
+  ck_assert_uint_ge(bot->stats.moves, bot->stats.plans);
+
+  bot->destroy(bot);
+  tetris->destroy(tetris);
+}
+END_TEST
+
+START_TEST(fleet_publishes_games) {
+  ck_assert_ptr_null(new_tetris_fleet(0, 1, 1));
+
+  TetrisFleet *fleet = new_tetris_fleet(5, 1, TETRIS_FLEET_MAX_SPEED * 2);
+  ck_assert_int_eq(fleet->speed, TETRIS_FLEET_MAX_SPEED);
+  ck_assert_int_eq(fleet->rate, TETRIS_FLEET_RATE);
+  ck_assert_int_ge(fleet->threads_count, 1);
+  ck_assert_int_le(fleet->threads_count, 5);
+  ck_assert_int_eq(fleet->start(fleet), 0);
+
+  // every game is started before the first read
+  for (int i = 0; i < fleet->count; i++) {
+    ck_assert_int_ne(fleet->latest(fleet, i)->state, TETRIS_READY_STATE);
+  }
+
+  unsigned long sequence = fleet->latest(fleet, 0)->sequence;
+  nanosleep(&(struct timespec){.tv_nsec = 200000000}, NULL);
+  ck_assert_uint_gt(fleet->latest(fleet, 0)->sequence, sequence);
+  ck_assert_int_ge(fleet->latest(fleet, 0)->stack_height, 0);
+
+  fleet->stop(fleet);
+  ck_assert_uint_gt(fleet->stats.ticks, 0);
+  fleet->destroy(fleet);
+}
+END_TEST
+
+Suite *suite_tetris__fleet(void) {
+  Suite *s = suite_create("tetris__fleet");
+  TCase *tc_core = tcase_create("default");
+  suite_add_tcase(s, tc_core);
+
+  tcase_add_test(tc_core, bot_clears_lines);
+  tcase_add_test(tc_core, fleet_publishes_games);
+
+  return s;
+}
@@ -82,11 +82,15 @@ START_TEST(tetris_fsm__pause) {
   Tetris *tetris = provide_tetris(new_brick_repository());
   tetris->repository->populate_custom(tetris->repository);
 
+  // the dispatcher sets the state, the handler only toggles the flag
   tetris->state = TETRIS_PAUSE_STATE;
-  userInput(Pause, false);
-  ck_assert_int_eq(tetris->state, TETRIS_PAUSE_STATE);
+  tetris->data.info.pause = 1;
   userInput(Pause, false);
   ck_assert_int_eq(tetris->state, TETRIS_MOVING_STATE);
+  ck_assert_int_eq(tetris->data.info.pause, 0);
+  userInput(Pause, false);
+  ck_assert_int_eq(tetris->state, TETRIS_PAUSE_STATE);
+  ck_assert_int_eq(tetris->data.info.pause, 1);
 
   tetris->state = TETRIS_PAUSE_STATE;
   userInput(Left, false);
@@ -123,6 +127,57 @@ START_TEST(tetris_fsm__gameover) {
 }
 END_TEST
 
+typedef struct {
+  TetriState state;
+  UserAction_t action;
+  int next;
+} Transition;
+
+#define TRANSITION(state, action, handler, next) {state, action, next},
+
+START_TEST(tetris_fsm__table_leads_to_declared_states) {
+  static const Transition transitions[] = {
+      TETRIS_FSM_TRANSITIONS(TRANSITION)};
+  size_t count = sizeof(transitions) / sizeof(transitions[0]);
+
+  for (size_t i = 0; i < count; i++) {
+    Tetris *tetris = new_simulation_tetris(7, BRICK_DEFAULTS_COUNT);
+    if (transitions[i].state != TETRIS_READY_STATE) tetris->start(tetris);
+    tetris->state = transitions[i].state;
+    tetris->data.info.pause = transitions[i].state == TETRIS_PAUSE_STATE;
+
+    // the handlers of the other transitions decide: a start on an empty
+    // field spawns a brick, a soft drop from the top keeps it moving
+    int next = transitions[i].next;
+    if (next == TETRIS_FSM_ANY) next = TETRIS_MOVING_STATE;
+    tetris_dispatch(tetris, transitions[i].action, false);
+    ck_assert_int_eq(tetris->state, next);
+#ifdef TETRIS_FSM_INSTRUMENT
+    ck_assert_uint_eq(tetris->fsm_stats
+                          .transitions[transitions[i].state]
+                                      [transitions[i].action]
+                          .diverted,
+                      0);
+#endif
+    tetris->destroy(tetris);
+  }
+
+  // a hard drop locks the brick
+  Tetris *dropped = new_simulation_tetris(7, BRICK_DEFAULTS_COUNT);
+  dropped->start(dropped);
+  tetris_dispatch(dropped, Down, true);
+  ck_assert_int_eq(dropped->state, TETRIS_ATTACH_STATE);
+  dropped->destroy(dropped);
+
+  // out of range states and actions are ignored
+  Tetris *tetris = new_tetris(new_brick_repository());
+  tetris_dispatch(tetris, (UserAction_t)TETRIS_FSM_ACTIONS, false);
+  tetris_dispatch(tetris, (UserAction_t)-1, false);
+  ck_assert_int_eq(tetris->state, TETRIS_READY_STATE);
+  tetris->destroy(tetris);
+}
+END_TEST
+
 Suite *suite_tetris__fsm(void) {
   Suite *s = suite_create("suite_tetris__fsm");
   TCase *tc_core = tcase_create("default");
@@ -134,6 +189,7 @@ Suite *suite_tetris__fsm(void) {
   tcase_add_test(tc_core, tetris_fsm__movement);
   tcase_add_test(tc_core, tetris_fsm__pause);
   tcase_add_test(tc_core, tetris_fsm__gameover);
+  tcase_add_test(tc_core, tetris_fsm__table_leads_to_declared_states);
 
   return s;
 }
@@ -0,0 +1,237 @@
+#include "test_tetris.h"
+
+#include "../../src/brick_game/tetris/ghost/ghost.h"
+
+/**
+ * Plays a game on the singleton engine with a virtual clock, recording it the
+ * same way the frontend does, and returns the encoded replay.
+ */
+static uint8_t *record_game(size_t *size, int *score) {
+  Tetris *tetris = provide_tetris();
+  tetris->timer = create_virtual_timer(tetris->timer.timeout_ns);
+  tetris->on_startup = NULL;
+  tetris->on_shutdown = NULL;
+  tetris->on_highscore = NULL;
+  tetris->on_gameover = NULL;
+  tetris->replay = new_replay();
+
+  UserAction_t moves[] = {Left, Left, Action, Right, Down, Left, Right};
+  long long now_ns = 0;
+  userInput(Start, false);
+  for (int frame = 0; frame < 20000 && tetris->state != TETRIS_GAMEOVER_STATE;
+       frame++) {
+    now_ns += 50000000LL + (frame % 7) * 1000;
+    tetris->timer.set_time(&tetris->timer,
+                           (struct timespec){.tv_sec = now_ns / 1000000000LL,
+                                             .tv_nsec = now_ns % 1000000000LL});
+    if (frame % 3 == 0) userInput(moves[frame % 7], frame % 11 == 0);
+    updateCurrentState();
+  }
+
+  *score = tetris->data.info.score;
+  return tetris->replay->encode(tetris->replay, size);
+}
+
+START_TEST(replay_roundtrip) {
+  Replay *replay = new_replay();
+  replay->begin(replay, 42, BRICK_DEFAULTS_COUNT, (struct timespec){0});
+  replay->record(replay, REPLAY_CODE_TICK, (struct timespec){.tv_nsec = 5});
+  replay->record(replay, (REPLAY_CODE_ACTION + Left) | REPLAY_CODE_HOLD,
+                 (struct timespec){.tv_sec = 3, .tv_nsec = 5});
+  strcpy(replay->header.player, "tester");
+
+  size_t size = 0;
+  uint8_t *buffer = replay->encode(replay, &size);
+  Replay *decoded = decode_replay(buffer, size);
+
+  ck_assert_ptr_nonnull(decoded);
+  ck_assert_int_eq(decoded->header.seed, 42);
+  ck_assert_int_eq(decoded->header.bricks_count, BRICK_DEFAULTS_COUNT);
+  ck_assert_int_eq(decoded->header.events_count, 2);
+  ck_assert_int_eq(decoded->events[0].dt_ns, 5);
+  ck_assert_int_eq(decoded->events[0].code, REPLAY_CODE_TICK);
+  ck_assert_int_eq(decoded->events[1].dt_ns, 3000000000LL);
+  ck_assert_int_eq(decoded->events[1].code,
+                   (REPLAY_CODE_ACTION + Left) | REPLAY_CODE_HOLD);
+  ck_assert_int_eq(strcmp(decoded->header.player, "tester"), 0);
+
+  ck_assert_ptr_null(decode_replay(buffer, size - 1));
+  // a count of events that cannot fit is not trusted with an allocation
+  uint8_t count[4];
+  memcpy(count, buffer + 14, 4);
+  memset(buffer + 14, 0xFF, 4);
+  ck_assert_ptr_null(decode_replay(buffer, size));
+  memcpy(buffer + 14, count, 4);
+  buffer[0] = 'X';
+  ck_assert_ptr_null(decode_replay(buffer, size));
+
+  free(buffer);
+  decoded->destroy(decoded);
+  replay->destroy(replay);
+}
+END_TEST
+
+START_TEST(replay_simulation_matches_game) {
+  size_t size = 0;
+  int score = 0;
+  uint8_t *buffer = record_game(&size, &score);
+  ck_assert_ptr_nonnull(buffer);
+  ck_assert_int_eq(provide_tetris()->state, TETRIS_GAMEOVER_STATE);
+
+  ReplaySimulation result = simulate_replay(buffer, size, score);
+  ck_assert_int_eq(result.verdict, REPLAY_VERDICT_OK);
+  ck_assert_int_eq(result.score, score);
+  ck_assert_int_eq(result.state, TETRIS_GAMEOVER_STATE);
+  ck_assert_int_gt(result.ticks, 0);
+
+  result = simulate_replay(buffer, size, score + 100);
+  ck_assert_int_eq(result.verdict, REPLAY_VERDICT_SCORE_MISMATCH);
+
+  free(buffer);
+  provide_tetris()->destroy(provide_tetris());
+}
+END_TEST
+
+START_TEST(replay_simulation_rejects) {
+  ReplaySimulation result = simulate_replay((const uint8_t *)"junk", 4, 0);
+  ck_assert_int_eq(result.verdict, REPLAY_VERDICT_MALFORMED);
+
+  Replay *replay = new_replay();
+  replay->begin(replay, 1, 5, (struct timespec){0});
+  size_t size = 0;
+  uint8_t *buffer = replay->encode(replay, &size);
+  result = simulate_replay(buffer, size, 0);
+  ck_assert_int_eq(result.verdict, REPLAY_VERDICT_BAD_BRICKS);
+  free(buffer);
+
+  // a hundred actions within one millisecond
+  replay->begin(replay, 1, BRICK_DEFAULTS_COUNT, (struct timespec){0});
+  for (int i = 0; i < 100; i++) {
+    replay->record(replay, REPLAY_CODE_ACTION + Left,
+                   (struct timespec){.tv_nsec = i * 10});
+  }
+  buffer = replay->encode(replay, &size);
+  result = simulate_replay(buffer, size, 0);
+  ck_assert_int_eq(result.verdict, REPLAY_VERDICT_BAD_TIMING);
+  free(buffer);
+
+  // held moves have a window of their own, but not an endless one
+  replay->begin(replay, 1, BRICK_DEFAULTS_COUNT, (struct timespec){0});
+  for (int i = 0; i < 200; i++) {
+    replay->record(replay, (REPLAY_CODE_ACTION + Left) | REPLAY_CODE_HOLD,
+                   (struct timespec){.tv_nsec = i * 1000000});
+  }
+  buffer = replay->encode(replay, &size);
+  result = simulate_replay(buffer, size, 0);
+  ck_assert_int_eq(result.verdict, REPLAY_VERDICT_BAD_TIMING);
+  ck_assert_uint_eq(result.actions, 128);
+  free(buffer);
+
+  replay->destroy(replay);
+}
+END_TEST
+
+START_TEST(replay_second_game_matches) {
+  size_t size = 0;
+  int score = 0;
+  free(record_game(&size, &score));
+
+  // the second game starts with bricks rotated by the first one
+  uint8_t *buffer = record_game(&size, &score);
+  Ghost *ghost = new_ghost(buffer, size);
+  ghost->advance(ghost, 24LL * 3600 * 1000000000LL);
+
+  int **field = provide_tetris()->data.info.field;
+  for (int row = 0; row < TETRIS_FIELD_HEIGHT; row++) {
+    for (int col = 0; col < TETRIS_FIELD_WIDTH; col++) {
+      ck_assert_int_eq(ghost->tetris->data.info.field[row][col],
+                       field[row][col]);
+    }
+  }
+
+  ghost->destroy(ghost);
+  provide_tetris()->destroy(provide_tetris());
+}
+END_TEST
+
+START_TEST(replay_ghost_follows_recording) {
+  size_t size = 0;
+  int score = 0;
+  uint8_t *buffer = record_game(&size, &score);
+
+  Ghost *ghost = new_ghost(buffer, size);
+  ck_assert_ptr_nonnull(ghost);
+  for (int frame = 0; frame < 100000 && !ghost->is_finished; frame++) {
+    ghost->advance(ghost, 50000000LL);
+  }
+  ck_assert(ghost->is_finished);
+  ck_assert_int_eq(ghost->tetris->data.info.score, score);
+  ck_assert_int_eq(ghost->tetris->state, TETRIS_GAMEOVER_STATE);
+
+  ghost->restart(ghost);
+  ck_assert_int_eq(ghost->tetris->data.info.score, 0);
+  ghost->advance(ghost, 24LL * 3600 * 1000000000LL);
+  ck_assert(ghost->is_finished);
+  ck_assert_int_eq(ghost->tetris->data.info.score, score);
+
+  ghost->destroy(ghost);
+  ck_assert_ptr_null(new_ghost(calloc(4, 1), 4));
+  provide_tetris()->destroy(provide_tetris());
+}
+END_TEST
+
+static int locks_count = 0;
+static int erases_count = 0;
+
+static void count_lock(Tetris *self, Brick *brick) {
+  ck_assert_ptr_eq(self->context, &locks_count);
+  ck_assert_ptr_nonnull(brick);
+  locks_count++;
+}
+
+static void count_erase(Tetris *self, int lines) {
+  ck_assert_int_ge(lines, 0);
+  ck_assert_int_le(lines, BRICK_HEIGHT);
+  (void)self;
+  erases_count++;
+}
+
+START_TEST(replay_run_reports_locks) {
+  size_t size = 0;
+  int score = 0;
+  uint8_t *buffer = record_game(&size, &score);
+
+  ReplayReader reader;
+  ck_assert(replay_reader_init(&reader, buffer, size));
+  Tetris *tetris =
+      new_simulation_tetris(reader.header.seed, reader.header.bricks_count);
+  tetris->context = &locks_count;
+  tetris->on_lock = count_lock;
+  tetris->on_erase = count_erase;
+
+  ReplaySimulation result = run_replay(tetris, &reader);
+  ck_assert_int_eq(result.verdict, REPLAY_VERDICT_OK);
+  ck_assert_int_eq(result.score, score);
+  ck_assert_int_gt(locks_count, 0);
+  ck_assert_int_eq(erases_count, locks_count);
+
+  free(buffer);
+  tetris->destroy(tetris);
+  provide_tetris()->destroy(provide_tetris());
+}
+END_TEST
+
+Suite *suite_tetris__replay(void) {
+  Suite *s = suite_create("tetris__replay");
+  TCase *tc_core = tcase_create("default");
+  suite_add_tcase(s, tc_core);
+
+  tcase_add_test(tc_core, replay_roundtrip);
+  tcase_add_test(tc_core, replay_simulation_matches_game);
+  tcase_add_test(tc_core, replay_simulation_rejects);
+  tcase_add_test(tc_core, replay_run_reports_locks);
+  tcase_add_test(tc_core, replay_second_game_matches);
+  tcase_add_test(tc_core, replay_ghost_follows_recording);
+
+  return s;
+}
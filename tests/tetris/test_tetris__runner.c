@@ -0,0 +1,159 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <time.h>
+#include <unistd.h>
+
+#include "../../src/brick_game/tetris/runner/runner.h"
+#include "test_tetris.h"
+
+/**
+ * Waits up to a second for the engine thread to publish a snapshot with the
+ * given number of applied commands and returns the latest snapshot.
+ */
+static const TetrisSnapshot *wait_for_commands(TetrisRunner *runner,
+                                               unsigned long count) {
+  const TetrisSnapshot *snapshot = runner->latest(runner);
+  for (int i = 0; i < 1000 && snapshot->input_sequence < count; i++) {
+    nanosleep(&(struct timespec){.tv_nsec = 1000000}, NULL);
+    snapshot = runner->latest(runner);
+  }
+  return snapshot;
+}
+
+START_TEST(runner_applies_commands) {
+  Tetris *tetris = new_simulation_tetris(7, BRICK_DEFAULTS_COUNT);
+  TetrisRunner *runner = new_tetris_runner(tetris, NULL, 1000);
+  ck_assert_int_eq(runner->start(runner), 0);
+
+  const TetrisSnapshot *snapshot = runner->latest(runner);
+  ck_assert_int_eq(snapshot->state, TETRIS_READY_STATE);
+  ck_assert(!snapshot->has_ghost);
+
+  ck_assert(runner->send(runner, Start, false));
+  snapshot = wait_for_commands(runner, 1);
+  ck_assert_uint_eq(snapshot->input_sequence, 1);
+  ck_assert_int_ne(snapshot->state, TETRIS_READY_STATE);
+
+  // the cells of a snapshot are its own
+  int cells = 0;
+  for (int row = 0; row < TETRIS_FIELD_HEIGHT; row++) {
+    for (int col = 0; col < TETRIS_FIELD_WIDTH; col++) {
+      cells += snapshot->info.field[row][col] != 0;
+    }
+    ck_assert_ptr_ne(snapshot->info.field[row], tetris->data.info.field[row]);
+  }
+  ck_assert_int_gt(cells, 0);
+
+  // the engine ticks on its own between the commands, a key is measured from
+  // the time it was read at
+  struct timespec read;
+  clock_gettime(CLOCK_MONOTONIC, &read);
+  nanosleep(&(struct timespec){.tv_nsec = 10000000}, NULL);
+  ck_assert(runner->send_at(runner, Terminate, false,
+                            read.tv_sec * 1000000000LL + read.tv_nsec));
+  snapshot = wait_for_commands(runner, 2);
+  ck_assert_int_eq(snapshot->state, TETRIS_TERMINATED_STATE);
+
+  runner->stop(runner);
+  ck_assert_uint_gt(runner->stats.ticks, 0);
+  ck_assert_uint_eq(runner->stats.commands, 2);
+  ck_assert_uint_eq(runner->stats.dropped, 0);
+  ck_assert_int_ge(runner->stats.max_latency_ns, 10000000);
+
+  runner->destroy(runner);
+  tetris->destroy(tetris);
+}
+END_TEST
+
+START_TEST(runner_snapshot_is_stable) {
+  Tetris *tetris = new_simulation_tetris(7, BRICK_DEFAULTS_COUNT);
+  TetrisRunner *runner = new_tetris_runner(tetris, NULL, 1000);
+  ck_assert_int_eq(runner->start(runner), 0);
+
+  // ticks that change nothing publish nothing
+  const TetrisSnapshot *snapshot = runner->latest(runner);
+  unsigned long sequence = snapshot->sequence;
+  nanosleep(&(struct timespec){.tv_nsec = 20000000}, NULL);
+  ck_assert_uint_eq(runner->latest(runner)->sequence, sequence);
+  char byte;
+  ck_assert_int_lt(read(runner->published_fd, &byte, 1), 0);
+
+  // the engine publishes the game start, the snapshot read last is left alone
+  ck_assert(runner->send(runner, Start, false));
+  nanosleep(&(struct timespec){.tv_nsec = 20000000}, NULL);
+  ck_assert_uint_eq(snapshot->sequence, sequence);
+  ck_assert_int_eq(snapshot->state, TETRIS_READY_STATE);
+
+  const TetrisSnapshot *next = wait_for_commands(runner, 1);
+  ck_assert_uint_gt(next->sequence, sequence);
+  ck_assert_int_eq(read(runner->published_fd, &byte, 1), 1);
+  ck_assert_uint_gt(next->generation.field, snapshot->generation.field);
+
+  runner->destroy(runner);
+  tetris->destroy(tetris);
+}
+END_TEST
+
+START_TEST(runner_drops_commands_when_full) {
+  Tetris *tetris = new_simulation_tetris(7, BRICK_DEFAULTS_COUNT);
+  TetrisRunner *runner = new_tetris_runner(tetris, NULL, 0);
+  ck_assert_int_eq(runner->rate, TETRIS_RUNNER_RATE);
+
+  for (int i = 0; i < TETRIS_RUNNER_QUEUE_SIZE; i++) {
+    ck_assert(runner->send(runner, Left, false));
+  }
+  ck_assert(!runner->send(runner, Left, false));
+  ck_assert_uint_eq(runner->stats.dropped, 1);
+
+  runner->destroy(runner);
+  tetris->destroy(tetris);
+}
+END_TEST
+
+START_TEST(runner_records_auto_repeat_replay) {
+  Tetris *tetris = new_simulation_tetris(7, BRICK_DEFAULTS_COUNT);
+  tetris->timer = create_timer(tetris->timer.timeout_ns);
+  tetris->replay = new_replay();
+  TetrisRunner *runner = new_tetris_runner(tetris, NULL, 1000);
+  ck_assert_int_eq(runner->start(runner), 0);
+
+  // left and right held together at the shortest auto-repeat period, the
+  // owed moves of every frame sent as one command, as the keyboard does
+  ck_assert(runner->send(runner, Start, false));
+  unsigned long commands = 1;
+  for (int frame = 0; frame < 75; frame++) {
+    UserAction_t action = frame % 2 ? Right : Left;
+    ck_assert(runner->send_repeated(runner, action, true, 2, 0));
+    commands++;
+    nanosleep(&(struct timespec){.tv_nsec = 16000000}, NULL);
+  }
+  wait_for_commands(runner, commands);
+  runner->stop(runner);
+  ck_assert_uint_eq(runner->stats.dropped, 0);
+
+  size_t size = 0;
+  uint8_t *buffer = tetris->replay->encode(tetris->replay, &size);
+  ck_assert_ptr_nonnull(buffer);
+  ReplaySimulation result =
+      simulate_replay(buffer, size, tetris->data.info.score);
+  ck_assert_int_eq(result.verdict, REPLAY_VERDICT_OK);
+  ck_assert_uint_eq(result.actions, 75 * 2);
+
+  free(buffer);
+  runner->destroy(runner);
+  tetris->destroy(tetris);
+}
+END_TEST
+
+Suite *suite_tetris__runner(void) {
+  Suite *s = suite_create("tetris__runner");
+  TCase *tc_core = tcase_create("default");
+  suite_add_tcase(s, tc_core);
+
+  tcase_add_test(tc_core, runner_applies_commands);
+  tcase_add_test(tc_core, runner_snapshot_is_stable);
+  tcase_add_test(tc_core, runner_drops_commands_when_full);
+  tcase_add_test(tc_core, runner_records_auto_repeat_replay);
+
+  return s;
+}
@@ -0,0 +1,187 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+
+#include "../../src/tools/validator/validator.h"
+#include "test_tetris.h"
+
+#define SOCKET_PATH "/tmp/test_tetris__validator.sock"
+
+typedef struct {
+  Validator *validator;
+  pthread_t thread;
+} Service;
+
+static void *serve_routine(void *arg) {
+  Validator *validator = (Validator *)arg;
+  validator->serve(validator);
+  return NULL;
+}
+
+// a running service on SOCKET_PATH, once it answers
+static Service start_service(size_t pending_capacity) {
+  signal(SIGPIPE, SIG_IGN);
+  Service service = {.validator = new_validator(
+                         (ValidatorConfig){.socket_path = SOCKET_PATH,
+                                           .workers = 1,
+                                           .queue_capacity = 4,
+                                           .pending_capacity =
+                                               pending_capacity})};
+  unlink(SOCKET_PATH);
+  pthread_create(&service.thread, NULL, serve_routine, service.validator);
+
+  char reply[VALIDATOR_REPLY_SIZE];
+  for (int i = 0; i < 1000 && request_validator_stats(SOCKET_PATH, reply,
+                                                      sizeof(reply));
+       i++) {
+    nanosleep(&(struct timespec){.tv_nsec = 1000000}, NULL);
+  }
+  return service;
+}
+
+static void stop_service(Service *service) {
+  service->validator->stop(service->validator);
+  pthread_join(service->thread, NULL);
+  service->validator->destroy(service->validator);
+}
+
+// a client socket that sends nothing by itself
+static int connect_client(void) {
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  struct sockaddr_un address = {.sun_family = AF_UNIX};
+  strncpy(address.sun_path, SOCKET_PATH, sizeof(address.sun_path) - 1);
+  ck_assert_int_eq(
+      connect(fd, (struct sockaddr *)&address, sizeof(address)), 0);
+  return fd;
+}
+
+// the reply line of a raw client, until the service closes it
+static void read_line(int fd, char *reply, size_t size) {
+  size_t done = 0;
+  ssize_t got = 0;
+  while (done + 1 < size &&
+         (got = read(fd, reply + done, size - done - 1)) > 0) {
+    done += (size_t)got;
+  }
+  reply[done] = '\0';
+}
+
+// the stats once the given number of verdicts were counted, the worker counts
+// a verdict after answering it
+static ValidatorStats wait_for_verdicts(Validator *validator,
+                                        unsigned long count) {
+  ValidatorStats stats = validator->get_stats(validator);
+  for (int i = 0; i < 1000 && stats.accepted + stats.rejected < count; i++) {
+    nanosleep(&(struct timespec){.tv_nsec = 1000000}, NULL);
+    stats = validator->get_stats(validator);
+  }
+  return stats;
+}
+
+// a game of a few ticks without a move, its score is 0
+static uint8_t *idle_replay(size_t *size) {
+  Replay *replay = new_replay();
+  replay->begin(replay, 3, BRICK_DEFAULTS_COUNT, (struct timespec){0});
+  for (int i = 1; i <= 30; i++) {
+    replay->record(replay, REPLAY_CODE_TICK,
+                   (struct timespec){.tv_nsec = i * TETRIS_FRAME_NS});
+  }
+  uint8_t *buffer = replay->encode(replay, size);
+  replay->destroy(replay);
+  // the tests write the size as a single byte
+  ck_assert_uint_lt(*size, 256);
+  return buffer;
+}
+
+START_TEST(validator_accepts_and_rejects) {
+  Service service = start_service(0);
+  size_t size = 0;
+  uint8_t *replay = idle_replay(&size);
+  char reply[VALIDATOR_REPLY_SIZE];
+
+  ck_assert_int_eq(
+      submit_replay(SOCKET_PATH, 0, replay, size, reply, sizeof(reply)), 0);
+  ck_assert_int_eq(strncmp(reply, "ACCEPT score=0", 14), 0);
+
+  ck_assert_int_eq(
+      submit_replay(SOCKET_PATH, 500, replay, size, reply, sizeof(reply)), 0);
+  ck_assert_str_eq(reply, "REJECT score mismatch score=0\n");
+
+  int client = connect_client();
+  ck_assert_int_eq(write(client, "JUNK", 4), 4);
+  read_line(client, reply, sizeof(reply));
+  ck_assert_str_eq(reply, "REJECT bad request\n");
+  close(client);
+
+  // the replay is cut short, the client says it is done
+  client = connect_client();
+  uint8_t header[VALIDATOR_HEADER_SIZE] = {'S', '2', '1', 'V', 0, 0, 0, 0,
+                                           (uint8_t)size};
+  ck_assert_int_eq(write(client, header, sizeof(header)), sizeof(header));
+  ck_assert_int_eq(write(client, replay, 10), 10);
+  shutdown(client, SHUT_WR);
+  read_line(client, reply, sizeof(reply));
+  ck_assert_str_eq(reply, "REJECT truncated replay\n");
+  close(client);
+
+  ValidatorStats stats = wait_for_verdicts(service.validator, 2);
+  ck_assert_uint_eq(stats.accepted, 1);
+  ck_assert_uint_eq(stats.rejected, 1);
+  ck_assert_uint_eq(stats.busy, 0);
+
+  free(replay);
+  stop_service(&service);
+}
+END_TEST
+
+START_TEST(validator_is_not_held_by_slow_clients) {
+  Service service = start_service(2);
+  size_t size = 0;
+  uint8_t *replay = idle_replay(&size);
+  char reply[VALIDATOR_REPLY_SIZE];
+
+  // a client that stops in the middle of its header keeps only its own slot
+  int slow = connect_client();
+  ck_assert_int_eq(write(slow, "S21V", 4), 4);
+  ck_assert_int_eq(
+      submit_replay(SOCKET_PATH, 0, replay, size, reply, sizeof(reply)), 0);
+  ck_assert_int_eq(strncmp(reply, "ACCEPT", 6), 0);
+
+  // with both slots taken the next client is refused at once
+  int stalled = connect_client();
+  ck_assert_int_eq(
+      submit_replay(SOCKET_PATH, 0, replay, size, reply, sizeof(reply)), 0);
+  ck_assert_str_eq(reply, "BUSY too many clients\n");
+
+  // the slow client finishes its submission after all
+  uint8_t header[VALIDATOR_HEADER_SIZE - 4] = {0, 0, 0, 0, (uint8_t)size};
+  ck_assert_int_eq(write(slow, header, sizeof(header)), sizeof(header));
+  ck_assert_int_eq(write(slow, replay, size), (ssize_t)size);
+  read_line(slow, reply, sizeof(reply));
+  ck_assert_int_eq(strncmp(reply, "ACCEPT", 6), 0);
+  close(slow);
+  close(stalled);
+
+  ValidatorStats stats = wait_for_verdicts(service.validator, 2);
+  ck_assert_uint_eq(stats.accepted, 2);
+  ck_assert_uint_eq(stats.busy, 1);
+
+  free(replay);
+  stop_service(&service);
+}
+END_TEST
+
+Suite *suite_tetris__validator(void) {
+  Suite *s = suite_create("tetris__validator");
+  TCase *tc_core = tcase_create("default");
+  suite_add_tcase(s, tc_core);
+
+  tcase_add_test(tc_core, validator_accepts_and_rejects);
+  tcase_add_test(tc_core, validator_is_not_held_by_slow_clients);
+
+  return s;
+}